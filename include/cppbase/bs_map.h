@@ -48,6 +48,169 @@
         }
     };
 
+    /*
+     *@@ BSBPMap:
+     *      drop-in alternative for BSMap which is implemented
+     *      with a B+ tree (see bptree.c) instead of a red-black
+     *      tree. This requires helpers\bptree.h.
+     *
+     *      As with BSMap, P must be a pointer to a structure
+     *      whose first member is a TREE with a valid ulKey.
+     *      Only ulKey is used though; the other TREE members
+     *      are left alone since the B+ tree keeps its keys in
+     *      its own nodes, which makes lookups in large maps
+     *      much more cache-friendly.
+     *
+     *      next() is O(1) while you iterate without modifying
+     *      the map in between; otherwise it has to look up the
+     *      key of p first.
+     *
+     *@@added V1.0.24 (2026-10-18) [agent]
+     */
+
+    template <class P, FNTREE_COMPARE *pfnCompare>
+    struct BSBPMap
+    {
+        BPTREE          _Tree;
+        BPTITER         _Iter;          // cursor for first() and next()
+
+        BSBPMap()
+        {
+            bptInit(&_Tree, pfnCompare);
+            _Iter.pLeaf = NULL;
+        }
+
+        ~BSBPMap()
+        {
+            bptClear(&_Tree);
+        }
+
+        int inline insert(P p)
+        {
+            return (bptInsert(&_Tree,
+                              ((TREE*)p)->ulKey,
+                              p));
+        }
+
+        int inline remove(P p)
+        {
+            return (bptDelete(&_Tree,
+                              ((TREE*)p)->ulKey,
+                              NULL));
+        }
+
+        P inline find(ULONG ulKey)
+        {
+            return (P)bptFind(&_Tree, ulKey, NULL);
+        }
+
+        LONG inline count() const
+        {
+            return _Tree.lCount;
+        }
+
+        P inline first()
+        {
+            if (bptFirst(&_Tree, &_Iter))
+                return (P)bptIterData(&_Iter);
+            return NULL;
+        }
+
+        P next(P p)
+        {
+            if (    (!bptIterValid(&_Iter))
+                 || (bptIterData(&_Iter) != p)
+               )
+                if (!bptFind(&_Tree, ((TREE*)p)->ulKey, &_Iter))
+                    return NULL;
+
+            if (bptNext(&_Iter))
+                return (P)bptIterData(&_Iter);
+            return NULL;
+        }
+
+    private:
+        // not copyable, the map owns its nodes
+        BSBPMap(const BSBPMap&);
+        BSBPMap& operator=(const BSBPMap&);
+    };
+
+    /*
+     *@@ BSStrHashMap:
+     *      string-keyed hash map for pointers to P, implemented
+     *      with a STRMAP (see strmap.c). This requires
+     *      helpers\strmap.h.
+     *
+     *      Use this instead of BSMap with a string compare
+     *      function if you only ever look up exact keys and
+     *      don't need sorted iteration; see StringMapEntry
+     *      for a typical entry type:
+     *
+     +          BSStrHashMap<StringMapEntry*> Map;
+     +          StringMapEntry *p = new StringMapEntry(strKey, strValue);
+     +          Map.insert(p->_strKey.c_str(), p);
+     *
+     *      As with STRMAP, the key is not copied and must stay
+     *      valid while the entry is in the map. The map does
+     *      not delete the entries.
+     *
+     *@@added V1.0.24 (2026-10-18) [agent]
+     */
+
+    template <class P>
+    struct BSStrHashMap
+    {
+        STRMAP          _Map;
+
+        BSStrHashMap()
+        {
+            smapInit(&_Map);
+        }
+
+        ~BSStrHashMap()
+        {
+            smapClear(&_Map);
+        }
+
+        int inline insert(const char *pcszKey, P p)
+        {
+            return smapInsert(&_Map, pcszKey, (void*)p);
+        }
+
+        P inline find(const char *pcszKey) const
+        {
+            return (P)smapFind(&_Map, pcszKey);
+        }
+
+        int inline remove(const char *pcszKey)
+        {
+            return smapRemove(&_Map, pcszKey, NULL);
+        }
+
+        ULONG inline count() const
+        {
+            return _Map.cItems;
+        }
+
+        /*
+         *  enumerate(): call with ul = 0 initially;
+         *  returns NULL after the last entry.
+         */
+
+        P enumerate(ULONG &ul) const
+        {
+            PSTRMAPSLOT pSlot;
+            if ((pSlot = smapEnum(&_Map, &ul)))
+                return (P)pSlot->pvData;
+            return NULL;
+        }
+
+    private:
+        // not copyable, the map owns its table
+        BSStrHashMap(const BSStrHashMap&);
+        BSStrHashMap& operator=(const BSStrHashMap&);
+    };
+
     /*
      *@@ StringMapEntry:
      *      string map entry for codepaged strings.
@@ -0,0 +1,123 @@
+
+/*
+ *@@sourcefile bptree.h:
+ *      header file for bptree.c (B+ trees). See remarks there.
+ *
+ *      Note: Version numbering in this file relates to XWorkplace version
+ *            numbering.
+ *
+ *@@include #include "helpers\tree.h"
+ *@@include #include "helpers\bptree.h"
+ */
+
+/*      Copyright (C) 2026 the XWorkplace helpers authors.
+ *      This file is part of the "XWorkplace helpers" source package.
+ *      This is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published
+ *      by the Free Software Foundation, in version 2 as it comes in the
+ *      "COPYING" file of the XWorkplace main distribution.
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ */
+
+#if __cplusplus
+extern "C" {
+#endif
+
+#ifndef XWPBPTREE_INCLUDED
+    #define XWPBPTREE_INCLUDED
+
+    #ifndef XWPTREE_INCLUDED
+        #error helpers\tree.h must be included before helpers\bptree.h.
+    #endif
+
+    #define STATUS_NO_MEMORY            -3
+
+    /*
+     *@@ BPTNODE:
+     *      opaque B+ tree node. See bptree.c.
+     */
+
+    typedef struct _BPTNODE *PBPTNODE;
+
+    /*
+     *@@ BPTREE:
+     *      the "root" of a B+ tree. Initialize this with
+     *      bptInit and clean up with bptClear.
+     *
+     *      See bptree.c for more on how to use these.
+     *
+     *@@added V1.0.24 (2026-10-18) [agent]
+     */
+
+    typedef struct _BPTREE
+    {
+        PBPTNODE        pRoot;          // root node (NULL if empty)
+        PBPTNODE        pFirstLeaf,     // leftmost leaf (NULL if empty)
+                        pLastLeaf;      // rightmost leaf (NULL if empty)
+        LONG            lCount;         // no. of keys in the tree
+        ULONG           ulStamp;        // raised on every modification
+        FNTREE_COMPARE  *pfnCompare;    // comparison func
+    } BPTREE, *PBPTREE;
+
+    /*
+     *@@ BPTITER:
+     *      position of a key in a B+ tree, as filled
+     *      by bptFirst, bptLast and bptFind and moved
+     *      by bptNext and bptPrev.
+     *
+     *      An iterator becomes invalid as soon as the
+     *      tree is modified; bptIterValid checks that.
+     *
+     *@@added V1.0.24 (2026-10-18) [agent]
+     */
+
+    typedef struct _BPTITER
+    {
+        PBPTREE         pTree;
+        PBPTNODE        pLeaf;
+        ULONG           ulIndex;
+        ULONG           ulStamp;        // copy of BPTREE.ulStamp
+    } BPTITER, *PBPTITER;
+
+    void bptInit(PBPTREE pTree,
+                 FNTREE_COMPARE *pfnCompare);
+
+    void bptClear(PBPTREE pTree);
+
+    int bptInsert(PBPTREE pTree,
+                  ULONG ulKey,
+                  void* pvData);
+
+    int bptDelete(PBPTREE pTree,
+                  ULONG ulKey,
+                  void **ppvData);
+
+    void* bptFind(PBPTREE pTree,
+                  ULONG ulKey,
+                  PBPTITER pIter);
+
+    BOOL bptFirst(PBPTREE pTree,
+                  PBPTITER pIter);
+
+    BOOL bptLast(PBPTREE pTree,
+                 PBPTITER pIter);
+
+    BOOL bptNext(PBPTITER pIter);
+
+    BOOL bptPrev(PBPTITER pIter);
+
+    BOOL bptIterValid(PBPTITER pIter);
+
+    ULONG bptIterKey(PBPTITER pIter);
+
+    void* bptIterData(PBPTITER pIter);
+
+#endif
+
+#if __cplusplus
+}
+#endif
+
@@ -0,0 +1,117 @@
+
+/*
+ *@@sourcefile pmap.h:
+ *      header file for pmap.c (persistent hash maps).
+ *      See remarks there.
+ *
+ *      Note: Version numbering in this file relates to XWorkplace version
+ *            numbering.
+ *
+ *@@include #include "helpers\tree.h"
+ *@@include #include "helpers\pmap.h"
+ */
+
+/*      Copyright (C) 2026 the XWorkplace helpers authors.
+ *      This file is part of the "XWorkplace helpers" source package.
+ *      This is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published
+ *      by the Free Software Foundation, in version 2 as it comes in the
+ *      "COPYING" file of the XWorkplace main distribution.
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ */
+
+#if __cplusplus
+extern "C" {
+#endif
+
+#ifndef XWPPMAP_INCLUDED
+    #define XWPPMAP_INCLUDED
+
+    #ifndef XWPTREE_INCLUDED
+        #error helpers\tree.h must be included before helpers\pmap.h.
+    #endif
+
+    #define PMAP_OK                     0
+    #define PMAP_REPLACED               1
+    #define PMAP_NOT_FOUND              -2
+    #define PMAP_NO_MEMORY              -3
+
+    #define PMAPDIFF_ADDED              1
+    #define PMAPDIFF_REMOVED            2
+    #define PMAPDIFF_CHANGED            3
+
+    typedef ULONG TREEENTRY FNPMAP_HASH(ULONG ulKey);
+
+    typedef BOOL TREEENTRY FNPMAP_ENUM(ULONG ulKey,
+                                       void *pvData,
+                                       void *pvUser);
+
+    typedef BOOL TREEENTRY FNPMAP_DIFF(ULONG ulKey,
+                                       void *pvOldData,
+                                       void *pvNewData,
+                                       ULONG ulChange,
+                                       void *pvUser);
+
+    typedef struct _PMAPNODE *PPMAPNODE;
+
+    /*
+     *@@ PMAP:
+     *      one version of a persistent map. Initialize
+     *      with pmapInit, take snapshots with pmapCopy
+     *      and release each version with pmapClear.
+     *
+     *      See pmap.c for more on how to use these.
+     *
+     *@@added V1.0.24 (2026-10-18) [agent]
+     */
+
+    typedef struct _PMAP
+    {
+        PPMAPNODE       pRoot;          // NULL if empty; shared between versions
+        LONG            lCount;         // no. of keys in this version
+        FNPMAP_HASH     *pfnHash;       // hash func for keys
+        FNTREE_COMPARE  *pfnCompare;    // only tested for == 0
+    } PMAP, *PPMAP;
+
+    ULONG TREEENTRY pmapHashKey(ULONG ulKey);
+
+    ULONG TREEENTRY pmapHashString(ULONG ulKey);
+
+    void pmapInit(PPMAP pMap,
+                  FNPMAP_HASH *pfnHash,
+                  FNTREE_COMPARE *pfnCompare);
+
+    void pmapCopy(PPMAP pTarget,
+                  const PMAP *pSource);
+
+    void pmapClear(PPMAP pMap);
+
+    int pmapSet(PPMAP pMap,
+                ULONG ulKey,
+                void *pvData);
+
+    int pmapRemove(PPMAP pMap,
+                   ULONG ulKey);
+
+    void* pmapFind(const PMAP *pMap,
+                   ULONG ulKey,
+                   BOOL *pfFound);
+
+    BOOL pmapEnum(const PMAP *pMap,
+                  FNPMAP_ENUM *pfnEnum,
+                  void *pvUser);
+
+    BOOL pmapDiff(const PMAP *pOld,
+                  const PMAP *pNew,
+                  FNPMAP_DIFF *pfnDiff,
+                  void *pvUser);
+
+#endif
+
+#if __cplusplus
+}
+#endif
+
@@ -45,9 +45,12 @@ typedef int BOOLEAN;
 #define EREE_BAD_BACKSLASH      (ERROR_REGEXP_FIRST + 21)
 #define EREE_BAD_BACKREF        (ERROR_REGEXP_FIRST + 22)
 #define EREE_SUBS_LEN           (ERROR_REGEXP_FIRST + 23)
-#define ERROR_REGEXP_LAST       (ERROR_REGEXP_FIRST + 23)
+#define EREE_STREAM_BACKREF     (ERROR_REGEXP_FIRST + 24)
+#define EREE_BAD_UTF8           (ERROR_REGEXP_FIRST + 25)
+#define ERROR_REGEXP_LAST       (ERROR_REGEXP_FIRST + 25)
 
 #define ERECF_TOLOWER           0x01
+#define ERECF_UTF8              0x02
 
 #define EREMF_SHORTEST          0x01
 #define EREMF_ANY           0x02
@@ -62,6 +65,24 @@ typedef struct
         ERE_SPAN spans[MAX_SPANS];
     } ERE_MATCHINFO;
 
+typedef struct
+    {
+        unsigned long hits;     /* rxpCompileCached found the ERE    */
+        unsigned long misses;   /* ... and had to compile it         */
+        unsigned long evictions;/* EREs freed to stay within budget  */
+        int      n_eres;        /* EREs in the cache now             */
+        long     mem;           /* Memory they take, roughly         */
+        long     max_mem;       /* Budget (see rxpCacheLimit)        */
+    } ERE_CACHESTATS;
+
+/* Called by rxpStreamFeed and rxpStreamEnd for each match, with its position
+   in the stream, its length and its text (not null-terminated). */
+typedef void ERESTREAMFN(
+    unsigned long pos_match, int len_match,
+    const char *match,
+    void *user
+    );
+
 #ifndef ERE_C
 
 typedef void ERE;
@@ -74,6 +95,19 @@ extern ERE *rxpCompile(
 
 extern int rxpMinLen(const ERE *ere);
 
+/* As rxpCompile, but shares EREs compiled before with the same text and
+   flags. rxpFree releases them as usual. */
+extern ERE *rxpCompileCached(
+    const char *str,
+    int erecf,
+    int *rc
+    );
+
+/* Sets the memory budget of the cache, returning the previous one. */
+extern long rxpCacheLimit(long max_mem);
+
+extern void rxpCacheQuery(ERE_CACHESTATS *stats);
+
 /* Returns the number of characters in the match, starting from pos characters
    into the string to be searched. Details of sub-matches can also be returend.
    Returns -1 if no match. */
@@ -108,6 +142,45 @@ extern BOOLEAN rxpMatch_bwd(
 
 extern void rxpFree(ERE *ere);
 
+typedef void ERESCRATCH;
+
+/* Creates scratch space for matching the ERE in one thread at a time, so
+   that many threads can match the same ERE without waiting for each other. */
+extern ERESCRATCH *rxpScratchCreate(
+    const ERE *ere,
+    int *rc
+    );
+
+extern void rxpScratchFree(ERESCRATCH *scratch);
+
+/* As rxpMatch, rxpMatch_fwd and rxpMatch_bwd, with scratch space of the
+   calling thread (or NULL). */
+extern int rxpMatchEx(
+    const ERE *ere,
+    int eremf,
+    const char *str, int pos,
+    ERE_MATCHINFO *mi,      /* can be NULL */
+    ERESCRATCH *scratch     /* can be NULL */
+    );
+
+extern BOOLEAN rxpMatch_fwdEx(
+    const ERE *ere,
+    int eremf,
+    const char *str, int pos,
+    int *pos_match, int *len_match,
+    ERE_MATCHINFO *mi,      /* can be NULL */
+    ERESCRATCH *scratch     /* can be NULL */
+    );
+
+extern BOOLEAN rxpMatch_bwdEx(
+    const ERE *ere,
+    int eremf,
+    const char *str, int pos,
+    int *pos_match, int *len_match,
+    ERE_MATCHINFO *mi,      /* can be NULL */
+    ERESCRATCH *scratch     /* can be NULL */
+    );
+
 extern BOOLEAN rxpSubsWith(
     const char *str,        /* Original string searched          */
     int pos, int len,       /* Span of the entire match          */
@@ -118,6 +191,53 @@ extern BOOLEAN rxpSubsWith(
     int *rc             /* Error, if FALSE returned          */
     );
 
+typedef void ERESET;
+
+/* Compiles several EREs for matching them all in one pass. On error, returns
+   NULL and the index of the bad ERE in *bad_ere. */
+extern ERESET *rxpCompileSet(
+    const char * const *strs,
+    int n_strs,
+    int erecf,
+    int *rc,
+    int *bad_ere            /* can be NULL */
+    );
+
+/* Sets matched[i] to TRUE for each ERE i of the set that can be found
+   starting pos characters into the string. Returns the number found. */
+extern int rxpMatchSet(
+    const ERESET *set,
+    const char *str, int pos,
+    BOOLEAN *matched        /* one per ERE */
+    );
+
+extern void rxpFreeSet(ERESET *set);
+
+typedef void ERESTREAM;
+
+/* Prepares for matching an ERE without backreferences against data that is
+   passed in chunks. */
+extern ERESTREAM *rxpStreamOpen(
+    const ERE *ere,
+    int eremf,
+    int *rc
+    );
+
+/* Passes the next chunk of data, calling fn for each complete match. */
+extern int rxpStreamFeed(
+    ERESTREAM *st,
+    const char *data, int len,
+    ERESTREAMFN *fn, void *user
+    );
+
+/* Reports the remaining matches at the end of the data. */
+extern int rxpStreamEnd(
+    ERESTREAM *st,
+    ERESTREAMFN *fn, void *user
+    );
+
+extern void rxpStreamClose(ERESTREAM *st);
+
 #endif
 
 #endif
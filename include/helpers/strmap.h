@@ -0,0 +1,113 @@
+
+/*
+ *@@sourcefile strmap.h:
+ *      header file for strmap.c (open-addressing string
+ *      hash maps). See remarks there.
+ *
+ *      Note: Version numbering in this file relates to XWorkplace version
+ *            numbering.
+ *
+ *@@include #include "helpers\strmap.h"
+ */
+
+/*      Copyright (C) 2026 the XWorkplace helpers authors.
+ *      This file is part of the "XWorkplace helpers" source package.
+ *      This is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published
+ *      by the Free Software Foundation, in version 2 as it comes in the
+ *      "COPYING" file of the XWorkplace main distribution.
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ */
+
+#if __cplusplus
+extern "C" {
+#endif
+
+#ifndef XWPSTRMAP_INCLUDED
+    #define XWPSTRMAP_INCLUDED
+
+    #ifndef XWPENTRY
+        #error You must define XWPENTRY to contain the standard linkage for the XWPHelpers.
+    #endif
+
+    #include "helpers\simples.h"
+
+    #define SMAP_OK                     0
+    #define SMAP_DUPLICATE_KEY          -1
+    #define SMAP_NOT_FOUND              -2
+    #define SMAP_NO_MEMORY              -3
+
+    /*
+     *@@ STRMAPSLOT:
+     *      one slot in a STRMAP's table. ulHash is 0
+     *      for empty slots (smapHash never returns 0).
+     *
+     *@@added V1.0.24 (2026-10-18) [agent]
+     */
+
+    typedef struct _STRMAPSLOT
+    {
+        ULONG           ulHash;         // full hash of key, 0 if slot is empty
+        ULONG           ulLength;       // strlen(pcszKey)
+        const char      *pcszKey;       // key (not copied)
+        void            *pvData;        // caller's data
+    } STRMAPSLOT, *PSTRMAPSLOT;
+
+    /*
+     *@@ STRMAP:
+     *      the "root" of a string hash map. Initialize this
+     *      with smapInit and clean up with smapClear.
+     *
+     *      See strmap.c for more on how to use these.
+     *
+     *@@added V1.0.24 (2026-10-18) [agent]
+     */
+
+    typedef struct _STRMAP
+    {
+        PSTRMAPSLOT     paSlots;        // table (NULL until first insert)
+        ULONG           cSlots;         // table size (power of 2 or 0)
+        ULONG           cItems;         // no. of used slots
+    } STRMAP, *PSTRMAP;
+
+    ULONG XWPENTRY smapHash(const char *pcsz,
+                            ULONG ulLength);
+
+    void XWPENTRY smapInit(PSTRMAP pMap);
+
+    void XWPENTRY smapClear(PSTRMAP pMap);
+
+    int XWPENTRY smapInsertHash(PSTRMAP pMap,
+                                const char *pcszKey,
+                                ULONG ulLength,
+                                ULONG ulHash,
+                                void *pvData);
+
+    int XWPENTRY smapInsert(PSTRMAP pMap,
+                            const char *pcszKey,
+                            void *pvData);
+
+    void* XWPENTRY smapFindHash(const STRMAP *pMap,
+                                const char *pcszKey,
+                                ULONG ulLength,
+                                ULONG ulHash);
+
+    void* XWPENTRY smapFind(const STRMAP *pMap,
+                            const char *pcszKey);
+
+    int XWPENTRY smapRemove(PSTRMAP pMap,
+                            const char *pcszKey,
+                            void **ppvData);
+
+    PSTRMAPSLOT XWPENTRY smapEnum(const STRMAP *pMap,
+                                  PULONG pulIndex);
+
+#endif
+
+#if __cplusplus
+}
+#endif
+
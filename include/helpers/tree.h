@@ -33,6 +33,15 @@ extern "C" {
      +      } MYTREENODE, *PMYTREENODE;
      *
      *      See tree.c for an introduction to the tree functions.
+     *
+     *      If __TREE_ORDER_STATISTICS__ is defined, each node
+     *      additionally caches the size of its subtree, which
+     *      enables treeSelect, treeRank and treeCountRange.
+     *      Since this changes the structure layout, all code
+     *      which shares trees must be compiled with the same
+     *      setting.
+     *
+     *@@changed V1.0.24 (2026-10-18) [agent]: added ulSize
      */
 
     typedef struct _TREE
@@ -44,6 +53,12 @@ extern "C" {
 
         ULONG           ulKey;          // the node's key (data)
 
+    #ifdef __TREE_ORDER_STATISTICS__
+        ULONG           ulSize;         // no. of nodes in this subtree,
+                                        // including this one; maintained
+                                        // by the tree functions
+    #endif
+
     } TREE, *PTREE;
 
     #if defined(__IBMC__) || defined(__IBMCPP__)
@@ -91,6 +106,24 @@ extern "C" {
     TREE** treeBuildArray(TREE* pRoot,
                           PLONG plCount);
 
+    int treeBuildFromSorted(TREE **root,
+                            TREE **apNodes,
+                            ULONG c);
+
+    #ifdef __TREE_ORDER_STATISTICS__
+        TREE* treeSelect(TREE *root,
+                         ULONG ulIndex);
+
+        ULONG treeRank(TREE *root,
+                       ULONG key,
+                       FNTREE_COMPARE *pfnCompare);
+
+        ULONG treeCountRange(TREE *root,
+                             ULONG keyLo,
+                             ULONG keyHi,
+                             FNTREE_COMPARE *pfnCompare);
+    #endif
+
 #endif
 
 #if __cplusplus
@@ -10,6 +10,7 @@
  *@@include #include "expat\expat.h"                // must come before xml.h
  *@@include #include "helpers\linklist.h"
  *@@include #include "helpers\tree.h"
+ *@@include #include "helpers\strmap.h"
  *@@include #include "helpers\xstring.h"
  *@@include #include "helpers\xml.h"
  */
@@ -94,7 +95,18 @@ extern "C" {
 
     #define ERROR_DOM_INVALID_EXTERNAL_HANDLER (ERROR_XML_FIRST + 48)
 
-    #define ERROR_XML_LAST                  (ERROR_XML_FIRST + 48)
+    #define ERROR_DOM_INVALID_PATH (ERROR_XML_FIRST + 49)
+                // xmlCompilePath V1.0.24 (2026-10-18) [agent]
+
+    #define ERROR_DOM_INCOMPLETE_CONTENT (ERROR_XML_FIRST + 50)
+                // invalidity: element ends before its content model
+                // is complete V1.0.24 (2026-10-18) [agent]
+
+    #define ERROR_DOM_INVALID_SNAPSHOT (ERROR_XML_FIRST + 51)
+                // xmlLoadBinary: file is not a binary DOM snapshot
+                // or is damaged V1.0.24 (2026-10-18) [agent]
+
+    #define ERROR_XML_LAST                  (ERROR_XML_FIRST + 51)
 
     const char* xmlDescribeError(int code);
 
@@ -213,7 +225,7 @@ extern "C" {
      *
      *      Overview of member fields usage:
      +
-     +      ulNodeType    | strNodeName | strNodeValue | llChildren | AttributesMap
+     +      ulNodeType    | strNodeName | strNodeValue | children   | AttributesMap
      +      (NODEBASE)    | (NODEBASE)  | (DOMNODE)    | (DOMNODE)  | (DOMNODE)
      +      =======================================================================
      +                    |             |              |            |
@@ -260,6 +272,26 @@ extern "C" {
      *      "#document", "#text", and "#comment" strings for DOCUMENT,
      *      TEXT, and COMMENT nodes, respectively. I see no point in this other
      *      than consuming memory, so these fields are empty with this implementation.
+     *
+     *      The children of a node are linked through the node
+     *      themselves: start with pFirstChild and follow the
+     *      pNextSibling pointers, or use xmlGetFirstChild and
+     *      xmlGetNextSibling. Up to V1.0.24, there was a LINKLIST
+     *      of children instead.
+     *
+     *      Element, attribute and PI names are interned: strNodeName
+     *      of such a node points to the single copy of the name in
+     *      the document's SymbolsMap, so nodes of the same document
+     *      have equal names exactly if strNodeName.psz is the same
+     *      pointer. Never modify or free these names.
+     *
+     *      If the DOM was parsed with DF_ARENA, all nodes except
+     *      the DOCUMENT and DOCTYPE nodes, their names and their
+     *      values live in the document's arena. Do not modify
+     *      the strings of such nodes; see xmlCreateDOM.
+     *
+     *@@changed V1.0.24 (2026-10-18) [agent]: replaced llChildren with intrusive child and sibling links
+     *@@changed V1.0.24 (2026-10-18) [agent]: names are now interned
      */
 
     typedef struct _DOMNODE
@@ -280,7 +312,10 @@ extern "C" {
         struct _DOMNODE *pDocumentNode;
                         // the document node, unless this is a DOCUMENT in itself.
 
-        LINKLIST        llChildren;     // of DOMNODE* pointers, no auto-free
+        struct _DOMNODE *pFirstChild,   // first child node or NULL
+                        *pLastChild,    // last child node or NULL
+                        *pNextSibling;  // next child node of pParentNode or NULL;
+                                        // always NULL for attributes
 
         TREE            *AttributesMap; // of DOMNODE* pointers
 
@@ -293,7 +328,7 @@ extern "C" {
      *
      *      The DOMDOCTYPENODE is special (other than having
      *      extra fields) in that it is stored both in
-     *      the document node's children list and in its
+     *      the document node's children and in its
      *      pDocType field.
      *
      *      DOMNODE.pstrNodeName is set to the name in the
@@ -312,11 +347,14 @@ extern "C" {
 
         BOOL        fHasInternalSubset;
 
-        TREE        *ElementDeclsTree;
-                    // tree with pointers to _CMELEMENTDECLNODE nodes
+        STRMAP      ElementDeclsMap;
+                    // hash map of _CMELEMENTDECLNODE nodes by element name
+                    // (was a tree before V1.0.24); note that smapEnum
+                    // goes through it in hash order, not sorted by name
 
-        TREE        *AttribDeclBasesTree;
-                    // tree with pointers to _CMATTRIBUTEDECLBASE nodes
+        STRMAP      AttribDeclBasesMap;
+                    // hash map of _CMATTRIBUTEDECLBASE nodes by element name
+                    // (was a tree before V1.0.24; in hash order too)
 
     } DOMDOCTYPENODE, *PDOMDOCTYPENODE;
 
@@ -326,6 +364,9 @@ extern "C" {
      *      is used for DOCUMENT nodes.
      *
      *@@added V0.9.9 (2001-02-14) [umoeller]
+     *@@changed V1.0.24 (2026-10-18) [agent]: added pArena
+     *@@changed V1.0.24 (2026-10-18) [agent]: added SymbolsMap
+     *@@changed V1.0.24 (2026-10-18) [agent]: added fNameIndex
      */
 
     typedef struct _DOMDOCUMENTNODE
@@ -335,6 +376,19 @@ extern "C" {
         PDOMDOCTYPENODE     pDocType;
                         // != NULL if DOCTYPE was found
 
+        struct _DOMARENA    *pArena;
+                        // != NULL if the nodes were allocated from
+                        // an arena (DF_ARENA); private to xml.c
+
+        STRMAP              SymbolsMap;
+                        // symbol table with the names of all element,
+                        // attribute and PI nodes in the document, of
+                        // DOMSYMBOL's; private to xml.c
+
+        BOOL                fNameIndex;
+                        // TRUE if the symbols have the name index
+                        // for xmlSelectNodes; private to xml.c
+
     } DOMDOCUMENTNODE, *PDOMDOCUMENTNODE;
 
     APIRET xmlCreateDomNode(PDOMNODE pParentNode,
@@ -484,6 +538,7 @@ extern "C" {
      *            element may have both sub-elements and PCDATA. Oh my.
      *
      *@@added V0.9.9 (2001-02-14) [umoeller]
+     *@@changed V1.0.24 (2026-10-18) [agent]: added pDFA
      */
 
     typedef struct _CMELEMENTDECLNODE
@@ -500,6 +555,11 @@ extern "C" {
                     // checking if an element name is allowed as a sub-element
                     // at all. Tree items are _CMELEMENTPARTICLE nodes.
 
+        struct _CMCONTENTDFA *pDFA;
+                    // for CHOICE and SEQ declarations, the content model
+                    // compiled into an automaton by xmlCreateElementDecl,
+                    // or NULL if the model was too large; private to xml.c
+
     } CMELEMENTDECLNODE, *PCMELEMENTDECLNODE;
 
     typedef enum _ATTRIBCONSTRAINT
@@ -585,8 +645,11 @@ extern "C" {
         NODEBASE        NodeBase;         // has TREE* as first item in turn
                     // NodeBase.strName is element name
 
-        TREE            *AttribDeclsTree;
-                            // root of tree with CMATTRIBUTEDECL;
+        STRMAP          AttribDeclsMap;
+                            // hash map of CMATTRIBUTEDECL by attribute name
+                            // (was a tree before V1.0.24; in hash order, so
+                            // validation reports missing attributes in that
+                            // order too)
 
     } CMATTRIBUTEDECLBASE, *PCMATTRIBUTEDECLBASE;
 
@@ -628,6 +691,9 @@ extern "C" {
 
     typedef struct _XMLDOM *PXMLDOM;
 
+    typedef struct _XMLDTD *PXMLDTD;
+                // compiled DTD from xmlCreateDTD; private to xml.c
+
     typedef int APIENTRY FNGETCPDATA(PXMLDOM pDom, ULONG ulCP, int *piMap);
     typedef FNGETCPDATA *PFNGETCPDATA;
 
@@ -668,11 +734,48 @@ extern "C" {
 
     } STATICSYSTEMID, *PSTATICSYSTEMID;
 
+    typedef APIRET APIENTRY FNSAXSTARTELEMENT(PXMLDOM pDom,
+                                              const char *pcszElement,
+                                              const char **papcszAttribs);
+    typedef FNSAXSTARTELEMENT *PFNSAXSTARTELEMENT;
+
+    typedef APIRET APIENTRY FNSAXENDELEMENT(PXMLDOM pDom,
+                                            const char *pcszElement);
+    typedef FNSAXENDELEMENT *PFNSAXENDELEMENT;
+
+    typedef APIRET APIENTRY FNSAXCHARACTERDATA(PXMLDOM pDom,
+                                               const char *pcch,
+                                               ULONG cch);
+    typedef FNSAXCHARACTERDATA *PFNSAXCHARACTERDATA;
+
+    typedef APIRET APIENTRY FNSAXCOMMENT(PXMLDOM pDom,
+                                         const char *pcszComment);
+    typedef FNSAXCOMMENT *PFNSAXCOMMENT;
+
+    /*
+     *@@ XMLSAXHANDLERS:
+     *      event callbacks for xmlCreateSAX. Any of these
+     *      can be NULL. See xmlCreateSAX for details.
+     *
+     *@@added V1.0.24 (2026-10-18) [agent]
+     */
+
+    typedef struct _XMLSAXHANDLERS
+    {
+        PFNSAXSTARTELEMENT  pfnStartElement;
+        PFNSAXENDELEMENT    pfnEndElement;
+        PFNSAXCHARACTERDATA pfnCharacterData;
+        PFNSAXCOMMENT       pfnComment;     // only with DF_PARSECOMMENTS
+    } XMLSAXHANDLERS, *PXMLSAXHANDLERS;
+
     /*
      *@@ XMLDOM:
-     *      DOM instance returned by xmlCreateDOM.
+     *      DOM instance returned by xmlCreateDOM or xmlCreateSAX.
      *
      *@@added V0.9.9 (2001-02-14) [umoeller]
+     *@@changed V1.0.24 (2026-10-18) [agent]: added SaxHandlers
+     *@@changed V1.0.24 (2026-10-18) [agent]: replaced pLastWasTextNode with strText
+     *@@changed V1.0.24 (2026-10-18) [agent]: added pDTD and pSharedDocType
      */
 
     typedef struct _XMLDOM
@@ -722,17 +825,33 @@ extern "C" {
                             // stack for maintaining the current items;
                             // these point to DOMSTACKITEMs (auto-free)
 
-        PDOMNODE        pLastWasTextNode;
+        XSTRING         strText;
+                            // character data collected by CharacterDataHandler
+                            // for the next text node (replaced pLastWasTextNode
+                            // with V1.0.24)
 
         PCMATTRIBUTEDECLBASE pAttListDeclCache;
                             // cache for attribute declarations according
                             // to attdecl element name
+
+        XMLSAXHANDLERS  SaxHandlers;
+                            // copied from xmlCreateSAX; all NULL with
+                            // xmlCreateDOM
+
+        PXMLDTD         pDTD;
+                            // shared DTD from xmlSetDTD or NULL
+
+        PDOMDOCTYPENODE pSharedDocType;
+                            // pDTD's declarations if the document
+                            // uses them (see ExternalEntityRefHandler),
+                            // NULL otherwise
     } XMLDOM;
 
     #define DF_PARSECOMMENTS        0x0001
     #define DF_PARSEDTD             0x0002
     #define DF_FAIL_IF_NO_DTD       0x0004
     #define DF_DROP_WHITESPACE      0x0008
+    #define DF_ARENA                0x0010
 
     APIRET xmlCreateDOM(ULONG flParserFlags,
                         const STATICSYSTEMID *paSystemIds,
@@ -742,6 +861,15 @@ extern "C" {
                         PVOID pvCallbackUser,
                         PXMLDOM *ppDom);
 
+    APIRET xmlCreateSAX(ULONG flParserFlags,
+                        const XMLSAXHANDLERS *pHandlers,
+                        const STATICSYSTEMID *paSystemIds,
+                        ULONG cSystemIds,
+                        PFNGETCPDATA pfnGetCPData,
+                        PFNEXTERNALHANDLER pfnExternalHandler,
+                        PVOID pvCallbackUser,
+                        PXMLDOM *ppDom);
+
     APIRET xmlParse(PXMLDOM pDom,
                     const char *pcszBuf,
                     ULONG cb,
@@ -751,6 +879,64 @@ extern "C" {
 
     APIRET xmlFreeDOM(PXMLDOM pDom);
 
+    /* ******************************************************************
+     *
+     *   Shared DTDs and batch parsing
+     *
+     ********************************************************************/
+
+    APIRET xmlCreateDTD(const char *pcszSystemId,
+                        const char *pcszContent,
+                        PXMLDTD *ppDTD);
+
+    VOID xmlFreeDTD(PXMLDTD pDTD);
+
+    APIRET xmlSetDTD(PXMLDOM pDom,
+                     PXMLDTD pDTD);
+
+    /*
+     *@@ XMLBATCHFILE:
+     *      one file for xmlParseFiles.
+     *
+     *@@added V1.0.24 (2026-10-18) [agent]
+     */
+
+    typedef struct _XMLBATCHFILE
+    {
+        PCSZ            pcszFilename;
+                            // in: file to parse
+        PXMLDOM         pDom;
+                            // out: DOM for the file, also on errors so
+                            // the error info can be looked at; NULL only
+                            // if it couldn't be created. Free with xmlFreeDOM.
+        APIRET          arc;
+                            // out: error code for the file
+    } XMLBATCHFILE, *PXMLBATCHFILE;
+
+    #define XML_MAX_BATCH_THREADS   32
+
+    APIRET xmlParseFiles(PXMLBATCHFILE paFiles,
+                         ULONG cFiles,
+                         ULONG flParserFlags,
+                         PXMLDTD pDTD,
+                         PFNGETCPDATA pfnGetCPData,
+                         PVOID pvCallbackUser,
+                         ULONG cThreads);
+
+    /* ******************************************************************
+     *
+     *   Binary DOM snapshots
+     *
+     ********************************************************************/
+
+    APIRET xmlSaveBinary(PDOMDOCUMENTNODE pDocument,
+                         PCSZ pcszFilename,
+                         PCSZ pcszSourceFile);
+
+    APIRET xmlLoadBinary(PXMLDOM pDom,
+                         PCSZ pcszFilename,
+                         PCSZ pcszSourceFile);
+
     /* ******************************************************************
      *
      *   DOM lookup
@@ -774,6 +960,8 @@ extern "C" {
 
     PDOMNODE xmlGetLastChild(PDOMNODE pDomNode);
 
+    PDOMNODE xmlGetNextSibling(PDOMNODE pDomNode);
+
     PDOMNODE xmlGetFirstText(PDOMNODE pElement);
 
     PLINKLIST xmlGetElementsByTagName(PDOMNODE pParent,
@@ -782,6 +970,26 @@ extern "C" {
     const XSTRING* xmlGetAttribute(PDOMNODE pElement,
                                    const char *pcszAttribName);
 
+    /* ******************************************************************
+     *
+     *   DOM queries
+     *
+     ********************************************************************/
+
+    typedef struct _XMLPATH *PXMLPATH;
+                // compiled path; private to xml.c
+
+    APIRET xmlCompilePath(const char *pcszPath,
+                          PXMLPATH *ppPath);
+
+    VOID xmlFreePath(PXMLPATH pPath);
+
+    PLINKLIST xmlSelectNodes(PDOMNODE pContext,
+                             const struct _XMLPATH *pPath);
+
+    PDOMNODE xmlSelectSingleNode(PDOMNODE pContext,
+                                 const struct _XMLPATH *pPath);
+
     /* ******************************************************************
      *
      *   DOM build
@@ -796,6 +1004,21 @@ extern "C" {
                             const char *pcszEncoding,
                             const char *pcszDoctype,
                             PXSTRING pxstr);
+
+    typedef APIRET APIENTRY FNXMLWRITE(PVOID pvUser,
+                                       const char *pcch,
+                                       ULONG cch);
+    typedef FNXMLWRITE *PFNXMLWRITE;
+
+    APIRET xmlWriteDocumentToSink(PDOMDOCUMENTNODE pDocument,
+                                  const char *pcszEncoding,
+                                  const char *pcszDoctype,
+                                  PFNXMLWRITE pfnWrite,
+                                  PVOID pvUser);
+
+    APIRET APIENTRY xmlWriteFileSink(PVOID pvUser,
+                                     const char *pcch,
+                                     ULONG cch);
 #endif
 
 #if __cplusplus
@@ -0,0 +1,395 @@
+
+/*
+ *      Test for bptree.c. Inserts, deletes and finds random keys
+ *      and compares the tree with a plain array of the keys that
+ *      should be in it, with a data pointer for each.
+ *
+ *      With the default of 20000 keys and BPT_MAXKEYS keys per
+ *      node, the tree grows to three or four levels, so splits,
+ *      borrowing from siblings and merges happen on internal
+ *      nodes as well as on leafs. The random part runs in phases
+ *      which mostly insert or mostly delete, so that the tree
+ *      grows and shrinks by several levels. Before that, keys
+ *      are inserted and then deleted in ascending and descending
+ *      order, which always splits and merges at the same end of
+ *      the tree.
+ *
+ *      Every so often and after every phase, the whole tree is
+ *      walked with bptFirst and bptNext and backwards with bptLast
+ *      and bptPrev, and a few walks start at keys found with
+ *      bptFind, so that the leaf links are checked after deletes.
+ *
+ *      Usage: _test_bptree [keys [operations [seed]]]
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "setup.h"                      // code generation and debugging options
+
+#include "helpers\tree.h"
+#include "helpers\bptree.h"
+
+#pragma hdrstop
+
+#define MAX_REPORTS         20
+#define WALK_EVERY          97          // operations between full walks
+#define MANY_KEYS           1000        // far more than fit into one node
+
+unsigned long   G_cChecks = 0,
+                G_cFailures = 0;
+
+ULONG           *G_paulData;            // data for key n is &G_paulData[n]
+
+/*
+ *@@ Fail:
+ *      counts a failure and reports it, unless there
+ *      have been too many already.
+ */
+
+VOID Fail(const char *pcszWhat,
+          const char *pcszError)
+{
+    if (++G_cFailures <= MAX_REPORTS)
+        printf("%s: %s\n", pcszWhat, pcszError);
+}
+
+/*
+ *@@ CheckFind:
+ *      checks bptFind for ulKey against afPresent.
+ */
+
+VOID CheckFind(PBPTREE pTree,
+               const BOOL *afPresent,
+               ULONG ulKey,
+               const char *pcszWhat)
+{
+    BPTITER Iter;
+    void    *pv = bptFind(pTree, ulKey, &Iter);
+
+    G_cChecks++;
+    if (afPresent[ulKey])
+    {
+        if (pv != &G_paulData[ulKey])
+            Fail(pcszWhat, "bptFind does not find a key");
+        else if (    (!bptIterValid(&Iter))
+                  || (bptIterKey(&Iter) != ulKey)
+                  || (bptIterData(&Iter) != pv)
+                )
+            Fail(pcszWhat, "bptFind returns a bad iterator");
+    }
+    else if (pv)
+        Fail(pcszWhat, "bptFind finds a missing key");
+    else if (bptIterValid(&Iter))
+        Fail(pcszWhat, "bptFind returns a valid iterator for a missing key");
+}
+
+/*
+ *@@ CheckWalk:
+ *      walks the whole tree forwards and backwards and
+ *      compares every key and data pointer with afPresent.
+ *      Then walks a few steps both ways from some keys
+ *      found with bptFind.
+ */
+
+VOID CheckWalk(PBPTREE pTree,
+               const BOOL *afPresent,
+               ULONG cKeys,
+               const char *pcszWhat)
+{
+    BPTITER Iter;
+    BOOL    fValid;
+    ULONG   ul,
+            cPresent = 0;
+
+    G_cChecks++;
+
+    for (ul = 0; ul < cKeys; ul++)
+        if (afPresent[ul])
+            cPresent++;
+    if (pTree->lCount != (LONG)cPresent)
+    {
+        Fail(pcszWhat, "wrong item count");
+        return;
+    }
+
+    fValid = bptFirst(pTree, &Iter);
+    for (ul = 0; ul < cKeys; ul++)
+        if (afPresent[ul])
+        {
+            if (    (!fValid)
+                 || (bptIterKey(&Iter) != ul)
+                 || (bptIterData(&Iter) != &G_paulData[ul])
+               )
+            {
+                Fail(pcszWhat, "bptNext does not match");
+                return;
+            }
+            fValid = bptNext(&Iter);
+        }
+    if (fValid)
+    {
+        Fail(pcszWhat, "bptNext returns too many keys");
+        return;
+    }
+
+    fValid = bptLast(pTree, &Iter);
+    for (ul = cKeys; ul > 0; ul--)
+        if (afPresent[ul - 1])
+        {
+            if (    (!fValid)
+                 || (bptIterKey(&Iter) != ul - 1)
+                 || (bptIterData(&Iter) != &G_paulData[ul - 1])
+               )
+            {
+                Fail(pcszWhat, "bptPrev does not match");
+                return;
+            }
+            fValid = bptPrev(&Iter);
+        }
+    if (fValid)
+    {
+        Fail(pcszWhat, "bptPrev returns too many keys");
+        return;
+    }
+
+    // walk a bit in both directions from a few keys
+    for (ul = 0; ul < 10 && cPresent; ul++)
+    {
+        ULONG   ulKey = rand() % cKeys,
+                ulNext,
+                ulPrev,
+                c;
+
+        if (!bptFind(pTree, ulKey, &Iter))
+            continue;
+
+        for (c = 0, ulNext = ulKey; c < 40 && bptNext(&Iter); c++)
+        {
+            while (    (++ulNext < cKeys)
+                    && (!afPresent[ulNext])
+                  )
+                ;
+            if (    (ulNext >= cKeys)
+                 || (bptIterKey(&Iter) != ulNext)
+               )
+            {
+                Fail(pcszWhat, "bptNext after bptFind does not match");
+                return;
+            }
+        }
+        if (c < 40)
+        {
+            // must have reached the end
+            while (++ulNext < cKeys)
+                if (afPresent[ulNext])
+                {
+                    Fail(pcszWhat, "bptNext after bptFind stops early");
+                    return;
+                }
+        }
+
+        bptFind(pTree, ulKey, &Iter);
+        for (c = 0, ulPrev = ulKey; c < 40 && bptPrev(&Iter); c++)
+        {
+            while (    (ulPrev)
+                    && (!afPresent[--ulPrev])
+                  )
+                ;
+            if (    (!afPresent[ulPrev])
+                 || (bptIterKey(&Iter) != ulPrev)
+               )
+            {
+                Fail(pcszWhat, "bptPrev after bptFind does not match");
+                return;
+            }
+        }
+    }
+}
+
+/*
+ *@@ Insert:
+ *      inserts ulKey and updates afPresent, or checks
+ *      that it is refused if it is there already.
+ */
+
+VOID Insert(PBPTREE pTree,
+            BOOL *afPresent,
+            ULONG ulKey,
+            const char *pcszWhat)
+{
+    BPTITER Iter;
+    int     rc;
+
+    // any modification must invalidate iterators
+    bptFirst(pTree, &Iter);
+
+    rc = bptInsert(pTree, ulKey, &G_paulData[ulKey]);
+    if (afPresent[ulKey])
+    {
+        if (rc != STATUS_DUPLICATE_KEY)
+            Fail(pcszWhat, "duplicate key not refused");
+    }
+    else if (rc)
+        Fail(pcszWhat, "bptInsert failed");
+    else
+    {
+        afPresent[ulKey] = TRUE;
+        if (bptIterValid(&Iter))
+            Fail(pcszWhat, "iterator still valid after bptInsert");
+    }
+}
+
+/*
+ *@@ Delete:
+ *      deletes ulKey and updates afPresent, or checks
+ *      that it is refused if it is not there.
+ */
+
+VOID Delete(PBPTREE pTree,
+            BOOL *afPresent,
+            ULONG ulKey,
+            const char *pcszWhat)
+{
+    BPTITER Iter;
+    void    *pv = NULL;
+    int     rc;
+
+    bptFirst(pTree, &Iter);
+
+    rc = bptDelete(pTree, ulKey, &pv);
+    if (!afPresent[ulKey])
+    {
+        if (rc != STATUS_INVALID_NODE)
+            Fail(pcszWhat, "deleting a missing key not refused");
+    }
+    else if (rc)
+        Fail(pcszWhat, "bptDelete failed");
+    else if (pv != &G_paulData[ulKey])
+        Fail(pcszWhat, "bptDelete returns the wrong data");
+    else
+    {
+        afPresent[ulKey] = FALSE;
+        if (bptIterValid(&Iter))
+            Fail(pcszWhat, "iterator still valid after bptDelete");
+    }
+}
+
+/*
+ *@@ CheckLevels:
+ *      checks that the tree has more than one level
+ *      when it has many keys, or the test would miss
+ *      all the internal node code.
+ */
+
+VOID CheckLevels(PBPTREE pTree,
+                 const char *pcszWhat)
+{
+    if (    (pTree->lCount > MANY_KEYS)
+         && (pTree->pRoot == pTree->pFirstLeaf)
+       )
+        Fail(pcszWhat, "tree has only one level");
+}
+
+int main(int argc, char *argv[])
+{
+    ULONG   cKeys = 20000,
+            cOps = 400000,
+            ul;
+    BOOL    *afPresent;
+    BPTREE  Tree;
+
+    if (argc > 1)
+        cKeys = strtoul(argv[1], NULL, 10);
+    if (argc > 2)
+        cOps = strtoul(argv[2], NULL, 10);
+    srand((argc > 3) ? atoi(argv[3]) : 1);
+
+    if (    (!cKeys)
+         || (!(afPresent = (BOOL*)calloc(cKeys, sizeof(BOOL))))
+         || (!(G_paulData = (ULONG*)calloc(cKeys, sizeof(ULONG))))
+       )
+        return 2;
+
+    bptInit(&Tree, treeCompareKeys);
+    CheckWalk(&Tree, afPresent, cKeys, "empty tree");
+    CheckFind(&Tree, afPresent, 0, "empty tree");
+
+    // ascending, then deleting ascending
+    for (ul = 0; ul < cKeys; ul++)
+        Insert(&Tree, afPresent, ul, "ascending insert");
+    CheckLevels(&Tree, "ascending insert");
+    CheckWalk(&Tree, afPresent, cKeys, "ascending insert");
+    for (ul = 0; ul < cKeys; ul++)
+    {
+        Delete(&Tree, afPresent, ul, "ascending delete");
+        if (ul % WALK_EVERY == 0)
+            CheckWalk(&Tree, afPresent, cKeys, "ascending delete");
+    }
+    CheckWalk(&Tree, afPresent, cKeys, "ascending delete");
+
+    // descending, then deleting descending
+    for (ul = cKeys; ul > 0; ul--)
+        Insert(&Tree, afPresent, ul - 1, "descending insert");
+    CheckLevels(&Tree, "descending insert");
+    CheckWalk(&Tree, afPresent, cKeys, "descending insert");
+    for (ul = cKeys; ul > 0; ul--)
+    {
+        Delete(&Tree, afPresent, ul - 1, "descending delete");
+        if (ul % WALK_EVERY == 0)
+            CheckWalk(&Tree, afPresent, cKeys, "descending delete");
+    }
+    CheckWalk(&Tree, afPresent, cKeys, "descending delete");
+
+    // random, in phases of mostly inserting and mostly deleting
+    for (ul = 0; ul < cOps; ul++)
+    {
+        ULONG   ulPhase = ul / (cKeys * 2);
+        int     iInsertPercent = (ulPhase & 1) ? 20 : 80;
+        ULONG   ulKey = rand() % cKeys;
+        char    szWhat[100];
+
+        sprintf(szWhat, "random operation %lu on key %lu", ul, ulKey);
+
+        switch (rand() % 4)
+        {
+            case 0:
+                CheckFind(&Tree, afPresent, ulKey, szWhat);
+            break;
+
+            default:
+                if (rand() % 100 < iInsertPercent)
+                    Insert(&Tree, afPresent, ulKey, szWhat);
+                else
+                    Delete(&Tree, afPresent, ulKey, szWhat);
+                CheckFind(&Tree, afPresent, ulKey, szWhat);
+        }
+
+        if (    (ul % WALK_EVERY == 0)
+             || ((ul + 1) % (cKeys * 2) == 0)
+           )
+        {
+            if (    (!(ulPhase & 1))
+                 && ((ul + 1) % (cKeys * 2) == 0)
+               )
+                CheckLevels(&Tree, szWhat);
+            CheckWalk(&Tree, afPresent, cKeys, szWhat);
+        }
+    }
+
+    bptClear(&Tree);
+    memset(afPresent, 0, cKeys * sizeof(BOOL));
+    CheckWalk(&Tree, afPresent, cKeys, "bptClear");
+
+    printf("%lu keys, %lu operations, %lu checks, %lu failures\n",
+           cKeys,
+           cOps,
+           G_cChecks,
+           G_cFailures);
+
+    free(G_paulData);
+    free(afPresent);
+
+    return (G_cFailures) ? 1 : 0;
+}
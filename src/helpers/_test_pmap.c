@@ -0,0 +1,455 @@
+
+/*
+ *      Test for pmap.c. Sets and removes random keys in a map and
+ *      keeps a plain array of what each key should map to. Every
+ *      so often, a snapshot of the map is taken with pmapCopy,
+ *      together with a copy of the array.
+ *
+ *      The snapshots must not change when the map is modified
+ *      afterwards, so each one is checked against its array with
+ *      pmapFind and pmapEnum before it is dropped, and pmapDiff
+ *      between the map and every snapshot, and between two
+ *      snapshots, is compared with the difference of the arrays.
+ *      The phases alternate between mostly setting and mostly
+ *      removing keys, so that nodes are collapsed and pulled up
+ *      until the map is empty again.
+ *
+ *      All this runs three times: with pmapHashKey; with a hash
+ *      that gives groups of eight keys exactly the same hash, so
+ *      that they end up in collision nodes; and with one that
+ *      gives such groups the same lower 25 bits, so that they
+ *      share a path of five nodes before they are told apart.
+ *
+ *      Build this with a leak checker if possible, since all
+ *      maps are cleared at the end and the reference counts
+ *      must then have freed every node.
+ *
+ *      Usage: _test_pmap [keys [operations [seed]]]
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "setup.h"                      // code generation and debugging options
+
+#include "helpers\tree.h"
+#include "helpers\pmap.h"
+
+#pragma hdrstop
+
+#define MAX_REPORTS         20
+#define SNAPSHOTS           8
+#define SNAPSHOT_EVERY      211         // operations between snapshots
+#define VALUES              3           // data pointers per key
+
+/*
+ *      The data for a key is &G_abData[value], with
+ *      value from 1 to VALUES; the arrays have 0 for
+ *      keys which are not in the map. With so few
+ *      values, pmapSet often stores the same pointer
+ *      again, which pmapDiff must not report.
+ */
+
+unsigned char   G_abData[VALUES + 1];
+
+typedef struct _SNAPSHOT
+{
+    PMAP            Map;
+    unsigned char   *pabValues;         // what the map should contain
+    BOOL            fUsed;
+} SNAPSHOT, *PSNAPSHOT;
+
+typedef struct _DIFFCHECK
+{
+    const unsigned char *pabOld,
+                        *pabNew;
+    unsigned char       *pabReported;   // keys reported so far
+    ULONG               cKeys;
+    const char          *pcszError;
+} DIFFCHECK, *PDIFFCHECK;
+
+unsigned long   G_cChecks = 0,
+                G_cFailures = 0;
+
+ULONG           G_cKeys;
+
+/*
+ *@@ HashCollide:
+ *      gives groups of eight keys the same hash.
+ */
+
+ULONG TREEENTRY HashCollide(ULONG ulKey)
+{
+    return pmapHashKey(ulKey / 8);
+}
+
+/*
+ *@@ HashDeep:
+ *      gives groups of eight keys the same lower
+ *      25 bits, but different upper bits.
+ */
+
+ULONG TREEENTRY HashDeep(ULONG ulKey)
+{
+    return (pmapHashKey(ulKey / 8) & 0x01FFFFFFUL) | ((ulKey % 8) << 25);
+}
+
+/*
+ *@@ Fail:
+ *      counts a failure and reports it, unless there
+ *      have been too many already.
+ */
+
+VOID Fail(const char *pcszWhat,
+          const char *pcszError)
+{
+    if (++G_cFailures <= MAX_REPORTS)
+        printf("%s: %s\n", pcszWhat, pcszError);
+}
+
+/*
+ *@@ EnumCheck:
+ *      FNPMAP_ENUM for CheckMap. pvUser points to a copy
+ *      of the array, in which every key found is set to 0,
+ *      or to 0xFF if the data doesn't match.
+ */
+
+BOOL TREEENTRY EnumCheck(ULONG ulKey,
+                         void *pvData,
+                         void *pvUser)
+{
+    unsigned char *pabLeft = (unsigned char*)pvUser;
+
+    if (    (ulKey >= G_cKeys)
+         || (!pabLeft[ulKey])
+         || (pvData != &G_abData[pabLeft[ulKey]])
+       )
+    {
+        // unknown, enumerated twice or wrong data
+        if (ulKey < G_cKeys)
+            pabLeft[ulKey] = 0xFF;
+        return FALSE;
+    }
+
+    pabLeft[ulKey] = 0;
+    return TRUE;
+}
+
+/*
+ *@@ CheckMap:
+ *      compares the map with pabValues, with pmapFind for
+ *      every key and with pmapEnum.
+ */
+
+VOID CheckMap(const PMAP *pMap,
+              const unsigned char *pabValues,
+              const char *pcszWhat)
+{
+    unsigned char   *pabLeft;
+    ULONG           ul,
+                    cPresent = 0;
+
+    G_cChecks++;
+
+    for (ul = 0; ul < G_cKeys; ul++)
+    {
+        BOOL    fFound;
+        void    *pv = pmapFind(pMap, ul, &fFound);
+
+        if (pabValues[ul])
+        {
+            cPresent++;
+            if (    (!fFound)
+                 || (pv != &G_abData[pabValues[ul]])
+               )
+            {
+                Fail(pcszWhat, "pmapFind does not find a key");
+                return;
+            }
+        }
+        else if (fFound || pv)
+        {
+            Fail(pcszWhat, "pmapFind finds a missing key");
+            return;
+        }
+    }
+
+    if (pMap->lCount != (LONG)cPresent)
+    {
+        Fail(pcszWhat, "wrong item count");
+        return;
+    }
+
+    if (!(pabLeft = (unsigned char*)malloc(G_cKeys)))
+        exit(2);
+    memcpy(pabLeft, pabValues, G_cKeys);
+    if (!pmapEnum(pMap, EnumCheck, pabLeft))
+        Fail(pcszWhat, "pmapEnum returns a bad item");
+    else
+        for (ul = 0; ul < G_cKeys; ul++)
+            if (pabLeft[ul])
+            {
+                Fail(pcszWhat, "pmapEnum misses an item");
+                break;
+            }
+    free(pabLeft);
+}
+
+/*
+ *@@ DiffCheck:
+ *      FNPMAP_DIFF for CheckDiff. Checks every reported
+ *      change against the two arrays.
+ */
+
+BOOL TREEENTRY DiffCheck(ULONG ulKey,
+                         void *pvOldData,
+                         void *pvNewData,
+                         ULONG ulChange,
+                         void *pvUser)
+{
+    PDIFFCHECK      pCheck = (PDIFFCHECK)pvUser;
+    unsigned char   bOld,
+                    bNew;
+
+    if (ulKey >= pCheck->cKeys)
+    {
+        pCheck->pcszError = "pmapDiff reports an unknown key";
+        return FALSE;
+    }
+    if (pCheck->pabReported[ulKey])
+    {
+        pCheck->pcszError = "pmapDiff reports a key twice";
+        return FALSE;
+    }
+    pCheck->pabReported[ulKey] = 1;
+
+    bOld = pCheck->pabOld[ulKey];
+    bNew = pCheck->pabNew[ulKey];
+    if (bOld == bNew)
+        pCheck->pcszError = "pmapDiff reports an unchanged key";
+    else if (    (pvOldData != ((bOld) ? &G_abData[bOld] : NULL))
+              || (pvNewData != ((bNew) ? &G_abData[bNew] : NULL))
+            )
+        pCheck->pcszError = "pmapDiff reports the wrong data";
+    else if (ulChange != (  (!bOld) ? PMAPDIFF_ADDED
+                          : (!bNew) ? PMAPDIFF_REMOVED
+                          : PMAPDIFF_CHANGED))
+        pCheck->pcszError = "pmapDiff reports the wrong change";
+
+    return (pCheck->pcszError == NULL);
+}
+
+/*
+ *@@ CheckDiff:
+ *      compares what pmapDiff reports for the two maps
+ *      with the difference of the two arrays.
+ */
+
+VOID CheckDiff(const PMAP *pOld,
+               const unsigned char *pabOld,
+               const PMAP *pNew,
+               const unsigned char *pabNew,
+               const char *pcszWhat)
+{
+    DIFFCHECK   Check;
+    ULONG       ul;
+
+    G_cChecks++;
+
+    Check.pabOld = pabOld;
+    Check.pabNew = pabNew;
+    Check.cKeys = G_cKeys;
+    Check.pcszError = NULL;
+    if (!(Check.pabReported = (unsigned char*)calloc(G_cKeys, 1)))
+        exit(2);
+
+    if (!pmapDiff(pOld, pNew, DiffCheck, &Check))
+        Fail(pcszWhat, (Check.pcszError) ? Check.pcszError : "pmapDiff failed");
+    else
+        for (ul = 0; ul < G_cKeys; ul++)
+            if (    (pabOld[ul] != pabNew[ul])
+                 && (!Check.pabReported[ul])
+               )
+            {
+                Fail(pcszWhat, "pmapDiff misses a change");
+                break;
+            }
+
+    free(Check.pabReported);
+}
+
+/*
+ *@@ DiffStop:
+ *      FNPMAP_DIFF which stops at the first change.
+ */
+
+BOOL TREEENTRY DiffStop(ULONG ulKey,
+                        void *pvOldData,
+                        void *pvNewData,
+                        ULONG ulChange,
+                        void *pvUser)
+{
+    (*(PULONG)pvUser)++;
+    return FALSE;
+}
+
+/*
+ *@@ Test:
+ *      runs the whole test with one hash function.
+ */
+
+VOID Test(FNPMAP_HASH *pfnHash,
+          const char *pcszHash,
+          ULONG cOps)
+{
+    SNAPSHOT        aSnapshots[SNAPSHOTS];
+    PMAP            Map,
+                    Empty;
+    unsigned char   *pabValues,
+                    *pabNone;
+    ULONG           ul,
+                    ulSnapshot = 0;
+    char            szWhat[200];
+
+    if (    (!(pabValues = (unsigned char*)calloc(G_cKeys, 1)))
+         || (!(pabNone = (unsigned char*)calloc(G_cKeys, 1)))
+       )
+        exit(2);
+    memset(aSnapshots, 0, sizeof(aSnapshots));
+
+    pmapInit(&Map, pfnHash, treeCompareKeys);
+    pmapInit(&Empty, pfnHash, treeCompareKeys);
+
+    for (ul = 0; ul < cOps; ul++)
+    {
+        // mostly setting in even phases, mostly removing in odd ones
+        int     iSetPercent = ((ul / (G_cKeys * 2)) & 1) ? 25 : 75;
+        ULONG   ulKey = rand() % G_cKeys;
+        int     rc;
+
+        sprintf(szWhat, "%s: operation %lu on key %lu", pcszHash, ul, ulKey);
+
+        if (rand() % 100 < iSetPercent)
+        {
+            unsigned char bValue = 1 + rand() % VALUES;
+            rc = pmapSet(&Map, ulKey, &G_abData[bValue]);
+            if (rc != ((pabValues[ulKey]) ? PMAP_REPLACED : PMAP_OK))
+                Fail(szWhat, "pmapSet returns the wrong code");
+            pabValues[ulKey] = bValue;
+        }
+        else
+        {
+            rc = pmapRemove(&Map, ulKey);
+            if (rc != ((pabValues[ulKey]) ? PMAP_OK : PMAP_NOT_FOUND))
+                Fail(szWhat, "pmapRemove returns the wrong code");
+            pabValues[ulKey] = 0;
+        }
+
+        if (ul % SNAPSHOT_EVERY == 0)
+        {
+            PSNAPSHOT   pSnap = &aSnapshots[ulSnapshot++ % SNAPSHOTS];
+            ULONG       ul2;
+
+            CheckMap(&Map, pabValues, szWhat);
+
+            // all older snapshots must still be what they were
+            for (ul2 = 0; ul2 < SNAPSHOTS; ul2++)
+                if (aSnapshots[ul2].fUsed)
+                {
+                    PSNAPSHOT   pOther = &aSnapshots[ul2];
+
+                    CheckMap(&pOther->Map, pOther->pabValues, szWhat);
+                    CheckDiff(&pOther->Map, pOther->pabValues,
+                              &Map, pabValues,
+                              szWhat);
+                    CheckDiff(&Map, pabValues,
+                              &pOther->Map, pOther->pabValues,
+                              szWhat);
+                    if (    (pSnap->fUsed)
+                         && (pOther != pSnap)
+                       )
+                        CheckDiff(&pSnap->Map, pSnap->pabValues,
+                                  &pOther->Map, pOther->pabValues,
+                                  szWhat);
+                }
+
+            CheckDiff(&Empty, pabNone, &Map, pabValues, szWhat);
+            CheckDiff(&Map, pabValues, &Empty, pabNone, szWhat);
+            CheckDiff(&Map, pabValues, &Map, pabValues, szWhat);
+
+            // replace the oldest snapshot
+            if (pSnap->fUsed)
+                pmapClear(&pSnap->Map);
+            else if (!(pSnap->pabValues = (unsigned char*)malloc(G_cKeys)))
+                exit(2);
+            pmapCopy(&pSnap->Map, &Map);
+            memcpy(pSnap->pabValues, pabValues, G_cKeys);
+            pSnap->fUsed = TRUE;
+        }
+    }
+
+    CheckMap(&Map, pabValues, pcszHash);
+
+    // pmapDiff must stop when the callback says so
+    if (Map.lCount)
+    {
+        ULONG cCalls = 0;
+        if (    (pmapDiff(&Empty, &Map, DiffStop, &cCalls))
+             || (cCalls != 1)
+           )
+            Fail(pcszHash, "pmapDiff does not stop");
+    }
+
+    // remove everything, so that the root is collapsed too
+    for (ul = 0; ul < G_cKeys; ul++)
+        if (pabValues[ul])
+        {
+            if (pmapRemove(&Map, ul))
+                Fail(pcszHash, "pmapRemove fails on the way to empty");
+            pabValues[ul] = 0;
+        }
+    if (Map.pRoot)
+        Fail(pcszHash, "empty map still has a root");
+    CheckMap(&Map, pabValues, pcszHash);
+
+    for (ul = 0; ul < SNAPSHOTS; ul++)
+        if (aSnapshots[ul].fUsed)
+        {
+            CheckMap(&aSnapshots[ul].Map, aSnapshots[ul].pabValues, pcszHash);
+            pmapClear(&aSnapshots[ul].Map);
+            free(aSnapshots[ul].pabValues);
+        }
+
+    pmapClear(&Map);
+    pmapClear(&Empty);
+    free(pabNone);
+    free(pabValues);
+}
+
+int main(int argc, char *argv[])
+{
+    ULONG   cOps = 100000;
+
+    G_cKeys = 2000;
+    if (argc > 1)
+        G_cKeys = strtoul(argv[1], NULL, 10);
+    if (argc > 2)
+        cOps = strtoul(argv[2], NULL, 10);
+    srand((argc > 3) ? atoi(argv[3]) : 1);
+
+    if (!G_cKeys)
+        return 2;
+
+    Test(pmapHashKey, "pmapHashKey", cOps);
+    Test(HashCollide, "full collisions", cOps);
+    Test(HashDeep, "25 bits shared", cOps);
+
+    printf("%lu keys, %lu operations per hash, %lu checks, %lu failures\n",
+           G_cKeys,
+           cOps,
+           G_cChecks,
+           G_cFailures);
+
+    return (G_cFailures) ? 1 : 0;
+}
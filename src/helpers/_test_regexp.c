@@ -0,0 +1,227 @@
+
+/*
+ *      Multi-threaded test for regexp.c. Greps one generated
+ *      corpus with one compiled ERE on several threads at once,
+ *      some with their own scratch space (rxpMatch_fwdEx) and
+ *      some sharing the one in the ERE (rxpMatch_fwd), and checks
+ *      that every thread finds the same matches as a single
+ *      thread did before.
+ *
+ *      Usage: _test_regexp [threads [lines [ere]]]
+ */
+
+#define INCL_DOSPROCESS
+#define INCL_DOSERRORS
+#include <os2.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "setup.h"                      // code generation and debugging options
+
+#include "helpers\regexp.h"
+
+#pragma hdrstop
+
+#define MAX_THREADS     32
+
+typedef struct _GREP
+{
+    const ERE       *pERE;
+    BOOL            fOwnScratch;    // use rxpMatch_fwdEx with own scratch
+    ULONG           cMatches;       // out: no. of matches
+    ULONG           ulChecksum;     // out: sum over positions and lengths
+    TID             tid;
+} GREP, *PGREP;
+
+char    **G_papszLines = NULL;
+ULONG   G_cLines = 0;
+
+/*
+ *@@ MakeCorpus:
+ *      generates log-file-like lines, some of which contain
+ *      the things the default ERE looks for.
+ */
+
+BOOL MakeCorpus(ULONG cLines)
+{
+    static const char *apcszWords[] =
+        {
+            "error", "warning", "info", "file", "open", "close",
+            "failed", "code", "0x1f", "12345", "C:\\OS2\\DLL", "rc="
+        };
+    ULONG ul;
+
+    if (!(G_papszLines = (char**)malloc(cLines * sizeof(char*))))
+        return FALSE;
+    srand(1);
+    for (ul = 0; ul < cLines; ul++)
+    {
+        char    szLine[200],
+                *p = szLine;
+        ULONG   cWords = 3 + rand() % 12,
+                ulWord;
+        for (ulWord = 0; ulWord < cWords; ulWord++)
+            p += sprintf(p,
+                         "%s%s",
+                         (ulWord) ? " " : "",
+                         apcszWords[rand() % (sizeof(apcszWords) / sizeof(apcszWords[0]))]);
+        if (!(G_papszLines[ul] = strdup(szLine)))
+            return FALSE;
+    }
+    G_cLines = cLines;
+    return TRUE;
+}
+
+/*
+ *@@ Grep:
+ *      finds all matches of the ERE in the corpus and
+ *      counts them.
+ */
+
+VOID Grep(PGREP pGrep)
+{
+    ERESCRATCH  *pScratch = NULL;
+    ULONG       ul;
+    int         rc;
+
+    pGrep->cMatches = 0;
+    pGrep->ulChecksum = 0;
+
+    if (    (pGrep->fOwnScratch)
+         && (!(pScratch = rxpScratchCreate(pGrep->pERE, &rc)))
+       )
+        return;
+
+    for (ul = 0; ul < G_cLines; ul++)
+    {
+        const char  *pcszLine = G_papszLines[ul];
+        int         pos = 0,
+                    pos_match,
+                    len_match;
+
+        while (rxpMatch_fwdEx(pGrep->pERE,
+                              0,
+                              pcszLine,
+                              pos,
+                              &pos_match,
+                              &len_match,
+                              NULL,
+                              pScratch))
+        {
+            pGrep->cMatches++;
+            pGrep->ulChecksum += ul * 31 + pos_match * 7 + len_match;
+            pos = pos_match + len_match;
+            if (len_match == 0)
+            {
+                if (!pcszLine[pos])
+                    break;
+                pos++;
+            }
+        }
+    }
+
+    rxpScratchFree(pScratch);
+}
+
+/*
+ *@@ fnGrepThread:
+ *      thread func.
+ */
+
+VOID APIENTRY fnGrepThread(ULONG ul)
+{
+    Grep((PGREP)ul);
+}
+
+int main(int argc, char *argv[])
+{
+    ULONG       cThreads = 4,
+                cLines = 100000,
+                ul;
+    const char  *pcszERE = "(error|warning|failed) (code|rc=) ?(0x[0-9a-f]+|[0-9]+)";
+    ERE         *pERE;
+    GREP        Ref,
+                aGreps[MAX_THREADS];
+    clock_t     cl;
+    int         rc = 0;
+
+    if (argc > 1)
+        cThreads = strtoul(argv[1], NULL, 10);
+    if (argc > 2)
+        cLines = strtoul(argv[2], NULL, 10);
+    if (argc > 3)
+        pcszERE = argv[3];
+    if (cThreads > MAX_THREADS)
+        cThreads = MAX_THREADS;
+
+    if (!MakeCorpus(cLines))
+        return 2;
+
+    if (!(pERE = rxpCompile(pcszERE, 0, &rc)))
+    {
+        printf("rxpCompile failed for \"%s\", rc = %d\n", pcszERE, rc);
+        return 2;
+    }
+
+    // single-threaded reference
+    Ref.pERE = pERE;
+    Ref.fOwnScratch = FALSE;
+    cl = clock();
+    Grep(&Ref);
+    printf("1 thread: %lu matches, %.3f s\n",
+           Ref.cMatches,
+           (double)(clock() - cl) / CLOCKS_PER_SEC);
+
+    // now all at once; every other thread has its own scratch,
+    // the others compete for the one in the ERE
+    cl = clock();
+    for (ul = 0; ul < cThreads; ul++)
+    {
+        aGreps[ul].pERE = pERE;
+        aGreps[ul].fOwnScratch = (ul & 1);
+        if (DosCreateThread(&aGreps[ul].tid,
+                            fnGrepThread,
+                            (ULONG)&aGreps[ul],
+                            0,
+                            0x10000))
+        {
+            printf("DosCreateThread failed\n");
+            return 2;
+        }
+    }
+
+    for (ul = 0; ul < cThreads; ul++)
+    {
+        TID tid = aGreps[ul].tid;
+        DosWaitThread(&tid, DCWW_WAIT);
+    }
+    printf("%lu threads: %.3f s\n",
+           cThreads,
+           (double)(clock() - cl) / CLOCKS_PER_SEC);
+
+    for (ul = 0; ul < cThreads; ul++)
+        if (    (aGreps[ul].cMatches != Ref.cMatches)
+             || (aGreps[ul].ulChecksum != Ref.ulChecksum)
+           )
+        {
+            printf("thread %lu (%s scratch): %lu matches, expected %lu\n",
+                   ul,
+                   (aGreps[ul].fOwnScratch) ? "own" : "shared",
+                   aGreps[ul].cMatches,
+                   Ref.cMatches);
+            rc = 1;
+        }
+
+    printf("%s\n", (rc) ? "FAILED" : "OK");
+
+    rxpFree(pERE);
+    for (ul = 0; ul < G_cLines; ul++)
+        free(G_papszLines[ul]);
+    free(G_papszLines);
+
+    return rc;
+}
+
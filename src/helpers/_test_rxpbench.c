@@ -0,0 +1,240 @@
+
+/*
+ *      Benchmark for regexp.c. Times rxpCompile, rxpMatch_fwd and
+ *      rxpMatch_bwd for a number of EREs over generated text, in
+ *      four groups: pathological EREs (which take exponential time
+ *      with a backtracking matcher), literal-heavy, class-heavy and
+ *      capture-heavy ones. The capture-heavy ones are also matched
+ *      with sub-match info, which takes a different path.
+ *
+ *      Every ERE is matched repeatedly over the whole text, from the
+ *      end of each match, as a "find all" would. The number of
+ *      matches is printed too, so that changes to the engine can be
+ *      checked for speed and results at once (see _test_rxpfuzz.c
+ *      for checking them properly).
+ *
+ *      Usage: _test_rxpbench [text size [repeats]]
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "setup.h"                      // code generation and debugging options
+
+#include "helpers\regexp.h"
+
+#pragma hdrstop
+
+typedef struct _BENCH
+{
+    const char  *pcszGroup;
+    const char  *pcszERE;
+    int         iText;          // index into G_apszTexts
+    BOOLEAN     fSubs;          // get sub-match info too
+} BENCH, *PBENCH;
+
+/*
+ *      The texts, filled in by MakeTexts:
+ *      0: words and numbers, like a log file
+ *      1: "aaaa...", for the pathological EREs
+ *      2: identifiers and punctuation, like source code
+ */
+
+char    *G_apszTexts[3];
+
+BENCH   G_aBenches[] =
+    {
+        { "pathological", "(a|a)*b", 1, FALSE },
+        { "pathological", "(a*)*b", 1, FALSE },
+        { "pathological", "(a|aa)*c", 1, FALSE },
+        { "pathological", "a?a?a?a?a?a?a?a?a?a?aaaaaaaaaa", 1, FALSE },
+        { "pathological", "(.*)*x", 1, FALSE },
+        { "literal", "error", 0, FALSE },
+        { "literal", "disk full", 0, FALSE },
+        { "literal", "warning: file not found", 0, FALSE },
+        { "literal", "(open|close|read|write) failed", 0, FALSE },
+        { "class", "[0-9]+", 0, FALSE },
+        { "class", "[A-Za-z_][A-Za-z0-9_]*", 2, FALSE },
+        { "class", "[[:upper:]][[:lower:]]+", 2, FALSE },
+        { "class", "[^ ;(){}]+\\(", 2, FALSE },
+        { "class", "\\<\\w+\\>", 0, FALSE },
+        { "capture", "([a-z]+) ([a-z]+)", 0, TRUE },
+        { "capture", "(([0-9])([0-9]))+", 0, TRUE },
+        { "capture", "([A-Za-z_]+)\\(([^)]*)\\)", 2, TRUE },
+        { "capture", "(a)(b)?(c)?(d)?(e)?(f)?(g)?(h)?(i)?", 0, TRUE },
+        { "backref", "([a-z]+) \\1", 0, FALSE }
+    };
+
+/*
+ *@@ MakeTexts:
+ *      generates the texts, of about cb bytes each.
+ */
+
+BOOLEAN MakeTexts(int cb)
+{
+    static const char *apcszWords[] =
+        {
+            "error", "disk", "full", "warning:", "file", "not", "found",
+            "open", "close", "read", "write", "failed", "12", "3456",
+            "the", "a", "and", "x86", "OS2", "\n"
+        };
+    static const char *apcszTokens[] =
+        {
+            "int", "x", "=", "Func(", ");", "{", "}", "if", "(", ")",
+            "pszName", "ulCount", "0", "1", ";", "\n", "WinSendMsg("
+        };
+    int     i, cbText;
+    char    *p;
+
+    for (i = 0; i < 3; i++)
+        if (!(G_apszTexts[i] = (char*)malloc(cb + 40)))
+            return FALSE;
+
+    srand(1);
+    for (p = G_apszTexts[0], cbText = 0; cbText < cb; )
+    {
+        int cbWord = sprintf(p,
+                             "%s ",
+                             apcszWords[rand() % (sizeof(apcszWords) / sizeof(apcszWords[0]))]);
+        p += cbWord;
+        cbText += cbWord;
+    }
+
+    memset(G_apszTexts[1], 'a', cb);
+    G_apszTexts[1][cb] = '\0';
+
+    for (p = G_apszTexts[2], cbText = 0; cbText < cb; )
+    {
+        int cbWord = sprintf(p,
+                             "%s ",
+                             apcszTokens[rand() % (sizeof(apcszTokens) / sizeof(apcszTokens[0]))]);
+        p += cbWord;
+        cbText += cbWord;
+    }
+
+    return TRUE;
+}
+
+/*
+ *@@ Seconds:
+ *
+ */
+
+double Seconds(clock_t cl)
+{
+    return (double)(clock() - cl) / CLOCKS_PER_SEC;
+}
+
+int main(int argc, char *argv[])
+{
+    int     cbText = 100000,
+            cRepeats = 3,
+            i;
+
+    if (argc > 1)
+        cbText = atoi(argv[1]);
+    if (argc > 2)
+        cRepeats = atoi(argv[2]);
+
+    if (!MakeTexts(cbText))
+        return 2;
+
+    printf("%d bytes of text, best of %d runs\n\n", cbText, cRepeats);
+    printf("%-13s %-40s %10s %8s %10s %8s\n",
+           "group", "ERE", "compile", "matches", "fwd", "bwd");
+
+    for (i = 0; i < sizeof(G_aBenches) / sizeof(G_aBenches[0]); i++)
+    {
+        PBENCH          pBench = &G_aBenches[i];
+        const char      *pcszText = G_apszTexts[pBench->iText];
+        int             len = strlen(pcszText),
+                        cbBwd = (len < 2000) ? len : 2000,
+                        rc,
+                        iRun,
+                        cMatches = 0;
+        double          dCompile = 1e9,
+                        dFwd = 1e9,
+                        dBwd = 1e9;
+        ERE             *pERE;
+        ERE_MATCHINFO   mi;
+
+        for (iRun = 0; iRun < cRepeats; iRun++)
+        {
+            int     pos,
+                    pos_match,
+                    len_match,
+                    c;
+            clock_t cl = clock();
+            double  d;
+
+            // compile 100 times, as it is quick
+            for (c = 0; c < 100; c++)
+            {
+                if (!(pERE = rxpCompile(pBench->pcszERE, 0, &rc)))
+                {
+                    printf("rxpCompile failed for \"%s\", rc = %d\n", pBench->pcszERE, rc);
+                    return 2;
+                }
+                if (c < 99)
+                    rxpFree(pERE);
+            }
+            if ((d = Seconds(cl) / 100) < dCompile)
+                dCompile = d;
+
+            // find all matches forwards
+            cl = clock();
+            cMatches = 0;
+            pos = 0;
+            while (    (pos <= len)
+                    && (rxpMatch_fwd(pERE,
+                                     0,
+                                     pcszText,
+                                     pos,
+                                     &pos_match,
+                                     &len_match,
+                                     (pBench->fSubs) ? &mi : NULL))
+                  )
+            {
+                cMatches++;
+                pos = pos_match + len_match + (len_match == 0);
+            }
+            if ((d = Seconds(cl)) < dFwd)
+                dFwd = d;
+
+            // rxpMatch_bwd tries every start position, so only run
+            // it over the start of the text, from the end
+            cl = clock();
+            pos = cbBwd;
+            while (    (pos >= 0)
+                    && (rxpMatch_bwd(pERE,
+                                     0,
+                                     pcszText,
+                                     pos,
+                                     &pos_match,
+                                     &len_match,
+                                     (pBench->fSubs) ? &mi : NULL))
+                  )
+                pos = pos_match - 1;
+            if ((d = Seconds(cl)) < dBwd)
+                dBwd = d;
+
+            rxpFree(pERE);
+        }
+
+        printf("%-13s %-40s %8.1fus %8d %8.1fms %6.1fms\n",
+               pBench->pcszGroup,
+               pBench->pcszERE,
+               dCompile * 1e6,
+               cMatches,
+               dFwd * 1e3,
+               dBwd * 1e3);
+    }
+
+    for (i = 0; i < 3; i++)
+        free(G_apszTexts[i]);
+
+    return 0;
+}
+
@@ -0,0 +1,472 @@
+
+/*
+ *      Differential fuzzer for regexp.c. Generates random EREs from
+ *      the subset of the syntax that regexp.c and POSIX agree on,
+ *      and random strings over a small alphabet, and checks that
+ *      rxpMatch and rxpMatch_fwd find the same matches as POSIX
+ *      regcomp/regexec with REG_EXTENDED do.
+ *
+ *      Both are leftmost-longest, so the position and length of
+ *      every match must be the same. Sub-match spans are not
+ *      compared, as POSIX chooses them by different rules than
+ *      walk_fsm does. Needs a C library with <regex.h>, such as
+ *      glibc on Linux.
+ *
+ *      The EREs have backreferences too, also inside groups. A
+ *      backreference in a group counts only the groups directly
+ *      in that group, in the order in which matching enters them,
+ *      while POSIX numbers all groups in the ERE from the left.
+ *      So GenERE writes two versions of each ERE, which differ
+ *      only in the numbers after the backslashes, and only lets
+ *      backreferences refer to groups whose number is the same
+ *      on every path (see SCOPE).
+ *
+ *      Building this off OS/2 needs an os2.h with the basic types
+ *      (LONG, ULONG, APIRET, BOOL, PCSZ and APIENTRY, TRUE, FALSE
+ *      and NO_ERROR), slashes instead of backslashes in the
+ *      #include paths, and regexp.c and encodings.c, e.g.
+ *
+ *          gcc -I<dir with os2.h> -I../../include _test_rxpfuzz.c
+ *              regexp.c encodings.c -lpthread
+ *
+ *      This file then brings its own lockExchange, semRequest and
+ *      semRelease, which come from interlock.asm and sem.c on OS/2.
+ *
+ *      Before that, a few EREs with backreferences inside groups
+ *      are checked against fixed results, through all the ways of
+ *      matching that must handle them (see CheckKnown).
+ *
+ *      Usage: _test_rxpfuzz [EREs [seed]]
+ */
+
+#define INCL_DOSSEMAPHORES
+#include <os2.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <regex.h>
+
+#include "setup.h"                      // code generation and debugging options
+
+#include "helpers\regexp.h"
+#include "helpers\sem.h"
+
+#pragma hdrstop
+
+#ifndef __OS2__
+
+#include <pthread.h>
+
+/*
+ *      Stand-ins for the lock and semaphore functions that
+ *      regexp.c uses, for building this with glibc. This is
+ *      single-threaded, so they needn't be fast.
+ */
+
+LONG APIENTRY lockExchange(PLONG pl, LONG l)
+{
+    return __sync_lock_test_and_set(pl, l);
+}
+
+pthread_mutex_t G_mtx = PTHREAD_MUTEX_INITIALIZER;
+
+APIRET semRequest(PFASTMTX pmtx)
+{
+    return pthread_mutex_lock(&G_mtx);
+}
+
+APIRET semRelease(PFASTMTX pmtx)
+{
+    return pthread_mutex_unlock(&G_mtx);
+}
+
+#endif
+
+#define STRINGS_PER_ERE     30
+#define MAX_REPORTS         20
+
+unsigned long   G_cChecks = 0,
+                G_cFailures = 0;
+
+const char      *G_pcszPosix = NULL;    // POSIX version of the current ERE
+
+/*
+ *      The groups that backreferences at one place in an ERE
+ *      can refer to, with their numbers for POSIX. A group after
+ *      a repeated one gets a different number depending on how
+ *      often the repeated one matched, and a group in the second
+ *      alternative is numbered as if the first had none. Those
+ *      after a repeated group get no POSIX number, and so cannot
+ *      be referred to, and the count starts over after "|".
+ */
+
+typedef struct _SCOPE
+{
+    int         cGroups;        // groups closed in this group so far
+    int         aiPosix[9];     // their POSIX numbers, 0 if not fixed
+    BOOLEAN     fRepeated;      // a repeated group was closed
+} SCOPE, *PSCOPE;
+
+int             G_cPosixGroups;         // groups in the ERE so far
+
+typedef struct _KNOWN
+{
+    const char  *pcszERE;
+    const char  *pcszString;
+    int         posMatch,       // expected match, found from position 0
+                lenMatch;
+} KNOWN, *PKNOWN;
+
+/*
+ *      EREs with backreferences inside groups. These can only be
+ *      matched by walk_fsm; the DFA, the Pike VM and streams would
+ *      never find a match for them. Inside a group, a backreference
+ *      counts the groups in that group only, which POSIX does not,
+ *      so the results are fixed here instead of coming from regexec.
+ */
+
+KNOWN   G_aKnown[] =
+    {
+        { "((.)\\1)", "xaa", 1, 2 },
+        { "a((b)\\1)c", "xabbc", 1, 4 },
+        { "((.)\\1)+", "xaabbc", 1, 4 },
+        { "(x|(.)\\1)", "zqq", 1, 2 },
+        { "(ab|(c)\\1)d", "ccd", 0, 3 },
+        { "((a)\\1)*b", "aaaab", 0, 5 }
+    };
+
+/*
+ *@@ Append:
+ *      appends the same text to both versions of the ERE.
+ */
+
+void Append(char **pp,
+            char **pq,
+            const char *pcsz)
+{
+    *pp += sprintf(*pp, "%s", pcsz);
+    *pq += sprintf(*pq, "%s", pcsz);
+}
+
+/*
+ *@@ GenERE:
+ *      appends a random ERE to *pp, and its version for POSIX
+ *      to *pq. Avoids what POSIX leaves undefined, such as empty
+ *      alternatives or repeating a repetition. Anchors are
+ *      added by main, at the ends only, as glibc gets them
+ *      wrong inside repeated groups.
+ *
+ *      pScope has the groups that a backreference here may
+ *      refer to: those closed before it in the same group.
+ *      Repeated groups are left out too, as glibc often gets
+ *      it wrong which of their iterations a backreference
+ *      stands for.
+ */
+
+void GenERE(char **pp,
+            char **pq,
+            int iDepth,
+            PSCOPE pScope)
+{
+    static const char *apcszAtoms[] =
+        {
+            "a", "b", "c", "ab", "ba", "abc", ".", "[ab]", "[^a]", "[a-c]", " "
+        };
+    int i = rand() % ((iDepth > 3) ? 4 : 12),
+        iGroup = (pScope->cGroups) ? rand() % pScope->cGroups : -1;
+
+    if (    (i >= 6)
+         && (i < 8 || i >= 10)
+         && (G_cPosixGroups >= 9)
+       )
+        // no more than \9 for POSIX
+        i = rand() % 6;
+
+    if (    (i < 2)
+         && (iGroup >= 0)
+         && (pScope->aiPosix[iGroup])
+       )
+    {
+        // backreference to one of the groups before
+        *pp += sprintf(*pp, "\\%d", iGroup + 1);
+        *pq += sprintf(*pq, "\\%d", pScope->aiPosix[iGroup]);
+    }
+    else if (i < 6)
+        Append(pp, pq, apcszAtoms[rand() % (sizeof(apcszAtoms) / sizeof(apcszAtoms[0]))]);
+    else if (i < 8 || i >= 10)
+    {
+        SCOPE   Sub;
+        int     iPosix = ++G_cPosixGroups;
+
+        Sub.cGroups = 0;
+        Sub.fRepeated = FALSE;
+        Append(pp, pq, "(");
+        GenERE(pp, pq, iDepth + 1, &Sub);
+        if (i < 8)
+        {
+            Append(pp, pq, "|");
+            Sub.cGroups = 0;
+            Sub.fRepeated = FALSE;
+            GenERE(pp, pq, iDepth + 1, &Sub);
+        }
+        Append(pp, pq, ")");
+        if (i >= 10)
+        {
+            pScope->fRepeated = TRUE;
+            switch (rand() % 4)
+            {
+                case 0: Append(pp, pq, "*"); break;
+                case 1: Append(pp, pq, "+"); break;
+                case 2: Append(pp, pq, "?"); break;
+                default:
+                {
+                    char    szRep[20];
+                    int     m = rand() % 3;
+                    sprintf(szRep, "{%d,%d}", m, m + rand() % 3);
+                    Append(pp, pq, szRep);
+                }
+            }
+        }
+
+        pScope->aiPosix[pScope->cGroups++] = (pScope->fRepeated) ? 0 : iPosix;
+    }
+    else
+    {
+        GenERE(pp, pq, iDepth + 1, pScope);
+        GenERE(pp, pq, iDepth + 1, pScope);
+    }
+}
+
+/*
+ *@@ Report:
+ *
+ */
+
+void Report(const char *pcszERE,
+            const char *pcszString,
+            const char *pcszWhat,
+            int pos,
+            int posExpected, int lenExpected,    // POSIX or G_aKnown
+            int posRxp, int lenRxp)
+{
+    if (G_cFailures++ < MAX_REPORTS)
+        printf("%s mismatch: ERE \"%s\", string \"%s\", pos %d: "
+               "expected (%d, %d), got (%d, %d)\n",
+               pcszWhat,
+               pcszERE,
+               pcszString,
+               pos,
+               posExpected, lenExpected,
+               posRxp, lenRxp);
+    if (    (G_cFailures <= MAX_REPORTS)
+         && (G_pcszPosix)
+         && (strcmp(G_pcszPosix, pcszERE))
+       )
+        printf("    (for POSIX: \"%s\")\n", G_pcszPosix);
+}
+
+/*
+ *@@ Check:
+ *      compares all matches of the ERE in the string, going
+ *      from the end of each match to the next, and the match
+ *      at each position.
+ */
+
+void Check(const char *pcszERE,
+           regex_t *pRegex,
+           ERE *pERE,
+           const char *pcszString)
+{
+    int len = strlen(pcszString),
+        pos;
+
+    // find all: rxpMatch_fwd vs. regexec
+    pos = 0;
+    while (pos <= len)
+    {
+        regmatch_t  rm;
+        int         posPosix = -1, lenPosix = -1,
+                    posRxp = -1, lenRxp = -1;
+
+        if (!regexec(pRegex, pcszString + pos, 1, &rm, (pos) ? REG_NOTBOL : 0))
+        {
+            posPosix = pos + rm.rm_so;
+            lenPosix = rm.rm_eo - rm.rm_so;
+        }
+        if (!rxpMatch_fwd(pERE, 0, pcszString, pos, &posRxp, &lenRxp, NULL))
+            posRxp = lenRxp = -1;
+
+        G_cChecks++;
+        if (posPosix != posRxp || lenPosix != lenRxp)
+        {
+            Report(pcszERE, pcszString, "rxpMatch_fwd", pos, posPosix, lenPosix, posRxp, lenRxp);
+            break;
+        }
+        if (posPosix == -1)
+            break;
+        pos = posPosix + lenPosix + (lenPosix == 0);
+    }
+
+    // anchored: rxpMatch vs. a POSIX match starting right there
+    for (pos = 0; pos <= len; pos++)
+    {
+        regmatch_t  rm;
+        int         lenPosix = -1,
+                    lenRxp = rxpMatch(pERE, 0, pcszString, pos, NULL);
+
+        if (    (!regexec(pRegex, pcszString + pos, 1, &rm, (pos) ? REG_NOTBOL : 0))
+             && (rm.rm_so == 0)
+           )
+            lenPosix = rm.rm_eo;
+
+        G_cChecks++;
+        if (lenPosix != lenRxp)
+        {
+            Report(pcszERE, pcszString, "rxpMatch", pos, pos, lenPosix, pos, lenRxp);
+            break;
+        }
+    }
+}
+
+/*
+ *@@ CheckKnown:
+ *      checks the EREs in G_aKnown with rxpMatch_fwd (with and
+ *      without sub-match info), rxpMatch and rxpMatchSet, and
+ *      that rxpStreamOpen refuses them.
+ */
+
+void CheckKnown(void)
+{
+    int i;
+
+    for (i = 0; i < sizeof(G_aKnown) / sizeof(G_aKnown[0]); i++)
+    {
+        PKNOWN          pKnown = &G_aKnown[i];
+        const char      *pcszERE = pKnown->pcszERE;
+        ERE             *pERE;
+        ERESET          *pSet;
+        ERESTREAM       *pStream;
+        ERE_MATCHINFO   mi;
+        BOOLEAN         fMatched;
+        int             posRxp, lenRxp,
+                        rc;
+
+        if (!(pERE = rxpCompile(pcszERE, 0, &rc)))
+        {
+            printf("rxpCompile failed for \"%s\", rc = %d\n", pcszERE, rc);
+            G_cFailures++;
+            continue;
+        }
+
+        G_cChecks += 5;
+
+        if (!rxpMatch_fwd(pERE, 0, pKnown->pcszString, 0, &posRxp, &lenRxp, NULL))
+            posRxp = lenRxp = -1;
+        if (posRxp != pKnown->posMatch || lenRxp != pKnown->lenMatch)
+            Report(pcszERE, pKnown->pcszString, "rxpMatch_fwd", 0,
+                   pKnown->posMatch, pKnown->lenMatch, posRxp, lenRxp);
+
+        if (!rxpMatch_fwd(pERE, 0, pKnown->pcszString, 0, &posRxp, &lenRxp, &mi))
+            posRxp = lenRxp = -1;
+        if (posRxp != pKnown->posMatch || lenRxp != pKnown->lenMatch)
+            Report(pcszERE, pKnown->pcszString, "rxpMatch_fwd with spans", 0,
+                   pKnown->posMatch, pKnown->lenMatch, posRxp, lenRxp);
+
+        lenRxp = rxpMatch(pERE, 0, pKnown->pcszString, pKnown->posMatch, NULL);
+        if (lenRxp != pKnown->lenMatch)
+            Report(pcszERE, pKnown->pcszString, "rxpMatch", pKnown->posMatch,
+                   pKnown->posMatch, pKnown->lenMatch, pKnown->posMatch, lenRxp);
+
+        if (!(pSet = rxpCompileSet(&pcszERE, 1, 0, &rc, NULL)))
+        {
+            printf("rxpCompileSet failed for \"%s\", rc = %d\n", pcszERE, rc);
+            G_cFailures++;
+        }
+        else
+        {
+            if (    (rxpMatchSet(pSet, pKnown->pcszString, 0, &fMatched) != 1)
+                 || (!fMatched)
+               )
+                Report(pcszERE, pKnown->pcszString, "rxpMatchSet", 0,
+                       pKnown->posMatch, pKnown->lenMatch, -1, -1);
+            rxpFreeSet(pSet);
+        }
+
+        if (pStream = rxpStreamOpen(pERE, 0, &rc))
+        {
+            rxpStreamClose(pStream);
+            rc = 0;
+        }
+        if (rc != EREE_STREAM_BACKREF)
+        {
+            printf("rxpStreamOpen did not refuse \"%s\", rc = %d\n", pcszERE, rc);
+            G_cFailures++;
+        }
+
+        rxpFree(pERE);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned long   cEREs = 10000,
+                    ul;
+
+    if (argc > 1)
+        cEREs = strtoul(argv[1], NULL, 10);
+    srand((argc > 2) ? atoi(argv[2]) : 1);
+
+    CheckKnown();
+
+    for (ul = 0; ul < cEREs; ul++)
+    {
+        char    szERE[1000],
+                szPosix[1000],
+                *p = szERE,
+                *q = szPosix;
+        SCOPE   Top;
+        regex_t Regex;
+        ERE     *pERE;
+        int     rc,
+                i;
+
+        if (rand() % 4 == 0)
+            Append(&p, &q, "^");
+        Top.cGroups = 0;
+        Top.fRepeated = FALSE;
+        G_cPosixGroups = 0;
+        GenERE(&p, &q, 0, &Top);
+        if (rand() % 4 == 0)
+            Append(&p, &q, "$");
+        if (regcomp(&Regex, szPosix, REG_EXTENDED))
+            continue;
+        G_pcszPosix = szPosix;
+        if (!(pERE = rxpCompile(szERE, 0, &rc)))
+        {
+            printf("rxpCompile failed for \"%s\", rc = %d\n", szERE, rc);
+            G_cFailures++;
+            regfree(&Regex);
+            continue;
+        }
+
+        for (i = 0; i < STRINGS_PER_ERE; i++)
+        {
+            char    szString[40];
+            int     len = rand() % 25,
+                    c;
+
+            for (c = 0; c < len; c++)
+                szString[c] = "abc  "[rand() % 5];
+            szString[len] = '\0';
+            Check(szERE, &Regex, pERE, szString);
+        }
+
+        rxpFree(pERE);
+        regfree(&Regex);
+    }
+
+    printf("%lu EREs, %lu checks, %lu failures\n", cEREs, G_cChecks, G_cFailures);
+    return (G_cFailures) ? 1 : 0;
+}
+
@@ -0,0 +1,158 @@
+
+/*
+ *      Test and benchmark for strmap.c. Inserts a number of
+ *      generated names both into a string TREE and into a
+ *      STRMAP, checks that both return the same items, and
+ *      times the lookups.
+ *
+ *      Usage: _test_strmap [items [lookups]]
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "setup.h"                      // code generation and debugging options
+
+#include "helpers\tree.h"
+#include "helpers\strmap.h"
+
+#pragma hdrstop
+
+typedef struct _NAMENODE
+{
+    TREE        Tree;           // ulKey points to szName
+    char        szName[32];
+} NAMENODE, *PNAMENODE;
+
+/*
+ *@@ MakeName:
+ *      generates an element-like name such as "attr-1234-x"
+ *      which shares its prefix with many others, which is
+ *      the typical case for XML names.
+ */
+
+void MakeName(char *pszBuf,
+              unsigned long ul)
+{
+    static const char *apcszPrefixes[] =
+        {
+            "attribute", "element", "package", "title", "item", "id"
+        };
+
+    sprintf(pszBuf,
+            "%s-%lu-%c",
+            apcszPrefixes[ul % (sizeof(apcszPrefixes) / sizeof(apcszPrefixes[0]))],
+            ul,
+            'a' + (char)(ul % 26));
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned long   cItems = 5000,
+                    cLookups = 2000000,
+                    ul,
+                    cFound;
+    PNAMENODE       paNodes;
+    TREE            *TreeRoot;
+    STRMAP          Map;
+    clock_t         cl;
+    double          dTree,
+                    dMap;
+    int             rc = 0;
+
+    if (argc > 1)
+        cItems = strtoul(argv[1], NULL, 10);
+    if (argc > 2)
+        cLookups = strtoul(argv[2], NULL, 10);
+
+    if (!(paNodes = (PNAMENODE)malloc(cItems * sizeof(NAMENODE))))
+        return 2;
+
+    treeInit(&TreeRoot, NULL);
+    smapInit(&Map);
+
+    for (ul = 0; ul < cItems; ul++)
+    {
+        MakeName(paNodes[ul].szName, ul);
+        paNodes[ul].Tree.ulKey = (ULONG)paNodes[ul].szName;
+        treeInsert(&TreeRoot, NULL, &paNodes[ul].Tree, treeCompareStrings);
+        if (smapInsert(&Map, paNodes[ul].szName, &paNodes[ul]))
+        {
+            printf("smapInsert failed for \"%s\"\n", paNodes[ul].szName);
+            rc = 1;
+        }
+    }
+
+    // duplicates must be rejected
+    if (cItems && smapInsert(&Map, paNodes[0].szName, NULL) != SMAP_DUPLICATE_KEY)
+    {
+        printf("duplicate key not detected\n");
+        rc = 1;
+    }
+
+    // both containers must agree on every key and on a miss
+    for (ul = 0; ul < cItems * 2; ul++)
+    {
+        char szKey[32];
+        MakeName(szKey, ul);
+        if (    (PNAMENODE)treeFind(TreeRoot, (ULONG)szKey, treeCompareStrings)
+             != (PNAMENODE)smapFind(&Map, szKey)
+           )
+        {
+            printf("mismatch for \"%s\"\n", szKey);
+            rc = 1;
+        }
+    }
+
+    // remove every other item and check again
+    for (ul = 0; ul < cItems; ul += 2)
+        if (smapRemove(&Map, paNodes[ul].szName, NULL))
+        {
+            printf("smapRemove failed for \"%s\"\n", paNodes[ul].szName);
+            rc = 1;
+        }
+    for (ul = 0; ul < cItems; ul++)
+        if (!smapFind(&Map, paNodes[ul].szName) != !(ul & 1))
+        {
+            printf("bad lookup after remove for \"%s\"\n", paNodes[ul].szName);
+            rc = 1;
+        }
+    for (ul = 0; ul < cItems; ul += 2)
+        smapInsert(&Map, paNodes[ul].szName, &paNodes[ul]);
+
+    // benchmark: look up existing names in random order
+    srand(1);
+    cFound = 0;
+    cl = clock();
+    for (ul = 0; ul < cLookups; ul++)
+    {
+        PNAMENODE p = &paNodes[rand() % cItems];
+        if (treeFind(TreeRoot, p->Tree.ulKey, treeCompareStrings))
+            cFound++;
+    }
+    dTree = (double)(clock() - cl) / CLOCKS_PER_SEC;
+
+    srand(1);
+    cl = clock();
+    for (ul = 0; ul < cLookups; ul++)
+    {
+        PNAMENODE p = &paNodes[rand() % cItems];
+        if (smapFind(&Map, p->szName))
+            cFound++;
+    }
+    dMap = (double)(clock() - cl) / CLOCKS_PER_SEC;
+
+    printf("%lu items, %lu lookups each (%lu hits)\n",
+           cItems, cLookups, cFound);
+    printf("  TREE   (treeCompareStrings): %.3f s\n", dTree);
+    printf("  STRMAP (smapFind):           %.3f s\n", dMap);
+    printf("%s\n", (rc) ? "FAILED" : "OK");
+
+    smapClear(&Map);
+    free(paNodes);
+
+    return rc;
+}
+
@@ -0,0 +1,405 @@
+
+/*
+ *      Test for tree.c. Inserts and deletes random keys and
+ *      compares the tree with a plain array of the keys that
+ *      should be in it. After every operation, the whole tree
+ *      is checked for the red-black rules (red nodes have black
+ *      children, every path has the same number of black nodes,
+ *      the root is black), for key order in both directions, for
+ *      the parent pointers and for the item count.
+ *
+ *      The test runs in phases which mostly insert or mostly
+ *      delete, so that the tree keeps growing full and shrinking
+ *      to nothing, and deleteFixup also runs near empty trees.
+ *
+ *      Before that, treeBuildFromSorted builds a tree from every
+ *      count of nodes from 0 to BUILD_MAX, and the same checks run
+ *      on each (see TestBuildFromSorted), since its coloring of
+ *      the last level is only right if the depth is computed
+ *      exactly for every count.
+ *
+ *      If __TREE_ORDER_STATISTICS__ is defined, the test also
+ *      checks TREE.ulSize in every node and compares treeSelect,
+ *      treeRank and treeCountRange with the array. Since that
+ *      changes the TREE structure, tree.c and this file must both
+ *      be compiled with it, so build and run this twice: once as
+ *      is and once with -D__TREE_ORDER_STATISTICS__.
+ *
+ *      Usage: _test_tree [keys [operations [seed]]]
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "setup.h"                      // code generation and debugging options
+
+#include "helpers\tree.h"
+
+#pragma hdrstop
+
+#define MAX_REPORTS         20
+#define BUILD_MAX           3000
+
+TREE            *G_pLeaf;               // the sentinel, from treeInit
+long            G_lPrevKey;             // for the order check in CheckNode
+const char      *G_pcszError;           // set by CheckNode
+
+unsigned long   G_cChecks = 0,
+                G_cFailures = 0;
+
+/*
+ *@@ CheckNode:
+ *      checks the subtree below p recursively and returns
+ *      its black height, or -1 after setting G_pcszError
+ *      if it breaks one of the rules.
+ */
+
+int CheckNode(TREE *p,
+              TREE *pParent)
+{
+    int iLeft,
+        iRight;
+
+    if (p == G_pLeaf)
+        return 1;
+
+    if (p->parent != pParent)
+    {
+        G_pcszError = "bad parent pointer";
+        return -1;
+    }
+    if (    (p->color == RED)
+         && (    (p->left->color == RED)
+              || (p->right->color == RED)
+            )
+       )
+    {
+        G_pcszError = "red node with red child";
+        return -1;
+    }
+
+    if ((iLeft = CheckNode(p->left, p)) < 0)
+        return -1;
+    if ((long)p->ulKey <= G_lPrevKey)
+    {
+        G_pcszError = "keys out of order";
+        return -1;
+    }
+    G_lPrevKey = p->ulKey;
+    if ((iRight = CheckNode(p->right, p)) < 0)
+        return -1;
+
+    if (iLeft != iRight)
+    {
+        G_pcszError = "black heights differ";
+        return -1;
+    }
+#ifdef __TREE_ORDER_STATISTICS__
+    if (p->ulSize != p->left->ulSize + p->right->ulSize + 1)
+    {
+        G_pcszError = "bad ulSize";
+        return -1;
+    }
+#endif
+
+    return iLeft + (p->color == BLACK);
+}
+
+/*
+ *@@ CheckTree:
+ *      checks the tree against afPresent, which has TRUE
+ *      for every key from 0 to cKeys - 1 that should be
+ *      in it, and against the item count lCount that
+ *      treeInsert and treeDelete maintain. Returns FALSE
+ *      and prints what is wrong otherwise.
+ *
+ *      pcszWhat describes the last operation, for the
+ *      report.
+ */
+
+BOOL CheckTree(TREE *root,
+               LONG lCount,
+               const BOOL *afPresent,
+               ULONG cKeys,
+               const char *pcszWhat)
+{
+    TREE    *p;
+    ULONG   ul,
+            cPresent = 0;
+
+    G_cChecks++;
+    G_pcszError = NULL;
+
+    for (ul = 0; ul < cKeys; ul++)
+        if (afPresent[ul])
+            cPresent++;
+
+    if (    (G_pLeaf->color != BLACK)
+#ifdef __TREE_ORDER_STATISTICS__
+         || (G_pLeaf->ulSize)
+#endif
+       )
+        G_pcszError = "sentinel was changed";
+    else if (    (root != G_pLeaf)
+              && (root->color != BLACK)
+            )
+        G_pcszError = "root is not black";
+    else if (lCount != (LONG)cPresent)
+        G_pcszError = "wrong item count";
+    else
+    {
+        G_lPrevKey = -1;
+        CheckNode(root, NULL);
+    }
+
+    // every key must be found in order, going both ways
+    if (!G_pcszError)
+    {
+        p = treeFirst(root);
+        for (ul = 0; ul < cKeys && !G_pcszError; ul++)
+            if (afPresent[ul])
+            {
+                if (!p || p->ulKey != ul)
+                    G_pcszError = "treeNext does not match";
+                else
+                    p = treeNext(p);
+            }
+        if (!G_pcszError && p)
+            G_pcszError = "treeNext returns too many nodes";
+    }
+    if (!G_pcszError)
+    {
+        p = treeLast(root);
+        for (ul = cKeys; ul > 0 && !G_pcszError; ul--)
+            if (afPresent[ul - 1])
+            {
+                if (!p || p->ulKey != ul - 1)
+                    G_pcszError = "treePrev does not match";
+                else
+                    p = treePrev(p);
+            }
+        if (!G_pcszError && p)
+            G_pcszError = "treePrev returns too many nodes";
+    }
+
+#ifdef __TREE_ORDER_STATISTICS__
+    // compare a few order statistics with the array
+    if (    (!G_pcszError)
+         && (root != G_pLeaf)
+         && (root->ulSize != cPresent)
+       )
+        G_pcszError = "root ulSize is not the item count";
+
+    for (ul = 0; ul < 8 && cKeys && !G_pcszError; ul++)
+    {
+        ULONG   ulKey = rand() % cKeys,
+                ulKey2 = rand() % cKeys,
+                cBelow = 0,
+                cRange = 0,
+                ul2;
+
+        for (ul2 = 0; ul2 < cKeys; ul2++)
+            if (afPresent[ul2])
+            {
+                if (ul2 < ulKey)
+                    cBelow++;
+                if (ul2 >= ulKey && ul2 <= ulKey2)
+                    cRange++;
+            }
+
+        if (treeRank(root, ulKey, treeCompareKeys) != cBelow)
+            G_pcszError = "wrong treeRank";
+        else if (treeCountRange(root, ulKey, ulKey2, treeCompareKeys) != cRange)
+            G_pcszError = "wrong treeCountRange";
+        else if (afPresent[ulKey])
+        {
+            if (    (!(p = treeSelect(root, cBelow)))
+                 || (p->ulKey != ulKey)
+               )
+                G_pcszError = "wrong treeSelect";
+        }
+        else if (    (cBelow == cPresent)
+                  && (treeSelect(root, cBelow))
+                )
+            G_pcszError = "treeSelect past the end";
+    }
+#endif
+
+    if (G_pcszError)
+    {
+        if (++G_cFailures <= MAX_REPORTS)
+            printf("%s: %s (%lu items)\n",
+                   pcszWhat,
+                   G_pcszError,
+                   cPresent);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/*
+ *@@ TestBuildFromSorted:
+ *      builds trees of 0 to BUILD_MAX nodes with
+ *      treeBuildFromSorted and checks each of them.
+ *      The nodes are filled with garbage first, so
+ *      that every member must be set by the build.
+ */
+
+VOID TestBuildFromSorted(VOID)
+{
+    TREE    *paNodes,
+            **papNodes,
+            *root;
+    BOOL    *afPresent;
+    ULONG   c,
+            ul;
+
+    if (    (!(paNodes = (TREE*)malloc(BUILD_MAX * sizeof(TREE))))
+         || (!(papNodes = (TREE**)malloc(BUILD_MAX * sizeof(TREE*))))
+         || (!(afPresent = (BOOL*)malloc(BUILD_MAX * sizeof(BOOL))))
+       )
+        exit(2);
+
+    for (c = 0; c <= BUILD_MAX; c++)
+    {
+        char    szWhat[100];
+
+        memset(paNodes, 0xAA, BUILD_MAX * sizeof(TREE));
+        for (ul = 0; ul < c; ul++)
+        {
+            paNodes[ul].ulKey = ul;
+            papNodes[ul] = &paNodes[ul];
+        }
+        for (ul = 0; ul < BUILD_MAX; ul++)
+            afPresent[ul] = (ul < c);
+
+        sprintf(szWhat, "treeBuildFromSorted with %lu nodes", c);
+        if (treeBuildFromSorted(&root, papNodes, c))
+        {
+            printf("%s: failed\n", szWhat);
+            G_cFailures++;
+        }
+        else
+            CheckTree(root, c, afPresent, BUILD_MAX, szWhat);
+    }
+
+    free(afPresent);
+    free(papNodes);
+    free(paNodes);
+}
+
+int main(int argc, char *argv[])
+{
+    ULONG   cKeys = 500,
+            cOps = 100000,
+            ul;
+    TREE    *paNodes,
+            Duplicate,
+            *root;
+    LONG    lCount;
+    BOOL    *afPresent;
+
+    if (argc > 1)
+        cKeys = strtoul(argv[1], NULL, 10);
+    if (argc > 2)
+        cOps = strtoul(argv[2], NULL, 10);
+    srand((argc > 3) ? atoi(argv[3]) : 1);
+
+    if (    (!cKeys)
+         || (!(paNodes = (TREE*)calloc(cKeys, sizeof(TREE))))
+         || (!(afPresent = (BOOL*)calloc(cKeys, sizeof(BOOL))))
+       )
+        return 2;
+
+    treeInit(&G_pLeaf, NULL);
+
+    TestBuildFromSorted();
+
+    treeInit(&root, &lCount);
+    CheckTree(root, lCount, afPresent, cKeys, "empty tree");
+
+    for (ul = 0; ul < cOps; ul++)
+    {
+        // mostly inserting in even phases, mostly deleting in odd ones
+        int     iInsertPercent = ((ul / (cKeys * 2)) & 1) ? 25 : 75;
+        ULONG   ulKey = rand() % cKeys;
+        char    szWhat[100];
+
+        if (rand() % 100 < iInsertPercent)
+        {
+            if (afPresent[ulKey])
+            {
+                // must be refused without changing anything
+                Duplicate.ulKey = ulKey;
+                sprintf(szWhat, "insert duplicate %lu", ulKey);
+                if (treeInsert(&root, &lCount, &Duplicate, treeCompareKeys) != STATUS_DUPLICATE_KEY)
+                {
+                    printf("%s: not refused\n", szWhat);
+                    G_cFailures++;
+                    break;
+                }
+            }
+            else
+            {
+                paNodes[ulKey].ulKey = ulKey;
+                sprintf(szWhat, "insert %lu", ulKey);
+                if (treeInsert(&root, &lCount, &paNodes[ulKey], treeCompareKeys))
+                {
+                    printf("%s: failed\n", szWhat);
+                    G_cFailures++;
+                    break;
+                }
+                afPresent[ulKey] = TRUE;
+            }
+        }
+        else
+        {
+            if (!afPresent[ulKey])
+            {
+                sprintf(szWhat, "find missing %lu", ulKey);
+                if (treeFind(root, ulKey, treeCompareKeys))
+                {
+                    printf("%s: found\n", szWhat);
+                    G_cFailures++;
+                    break;
+                }
+            }
+            else
+            {
+                sprintf(szWhat, "delete %lu", ulKey);
+                if (    (treeFind(root, ulKey, treeCompareKeys) != &paNodes[ulKey])
+                     || (treeDelete(&root, &lCount, &paNodes[ulKey]))
+                   )
+                {
+                    printf("%s: failed\n", szWhat);
+                    G_cFailures++;
+                    break;
+                }
+                afPresent[ulKey] = FALSE;
+            }
+        }
+
+        if (!CheckTree(root, lCount, afPresent, cKeys, szWhat))
+            // the tree is broken, so the next checks would only repeat it
+            break;
+    }
+
+    printf("%lu keys, %lu operations, %lu checks, %lu failures%s\n",
+           cKeys,
+           cOps,
+           G_cChecks,
+           G_cFailures,
+#ifdef __TREE_ORDER_STATISTICS__
+           " (with order statistics)"
+#else
+           ""
+#endif
+           );
+
+    free(afPresent);
+    free(paNodes);
+
+    return (G_cFailures) ? 1 : 0;
+}
@@ -0,0 +1,146 @@
+
+/*
+ *      Test for the validation in xml.c. Parses a number of
+ *      small documents, each of which breaks its DTD in one
+ *      way, and checks that xmlParse reports a validity error
+ *      with the right error code, failing node and position.
+ *      A valid document is parsed first, so that the tests
+ *      don't pass just because everything is rejected.
+ *
+ *      Usage: _test_xml
+ */
+
+#define INCL_DOSERRORS
+#include <os2.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "setup.h"                      // code generation and debugging options
+
+#include "expat\expat.h"
+
+#include "helpers\linklist.h"
+#include "helpers\tree.h"
+#include "helpers\strmap.h"
+#include "helpers\xstring.h"
+#include "helpers\xml.h"
+
+#pragma hdrstop
+
+typedef struct _INVALIDDOC
+{
+    const char  *pcszDoc;
+    APIRET      arcExpected;        // expected arcDOM
+    const char  *pcszFailing;       // expected failing node
+} INVALIDDOC, *PINVALIDDOC;
+
+INVALIDDOC  G_aInvalidDocs[] =
+    {
+        {
+            "<!DOCTYPE ref [<!ELEMENT ref EMPTY>]><ref>text</ref>",
+            ERROR_ELEMENT_CANNOT_HAVE_CONTENT, "ref"
+        },
+        {
+            "<!DOCTYPE ref [<!ELEMENT ref EMPTY><!ELEMENT x EMPTY>]><ref><x/></ref>",
+            ERROR_DOM_SUBELEMENT_IN_EMPTY_ELEMENT, "x"
+        },
+        {
+            "<!DOCTYPE a [<!ELEMENT a (b)><!ELEMENT b EMPTY>]><a>text</a>",
+            ERROR_ELEMENT_CANNOT_HAVE_CONTENT, "a"
+        },
+        {
+            "<!DOCTYPE a [<!ELEMENT a (#PCDATA)><!ELEMENT a EMPTY>]><a/>",
+            ERROR_DOM_DUPLICATE_ELEMENT_DECL, "a"
+        },
+        {
+            "<!DOCTYPE a [<!ELEMENT a EMPTY>"
+                "<!ATTLIST a x CDATA #IMPLIED>"
+                "<!ATTLIST a x CDATA #REQUIRED>]><a/>",
+            ERROR_DOM_DUPLICATE_ATTRIBUTE_DECL, "x"
+        }
+    };
+
+/*
+ *@@ Parse:
+ *      parses pcszDoc into a new DOM with DTD validation
+ *      and returns the xmlParse return code. The caller
+ *      must free *ppDom.
+ */
+
+APIRET Parse(const char *pcszDoc,
+             PXMLDOM *ppDom)
+{
+    APIRET arc;
+
+    if (!(arc = xmlCreateDOM(DF_PARSEDTD,
+                             NULL,
+                             0,
+                             NULL,
+                             NULL,
+                             NULL,
+                             ppDom)))
+        arc = xmlParse(*ppDom,
+                       pcszDoc,
+                       strlen(pcszDoc),
+                       TRUE);
+    return arc;
+}
+
+int main(int argc, char *argv[])
+{
+    static const char *pcszValid =
+            "<!DOCTYPE ref [<!ELEMENT ref (x*)><!ELEMENT x EMPTY>"
+                "<!ATTLIST x id CDATA #REQUIRED>]>"
+            "<ref> <x id=\"1\"/> <x id=\"2\"/> </ref>";
+    PXMLDOM     pDom = NULL;
+    APIRET      arc;
+    int         i,
+                rc = 0;
+
+    if (arc = Parse(pcszValid, &pDom))
+    {
+        printf("valid document rejected, rc = %lu\n", arc);
+        rc = 1;
+    }
+    xmlFreeDOM(pDom);
+
+    for (i = 0; i < sizeof(G_aInvalidDocs) / sizeof(G_aInvalidDocs[0]); i++)
+    {
+        PINVALIDDOC pDoc = &G_aInvalidDocs[i];
+
+        pDom = NULL;
+        if ((arc = Parse(pDoc->pcszDoc, &pDom)) != ERROR_DOM_VALIDITY)
+        {
+            printf("\"%s\": expected rc %lu, got %lu\n",
+                   pDoc->pcszDoc,
+                   (ULONG)ERROR_DOM_VALIDITY,
+                   arc);
+            rc = 1;
+        }
+        else if (    (pDom->arcDOM != pDoc->arcExpected)
+                  || (!pDom->fInvalid)
+                  || (!pDom->pxstrFailingNode)
+                  || (strcmp(pDom->pxstrFailingNode->psz, pDoc->pcszFailing))
+                  || (!pDom->ulErrorLine)
+                )
+        {
+            printf("\"%s\": expected error %lu at \"%s\", got %lu at \"%s\" (line %lu)\n",
+                   pDoc->pcszDoc,
+                   pDoc->arcExpected,
+                   pDoc->pcszFailing,
+                   pDom->arcDOM,
+                   (pDom->pxstrFailingNode) ? pDom->pxstrFailingNode->psz : "",
+                   pDom->ulErrorLine);
+            rc = 1;
+        }
+        xmlFreeDOM(pDom);
+    }
+
+    printf("%d invalid documents, %s\n",
+           i,
+           (rc) ? "FAILED" : "OK");
+
+    return rc;
+}
@@ -0,0 +1,333 @@
+
+/*
+ *      Benchmark for the expat tokenizer. Times XML_Parse over
+ *      generated documents of four shapes: text-heavy (long runs
+ *      of character data), attribute-heavy (many long attribute
+ *      values), markup-heavy (short content, long element names)
+ *      and UTF-8 text (character data with multi-byte characters).
+ *
+ *      Every document is parsed in one go and in 4 KB chunks, as
+ *      xmlParse would get it from a file, so that tokens split
+ *      across buffers are covered too. The handlers count elements,
+ *      attributes and bytes of character data, and the counts are
+ *      printed, so that changes to the tokenizer can be checked for
+ *      speed and results at once.
+ *
+ *      Usage: _test_xmlbench [doc size [repeats]]
+ */
+
+#define INCL_DOSERRORS
+#include <os2.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "setup.h"                      // code generation and debugging options
+
+#include "expat\expat.h"
+
+#pragma hdrstop
+
+#define CHUNK_SIZE          4096
+
+typedef struct _COUNTS
+{
+    unsigned long   cElements,
+                    cAttribs,
+                    cbChars;
+} COUNTS, *PCOUNTS;
+
+typedef struct _BENCH
+{
+    const char  *pcszName;
+    char        *pszDoc;        // filled in by MakeDocs
+    int         cbDoc;
+} BENCH, *PBENCH;
+
+BENCH   G_aBenches[] =
+    {
+        { "text", NULL, 0 },
+        { "attributes", NULL, 0 },
+        { "markup", NULL, 0 },
+        { "utf-8 text", NULL, 0 }
+    };
+
+#define BENCH_TEXT      0
+#define BENCH_ATTRIBS   1
+#define BENCH_MARKUP    2
+#define BENCH_UTF8      3
+
+/*
+ *@@ AppendWords:
+ *      appends cWords random words from the given list,
+ *      separated by spaces, and returns the new end.
+ */
+
+char* AppendWords(char *p,
+                  const char **papcszWords,
+                  int cWordsInList,
+                  int cWords)
+{
+    int i;
+    for (i = 0; i < cWords; i++)
+        p += sprintf(p,
+                     "%s%s",
+                     (i) ? " " : "",
+                     papcszWords[rand() % cWordsInList]);
+    return p;
+}
+
+/*
+ *@@ MakeDocs:
+ *      generates the documents, of about cb bytes each.
+ */
+
+BOOL MakeDocs(int cb)
+{
+    static const char *apcszWords[] =
+        {
+            "the", "workplace", "shell", "folder", "object", "settings",
+            "notebook", "desktop", "drive", "program", "reference", "a",
+            "and", "of", "OS/2", "1234", "&amp;", "&lt;", "(default)"
+        };
+    static const char *apcszUTF8Words[] =
+        {
+            "Ordner", "\xC3\x9C" "bersicht", "Gr\xC3\xB6\xC3\x9F" "e",
+            "Schl\xC3\xBCssel", "\xE2\x82\xAC", "caf\xC3\xA9", "na\xC3\xAFve",
+            "\xE6\x96\x87\xE5\xAD\x97", "und", "der", "\xF0\x9F\x93\x81"
+        };
+    static const char *apcszNames[] =
+        {
+            "WPFolder", "WPProgram", "WPDesktop", "WPDataFile",
+            "WPShadow", "WPPrinter", "WPDrives", "WPNetwork"
+        };
+    #define WORDS       (sizeof(apcszWords) / sizeof(apcszWords[0]))
+    #define UTF8WORDS   (sizeof(apcszUTF8Words) / sizeof(apcszUTF8Words[0]))
+    #define NAMES       (sizeof(apcszNames) / sizeof(apcszNames[0]))
+    int     i;
+
+    srand(1);
+    for (i = 0; i < sizeof(G_aBenches) / sizeof(G_aBenches[0]); i++)
+    {
+        PBENCH  pBench = &G_aBenches[i];
+        char    *p;
+
+        if (!(pBench->pszDoc = (char*)malloc(cb + 1000)))
+            return FALSE;
+
+        p = pBench->pszDoc;
+        p += sprintf(p, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<doc>\n");
+        while (p - pBench->pszDoc < cb)
+        {
+            switch (i)
+            {
+                case BENCH_TEXT:
+                    p += sprintf(p, "<para>");
+                    p = AppendWords(p, apcszWords, WORDS, 40 + rand() % 80);
+                    p += sprintf(p, "</para>\n");
+                break;
+
+                case BENCH_ATTRIBS:
+                {
+                    int cAttribs = 3 + rand() % 6,
+                        a;
+                    p += sprintf(p, "<object");
+                    for (a = 0; a < cAttribs; a++)
+                    {
+                        p += sprintf(p, " attrib%d=\"", a);
+                        p = AppendWords(p, apcszWords, WORDS, 2 + rand() % 10);
+                        *p++ = '"';
+                    }
+                    p += sprintf(p, "/>\n");
+                }
+                break;
+
+                case BENCH_MARKUP:
+                {
+                    const char *pcszName = apcszNames[rand() % NAMES];
+                    p += sprintf(p,
+                                 "<%sContainer><%sObjectIdentifier>%d</%sObjectIdentifier>"
+                                 "<%sEmptyElementWithLongName/></%sContainer>\n",
+                                 pcszName,
+                                 pcszName,
+                                 rand(),
+                                 pcszName,
+                                 pcszName,
+                                 pcszName);
+                }
+                break;
+
+                case BENCH_UTF8:
+                    p += sprintf(p, "<para>");
+                    p = AppendWords(p, apcszUTF8Words, UTF8WORDS, 40 + rand() % 80);
+                    p += sprintf(p, "</para>\n");
+                break;
+            }
+        }
+        p += sprintf(p, "</doc>\n");
+        pBench->cbDoc = p - pBench->pszDoc;
+    }
+
+    return TRUE;
+}
+
+/*
+ *@@ StartElement:
+ *
+ */
+
+void EXPATENTRY StartElement(void *pUserData,
+                             const XML_Char *pcszElement,
+                             const XML_Char **papcszAttribs)
+{
+    PCOUNTS pCounts = (PCOUNTS)pUserData;
+    pCounts->cElements++;
+    while (*papcszAttribs)
+    {
+        pCounts->cAttribs++;
+        papcszAttribs += 2;
+    }
+}
+
+/*
+ *@@ EndElement:
+ *
+ */
+
+void EXPATENTRY EndElement(void *pUserData,
+                           const XML_Char *pcszElement)
+{
+}
+
+/*
+ *@@ CharacterData:
+ *
+ */
+
+void EXPATENTRY CharacterData(void *pUserData,
+                              const XML_Char *pcsz,
+                              int len)
+{
+    ((PCOUNTS)pUserData)->cbChars += len;
+}
+
+/*
+ *@@ Parse:
+ *      parses the document, in chunks of cbChunk bytes,
+ *      and counts what it contains. Returns FALSE on
+ *      errors.
+ */
+
+BOOL Parse(const char *pcszDoc,
+           int cbDoc,
+           int cbChunk,
+           PCOUNTS pCounts)
+{
+    XML_Parser  p;
+    int         ofs = 0;
+    BOOL        brc = TRUE;
+
+    memset(pCounts, 0, sizeof(COUNTS));
+    if (!(p = XML_ParserCreate(NULL)))
+        return FALSE;
+    XML_SetUserData(p, pCounts);
+    XML_SetElementHandler(p, StartElement, EndElement);
+    XML_SetCharacterDataHandler(p, CharacterData);
+
+    do
+    {
+        int cb = cbDoc - ofs;
+        if (cb > cbChunk)
+            cb = cbChunk;
+        if (!XML_Parse(p, pcszDoc + ofs, cb, (ofs + cb == cbDoc)))
+        {
+            printf("XML_Parse failed: %s, line %d\n",
+                   XML_ErrorString(XML_GetErrorCode(p)),
+                   XML_GetCurrentLineNumber(p));
+            brc = FALSE;
+            break;
+        }
+        ofs += cb;
+    } while (ofs < cbDoc);
+
+    XML_ParserFree(p);
+    return brc;
+}
+
+/*
+ *@@ Seconds:
+ *
+ */
+
+double Seconds(clock_t cl)
+{
+    return (double)(clock() - cl) / CLOCKS_PER_SEC;
+}
+
+int main(int argc, char *argv[])
+{
+    int     cbDoc = 4000000,
+            cRepeats = 5,
+            i;
+
+    if (argc > 1)
+        cbDoc = atoi(argv[1]);
+    if (argc > 2)
+        cRepeats = atoi(argv[2]);
+
+    if (!MakeDocs(cbDoc))
+        return 2;
+
+    printf("%d bytes per document, best of %d runs\n\n", cbDoc, cRepeats);
+    printf("%-11s %9s %9s %10s %10s %10s\n",
+           "document", "elements", "attribs", "chars", "whole", "chunked");
+
+    for (i = 0; i < sizeof(G_aBenches) / sizeof(G_aBenches[0]); i++)
+    {
+        PBENCH  pBench = &G_aBenches[i];
+        double  dWhole = 1e9,
+                dChunked = 1e9;
+        COUNTS  Whole,
+                Chunked;
+        int     iRun;
+
+        for (iRun = 0; iRun < cRepeats; iRun++)
+        {
+            clock_t cl = clock();
+            double  d;
+
+            if (!Parse(pBench->pszDoc, pBench->cbDoc, pBench->cbDoc, &Whole))
+                return 2;
+            if ((d = Seconds(cl)) < dWhole)
+                dWhole = d;
+
+            cl = clock();
+            if (!Parse(pBench->pszDoc, pBench->cbDoc, CHUNK_SIZE, &Chunked))
+                return 2;
+            if ((d = Seconds(cl)) < dChunked)
+                dChunked = d;
+        }
+
+        if (memcmp(&Whole, &Chunked, sizeof(COUNTS)))
+        {
+            printf("%s: counts differ when parsed in chunks\n", pBench->pcszName);
+            return 1;
+        }
+
+        printf("%-11s %9lu %9lu %10lu %6.1fMB/s %6.1fMB/s\n",
+               pBench->pcszName,
+               Whole.cElements,
+               Whole.cAttribs,
+               Whole.cbChars,
+               pBench->cbDoc / dWhole / 1e6,
+               pBench->cbDoc / dChunked / 1e6);
+    }
+
+    for (i = 0; i < sizeof(G_aBenches) / sizeof(G_aBenches[0]); i++)
+        free(G_aBenches[i].pszDoc);
+
+    return 0;
+}
+
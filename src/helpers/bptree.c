@@ -0,0 +1,826 @@
+
+/*
+ *@@sourcefile bptree.c:
+ *      contains helper functions for maintaining B+ trees,
+ *      a cache-friendly alternative to the red-black trees
+ *      in tree.c.
+ *
+ *      Usage: All C programs; not OS/2-specific.
+ *
+ *      Function prefixes:
+ *      --  bpt*    B+ tree helper functions
+ *
+ *      <B>Introduction</B>
+ *
+ *      The red-black trees in tree.c embed a TREE structure in
+ *      every user item. That is very convenient since the tree
+ *      functions never allocate memory, but every step of a
+ *      search has to follow a pointer to a different heap
+ *      block, which is slow for large trees since nearly every
+ *      comparison touches a new cache line.
+ *
+ *      A B+ tree instead stores many keys in one node, in a
+ *      contiguous array. A search does a binary search in that
+ *      array and then descends into one of the node's children;
+ *      with BPT_MAXKEYS keys per node, a tree with one million
+ *      items is only four or five levels deep. All keys and
+ *      their data pointers are stored in the leaf nodes, which
+ *      are linked to each other, so iterating over the tree in
+ *      sorted order is a simple array walk.
+ *
+ *      Differences compared to tree.c:
+ *
+ *      -- The B+ tree allocates its own nodes. Your items need
+ *         no TREE header; the tree stores a ULONG key and a
+ *         void* data pointer for each item instead.
+ *
+ *      -- The comparison functions are the same, so you can
+ *         use treeCompareKeys and treeCompareStrings or your
+ *         own FNTREE_COMPARE. As with tree.c, duplicate keys
+ *         are not allowed.
+ *
+ *      -- Items are addressed by key, not by node. To delete
+ *         an item, call bptDelete with its key.
+ *
+ *      -- Iteration uses a BPTITER instead of a TREE pointer.
+ *         Iterators become invalid when the tree is modified.
+ *
+ *      <B>Example</B>
+ *
+ +          BPTREE  Tree;
+ +          BPTITER Iter;
+ +
+ +          bptInit(&Tree, treeCompareStrings);
+ +          bptInsert(&Tree, (ULONG)pItem->pszName, pItem);
+ +          ...
+ +          pItem = (PMYITEM)bptFind(&Tree, (ULONG)"name", NULL);
+ +          ...
+ +          if (bptFirst(&Tree, &Iter))
+ +              do
+ +              {
+ +                  PMYITEM p = (PMYITEM)bptIterData(&Iter);
+ +                  ...
+ +              } while (bptNext(&Iter));
+ +
+ +          bptClear(&Tree);
+ *
+ *      Note: Version numbering in this file relates to XWorkplace version
+ *            numbering.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ *@@header "helpers\bptree.h"
+ */
+
+/*
+ *      Copyright (C) 2026 the XWorkplace helpers authors.
+ *      This file is part of the "XWorkplace helpers" source package.
+ *      This is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published
+ *      by the Free Software Foundation, in version 2 as it comes in the
+ *      "COPYING" file of the XWorkplace main distribution.
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "setup.h"                      // code generation and debugging options
+
+#include "helpers\tree.h"
+#include "helpers\bptree.h"
+
+#pragma hdrstop
+
+/*
+ *@@category: Helpers\C helpers\B+ trees
+ *      See bptree.c.
+ */
+
+/* ******************************************************************
+ *
+ *   Private declarations
+ *
+ ********************************************************************/
+
+// max no. of keys per node; this must be odd so that a
+// full node can be split into two halves of BPT_MINKEYS
+// keys each (plus one separator for internal nodes)
+#define BPT_MAXKEYS         31
+#define BPT_MINKEYS         (BPT_MAXKEYS / 2)
+
+/*
+ *@@ BPTNODE:
+ *      B+ tree node. Internal nodes have cKeys
+ *      separator keys and cKeys + 1 children; all
+ *      keys in apChildren[i] are >= aulKeys[i - 1]
+ *      and < aulKeys[i]. Leaf nodes have cKeys keys
+ *      with their data pointers and are linked to
+ *      their neighbors.
+ */
+
+typedef struct _BPTNODE
+{
+    BOOL        fLeaf;
+    ULONG       cKeys;
+    ULONG       aulKeys[BPT_MAXKEYS];
+    union
+    {
+        struct _BPTNODE *apChildren[BPT_MAXKEYS + 1];
+        struct
+        {
+            void*           apvData[BPT_MAXKEYS];
+            struct _BPTNODE *pNext,
+                            *pPrev;
+        } l;
+    } u;
+} BPTNODE;
+
+/*
+ *@@ bptNewNode:
+ *
+ */
+
+STATIC PBPTNODE bptNewNode(BOOL fLeaf)
+{
+    PBPTNODE p;
+
+    if ((p = (PBPTNODE)malloc(sizeof(BPTNODE))))
+    {
+        memset(p, 0, sizeof(BPTNODE));
+        p->fLeaf = fLeaf;
+    }
+
+    return p;
+}
+
+/*
+ *@@ bptFreeNodes:
+ *
+ */
+
+STATIC void bptFreeNodes(PBPTNODE p)
+{
+    if (!p->fLeaf)
+    {
+        ULONG ul;
+        for (ul = 0; ul <= p->cKeys; ul++)
+            bptFreeNodes(p->u.apChildren[ul]);
+    }
+
+    free(p);
+}
+
+/*
+ *@@ bptUpperBound:
+ *      returns the index of the first key in the
+ *      node which is greater than ulKey (or cKeys).
+ *      This is the child to descend into for
+ *      internal nodes.
+ */
+
+STATIC ULONG bptUpperBound(PBPTNODE p,
+                           ULONG ulKey,
+                           FNTREE_COMPARE *pfnCompare)
+{
+    ULONG   ulLo = 0,
+            ulHi = p->cKeys;
+
+    while (ulLo < ulHi)
+    {
+        ULONG ulMid = (ulLo + ulHi) / 2;
+        if (pfnCompare(ulKey, p->aulKeys[ulMid]) < 0)
+            ulHi = ulMid;
+        else
+            ulLo = ulMid + 1;
+    }
+
+    return ulLo;
+}
+
+/*
+ *@@ bptLowerBound:
+ *      returns the index of the first key in the
+ *      node which is greater than or equal to ulKey
+ *      (or cKeys).
+ */
+
+STATIC ULONG bptLowerBound(PBPTNODE p,
+                           ULONG ulKey,
+                           FNTREE_COMPARE *pfnCompare)
+{
+    ULONG   ulLo = 0,
+            ulHi = p->cKeys;
+
+    while (ulLo < ulHi)
+    {
+        ULONG ulMid = (ulLo + ulHi) / 2;
+        if (pfnCompare(ulKey, p->aulKeys[ulMid]) > 0)
+            ulLo = ulMid + 1;
+        else
+            ulHi = ulMid;
+    }
+
+    return ulLo;
+}
+
+/*
+ *@@ bptSplitChild:
+ *      splits the full child at index ul of the
+ *      non-full internal node pParent into two
+ *      nodes and inserts the new separator key
+ *      into pParent.
+ *
+ *      Returns FALSE if no memory could be
+ *      allocated; the tree is unchanged then.
+ */
+
+STATIC BOOL bptSplitChild(PBPTREE pTree,
+                          PBPTNODE pParent,
+                          ULONG ul)
+{
+    PBPTNODE    pLeft = pParent->u.apChildren[ul],
+                pRight;
+    ULONG       ulSep;
+
+    if (!(pRight = bptNewNode(pLeft->fLeaf)))
+        return FALSE;
+
+    if (pLeft->fLeaf)
+    {
+        // leaf: the upper half goes to the new node, whose
+        // first key becomes the separator (and stays in the leaf)
+        pRight->cKeys = BPT_MAXKEYS - BPT_MINKEYS;
+        memcpy(pRight->aulKeys,
+               &pLeft->aulKeys[BPT_MINKEYS],
+               pRight->cKeys * sizeof(ULONG));
+        memcpy(pRight->u.l.apvData,
+               &pLeft->u.l.apvData[BPT_MINKEYS],
+               pRight->cKeys * sizeof(void*));
+        pLeft->cKeys = BPT_MINKEYS;
+        ulSep = pRight->aulKeys[0];
+
+        // link leafs
+        pRight->u.l.pNext = pLeft->u.l.pNext;
+        pRight->u.l.pPrev = pLeft;
+        if (pLeft->u.l.pNext)
+            pLeft->u.l.pNext->u.l.pPrev = pRight;
+        else
+            pTree->pLastLeaf = pRight;
+        pLeft->u.l.pNext = pRight;
+    }
+    else
+    {
+        // internal: the middle key moves up to the parent
+        ulSep = pLeft->aulKeys[BPT_MINKEYS];
+        pRight->cKeys = BPT_MAXKEYS - BPT_MINKEYS - 1;
+        memcpy(pRight->aulKeys,
+               &pLeft->aulKeys[BPT_MINKEYS + 1],
+               pRight->cKeys * sizeof(ULONG));
+        memcpy(pRight->u.apChildren,
+               &pLeft->u.apChildren[BPT_MINKEYS + 1],
+               (pRight->cKeys + 1) * sizeof(PBPTNODE));
+        pLeft->cKeys = BPT_MINKEYS;
+    }
+
+    // make room in the parent
+    memmove(&pParent->aulKeys[ul + 1],
+            &pParent->aulKeys[ul],
+            (pParent->cKeys - ul) * sizeof(ULONG));
+    memmove(&pParent->u.apChildren[ul + 2],
+            &pParent->u.apChildren[ul + 1],
+            (pParent->cKeys - ul) * sizeof(PBPTNODE));
+    pParent->aulKeys[ul] = ulSep;
+    pParent->u.apChildren[ul + 1] = pRight;
+    pParent->cKeys++;
+
+    return TRUE;
+}
+
+/*
+ *@@ bptFixChild:
+ *      makes sure that the child at index ul of the
+ *      internal node pParent has more than BPT_MINKEYS
+ *      keys by borrowing a key from a sibling or merging
+ *      it with a sibling. This never allocates memory.
+ *
+ *      Returns the index of the child which now covers
+ *      the keys of the original child (which changes if
+ *      it was merged into its left sibling).
+ */
+
+STATIC ULONG bptFixChild(PBPTREE pTree,
+                         PBPTNODE pParent,
+                         ULONG ul)
+{
+    PBPTNODE    pChild = pParent->u.apChildren[ul],
+                pLeft = (ul > 0) ? pParent->u.apChildren[ul - 1] : NULL,
+                pRight = (ul < pParent->cKeys) ? pParent->u.apChildren[ul + 1] : NULL;
+
+    if (pLeft && pLeft->cKeys > BPT_MINKEYS)
+    {
+        // borrow the last key of the left sibling
+        memmove(&pChild->aulKeys[1],
+                &pChild->aulKeys[0],
+                pChild->cKeys * sizeof(ULONG));
+        if (pChild->fLeaf)
+        {
+            memmove(&pChild->u.l.apvData[1],
+                    &pChild->u.l.apvData[0],
+                    pChild->cKeys * sizeof(void*));
+            pChild->aulKeys[0] = pLeft->aulKeys[pLeft->cKeys - 1];
+            pChild->u.l.apvData[0] = pLeft->u.l.apvData[pLeft->cKeys - 1];
+            pParent->aulKeys[ul - 1] = pChild->aulKeys[0];
+        }
+        else
+        {
+            memmove(&pChild->u.apChildren[1],
+                    &pChild->u.apChildren[0],
+                    (pChild->cKeys + 1) * sizeof(PBPTNODE));
+            pChild->aulKeys[0] = pParent->aulKeys[ul - 1];
+            pChild->u.apChildren[0] = pLeft->u.apChildren[pLeft->cKeys];
+            pParent->aulKeys[ul - 1] = pLeft->aulKeys[pLeft->cKeys - 1];
+        }
+        pChild->cKeys++;
+        pLeft->cKeys--;
+    }
+    else if (pRight && pRight->cKeys > BPT_MINKEYS)
+    {
+        // borrow the first key of the right sibling
+        if (pChild->fLeaf)
+        {
+            pChild->aulKeys[pChild->cKeys] = pRight->aulKeys[0];
+            pChild->u.l.apvData[pChild->cKeys] = pRight->u.l.apvData[0];
+            memmove(&pRight->u.l.apvData[0],
+                    &pRight->u.l.apvData[1],
+                    (pRight->cKeys - 1) * sizeof(void*));
+            memmove(&pRight->aulKeys[0],
+                    &pRight->aulKeys[1],
+                    (pRight->cKeys - 1) * sizeof(ULONG));
+            pParent->aulKeys[ul] = pRight->aulKeys[0];
+        }
+        else
+        {
+            pChild->aulKeys[pChild->cKeys] = pParent->aulKeys[ul];
+            pChild->u.apChildren[pChild->cKeys + 1] = pRight->u.apChildren[0];
+            pParent->aulKeys[ul] = pRight->aulKeys[0];
+            memmove(&pRight->aulKeys[0],
+                    &pRight->aulKeys[1],
+                    (pRight->cKeys - 1) * sizeof(ULONG));
+            memmove(&pRight->u.apChildren[0],
+                    &pRight->u.apChildren[1],
+                    pRight->cKeys * sizeof(PBPTNODE));
+        }
+        pChild->cKeys++;
+        pRight->cKeys--;
+    }
+    else
+    {
+        // both siblings are minimal: merge with one of them
+        if (!pRight)
+        {
+            // merge into left sibling
+            pRight = pChild;
+            pChild = pLeft;
+            ul--;
+        }
+
+        if (pChild->fLeaf)
+        {
+            memcpy(&pChild->aulKeys[pChild->cKeys],
+                   pRight->aulKeys,
+                   pRight->cKeys * sizeof(ULONG));
+            memcpy(&pChild->u.l.apvData[pChild->cKeys],
+                   pRight->u.l.apvData,
+                   pRight->cKeys * sizeof(void*));
+            pChild->cKeys += pRight->cKeys;
+
+            pChild->u.l.pNext = pRight->u.l.pNext;
+            if (pRight->u.l.pNext)
+                pRight->u.l.pNext->u.l.pPrev = pChild;
+            else
+                pTree->pLastLeaf = pChild;
+        }
+        else
+        {
+            pChild->aulKeys[pChild->cKeys] = pParent->aulKeys[ul];
+            memcpy(&pChild->aulKeys[pChild->cKeys + 1],
+                   pRight->aulKeys,
+                   pRight->cKeys * sizeof(ULONG));
+            memcpy(&pChild->u.apChildren[pChild->cKeys + 1],
+                   pRight->u.apChildren,
+                   (pRight->cKeys + 1) * sizeof(PBPTNODE));
+            pChild->cKeys += pRight->cKeys + 1;
+        }
+
+        // remove separator and right node from parent
+        memmove(&pParent->aulKeys[ul],
+                &pParent->aulKeys[ul + 1],
+                (pParent->cKeys - ul - 1) * sizeof(ULONG));
+        memmove(&pParent->u.apChildren[ul + 1],
+                &pParent->u.apChildren[ul + 2],
+                (pParent->cKeys - ul - 1) * sizeof(PBPTNODE));
+        pParent->cKeys--;
+
+        free(pRight);
+    }
+
+    return ul;
+}
+
+/* ******************************************************************
+ *
+ *   B+ tree functions
+ *
+ ********************************************************************/
+
+/*
+ *@@ bptInit:
+ *      initializes a B+ tree. pfnCompare has the
+ *      same meaning as with the tree.c functions.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+void bptInit(PBPTREE pTree,                 // out: tree to initialize
+             FNTREE_COMPARE *pfnCompare)    // in: comparison func
+{
+    memset(pTree, 0, sizeof(BPTREE));
+    pTree->pfnCompare = pfnCompare;
+}
+
+/*
+ *@@ bptClear:
+ *      removes all items from the tree and frees
+ *      all nodes. The item data is not touched, so
+ *      if the data pointers point to heap memory,
+ *      free them first (e.g. while iterating).
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+void bptClear(PBPTREE pTree)
+{
+    if (pTree->pRoot)
+        bptFreeNodes(pTree->pRoot);
+
+    pTree->pRoot = NULL;
+    pTree->pFirstLeaf = NULL;
+    pTree->pLastLeaf = NULL;
+    pTree->lCount = 0;
+    pTree->ulStamp++;
+}
+
+/*
+ *@@ bptInsert:
+ *      inserts ulKey with the given data pointer into
+ *      the tree.
+ *
+ *      Full nodes are split on the way down, so a node
+ *      never overflows and the tree is always valid, even
+ *      if memory runs out half way.
+ *
+ *      Returns:
+ *
+ *      --  STATUS_OK
+ *
+ *      --  STATUS_DUPLICATE_KEY: ulKey is already in the tree.
+ *
+ *      --  STATUS_NO_MEMORY
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+int bptInsert(PBPTREE pTree,        // in: tree
+              ULONG ulKey,          // in: new key
+              void* pvData)         // in: data for key
+{
+    PBPTNODE    p;
+    ULONG       ul;
+
+    if (!(p = pTree->pRoot))
+    {
+        if (!(p = bptNewNode(TRUE)))
+            return STATUS_NO_MEMORY;
+
+        pTree->pRoot = p;
+        pTree->pFirstLeaf = p;
+        pTree->pLastLeaf = p;
+    }
+    else if (p->cKeys == BPT_MAXKEYS)
+    {
+        // root is full: grow the tree by one level
+        PBPTNODE pNewRoot;
+        if (!(pNewRoot = bptNewNode(FALSE)))
+            return STATUS_NO_MEMORY;
+
+        pNewRoot->u.apChildren[0] = p;
+        if (!bptSplitChild(pTree, pNewRoot, 0))
+        {
+            free(pNewRoot);
+            return STATUS_NO_MEMORY;
+        }
+
+        pTree->pRoot = p = pNewRoot;
+    }
+
+    pTree->ulStamp++;
+
+    while (!p->fLeaf)
+    {
+        ul = bptUpperBound(p, ulKey, pTree->pfnCompare);
+        if (p->u.apChildren[ul]->cKeys == BPT_MAXKEYS)
+        {
+            if (!bptSplitChild(pTree, p, ul))
+                return STATUS_NO_MEMORY;
+
+            if (pTree->pfnCompare(ulKey, p->aulKeys[ul]) >= 0)
+                ul++;
+        }
+
+        p = p->u.apChildren[ul];
+    }
+
+    ul = bptLowerBound(p, ulKey, pTree->pfnCompare);
+    if (    (ul < p->cKeys)
+         && (!pTree->pfnCompare(ulKey, p->aulKeys[ul]))
+       )
+        return STATUS_DUPLICATE_KEY;
+
+    memmove(&p->aulKeys[ul + 1],
+            &p->aulKeys[ul],
+            (p->cKeys - ul) * sizeof(ULONG));
+    memmove(&p->u.l.apvData[ul + 1],
+            &p->u.l.apvData[ul],
+            (p->cKeys - ul) * sizeof(void*));
+    p->aulKeys[ul] = ulKey;
+    p->u.l.apvData[ul] = pvData;
+    p->cKeys++;
+
+    pTree->lCount++;
+
+    return STATUS_OK;
+}
+
+/*
+ *@@ bptDelete:
+ *      removes the item with the given key from the tree.
+ *      If ppvData is not NULL, it receives the item's data
+ *      pointer, which is not freed.
+ *
+ *      Returns STATUS_OK or STATUS_INVALID_NODE if the key
+ *      was not found.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+int bptDelete(PBPTREE pTree,        // in: tree
+              ULONG ulKey,          // in: key to remove
+              void **ppvData)       // out: data of removed item (ptr can be NULL)
+{
+    PBPTNODE    p;
+    ULONG       ul;
+
+    if (!(p = pTree->pRoot))
+        return STATUS_INVALID_NODE;
+
+    pTree->ulStamp++;
+
+    // make sure every node we descend into can lose a key
+    while (!p->fLeaf)
+    {
+        ul = bptUpperBound(p, ulKey, pTree->pfnCompare);
+        if (p->u.apChildren[ul]->cKeys <= BPT_MINKEYS)
+        {
+            ul = bptFixChild(pTree, p, ul);
+
+            if (!p->cKeys)
+            {
+                // root lost its last key: shrink the tree
+                pTree->pRoot = p->u.apChildren[0];
+                free(p);
+                p = pTree->pRoot;
+                continue;
+            }
+
+            // keys may have moved between siblings
+            ul = bptUpperBound(p, ulKey, pTree->pfnCompare);
+        }
+
+        p = p->u.apChildren[ul];
+    }
+
+    ul = bptLowerBound(p, ulKey, pTree->pfnCompare);
+    if (    (ul >= p->cKeys)
+         || (pTree->pfnCompare(ulKey, p->aulKeys[ul]))
+       )
+        return STATUS_INVALID_NODE;
+
+    if (ppvData)
+        *ppvData = p->u.l.apvData[ul];
+
+    memmove(&p->aulKeys[ul],
+            &p->aulKeys[ul + 1],
+            (p->cKeys - ul - 1) * sizeof(ULONG));
+    memmove(&p->u.l.apvData[ul],
+            &p->u.l.apvData[ul + 1],
+            (p->cKeys - ul - 1) * sizeof(void*));
+    p->cKeys--;
+
+    if (!(--pTree->lCount))
+    {
+        free(p);
+        pTree->pRoot = NULL;
+        pTree->pFirstLeaf = NULL;
+        pTree->pLastLeaf = NULL;
+    }
+
+    return STATUS_OK;
+}
+
+/*
+ *@@ bptFind:
+ *      finds the item with the specified key and
+ *      returns its data pointer, or NULL if the key
+ *      was not found.
+ *
+ *      If pIter is not NULL, it is set to the item's
+ *      position so that bptNext and bptPrev can be
+ *      used from there. If the key was not found,
+ *      pIter->pLeaf is set to NULL; use that to tell
+ *      a missing item from one with a NULL data pointer.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+void* bptFind(PBPTREE pTree,        // in: tree
+              ULONG ulKey,          // in: key to find
+              PBPTITER pIter)       // out: position of key (ptr can be NULL)
+{
+    PBPTNODE    p;
+    ULONG       ul;
+
+    if (pIter)
+    {
+        pIter->pTree = pTree;
+        pIter->pLeaf = NULL;
+        pIter->ulStamp = pTree->ulStamp;
+    }
+
+    if (!(p = pTree->pRoot))
+        return NULL;
+
+    while (!p->fLeaf)
+        p = p->u.apChildren[bptUpperBound(p, ulKey, pTree->pfnCompare)];
+
+    ul = bptLowerBound(p, ulKey, pTree->pfnCompare);
+    if (    (ul >= p->cKeys)
+         || (pTree->pfnCompare(ulKey, p->aulKeys[ul]))
+       )
+        return NULL;
+
+    if (pIter)
+    {
+        pIter->pLeaf = p;
+        pIter->ulIndex = ul;
+    }
+
+    return p->u.l.apvData[ul];
+}
+
+/*
+ *@@ bptFirst:
+ *      sets pIter to the first (smallest) item of
+ *      the tree. Returns FALSE if the tree is empty.
+ *
+ *      Example for traversing a whole tree:
+ *
+ +          BPTITER Iter;
+ +          if (bptFirst(&Tree, &Iter))
+ +              do
+ +              {
+ +                  ... bptIterKey(&Iter), bptIterData(&Iter)
+ +              } while (bptNext(&Iter));
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+BOOL bptFirst(PBPTREE pTree,
+              PBPTITER pIter)
+{
+    pIter->pTree = pTree;
+    pIter->pLeaf = pTree->pFirstLeaf;
+    pIter->ulIndex = 0;
+    pIter->ulStamp = pTree->ulStamp;
+
+    return (pIter->pLeaf != NULL);
+}
+
+/*
+ *@@ bptLast:
+ *      sets pIter to the last (greatest) item of
+ *      the tree. Returns FALSE if the tree is empty.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+BOOL bptLast(PBPTREE pTree,
+             PBPTITER pIter)
+{
+    pIter->pTree = pTree;
+    pIter->pLeaf = pTree->pLastLeaf;
+    pIter->ulIndex = (pIter->pLeaf) ? pIter->pLeaf->cKeys - 1 : 0;
+    pIter->ulStamp = pTree->ulStamp;
+
+    return (pIter->pLeaf != NULL);
+}
+
+/*
+ *@@ bptNext:
+ *      advances pIter to the next item in sorted
+ *      order. Returns FALSE if there is none or
+ *      the iterator is no longer valid.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+BOOL bptNext(PBPTITER pIter)
+{
+    if (!bptIterValid(pIter))
+        return FALSE;
+
+    if (++pIter->ulIndex >= pIter->pLeaf->cKeys)
+    {
+        pIter->pLeaf = pIter->pLeaf->u.l.pNext;
+        pIter->ulIndex = 0;
+    }
+
+    return (pIter->pLeaf != NULL);
+}
+
+/*
+ *@@ bptPrev:
+ *      moves pIter to the previous item in sorted
+ *      order. Returns FALSE if there is none or
+ *      the iterator is no longer valid.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+BOOL bptPrev(PBPTITER pIter)
+{
+    if (!bptIterValid(pIter))
+        return FALSE;
+
+    if (pIter->ulIndex)
+        pIter->ulIndex--;
+    else if ((pIter->pLeaf = pIter->pLeaf->u.l.pPrev))
+        pIter->ulIndex = pIter->pLeaf->cKeys - 1;
+
+    return (pIter->pLeaf != NULL);
+}
+
+/*
+ *@@ bptIterValid:
+ *      returns TRUE if pIter points to an item and
+ *      the tree has not been modified since the
+ *      iterator was set.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+BOOL bptIterValid(PBPTITER pIter)
+{
+    return (    (pIter->pLeaf)
+             && (pIter->ulStamp == pIter->pTree->ulStamp)
+           );
+}
+
+/*
+ *@@ bptIterKey:
+ *      returns the key of the item at pIter.
+ *      pIter must be valid.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+ULONG bptIterKey(PBPTITER pIter)
+{
+    return pIter->pLeaf->aulKeys[pIter->ulIndex];
+}
+
+/*
+ *@@ bptIterData:
+ *      returns the data pointer of the item at pIter.
+ *      pIter must be valid.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+void* bptIterData(PBPTITER pIter)
+{
+    return pIter->pLeaf->u.l.apvData[pIter->ulIndex];
+}
+
@@ -0,0 +1,1147 @@
+
+/*
+ *@@sourcefile pmap.c:
+ *      contains helper functions for maintaining persistent
+ *      (immutable) maps, which can be copied in constant
+ *      time and compared with each other quickly.
+ *
+ *      Usage: All C programs; not OS/2-specific.
+ *
+ *      Function prefixes:
+ *      --  pmap*   persistent map functions
+ *
+ *      <B>Introduction</B>
+ *
+ *      Code which wants to find out what has changed in some
+ *      state, e.g. the INI handles loaded by wphLoadHandles or
+ *      the application and key names in a profile, usually
+ *      keeps a copy of the old state and compares it with the
+ *      new one afterwards. With a tree.c tree or a linked list,
+ *      both the copy and the comparison have to look at every
+ *      item, even if only one of them has changed.
+ *
+ *      A PMAP is a map from ULONG keys to void* data which is
+ *      never modified in place. pmapSet and pmapRemove copy the
+ *      (short) path from the root to the changed item and share
+ *      all other nodes with the previous version, which stays
+ *      valid if another PMAP still refers to it. As a result:
+ *
+ *      -- pmapCopy takes a snapshot in O(1) by sharing the
+ *         root of the source map.
+ *
+ *      -- pmapSet and pmapRemove take O(log n) time and
+ *         memory, no matter how many snapshots exist.
+ *
+ *      -- pmapDiff reports the keys that were added, removed
+ *         or changed between two versions and skips every
+ *         subtree which the two versions share, so comparing
+ *         a snapshot with a slightly modified copy costs
+ *         about O(changes * log n) instead of O(n).
+ *
+ *      The map is a hash array mapped trie (HAMT): every node
+ *      has up to 32 entries which are selected by five bits of
+ *      the key's hash, and only the used entries are stored.
+ *      Since the shape of the trie depends only on the keys it
+ *      contains and not on the order of the changes, two versions
+ *      with the same contents in one region of the trie can be
+ *      compared entry by entry.
+ *
+ *      Differences compared to tree.c:
+ *
+ *      -- A PMAP is not sorted. pmapEnum and pmapDiff return the
+ *         items in hash order.
+ *
+ *      -- Besides a comparison function (which is only ever
+ *         tested for == 0), you need a hash function for your
+ *         keys. Use pmapHashKey with treeCompareKeys for plain
+ *         ULONG keys and pmapHashString with treeCompareStrings
+ *         for string keys.
+ *
+ *      -- The map allocates its own nodes, which are reference
+ *         counted. Call pmapClear on every version when you're
+ *         done with it. The reference counts are not protected,
+ *         so all versions which share nodes must be used on the
+ *         same thread.
+ *
+ *      -- The map does not own the keys and data. Both must stay
+ *         valid as long as any version still contains them, and
+ *         they should not be modified while they are in a map;
+ *         to change an item's data, store a new data pointer with
+ *         pmapSet, which is what pmapDiff looks at.
+ *
+ *      <B>Example</B>
+ *
+ +          PMAP    Old, New;
+ +          pmapInit(&New, pmapHashString, treeCompareStrings);
+ +          pmapSet(&New, (ULONG)pItem->pszName, pItem);
+ +          ...
+ +          pmapCopy(&Old, &New);       // O(1)
+ +          pmapRemove(&New, (ULONG)"name");
+ +          ...
+ +          pmapDiff(&Old, &New, fnReportChange, NULL);
+ +          pmapClear(&Old);
+ +          pmapClear(&New);
+ *
+ *      Note: Version numbering in this file relates to XWorkplace version
+ *            numbering.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ *@@header "helpers\pmap.h"
+ */
+
+/*
+ *      Copyright (C) 2026 the XWorkplace helpers authors.
+ *      This file is part of the "XWorkplace helpers" source package.
+ *      This is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published
+ *      by the Free Software Foundation, in version 2 as it comes in the
+ *      "COPYING" file of the XWorkplace main distribution.
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "setup.h"                      // code generation and debugging options
+
+#include "helpers\tree.h"
+#include "helpers\pmap.h"
+#include "helpers\strmap.h"
+
+#pragma hdrstop
+
+/*
+ *@@category: Helpers\C helpers\Persistent maps
+ *      See pmap.c.
+ */
+
+/* ******************************************************************
+ *
+ *   Private declarations
+ *
+ ********************************************************************/
+
+#define PMAP_BITS           5
+#define PMAP_MASK           ((1UL << PMAP_BITS) - 1)
+// nodes at this shift or deeper hold keys with identical hashes
+#define PMAP_MAXSHIFT       32
+
+#define FRAGBIT(ulHash, ulShift) (1UL << (((ulHash) >> (ulShift)) & PMAP_MASK))
+
+/*
+ *@@ PMAPLEAF:
+ *      one key/data pair in a PMAPNODE.
+ */
+
+typedef struct _PMAPLEAF
+{
+    ULONG       ulHash;
+    ULONG       ulKey;
+    void        *pvData;
+} PMAPLEAF, *PPMAPLEAF;
+
+/*
+ *@@ PMAPNODE:
+ *      trie node. Bit n in flLeafs or flChildren is set
+ *      if entry n (selected by five bits of the hash) is
+ *      a key/data pair or a child node. The node is
+ *      allocated with room for exactly as many entries
+ *      as it has: first cLeafs PMAPLEAF's, then cChildren
+ *      child pointers, both in bit order.
+ *
+ *      Nodes at PMAP_MAXSHIFT are "collision" nodes, which
+ *      have no bitmaps and a plain array of cLeafs leafs
+ *      with the same hash.
+ *
+ *      A node is immutable once it is in a map, except
+ *      for its reference count.
+ */
+
+typedef struct _PMAPNODE
+{
+    ULONG       cRefs;
+    ULONG       flLeafs,
+                flChildren;
+    ULONG       cLeafs,
+                cChildren;
+    PMAPLEAF    aLeafs[1];          // variable size, followed by children
+} PMAPNODE;
+
+#define CHILDREN(p)         ((PPMAPNODE*)&(p)->aLeafs[(p)->cLeafs])
+
+/*
+ *@@ pmapCountBits:
+ *
+ */
+
+STATIC ULONG pmapCountBits(ULONG fl)
+{
+    fl = fl - ((fl >> 1) & 0x55555555UL);
+    fl = (fl & 0x33333333UL) + ((fl >> 2) & 0x33333333UL);
+    fl = (fl + (fl >> 4)) & 0x0F0F0F0FUL;
+    return ((fl * 0x01010101UL) & 0xFFFFFFFFUL) >> 24;
+}
+
+// index of the entry for fl in a bitmap
+#define INDEX(flMap, fl)    pmapCountBits((flMap) & ((fl) - 1))
+
+/*
+ *@@ pmapNewNode:
+ *      allocates a node with room for the given no.
+ *      of entries. The caller must fill them.
+ */
+
+STATIC PPMAPNODE pmapNewNode(ULONG flLeafs,
+                             ULONG flChildren,
+                             ULONG cLeafs,
+                             ULONG cChildren)
+{
+    PPMAPNODE p;
+
+    if ((p = (PPMAPNODE)malloc(   sizeof(PMAPNODE)
+                                + cLeafs * sizeof(PMAPLEAF)
+                                + cChildren * sizeof(PPMAPNODE))))
+    {
+        p->cRefs = 1;
+        p->flLeafs = flLeafs;
+        p->flChildren = flChildren;
+        p->cLeafs = cLeafs;
+        p->cChildren = cChildren;
+    }
+
+    return p;
+}
+
+/*
+ *@@ pmapRelease:
+ *      drops one reference to the node and frees it
+ *      and all nodes only it refers to if that was
+ *      the last one.
+ */
+
+STATIC void pmapRelease(PPMAPNODE p)
+{
+    if (p && !--p->cRefs)
+    {
+        PPMAPNODE   *papChildren = CHILDREN(p);
+        ULONG       ul;
+
+        for (ul = 0; ul < p->cChildren; ul++)
+            pmapRelease(papChildren[ul]);
+
+        free(p);
+    }
+}
+
+/*
+ *@@ pmapCopyNode:
+ *      creates a copy of p in which the entry for fl
+ *      is changed.
+ *
+ *      If pLeaf != NULL, the entry becomes a leaf with that
+ *      key and data; if pChild != NULL, it becomes that
+ *      child (whose reference is taken over); if both are
+ *      NULL, the entry is removed.
+ *
+ *      All other children get an additional reference.
+ *
+ *      Must not be used with collision nodes.
+ */
+
+STATIC PPMAPNODE pmapCopyNode(PPMAPNODE p,
+                              ULONG fl,
+                              const PMAPLEAF *pLeaf,
+                              PPMAPNODE pChild)
+{
+    ULONG       flLeafs = p->flLeafs & ~fl,
+                flChildren = p->flChildren & ~fl,
+                flAll,
+                ulOldLeaf = 0,
+                ulOldChild = 0,
+                ulNewLeaf = 0,
+                ulNewChild = 0;
+    PPMAPNODE   pNew,
+                *papOld,
+                *papNew;
+
+    if (pLeaf)
+        flLeafs |= fl;
+    else if (pChild)
+        flChildren |= fl;
+
+    if (!(pNew = pmapNewNode(flLeafs,
+                             flChildren,
+                             pmapCountBits(flLeafs),
+                             pmapCountBits(flChildren))))
+        return NULL;
+
+    papOld = CHILDREN(p);
+    papNew = CHILDREN(pNew);
+
+    // walk all entries of old and new node in bit order
+    flAll = p->flLeafs | p->flChildren | fl;
+    while (flAll)
+    {
+        ULONG flBit = flAll & (~flAll + 1);     // lowest bit
+        flAll &= flAll - 1;
+
+        if (flBit == fl)
+        {
+            if (p->flLeafs & fl)
+                ulOldLeaf++;
+            else if (p->flChildren & fl)
+                ulOldChild++;
+
+            if (pLeaf)
+                pNew->aLeafs[ulNewLeaf++] = *pLeaf;
+            else if (pChild)
+                papNew[ulNewChild++] = pChild;
+        }
+        else if (p->flLeafs & flBit)
+            pNew->aLeafs[ulNewLeaf++] = p->aLeafs[ulOldLeaf++];
+        else
+        {
+            papOld[ulOldChild]->cRefs++;
+            papNew[ulNewChild++] = papOld[ulOldChild++];
+        }
+    }
+
+    return pNew;
+}
+
+/*
+ *@@ pmapMergeLeafs:
+ *      creates a subtree at ulShift which contains the two
+ *      leafs (whose keys are different).
+ */
+
+STATIC PPMAPNODE pmapMergeLeafs(const PMAPLEAF *pLeaf1,
+                                const PMAPLEAF *pLeaf2,
+                                ULONG ulShift)
+{
+    PPMAPNODE   p;
+    ULONG       fl1,
+                fl2;
+
+    if (ulShift >= PMAP_MAXSHIFT)
+    {
+        if ((p = pmapNewNode(0, 0, 2, 0)))
+        {
+            p->aLeafs[0] = *pLeaf1;
+            p->aLeafs[1] = *pLeaf2;
+        }
+        return p;
+    }
+
+    fl1 = FRAGBIT(pLeaf1->ulHash, ulShift);
+    fl2 = FRAGBIT(pLeaf2->ulHash, ulShift);
+
+    if (fl1 == fl2)
+    {
+        PPMAPNODE pChild;
+        if (!(pChild = pmapMergeLeafs(pLeaf1, pLeaf2, ulShift + PMAP_BITS)))
+            return NULL;
+        if (!(p = pmapNewNode(0, fl1, 0, 1)))
+        {
+            pmapRelease(pChild);
+            return NULL;
+        }
+        CHILDREN(p)[0] = pChild;
+    }
+    else if ((p = pmapNewNode(fl1 | fl2, 0, 2, 0)))
+    {
+        if (fl1 < fl2)
+        {
+            p->aLeafs[0] = *pLeaf1;
+            p->aLeafs[1] = *pLeaf2;
+        }
+        else
+        {
+            p->aLeafs[0] = *pLeaf2;
+            p->aLeafs[1] = *pLeaf1;
+        }
+    }
+
+    return p;
+}
+
+/*
+ *@@ pmapSetRec:
+ *      returns a copy of the subtree p (which may be NULL)
+ *      at ulShift in which pLeaf has been set, or NULL if
+ *      memory ran out. *pfReplaced is set to TRUE if the
+ *      key was already in the subtree.
+ */
+
+STATIC PPMAPNODE pmapSetRec(PPMAPNODE p,
+                            ULONG ulShift,
+                            const PMAPLEAF *pLeaf,
+                            FNTREE_COMPARE *pfnCompare,
+                            BOOL *pfReplaced)
+{
+    ULONG       fl,
+                ul;
+    PPMAPNODE   pNew;
+
+    if (!p)
+    {
+        if (ulShift >= PMAP_MAXSHIFT)
+            fl = 0;
+        else
+            fl = FRAGBIT(pLeaf->ulHash, ulShift);
+
+        if ((pNew = pmapNewNode(fl, 0, 1, 0)))
+            pNew->aLeafs[0] = *pLeaf;
+        return pNew;
+    }
+
+    if (ulShift >= PMAP_MAXSHIFT)
+    {
+        // collision node: replace or append
+        for (ul = 0; ul < p->cLeafs; ul++)
+            if (!pfnCompare(p->aLeafs[ul].ulKey, pLeaf->ulKey))
+                break;
+
+        if (ul == p->cLeafs)
+        {
+            if (!(pNew = pmapNewNode(0, 0, p->cLeafs + 1, 0)))
+                return NULL;
+            pNew->aLeafs[p->cLeafs] = *pLeaf;
+        }
+        else
+        {
+            if (!(pNew = pmapNewNode(0, 0, p->cLeafs, 0)))
+                return NULL;
+            *pfReplaced = TRUE;
+        }
+
+        memcpy(pNew->aLeafs, p->aLeafs, p->cLeafs * sizeof(PMAPLEAF));
+        if (*pfReplaced)
+            pNew->aLeafs[ul] = *pLeaf;
+
+        return pNew;
+    }
+
+    fl = FRAGBIT(pLeaf->ulHash, ulShift);
+
+    if (p->flLeafs & fl)
+    {
+        PPMAPLEAF pOld = &p->aLeafs[INDEX(p->flLeafs, fl)];
+
+        if (    (pOld->ulHash == pLeaf->ulHash)
+             && (!pfnCompare(pOld->ulKey, pLeaf->ulKey))
+           )
+        {
+            *pfReplaced = TRUE;
+            return pmapCopyNode(p, fl, pLeaf, NULL);
+        }
+
+        // two different keys in this entry: push both down
+        if (!(pNew = pmapMergeLeafs(pOld, pLeaf, ulShift + PMAP_BITS)))
+            return NULL;
+    }
+    else if (p->flChildren & fl)
+    {
+        if (!(pNew = pmapSetRec(CHILDREN(p)[INDEX(p->flChildren, fl)],
+                                ulShift + PMAP_BITS,
+                                pLeaf,
+                                pfnCompare,
+                                pfReplaced)))
+            return NULL;
+    }
+    else
+        return pmapCopyNode(p, fl, pLeaf, NULL);
+
+    {
+        PPMAPNODE pCopy;
+        if (!(pCopy = pmapCopyNode(p, fl, NULL, pNew)))
+            pmapRelease(pNew);
+        return pCopy;
+    }
+}
+
+/*
+ *@@ pmapRemoveRec:
+ *      removes the key from the subtree p at ulShift.
+ *
+ *      On success, *ppNew receives the new subtree, which
+ *      is NULL if it became empty. If only a single item
+ *      is left in a subtree, that is returned as a node
+ *      with one leaf, which the caller pulls up into its
+ *      own node, so that the trie has the same shape as
+ *      if the item had been inserted alone.
+ *
+ *      Returns PMAP_OK, PMAP_NOT_FOUND or PMAP_NO_MEMORY.
+ */
+
+STATIC int pmapRemoveRec(PPMAPNODE p,
+                         ULONG ulShift,
+                         ULONG ulHash,
+                         ULONG ulKey,
+                         FNTREE_COMPARE *pfnCompare,
+                         PPMAPNODE *ppNew)
+{
+    ULONG       fl,
+                ul;
+    PPMAPNODE   pChild;
+    int         rc;
+
+    if (ulShift >= PMAP_MAXSHIFT)
+    {
+        for (ul = 0; ul < p->cLeafs; ul++)
+            if (!pfnCompare(p->aLeafs[ul].ulKey, ulKey))
+                break;
+
+        if (ul == p->cLeafs)
+            return PMAP_NOT_FOUND;
+
+        if (p->cLeafs == 1)
+            *ppNew = NULL;
+        else
+        {
+            if (!(*ppNew = pmapNewNode(0, 0, p->cLeafs - 1, 0)))
+                return PMAP_NO_MEMORY;
+            memcpy((*ppNew)->aLeafs, p->aLeafs, ul * sizeof(PMAPLEAF));
+            memcpy(&(*ppNew)->aLeafs[ul],
+                   &p->aLeafs[ul + 1],
+                   (p->cLeafs - ul - 1) * sizeof(PMAPLEAF));
+        }
+
+        return PMAP_OK;
+    }
+
+    fl = FRAGBIT(ulHash, ulShift);
+
+    if (p->flLeafs & fl)
+    {
+        PPMAPLEAF pOld = &p->aLeafs[INDEX(p->flLeafs, fl)];
+
+        if (    (pOld->ulHash != ulHash)
+             || (pfnCompare(pOld->ulKey, ulKey))
+           )
+            return PMAP_NOT_FOUND;
+
+        if (p->cLeafs + p->cChildren == 1)
+            *ppNew = NULL;
+        else if (!(*ppNew = pmapCopyNode(p, fl, NULL, NULL)))
+            return PMAP_NO_MEMORY;
+
+        return PMAP_OK;
+    }
+
+    if (!(p->flChildren & fl))
+        return PMAP_NOT_FOUND;
+
+    if ((rc = pmapRemoveRec(CHILDREN(p)[INDEX(p->flChildren, fl)],
+                            ulShift + PMAP_BITS,
+                            ulHash,
+                            ulKey,
+                            pfnCompare,
+                            &pChild)))
+        return rc;
+
+    if (!pChild)
+    {
+        if (p->cLeafs + p->cChildren == 1)
+            *ppNew = NULL;
+        else if (!(*ppNew = pmapCopyNode(p, fl, NULL, NULL)))
+            return PMAP_NO_MEMORY;
+    }
+    else if (pChild->cLeafs == 1 && !pChild->cChildren)
+    {
+        // child has a single item left: pull it up
+        if (p->cLeafs + p->cChildren == 1)
+            // we'd be in the same situation; let our caller do it
+            *ppNew = pChild;
+        else
+        {
+            *ppNew = pmapCopyNode(p, fl, &pChild->aLeafs[0], NULL);
+            pmapRelease(pChild);
+            if (!*ppNew)
+                return PMAP_NO_MEMORY;
+        }
+    }
+    else if (!(*ppNew = pmapCopyNode(p, fl, NULL, pChild)))
+    {
+        pmapRelease(pChild);
+        return PMAP_NO_MEMORY;
+    }
+
+    return PMAP_OK;
+}
+
+/*
+ *@@ pmapEnumRec:
+ *
+ */
+
+STATIC BOOL pmapEnumRec(PPMAPNODE p,
+                        FNPMAP_ENUM *pfnEnum,
+                        void *pvUser)
+{
+    PPMAPNODE   *papChildren = CHILDREN(p);
+    ULONG       ul;
+
+    for (ul = 0; ul < p->cLeafs; ul++)
+        if (!pfnEnum(p->aLeafs[ul].ulKey, p->aLeafs[ul].pvData, pvUser))
+            return FALSE;
+
+    for (ul = 0; ul < p->cChildren; ul++)
+        if (!pmapEnumRec(papChildren[ul], pfnEnum, pvUser))
+            return FALSE;
+
+    return TRUE;
+}
+
+/*
+ *@@ pmapFindLeaf:
+ *      finds the leaf for the given key in the subtree
+ *      p at ulShift (which may be NULL).
+ */
+
+STATIC PPMAPLEAF pmapFindLeaf(PPMAPNODE p,
+                              ULONG ulShift,
+                              ULONG ulHash,
+                              ULONG ulKey,
+                              FNTREE_COMPARE *pfnCompare)
+{
+    while (p)
+    {
+        ULONG fl;
+
+        if (ulShift >= PMAP_MAXSHIFT)
+        {
+            ULONG ul;
+            for (ul = 0; ul < p->cLeafs; ul++)
+                if (!pfnCompare(p->aLeafs[ul].ulKey, ulKey))
+                    return &p->aLeafs[ul];
+            break;
+        }
+
+        fl = FRAGBIT(ulHash, ulShift);
+
+        if (p->flLeafs & fl)
+        {
+            PPMAPLEAF pLeaf = &p->aLeafs[INDEX(p->flLeafs, fl)];
+            if (    (pLeaf->ulHash == ulHash)
+                 && (!pfnCompare(pLeaf->ulKey, ulKey))
+               )
+                return pLeaf;
+            break;
+        }
+
+        if (!(p->flChildren & fl))
+            break;
+
+        p = CHILDREN(p)[INDEX(p->flChildren, fl)];
+        ulShift += PMAP_BITS;
+    }
+
+    return NULL;
+}
+
+/*
+ *@@ DIFFDATA:
+ *
+ */
+
+typedef struct _DIFFDATA
+{
+    FNPMAP_DIFF     *pfnDiff;
+    void            *pvUser;
+    FNTREE_COMPARE  *pfnCompare;
+    ULONG           ulChange;       // for pmapDiffAllRec
+    PPMAPLEAF       pSkip;          // for pmapDiffAllRec
+} DIFFDATA, *PDIFFDATA;
+
+/*
+ *@@ pmapDiffLeafs:
+ *      reports the difference between two leafs, either
+ *      of which may be NULL.
+ */
+
+STATIC BOOL pmapDiffLeafs(const PMAPLEAF *pOld,
+                          const PMAPLEAF *pNew,
+                          PDIFFDATA pData)
+{
+    if (pOld && pNew)
+    {
+        if (    (pOld->ulHash == pNew->ulHash)
+             && (!pData->pfnCompare(pOld->ulKey, pNew->ulKey))
+           )
+        {
+            if (pOld->pvData != pNew->pvData)
+                return pData->pfnDiff(pNew->ulKey,
+                                      pOld->pvData,
+                                      pNew->pvData,
+                                      PMAPDIFF_CHANGED,
+                                      pData->pvUser);
+            return TRUE;
+        }
+
+        return (    pmapDiffLeafs(pOld, NULL, pData)
+                 && pmapDiffLeafs(NULL, pNew, pData)
+               );
+    }
+
+    if (pOld)
+        return pData->pfnDiff(pOld->ulKey,
+                              pOld->pvData,
+                              NULL,
+                              PMAPDIFF_REMOVED,
+                              pData->pvUser);
+
+    return pData->pfnDiff(pNew->ulKey,
+                          NULL,
+                          pNew->pvData,
+                          PMAPDIFF_ADDED,
+                          pData->pvUser);
+}
+
+/*
+ *@@ pmapDiffAllRec:
+ *      reports all items in p except pData->pSkip
+ *      as pData->ulChange.
+ */
+
+STATIC BOOL pmapDiffAllRec(PPMAPNODE p,
+                           PDIFFDATA pData)
+{
+    PPMAPNODE   *papChildren = CHILDREN(p);
+    ULONG       ul;
+
+    for (ul = 0; ul < p->cLeafs; ul++)
+        if (&p->aLeafs[ul] != pData->pSkip)
+            if (!pmapDiffLeafs((pData->ulChange == PMAPDIFF_REMOVED) ? &p->aLeafs[ul] : NULL,
+                               (pData->ulChange == PMAPDIFF_ADDED) ? &p->aLeafs[ul] : NULL,
+                               pData))
+                return FALSE;
+
+    for (ul = 0; ul < p->cChildren; ul++)
+        if (!pmapDiffAllRec(papChildren[ul], pData))
+            return FALSE;
+
+    return TRUE;
+}
+
+/*
+ *@@ pmapDiffAll:
+ *      reports all items in p (which may be NULL) except
+ *      pSkip as added or removed.
+ */
+
+STATIC BOOL pmapDiffAll(PPMAPNODE p,
+                        PPMAPLEAF pSkip,
+                        ULONG ulChange,
+                        PDIFFDATA pData)
+{
+    if (!p)
+        return TRUE;
+
+    pData->ulChange = ulChange;
+    pData->pSkip = pSkip;
+    return pmapDiffAllRec(p, pData);
+}
+
+/*
+ *@@ pmapDiffLeafAndNode:
+ *      compares a single leaf with a subtree at ulShift.
+ *      If fOldIsLeaf, the leaf belongs to the old version
+ *      and the subtree to the new one.
+ */
+
+STATIC BOOL pmapDiffLeafAndNode(const PMAPLEAF *pLeaf,
+                                PPMAPNODE p,
+                                ULONG ulShift,
+                                BOOL fOldIsLeaf,
+                                PDIFFDATA pData)
+{
+    PPMAPLEAF   pOther = pmapFindLeaf(p,
+                                      ulShift,
+                                      pLeaf->ulHash,
+                                      pLeaf->ulKey,
+                                      pData->pfnCompare);
+    BOOL        brc;
+
+    // report the leaf, or the pair if the subtree has it too
+    if (fOldIsLeaf)
+        brc = pmapDiffLeafs(pLeaf, pOther, pData);
+    else
+        brc = pmapDiffLeafs(pOther, pLeaf, pData);
+
+    // everything else in the subtree is new or gone
+    return (    (brc)
+             && (pmapDiffAll(p,
+                             pOther,
+                             (fOldIsLeaf) ? PMAPDIFF_ADDED : PMAPDIFF_REMOVED,
+                             pData))
+           );
+}
+
+/*
+ *@@ pmapDiffRec:
+ *      compares two subtrees at ulShift, either of which
+ *      may be NULL. Identical subtrees are skipped.
+ */
+
+STATIC BOOL pmapDiffRec(PPMAPNODE pOld,
+                        PPMAPNODE pNew,
+                        ULONG ulShift,
+                        PDIFFDATA pData)
+{
+    PPMAPNODE   *papOld,
+                *papNew;
+    ULONG       flAll,
+                ul;
+
+    if (pOld == pNew)
+        return TRUE;        // shared, or both NULL
+
+    if (!pOld)
+        return pmapDiffAll(pNew, NULL, PMAPDIFF_ADDED, pData);
+    if (!pNew)
+        return pmapDiffAll(pOld, NULL, PMAPDIFF_REMOVED, pData);
+
+    if (ulShift >= PMAP_MAXSHIFT)
+    {
+        // collision nodes: compare all with all; there are
+        // hardly ever more than two items in them
+        for (ul = 0; ul < pOld->cLeafs; ul++)
+            if (!pmapDiffLeafs(&pOld->aLeafs[ul],
+                               pmapFindLeaf(pNew,
+                                            ulShift,
+                                            pOld->aLeafs[ul].ulHash,
+                                            pOld->aLeafs[ul].ulKey,
+                                            pData->pfnCompare),
+                               pData))
+                return FALSE;
+
+        for (ul = 0; ul < pNew->cLeafs; ul++)
+            if (!pmapFindLeaf(pOld,
+                              ulShift,
+                              pNew->aLeafs[ul].ulHash,
+                              pNew->aLeafs[ul].ulKey,
+                              pData->pfnCompare))
+                if (!pmapDiffLeafs(NULL, &pNew->aLeafs[ul], pData))
+                    return FALSE;
+
+        return TRUE;
+    }
+
+    papOld = CHILDREN(pOld);
+    papNew = CHILDREN(pNew);
+
+    flAll = pOld->flLeafs | pOld->flChildren | pNew->flLeafs | pNew->flChildren;
+    while (flAll)
+    {
+        ULONG       fl = flAll & (~flAll + 1);      // lowest bit
+        PPMAPLEAF   pOldLeaf = NULL,
+                    pNewLeaf = NULL;
+        PPMAPNODE   pOldChild = NULL,
+                    pNewChild = NULL;
+        BOOL        brc;
+
+        flAll &= flAll - 1;
+
+        if (pOld->flLeafs & fl)
+            pOldLeaf = &pOld->aLeafs[INDEX(pOld->flLeafs, fl)];
+        else if (pOld->flChildren & fl)
+            pOldChild = papOld[INDEX(pOld->flChildren, fl)];
+
+        if (pNew->flLeafs & fl)
+            pNewLeaf = &pNew->aLeafs[INDEX(pNew->flLeafs, fl)];
+        else if (pNew->flChildren & fl)
+            pNewChild = papNew[INDEX(pNew->flChildren, fl)];
+
+        if (pOldLeaf && pNewChild)
+            brc = pmapDiffLeafAndNode(pOldLeaf, pNewChild, ulShift + PMAP_BITS, TRUE, pData);
+        else if (pOldChild && pNewLeaf)
+            brc = pmapDiffLeafAndNode(pNewLeaf, pOldChild, ulShift + PMAP_BITS, FALSE, pData);
+        else if (pOldLeaf || pNewLeaf)
+            brc = pmapDiffLeafs(pOldLeaf, pNewLeaf, pData);
+        else
+            brc = pmapDiffRec(pOldChild, pNewChild, ulShift + PMAP_BITS, pData);
+
+        if (!brc)
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+/* ******************************************************************
+ *
+ *   Persistent map functions
+ *
+ ********************************************************************/
+
+/*
+ *@@ pmapHashKey:
+ *      hash function for plain ULONG keys, to be used
+ *      with treeCompareKeys.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+ULONG TREEENTRY pmapHashKey(ULONG ulKey)
+{
+    ulKey ^= ulKey >> 16;
+    ulKey = (ulKey * 0x7FEB352DUL) & 0xFFFFFFFFUL;
+    ulKey ^= ulKey >> 15;
+    ulKey = (ulKey * 0x846CA68BUL) & 0xFFFFFFFFUL;
+    ulKey ^= ulKey >> 16;
+
+    return ulKey;
+}
+
+/*
+ *@@ pmapHashString:
+ *      hash function for string keys (i.e. ulKey is
+ *      a const char*), to be used with treeCompareStrings.
+ *      This uses smapHash from strmap.c.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+ULONG TREEENTRY pmapHashString(ULONG ulKey)
+{
+    return smapHash((const char*)ulKey, 0);
+}
+
+/*
+ *@@ pmapInit:
+ *      initializes an empty map. pfnHash must return
+ *      the same hash for keys which pfnCompare finds
+ *      equal.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+void pmapInit(PPMAP pMap,                   // out: map to initialize
+              FNPMAP_HASH *pfnHash,         // in: hash func
+              FNTREE_COMPARE *pfnCompare)   // in: comparison func
+{
+    pMap->pRoot = NULL;
+    pMap->lCount = 0;
+    pMap->pfnHash = pfnHash;
+    pMap->pfnCompare = pfnCompare;
+}
+
+/*
+ *@@ pmapCopy:
+ *      makes pTarget a snapshot of pSource, which
+ *      takes constant time since both share all nodes
+ *      until one of them is modified.
+ *
+ *      pTarget must not be initialized (or must have
+ *      been cleared with pmapClear). Call pmapClear on
+ *      it when you no longer need it.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+void pmapCopy(PPMAP pTarget,
+              const PMAP *pSource)
+{
+    *pTarget = *pSource;
+    if (pTarget->pRoot)
+        pTarget->pRoot->cRefs++;
+}
+
+/*
+ *@@ pmapClear:
+ *      releases this version of the map. Nodes which
+ *      are still used by other versions are not freed.
+ *      The map is empty afterwards and can be used again.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+void pmapClear(PPMAP pMap)
+{
+    pmapRelease(pMap->pRoot);
+    pMap->pRoot = NULL;
+    pMap->lCount = 0;
+}
+
+/*
+ *@@ pmapSet:
+ *      adds ulKey to the map with the given data or
+ *      replaces the data if ulKey is already in it.
+ *      Other versions of the map are not affected.
+ *
+ *      Returns:
+ *
+ *      --  PMAP_OK: key was added.
+ *
+ *      --  PMAP_REPLACED: key existed, data was replaced.
+ *
+ *      --  PMAP_NO_MEMORY: map is unchanged.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+int pmapSet(PPMAP pMap,
+            ULONG ulKey,
+            void *pvData)
+{
+    PMAPLEAF    Leaf;
+    PPMAPNODE   pNew;
+    BOOL        fReplaced = FALSE;
+
+    Leaf.ulHash = pMap->pfnHash(ulKey);
+    Leaf.ulKey = ulKey;
+    Leaf.pvData = pvData;
+
+    if (!(pNew = pmapSetRec(pMap->pRoot, 0, &Leaf, pMap->pfnCompare, &fReplaced)))
+        return PMAP_NO_MEMORY;
+
+    pmapRelease(pMap->pRoot);
+    pMap->pRoot = pNew;
+
+    if (fReplaced)
+        return PMAP_REPLACED;
+
+    pMap->lCount++;
+    return PMAP_OK;
+}
+
+/*
+ *@@ pmapRemove:
+ *      removes ulKey from the map. Other versions of the
+ *      map are not affected.
+ *
+ *      Returns PMAP_OK, PMAP_NOT_FOUND or PMAP_NO_MEMORY.
+ *      On errors, the map is unchanged.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+int pmapRemove(PPMAP pMap,
+               ULONG ulKey)
+{
+    PPMAPNODE   pNew;
+    int         rc;
+
+    if (!pMap->pRoot)
+        return PMAP_NOT_FOUND;
+
+    if (!(rc = pmapRemoveRec(pMap->pRoot,
+                             0,
+                             pMap->pfnHash(ulKey),
+                             ulKey,
+                             pMap->pfnCompare,
+                             &pNew)))
+    {
+        if (pNew && pNew->cLeafs == 1 && !pNew->cChildren)
+        {
+            // single item pulled up to the root: it has to
+            // sit in the root's entry for its hash
+            PMAPLEAF    Leaf = pNew->aLeafs[0];
+            ULONG       fl = FRAGBIT(Leaf.ulHash, 0);
+            if (pNew->flLeafs != fl)
+            {
+                pmapRelease(pNew);
+                if (!(pNew = pmapNewNode(fl, 0, 1, 0)))
+                    return PMAP_NO_MEMORY;
+                pNew->aLeafs[0] = Leaf;
+            }
+        }
+
+        pmapRelease(pMap->pRoot);
+        pMap->pRoot = pNew;
+        pMap->lCount--;
+    }
+
+    return rc;
+}
+
+/*
+ *@@ pmapFind:
+ *      returns the data for ulKey. Since NULL may be
+ *      valid data, pfFound (if != NULL) is set to
+ *      whether the key was found.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+void* pmapFind(const PMAP *pMap,
+               ULONG ulKey,
+               BOOL *pfFound)
+{
+    PPMAPLEAF pLeaf = pmapFindLeaf(pMap->pRoot,
+                                   0,
+                                   pMap->pfnHash(ulKey),
+                                   ulKey,
+                                   pMap->pfnCompare);
+    if (pfFound)
+        *pfFound = (pLeaf != NULL);
+
+    return (pLeaf) ? pLeaf->pvData : NULL;
+}
+
+/*
+ *@@ pmapEnum:
+ *      calls pfnEnum for every item in the map, in hash
+ *      order, until it returns FALSE. Returns FALSE if
+ *      the enumeration was stopped that way.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+BOOL pmapEnum(const PMAP *pMap,
+              FNPMAP_ENUM *pfnEnum,
+              void *pvUser)
+{
+    if (!pMap->pRoot)
+        return TRUE;
+
+    return pmapEnumRec(pMap->pRoot, pfnEnum, pvUser);
+}
+
+/*
+ *@@ pmapDiff:
+ *      compares two versions of a map and calls pfnDiff
+ *      for every key which differs between them, with
+ *      ulChange set to one of:
+ *
+ *      --  PMAPDIFF_ADDED: key is only in pNew; pvOldData
+ *          is NULL.
+ *
+ *      --  PMAPDIFF_REMOVED: key is only in pOld; pvNewData
+ *          is NULL.
+ *
+ *      --  PMAPDIFF_CHANGED: key is in both, but with a
+ *          different data pointer.
+ *
+ *      Subtrees which both versions share are skipped
+ *      without looking at them, so this is fast if pNew
+ *      was created from pOld with pmapCopy and a few changes
+ *      (or vice versa). The two maps must use the same
+ *      hash and comparison functions.
+ *
+ *      If pfnDiff returns FALSE, the comparison is stopped
+ *      and FALSE is returned.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+BOOL pmapDiff(const PMAP *pOld,
+              const PMAP *pNew,
+              FNPMAP_DIFF *pfnDiff,
+              void *pvUser)
+{
+    DIFFDATA    Data;
+
+    Data.pfnDiff = pfnDiff;
+    Data.pvUser = pvUser;
+    Data.pfnCompare = pNew->pfnCompare;
+    Data.ulChange = 0;
+    Data.pSkip = NULL;
+
+    return pmapDiffRec(pOld->pRoot, pNew->pRoot, 0, &Data);
+}
+
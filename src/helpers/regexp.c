@@ -6,7 +6,11 @@
  *      (nyangau@interalpha.co.uk) and released into the public
  *      domain, plus adjustments for the XWP helpers.
  *
- *      Usage: All C programs; not OS/2-specific.
+ *      Usage: All OS/2 programs. Since V1.0.24, this needs the
+ *      lock* functions from interlock.asm, with which the scratch
+ *      space of an ERE is claimed by one thread at a time, and the
+ *      fast mutexes in sem.c, which guard the rxpCompileCached
+ *      cache (both declared in sem.h).
  *
  *      Function prefixes:
  *      --  rxp*       regular expression functions.
@@ -29,8 +33,40 @@
  *      2)  Call one of rxpMatch, rxpMatch_fwd, or rxpMatch_bwd to
  *          perform a match.
  *
+ *          For EREs without backreferences, rxpMatch and rxpMatch_fwd
+ *          run a DFA instead, which is built from the FSM on demand
+ *          while matching and cached in the ERE. This takes time
+ *          linear in the length of the string, where walk_fsm can
+ *          take exponential time on EREs like "(a|a)*b".
+ *
+ *          Either way, rxpCompile also records the literal text
+ *          that every match starts with (or else the bytes a match
+ *          can start with), and the string is scanned for these with
+ *          memchr first, so that most positions are never tried.
+ *
+ *          Code that compiles the same EREs over and over can use
+ *          rxpCompileCached instead, which keeps them in a cache.
+ *
+ *          To find out which of many EREs match a string, compile
+ *          them together with rxpCompileSet and use rxpMatchSet,
+ *          which runs them all in a single pass.
+ *
+ *          To search data that is read in chunks, such as a file,
+ *          use rxpStreamOpen and pass the chunks to rxpStreamFeed,
+ *          which reports matches even if they span chunks.
+ *
+ *          For UTF-8 text, pass ERECF_UTF8 to rxpCompile, so that
+ *          character classes and "." match whole characters.
+ *
  *      3)  Call rxpFree to free the compiled ERE.
  *
+ *      A compiled ERE is never changed by matching, and may be used
+ *      by several threads at once. What matching does write to is
+ *      kept in scratch space, of which every ERE has one for use by
+ *      one thread at a time. Threads that do many matches should
+ *      create their own with rxpScratchCreate and use rxpMatchEx,
+ *      rxpMatch_fwdEx and rxpMatch_bwdEx.
+ *
  *      Beware: The matching routine is highly recursive and can
  *      require around 20 to 30 bytes per character in the source string
  *      to match it. Thus you should try to limit the length of the source
@@ -40,6 +76,7 @@
  *
  *@@header "helpers\regexp.h"
  *@@added V0.9.19 (2002-04-17) [umoeller]
+ *@@changed V1.0.24 (2026-10-18) [agent]: now needs OS/2, interlock.asm and sem.c for thread safety
  */
 
 /*
@@ -55,6 +92,9 @@
  *      GNU General Public License for more details.
  */
 
+#define INCL_DOSSEMAPHORES
+#include <os2.h>
+
 #include <stdio.h>
 #include <ctype.h>
 #include <stdlib.h>
@@ -64,6 +104,10 @@
 
 #include "setup.h"                      // code generation and debugging options
 
+#include "helpers\sem.h"                // lock* functions and fast mutexes
+
+#include "encodings\base.h"
+
 #define ERE_C
 #include "helpers\regexp.h"
 
@@ -205,17 +249,17 @@ POSIX_CCLASS;
 
 STATIC POSIX_CCLASS posix_cclass[] =
 {
-    5, "alnum", my_isalnum,
-    5, "alpha", my_isalpha,
-    5, "blank", my_isblank,
-    5, "cntrl", my_iscntrl,
-    5, "digit", my_isdigit,
-    5, "lower", my_islower,
-    5, "print", my_isprint,
-    5, "punct", my_ispunct,
-    5, "space", my_isspace,
-    5, "upper", my_isupper,
-    6, "xdigit", my_isxdigit,
+    { 5, "alnum", my_isalnum },
+    { 5, "alpha", my_isalpha },
+    { 5, "blank", my_isblank },
+    { 5, "cntrl", my_iscntrl },
+    { 5, "digit", my_isdigit },
+    { 5, "lower", my_islower },
+    { 5, "print", my_isprint },
+    { 5, "punct", my_ispunct },
+    { 5, "space", my_isspace },
+    { 5, "upper", my_isupper },
+    { 6, "xdigit", my_isxdigit },
 };
 
 STATIC int find_posix(const char *str)
@@ -545,6 +589,8 @@ STATIC BOOLEAN got_backrefs(MATCH * match)
         case MTYPE_PLUS:
         case MTYPE_STAR:
             return got_backrefs(match->u.match);
+        case MTYPE_SUB:
+            return got_backrefs(match->u.match);
         case MTYPE_CREP:
             return got_backrefs(match->u.crep.match);
         case MTYPE_OR:
@@ -819,10 +865,529 @@ STATIC MATCH *create_match(int *rc)
     return match;
 }
 
+/*...sUTF\45\8 characters and range tables:0: */
+/* With ERECF_UTF8, the ERE and the strings it is matched against are taken
+ * to be UTF-8. A character class is then collected as a table of Unicode
+ * code point ranges, rather than the 256 bit bitmap used for bytes.
+ *
+ * The FSM, the DFA and the Pike VM still only ever look at bytes, so the
+ * range table is turned into byte classes: the ASCII part of it into a
+ * single cclass, as before, and the rest into alternatives such as
+ * [\xe1-\xec][\x80-\xbf][\x80-\xbf], one byte class per byte of the UTF-8
+ * encoding. Where all the ranges are ASCII, the result is just the cclass,
+ * so EREs that don't use anything beyond ASCII run exactly as fast as
+ * without ERECF_UTF8.
+ *
+ * POSIX character classes and ERECF_TOLOWER only apply to ASCII. */
+
+#define UNICODE_MAX  0x10ffffL
+
+typedef struct
+{
+    long lo, hi;
+}
+URANGE;
+
+typedef struct
+{
+    int n, max;
+    URANGE *ranges;
+}
+URANGES;
+
+STATIC long utf8_min[] =
+{0, 0, 0x80, 0x800, 0x10000};
+
+/* Decodes the UTF-8 character at *s with encDecodeUTF8 and moves *s past it.
+ * encDecodeUTF8 lets some bad sequences through (stray continuation bytes,
+ * overlong forms, surrogates), so these are checked for here, and give -1
+ * without moving *s. */
+STATIC long utf8_decode(const char **s)
+{
+    const unsigned char *u = (const unsigned char *)*s;
+    const char *p = *s;
+    long c;
+    int i, n;
+
+    if (u[0] < 0x80)
+        n = 1;
+    else if (u[0] < 0xc2)
+        return -1;
+    else if (u[0] < 0xe0)
+        n = 2;
+    else if (u[0] < 0xf0)
+        n = 3;
+    else if (u[0] < 0xf5)
+        n = 4;
+    else
+        return -1;
+    for (i = 1; i < n; i++)
+        if ((u[i] & 0xc0) != 0x80)
+            return -1;
+
+    c = (long)encDecodeUTF8(&p);
+    if (c < utf8_min[n] || c > UNICODE_MAX || (c >= 0xd800 && c <= 0xdfff))
+        return -1;
+    *s = p;
+    return c;
+}
+
+STATIC int utf8_encode(long c, unsigned char *buf)
+{
+    if (c < 0x80)
+    {
+        buf[0] = (unsigned char)c;
+        return 1;
+    }
+    if (c < 0x800)
+    {
+        buf[0] = (unsigned char)(0xc0 | (c >> 6));
+        buf[1] = (unsigned char)(0x80 | (c & 0x3f));
+        return 2;
+    }
+    if (c < 0x10000)
+    {
+        buf[0] = (unsigned char)(0xe0 | (c >> 12));
+        buf[1] = (unsigned char)(0x80 | ((c >> 6) & 0x3f));
+        buf[2] = (unsigned char)(0x80 | (c & 0x3f));
+        return 3;
+    }
+    buf[0] = (unsigned char)(0xf0 | (c >> 18));
+    buf[1] = (unsigned char)(0x80 | ((c >> 12) & 0x3f));
+    buf[2] = (unsigned char)(0x80 | ((c >> 6) & 0x3f));
+    buf[3] = (unsigned char)(0x80 | (c & 0x3f));
+    return 4;
+}
+
+STATIC BOOLEAN add_urange(URANGES * us, long lo, long hi)
+{
+    if (us->n == us->max)
+    {
+        int max = (us->max == 0) ? 16 : us->max * 2;
+        URANGE *ranges;
+
+        if ((ranges = (URANGE *) realloc(us->ranges, max * sizeof(URANGE))) == NULL)
+            return FALSE;
+        us->ranges = ranges;
+        us->max = max;
+    }
+    us->ranges[us->n].lo = lo;
+    us->ranges[us->n].hi = hi;
+    us->n++;
+    return TRUE;
+}
+
+/* Adds lo..hi less NUL, the surrogates and anything beyond Unicode,
+ * none of which can appear in valid UTF-8 strings. */
+STATIC BOOLEAN add_urange_valid(URANGES * us, long lo, long hi)
+{
+    if (lo < 1)
+        lo = 1;
+    if (hi > UNICODE_MAX)
+        hi = UNICODE_MAX;
+    if (lo < 0xd800 && hi > 0xdfff)
+        return add_urange(us, lo, 0xd7ff) && add_urange(us, 0xe000, hi);
+    if (lo >= 0xd800 && lo <= 0xdfff)
+        lo = 0xe000;
+    if (hi >= 0xd800 && hi <= 0xdfff)
+        hi = 0xd7ff;
+    return lo > hi || add_urange(us, lo, hi);
+}
+
+STATIC int compare_urange(const void *a, const void *b)
+{
+    long lo_a = ((const URANGE *)a)->lo, lo_b = ((const URANGE *)b)->lo;
+
+    return (lo_a < lo_b) ? -1 : (lo_a > lo_b) ? 1 : 0;
+}
+
+/* Sorts the ranges and merges those that overlap or touch, then
+ * complements them, if asked to, and removes what is not valid. */
+STATIC BOOLEAN normalise_uranges(URANGES * us, BOOLEAN complement)
+{
+    URANGES out;
+    long next = 1;
+    int i, n = 0;
+
+    if (us->n > 1)
+        qsort(us->ranges, us->n, sizeof(URANGE), compare_urange);
+    for (i = 0; i < us->n; i++)
+        if (n > 0 && us->ranges[i].lo <= us->ranges[n - 1].hi + 1)
+        {
+            if (us->ranges[i].hi > us->ranges[n - 1].hi)
+                us->ranges[n - 1].hi = us->ranges[i].hi;
+        }
+        else
+            us->ranges[n++] = us->ranges[i];
+
+    out.n = out.max = 0;
+    out.ranges = NULL;
+    for (i = 0; i < n; i++)
+        if (complement)
+        {
+            if (us->ranges[i].lo > next &&
+                !add_urange_valid(&out, next, us->ranges[i].lo - 1))
+                break;
+            next = us->ranges[i].hi + 1;
+        }
+        else if (!add_urange_valid(&out, us->ranges[i].lo, us->ranges[i].hi))
+            break;
+    if (i < n ||
+        (complement && next <= UNICODE_MAX &&
+         !add_urange_valid(&out, next, UNICODE_MAX)))
+    {
+        free(out.ranges);
+        return FALSE;
+    }
+
+    free(us->ranges);
+    *us = out;
+    return TRUE;
+}
+
+STATIC MATCH *cclass_match(unsigned char *cclass, int *rc)
+{
+    MATCH *match;
+
+    if ((match = create_match(rc)) == NULL)
+    {
+        delete_cclass(cclass);
+        return NULL;
+    }
+    match->mtype = MTYPE_CCLASS;
+    match->u.cclass = cclass;
+    return match;
+}
+
+/* Joins two matches with MTYPE_OR or MTYPE_CAT. Either may be NULL, in
+ * which case the other is returned as is. Deletes both on failure. */
+STATIC MATCH *join_match(MTYPE mtype, MATCH * a, MATCH * b, int *rc)
+{
+    MATCH *parent;
+
+    if (a == NULL)
+        return b;
+    if (b == NULL)
+        return a;
+    if ((parent = create_match(rc)) == NULL)
+    {
+        delete_match(a);
+        delete_match(b);
+        return NULL;
+    }
+    parent->mtype = mtype;
+    parent->u.matchs[0] = a;
+    parent->u.matchs[1] = b;
+    return parent;
+}
+
+/* Adds lo..hi, which must be valid and not ASCII, to *alts as a number
+ * of byte sequences. The range is split until lo and hi encode to the
+ * same number of bytes, and all the code points in between are found by
+ * taking each byte from the range of that byte in lo to that in hi. */
+STATIC BOOLEAN add_utf8_sequences(long lo, long hi, MATCH ** alts, int *rc)
+{
+    static long ends[] = {0x7ff, 0xffff};
+    unsigned char lo_bytes[4], hi_bytes[4];
+    MATCH *seq = NULL;
+    int i, j, n;
+
+    for (i = 0; i < 2; i++)
+        if (lo <= ends[i] && hi > ends[i])
+            return add_utf8_sequences(lo, ends[i], alts, rc) &&
+                add_utf8_sequences(ends[i] + 1, hi, alts, rc);
+
+    for (i = 1; i < 4; i++)
+    {
+        long m = (1L << (6 * i)) - 1;
+
+        if ((lo & ~m) != (hi & ~m))
+        {
+            if ((lo & m) != 0)
+                return add_utf8_sequences(lo, lo | m, alts, rc) &&
+                    add_utf8_sequences((lo | m) + 1, hi, alts, rc);
+            if ((hi & m) != m)
+                return add_utf8_sequences(lo, (hi & ~m) - 1, alts, rc) &&
+                    add_utf8_sequences(hi & ~m, hi, alts, rc);
+        }
+    }
+
+    n = utf8_encode(lo, lo_bytes);
+    utf8_encode(hi, hi_bytes);
+    for (i = 0; i < n; i++)
+    {
+        unsigned char *cclass;
+        MATCH *byte_match;
+
+        if ((cclass = (unsigned char *)malloc(0x100 >> 3)) == NULL)
+        {
+            if (seq != NULL)
+                delete_match(seq);
+            *rc = ERROR_NOT_ENOUGH_MEMORY;
+            return FALSE;
+        }
+        zero_cclass(cclass);
+        for (j = lo_bytes[i]; j <= hi_bytes[i]; j++)
+            add_to_cclass(j, cclass);
+        if ((byte_match = cclass_match(cclass, rc)) == NULL ||
+            (seq = join_match(MTYPE_CAT, seq, byte_match, rc)) == NULL)
+        {
+            if (byte_match == NULL && seq != NULL)
+                delete_match(seq);
+            return FALSE;
+        }
+    }
+
+    return (*alts = join_match(MTYPE_OR, *alts, seq, rc)) != NULL;
+}
+
+/* Turns normalised ranges into a match, as described above.
+ * Frees the ranges. */
+STATIC MATCH *compile_uranges(URANGES * us, int *rc)
+{
+    unsigned char *cclass;
+    MATCH *alts = NULL, *match;
+    long c;
+    int i;
+
+    if ((cclass = (unsigned char *)malloc(0x100 >> 3)) == NULL)
+    {
+        free(us->ranges);
+        *rc = ERROR_NOT_ENOUGH_MEMORY;
+        return NULL;
+    }
+    zero_cclass(cclass);
+
+    for (i = 0; i < us->n; i++)
+    {
+        long lo = us->ranges[i].lo, hi = us->ranges[i].hi;
+
+        for (c = lo; c <= hi && c < 0x80; c++)
+            add_to_cclass(c, cclass);
+        if (hi >= 0x80 &&
+            !add_utf8_sequences((lo < 0x80) ? 0x80 : lo, hi, &alts, rc))
+        {
+            if (alts != NULL)
+                delete_match(alts);
+            delete_cclass(cclass);
+            free(us->ranges);
+            return NULL;
+        }
+    }
+    free(us->ranges);
+
+    if ((match = cclass_match(cclass, rc)) == NULL)
+    {
+        if (alts != NULL)
+            delete_match(alts);
+        return NULL;
+    }
+    if (alts == NULL)
+        return match;
+    return join_match(MTYPE_OR, match, alts, rc);
+}
+
+/* Everything but the given ranges, for ., ~c and \W. */
+STATIC MATCH *compile_unot(const URANGE * ranges, int n, int *rc)
+{
+    URANGES us;
+    int i;
+
+    us.n = us.max = 0;
+    us.ranges = NULL;
+    for (i = 0; i < n; i++)
+        if (!add_urange(&us, ranges[i].lo, ranges[i].hi))
+            break;
+    if (i < n || !normalise_uranges(&us, TRUE))
+    {
+        free(us.ranges);
+        *rc = ERROR_NOT_ENOUGH_MEMORY;
+        return NULL;
+    }
+    return compile_uranges(&us, rc);
+}
+
+STATIC URANGE word_uranges[] =
+{
+    {'0', '9'},
+    {'A', 'Z'},
+    {'_', '_'},
+    {'a', 'z'}
+};
+
+/* With ERECF_UTF8, a span of 'boring' characters must not be split in the
+ * middle of a character, and any modifier after the span applies to all
+ * the bytes of its last character. So if the span has bytes beyond ASCII,
+ * this returns how many bytes of it to take as a string: all but the last
+ * character, or that alone, if it is the only one. Returns 0 to leave the
+ * span to thisch, and -1 for bad UTF-8. */
+STATIC int utf8_string(const char *str)
+{
+    const char *p = str, *last = str;
+    int i, n = boring_string(str);
+
+    for (i = 0; i < n && (unsigned char)str[i] < 0x80; i++)
+        ;
+    if (i == n)
+        return 0;
+    while (p < str + n)
+    {
+        last = p;
+        if (utf8_decode(&p) == -1)
+            return -1;
+    }
+    return (last > str) ? (int)(last - str) : (int)(p - str);
+}
+
+STATIC BOOLEAN make_string_match(MATCH * match, const char *s, int len, int erecf, int *rc)
+{
+    int i;
+
+    match->mtype = MTYPE_STRING;
+    if ((match->u.string = (char *)malloc(1 + len)) == NULL)
+    {
+        free(match);
+        *rc = ERROR_NOT_ENOUGH_MEMORY;
+        return FALSE;
+    }
+    match->u.string[0] = (char)len;
+    memcpy(match->u.string + 1, s, len);
+    if (erecf & ERECF_TOLOWER)
+        for (i = 1; i <= len; i++)
+            if ((unsigned char)match->u.string[i] < 0x80)
+                match->u.string[i] = (char)tolower(match->u.string[i]);
+    return TRUE;
+}
+
+#define CHL_BAD_UTF8          (-7)
+
+STATIC long uclass_thisch(const char *str)
+{
+    if ((unsigned char)str[0] >= 0x80)
+    {
+        long c = utf8_decode(&str);
+
+        return (c == -1) ? CHL_BAD_UTF8 : c;
+    }
+    return cclass_thisch(str);
+}
+
+STATIC const char *uclass_nextch(const char *str)
+{
+    if ((unsigned char)str[0] >= 0x80)
+    {
+        utf8_decode(&str);
+        return str;
+    }
+    return cclass_nextch(str);
+}
+
+/* As compile_cclass, but for ERECF_UTF8. */
+STATIC MATCH *compile_uclass(const char *str,
+                             const char **str_after,
+                             int erecf,
+                             int *rc)
+{
+    URANGES us;
+    BOOLEAN complement;
+    long c, last_c = -1;
+    int i, err = NO_ERROR;
+
+    us.n = us.max = 0;
+    us.ranges = NULL;
+
+    complement = (uclass_thisch(str) == CHL_COMP);
+    if (complement)
+        str = uclass_nextch(str);
+
+    while ((c = uclass_thisch(str)) != CHL_EOS && c != CHL_END_CCLASS)
+    {
+        if (CHL_POSIX_CCLASS_BASE <= c && c < CHL_POSIX_CCLASS_END)
+        {
+            for (i = 1; i < 0x80; i++)
+                if (posix_cclass[c - CHL_POSIX_CCLASS_BASE].iscclass(i) &&
+                    !add_urange(&us, i, i))
+                    err = ERROR_NOT_ENOUGH_MEMORY;
+            last_c = -1;
+        }
+        else
+            switch (c)
+            {
+                case CHL_POSIX_COLLATING:
+                    err = EREE_POSIX_COLLATING;
+                    break;
+                case CHL_POSIX_EQUIVALENCE:
+                    err = EREE_POSIX_EQUIVALENCE;
+                    break;
+                case CHL_POSIX_CCLASS_BAD:
+                    err = EREE_POSIX_CCLASS_BAD;
+                    break;
+                case CHL_BAD_UTF8:
+                    err = EREE_BAD_UTF8;
+                    break;
+                case CHL_RANGE:
+                    if (last_c == -1)
+                    {
+                        err = EREE_UNEX_RANGE;
+                        break;
+                    }
+                    str = uclass_nextch(str);
+                    if ((c = uclass_thisch(str)) == CHL_EOS || c == CHL_END_CCLASS)
+                        err = EREE_UNF_RANGE;
+                    else if (c == CHL_BAD_UTF8)
+                        err = EREE_BAD_UTF8;
+                    else if (c > last_c && !add_urange(&us, last_c + 1, c))
+                        err = ERROR_NOT_ENOUGH_MEMORY;
+                    last_c = c;
+                    break;
+
+#pragma info(nogen)     // do not warn here
+
+                case CHL_COMP:
+                    c = '^';
+                    // Fall through
+                default:
+                    if ((erecf & ERECF_TOLOWER) && c < 0x80)
+                        c = tolower((int)c);
+                    if (!add_urange(&us, c, c))
+                        err = ERROR_NOT_ENOUGH_MEMORY;
+                    last_c = c;
+                    break;
+
+#pragma info(restore)
+
+            }
+        if (err != NO_ERROR)
+        {
+            free(us.ranges);
+            *rc = err;
+            return NULL;
+        }
+        str = uclass_nextch(str);
+    }
+
+    if (c == CHL_EOS)
+    {
+        free(us.ranges);
+        *rc = EREE_UNF_CCLASS;
+        return NULL;
+    }
+
+    if (!normalise_uranges(&us, complement))
+    {
+        free(us.ranges);
+        *rc = ERROR_NOT_ENOUGH_MEMORY;
+        return NULL;
+    }
+
+    *str_after = uclass_nextch(str);
+    return compile_uranges(&us, rc);
+}
+
 STATIC MATCH *compile_term(const char *str, const char **str_after, int erecf, int *rc)
 {
     MATCH *match;
-    int c;
+    int c, n;
 
     c = thisch(str);
     switch (c)
@@ -856,7 +1421,45 @@ STATIC MATCH *compile_term(const char *str, const char **str_after, int erecf, i
     if ((match = create_match(rc)) == NULL)
         return NULL;
 
-    if (CH_NOT_BASE <= c && c < CH_NOT_END)
+    if ((erecf & ERECF_UTF8) && (n = utf8_string(str)) != 0)
+/*...sa string of UTF\45\8 characters:16: */
+    {
+        if (n == -1)
+        {
+            free(match);
+            *rc = EREE_BAD_UTF8;
+            return NULL;
+        }
+        if (!make_string_match(match, str, n, erecf, rc))
+            return NULL;
+        str += n;
+    }
+    else if ((erecf & ERECF_UTF8) && CH_NOT_BASE <= c && c < CH_NOT_END)
+/*...snot a specific UTF\45\8 character:16: */
+    {
+        URANGE nc;
+
+        nc.lo = c - CH_NOT_BASE;
+        if (str[1] != '\\' && nc.lo >= 0x80)
+        {
+            str++;
+            if ((nc.lo = utf8_decode(&str)) == -1)
+            {
+                free(match);
+                *rc = EREE_BAD_UTF8;
+                return NULL;
+            }
+        }
+        else
+            str = nextch(str);
+        if ((erecf & ERECF_TOLOWER) && nc.lo < 0x80)
+            nc.lo = tolower((int)nc.lo);
+        nc.hi = nc.lo;
+        free(match);
+        if ((match = compile_unot(&nc, 1, rc)) == NULL)
+            return NULL;
+    }
+    else if (CH_NOT_BASE <= c && c < CH_NOT_END)
 /*...snot a specific character:16: */
     {
         char ch = (char)(c - CH_NOT_BASE);
@@ -903,9 +1506,16 @@ STATIC MATCH *compile_term(const char *str, const char **str_after, int erecf, i
         {
 /*...sCH_LSQR   \45\ character class:24: */
             case CH_LSQR:
-                match->mtype = MTYPE_CCLASS;
                 str = nextch(str);
-                if ((match->u.cclass = compile_cclass(str, &str, erecf, rc)) == NULL)
+                if (erecf & ERECF_UTF8)
+                {
+                    free(match);
+                    if ((match = compile_uclass(str, &str, erecf, rc)) == NULL)
+                        return NULL;
+                    break;
+                }
+                match->mtype = MTYPE_CCLASS;
+                if ((match->u.cclass = compile_cclass(str, &str, erecf, rc)) == NULL)
                 {
                     free(match);
                     return NULL;
@@ -913,8 +1523,15 @@ STATIC MATCH *compile_term(const char *str, const char **str_after, int erecf, i
                 break;
 /*...sCH_DOT    \45\ any character:24: */
             case CH_DOT:
-                match->mtype = MTYPE_DOT;
                 str = nextch(str);
+                if (erecf & ERECF_UTF8)
+                {
+                    free(match);
+                    if ((match = compile_unot(NULL, 0, rc)) == NULL)
+                        return NULL;
+                    break;
+                }
+                match->mtype = MTYPE_DOT;
                 break;
 /*...sCH_WORD   \45\ \92\w:24: */
             case CH_WORD:
@@ -923,8 +1540,17 @@ STATIC MATCH *compile_term(const char *str, const char **str_after, int erecf, i
                 break;
 /*...sCH_NWORD  \45\ \92\W:24: */
             case CH_NWORD:
-                match->mtype = MTYPE_NWORD;
                 str = nextch(str);
+                if (erecf & ERECF_UTF8)
+                {
+                    free(match);
+                    if ((match = compile_unot(word_uranges,
+                                              sizeof(word_uranges) / sizeof(word_uranges[0]),
+                                              rc)) == NULL)
+                        return NULL;
+                    break;
+                }
+                match->mtype = MTYPE_NWORD;
                 break;
 /*...sCH_LPAR   \45\ nested regular expression:24: */
             case CH_LPAR:
@@ -981,6 +1607,18 @@ STATIC MATCH *compile_term(const char *str, const char **str_after, int erecf, i
                 break;
 /*...sdefault   \45\ any old character:24: */
             default:
+                if ((erecf & ERECF_UTF8) && c >= 0x80)
+                    // \xhh is U+00hh
+                {
+                    char buf[4];
+
+                    if (!make_string_match(match, buf,
+                                           utf8_encode(c, (unsigned char *)buf),
+                                           erecf, rc))
+                        return NULL;
+                    str = nextch(str);
+                    break;
+                }
                 {
                     char ch = (char)c;
 
@@ -1295,24 +1933,17 @@ typedef struct
         int n_span;             // Used if ETYPE_BACK
     }
     u;
-    const char *gate;           // Used if type of epsilon move
     int to_state;               // State to go to if test succeeds
     int next_edge;              // Next test to try after this
 }
 EDGE;
 
-/* Under DOS, restrict FSM size to 13KB approx.. On other environments memory
- * isn't such an issue, so allow something closer to 32KB. Of course, a better
- * implementation would dynamically grow the FSM size as needed. Something for
- * the future perhaps... */
-
-#ifdef xxDOS
-#define MAX_STATES   200
-#define MAX_EDGES    600
-#else
-#define MAX_STATES   500
-#define MAX_EDGES   1500
-#endif
+/* The tables of an FSM start small and are doubled whenever they are
+ * full, so small EREs take little memory, and large ones (such as
+ * generated alternations of many words) are not limited in size. */
+
+#define FSM_INIT_STATES  16
+#define FSM_INIT_EDGES   32
 
 #define FLAG_FINISH 0x01
 #define FLAG_VISITED    0x02
@@ -1321,18 +1952,79 @@ EDGE;
 typedef struct
 {
     int n_states;
-    int state_first_edges[MAX_STATES];
-    unsigned char state_flags[MAX_STATES];
+    int max_states;             // Size of state tables
+    int *state_first_edges;
+    unsigned char *state_flags;
     int n_edges;
-    EDGE edges[MAX_EDGES];
+    int max_edges;              // Size of edges
+    EDGE *edges;
 }
 FSM;
 
+/*...sreserve_states:0: */
+/* Makes room for at least n states. New states have no edges and no
+ * flags. */
+
+STATIC BOOLEAN reserve_states(FSM * fsm, int n)
+{
+    if (n > fsm->max_states)
+    {
+        int max_states = fsm->max_states * 2;
+        int *state_first_edges;
+        unsigned char *state_flags;
+        int i;
+
+        if (max_states < n)
+            max_states = n;
+        if ((state_first_edges = (int *)realloc(fsm->state_first_edges,
+                                                max_states * sizeof(int))) == NULL)
+            return FALSE;
+        fsm->state_first_edges = state_first_edges;
+        if ((state_flags = (unsigned char *)realloc(fsm->state_flags,
+                                                    max_states)) == NULL)
+            return FALSE;
+        fsm->state_flags = state_flags;
+        for (i = fsm->max_states; i < max_states; i++)
+        {
+            state_first_edges[i] = -1;
+            state_flags[i] = 0;
+        }
+        fsm->max_states = max_states;
+    }
+    return TRUE;
+}
+
+/*...sreserve_edges:0: */
+STATIC BOOLEAN reserve_edges(FSM * fsm, int n)
+{
+    if (n > fsm->max_edges)
+    {
+        int max_edges = fsm->max_edges * 2;
+        EDGE *edges;
+
+        if (max_edges < n)
+            max_edges = n;
+        if ((edges = (EDGE *) realloc(fsm->edges, max_edges * sizeof(EDGE))) == NULL)
+            return FALSE;
+        fsm->edges = edges;
+        fsm->max_edges = max_edges;
+    }
+    return TRUE;
+}
+
+/*...sdelete_fsm:0: */
+STATIC void delete_fsm(FSM * fsm)
+{
+    free(fsm->state_first_edges);
+    free(fsm->state_flags);
+    free(fsm->edges);
+    free(fsm);
+}
+
 /*...screate_fsm:0: */
 STATIC FSM *create_fsm(int *rc)
 {
     FSM *fsm;
-    int i;
 
     if ((fsm = (FSM *) malloc(sizeof(FSM))) == NULL)
     {
@@ -1341,23 +2033,51 @@ STATIC FSM *create_fsm(int *rc)
     }
 
     fsm->n_states = 0;
+    fsm->max_states = 0;
+    fsm->state_first_edges = NULL;
+    fsm->state_flags = NULL;
     fsm->n_edges = 0;
+    fsm->max_edges = 0;
+    fsm->edges = NULL;
 
-    for (i = 0; i < MAX_STATES; i++)
+    if (!reserve_states(fsm, FSM_INIT_STATES) ||
+        !reserve_edges(fsm, FSM_INIT_EDGES))
     {
-        fsm->state_first_edges[i] = -1;
-        fsm->state_flags[i] = 0;
+        delete_fsm(fsm);
+        *rc = ERROR_NOT_ENOUGH_MEMORY;
+        return NULL;
     }
 
     return fsm;
 }
-/*...sdelete_fsm:0: */
-#define delete_fsm(fsm) free(fsm)
+
+/*...scompact_fsm:0: */
+/* Gives back the unused parts of the tables, once the FSM is complete. */
+
+STATIC void compact_fsm(FSM * fsm)
+{
+    void *p;
+
+    if (fsm->n_states > 0 && fsm->n_states < fsm->max_states)
+    {
+        if ((p = realloc(fsm->state_first_edges, fsm->n_states * sizeof(int))) != NULL)
+            fsm->state_first_edges = (int *)p;
+        if ((p = realloc(fsm->state_flags, fsm->n_states)) != NULL)
+            fsm->state_flags = (unsigned char *)p;
+        fsm->max_states = fsm->n_states;
+    }
+    if (fsm->n_edges > 0 && fsm->n_edges < fsm->max_edges)
+    {
+        if ((p = realloc(fsm->edges, fsm->n_edges * sizeof(EDGE))) != NULL)
+            fsm->edges = (EDGE *) p;
+        fsm->max_edges = fsm->n_edges;
+    }
+}
 
 /*...smalloc_state:0: */
 STATIC int malloc_state(FSM * fsm)
 {
-    if (fsm->n_states == MAX_STATES)
+    if (!reserve_states(fsm, fsm->n_states + 1))
         return -1;
     else
         return fsm->n_states++;
@@ -1369,7 +2089,7 @@ STATIC int malloc_state(FSM * fsm)
 
 STATIC BOOLEAN malloc_edge(int s, EDGE * edge, FSM * fsm)
 {
-    int edge_no, n_edges = fsm->n_edges++;
+    int edge_no, n_edges = fsm->n_edges;
 
     // See if edge already exists
 
@@ -1423,12 +2143,13 @@ STATIC BOOLEAN malloc_edge(int s, EDGE * edge, FSM * fsm)
 
     // Going to have to add the edge
 
-    if (n_edges >= MAX_EDGES)
+    if (!reserve_edges(fsm, n_edges + 1))
         return FALSE;
 
     memcpy(&(fsm->edges[n_edges]), edge, sizeof(EDGE));
     fsm->edges[n_edges].next_edge = fsm->state_first_edges[s];
     fsm->state_first_edges[s] = n_edges;
+    fsm->n_edges++;
     return TRUE;
 }
 /*...smake_fsm_from_match:0: */
@@ -1515,7 +2236,6 @@ STATIC BOOLEAN add_edge_to_fsm_special(int s, int f, FSM * fsm, ETYPE etype)
 
     edge.etype = etype;
     edge.to_state = f;
-    edge.gate = NULL;
     return malloc_edge(s, &edge, fsm);
 }
 /*...sadd_edge_to_fsm_back:0: */
@@ -1525,7 +2245,6 @@ STATIC BOOLEAN add_edge_to_fsm_back(int s, int f, FSM * fsm, int n_span)
 
     edge.etype = ETYPE_BACK;
     edge.to_state = f;
-    edge.gate = NULL;
     edge.u.n_span = n_span;
     return malloc_edge(s, &edge, fsm);
 }
@@ -1908,7 +2627,7 @@ STATIC void determine_reachable(int s, FSM * fsm, FSM * fsm_without)
 }
 
 /*...scopy_non_epsilons:0: */
-STATIC void copy_non_epsilons(FSM * fsm, FSM * fsm_without)
+STATIC BOOLEAN copy_non_epsilons(FSM * fsm, FSM * fsm_without)
 {
     int state_no, edge_no;
 
@@ -1918,7 +2637,9 @@ STATIC void copy_non_epsilons(FSM * fsm, FSM * fsm_without)
                  edge_no != -1;
                  edge_no = fsm->edges[edge_no].next_edge)
                 if (fsm->edges[edge_no].etype != ETYPE_EPSILON)
-                    malloc_edge(state_no, &(fsm->edges[edge_no]), fsm_without);
+                    if (!malloc_edge(state_no, &(fsm->edges[edge_no]), fsm_without))
+                        return FALSE;
+    return TRUE;
 }
 
 /*...sfollow_epsilons:0: */
@@ -1987,6 +2708,8 @@ STATIC BOOLEAN remove_epsilons(int s, int f, FSM * fsm, FSM * fsm_without)
 {
     // FSM with no epsilon moves will have the same number of states
 
+    if (!reserve_states(fsm_without, fsm->n_states))
+        return FALSE;
     fsm_without->n_states = fsm->n_states;
 
     // Mark state f as a finish state in the new FSM
@@ -2003,7 +2726,8 @@ STATIC BOOLEAN remove_epsilons(int s, int f, FSM * fsm, FSM * fsm_without)
 
     // Copy across all reachable, non epsilon moves to new FSM
 
-    copy_non_epsilons(fsm, fsm_without);
+    if (!copy_non_epsilons(fsm, fsm_without))
+        return FALSE;
 
     // For all states, determine all other states that can be reached by
     // epsilon moves and add the edges leading from them to us
@@ -2043,6 +2767,19 @@ struct substruct
 
 #define MAX_SUBS 20
 
+/* Special edges taken on the current path. walk_fsm must not take the
+ * same one twice at a position, or it would loop. These live on the
+ * stack, rather than in the FSM, so that matches in several threads
+ * can walk the same FSM. */
+
+typedef struct gate GATE;
+struct gate
+{
+    const EDGE *e;
+    const char *str;            // Position at which e was taken
+    GATE *next;
+};
+
 typedef struct
 {
     FSM *fsm;
@@ -2052,6 +2789,7 @@ typedef struct
     const char *str_best;
     SUBS *subs;
     SUBS *subs_base;
+    GATE *gates;
     ERE_MATCHINFO *mi;
 }
 CONTEXT;
@@ -2062,15 +2800,20 @@ STATIC void NR walk_fsm(const char *str, int state_no, CONTEXT * cx);
 
 STATIC void NR walk_fsm_gated(const char *str, CONTEXT * cx, EDGE * e)
 {
-    if (e->gate != str)
-        // Avoid looping via this edge
-    {
-        const char *gate = e->gate;
+    GATE gate, *g;
 
-        e->gate = str;
-        walk_fsm(str, e->to_state, cx);
-        e->gate = gate;
-    }
+    // Avoid looping via this edge. Positions never decrease along the
+    // path, so the edges taken at str are the most recent ones.
+    for (g = cx->gates; g != NULL && g->str == str; g = g->next)
+        if (g->e == e)
+            return;
+
+    gate.e = e;
+    gate.str = str;
+    gate.next = cx->gates;
+    cx->gates = &gate;
+    walk_fsm(str, e->to_state, cx);
+    cx->gates = gate.next;
 }
 
 STATIC void NR walk_fsm_ssub(const char *str, CONTEXT * cx, EDGE * e)
@@ -2121,6 +2864,9 @@ STATIC void NR walk_fsm(const char *str, int state_no, CONTEXT * cx)
                 int i;
 
                 cx->mi->n_spans = cx->subs_base->n_spans;
+                if (cx->mi->n_spans > MAX_SPANS)
+                    // Further spans were not recorded
+                    cx->mi->n_spans = MAX_SPANS;
                 for (i = 0; i < cx->mi->n_spans; i++)
                     cx->mi->spans[i] = cx->subs_base->spans[i];
             }
@@ -2156,7 +2902,7 @@ STATIC void NR walk_fsm(const char *str, int state_no, CONTEXT * cx)
                 {
                     unsigned len = (unsigned char)e->u.string[0];
 
-                    if (!memcmp(str, e->u.string + 1, len))
+                    if (!strncmp(str, e->u.string + 1, len))
                         walk_fsm(str + len, e->to_state, cx);
                 }
                 break;
@@ -2234,7 +2980,8 @@ STATIC void NR walk_fsm(const char *str, int state_no, CONTEXT * cx)
                 {
                     int len = cx->subs->spans[e->u.n_span].len;
 
-                    if (!memcmp(str, cx->str_init + cx->subs->spans[e->u.n_span].pos, len))
+                    // strncmp, as str may end before len characters
+                    if (!strncmp(str, cx->str_init + cx->subs->spans[e->u.n_span].pos, len))
                         walk_fsm_gated(str + len, cx, e);
                 }
                 break;
@@ -2261,6 +3008,7 @@ STATIC const char *match_fsm(FSM * fsm,
     cx.str_best = NULL;
     cx.subs = &subs;
     cx.subs_base = &subs;
+    cx.gates = NULL;
     cx.mi = mi;
     subs.n_spans = 0;
     walk_fsm(str + posn, state_no, &cx);
@@ -2268,444 +3016,3002 @@ STATIC const char *match_fsm(FSM * fsm,
 }
 
 
-#ifdef DEBUG
-/*...sprint_fsm:0: */
-STATIC void print_fsm(FSM * fsm, int s, BOOLEAN not_just_reachable)
-{
-    int state_no, edge_no;
-
-    printf("Starting state %02d\n", s);
-    for (state_no = 0; state_no < fsm->n_states; state_no++)
-        if ((fsm->state_flags[state_no] & FLAG_REACHABLE) != 0 ||
-            not_just_reachable)
-        {
-            printf("%02d:%c\t", state_no, ((fsm->state_flags[state_no] & FLAG_FINISH) != 0) ? 'F' : ' ');
-            for (edge_no = fsm->state_first_edges[state_no];
-                 edge_no != -1;
-                 edge_no = fsm->edges[edge_no].next_edge)
-/*...sshow edge:32: */
-            {
-                EDGE *e = &(fsm->edges[edge_no]);
-
-                switch (e->etype)
-                {
-                    case ETYPE_CHAR:
-                        printf("%c", e->u.character);
-                        break;
-                    case ETYPE_NCHAR:
-                        printf("~%c", e->u.character);
-                        break;
-                    case ETYPE_STRING:
-                        printf("%*.*s",
-                               (unsigned char)e->u.string[0],
-                               (unsigned char)e->u.string[0],
-                               e->u.string + 1);
-                        break;
-                    case ETYPE_DOT:
-                        printf(".");
-                        break;
-                    case ETYPE_CCLASS:
-                        printf("[");
-                        break;
-                    case ETYPE_WORD:
-                        printf("\\w");
-                        break;
-                    case ETYPE_NWORD:
-                        printf("\\W");
-                        break;
-                    case ETYPE_EPSILON:
-                        printf("e");
-                        break;
-                    case ETYPE_SOL:
-                        printf("^");
-                        break;
-                    case ETYPE_EOL:
-                        printf("$");
-                        break;
-                    case ETYPE_SOW:
-                        printf("\\<");
-                        break;
-                    case ETYPE_EOW:
-                        printf("\\>");
-                        break;
-                    case ETYPE_IW:
-                        printf("\\B");
-                        break;
-                    case ETYPE_EW:
-                        printf("\\y");
-                        break;
-                    case ETYPE_SSUB:
-                        printf("(");
-                        break;
-                    case ETYPE_ESUB:
-                        printf(")");
-                        break;
-                    case ETYPE_BACK:
-                        printf("\\%d", e->u.n_span + 1);
-                        break;
-                }
-                printf("->%02d\t", e->to_state);
-            }
+/*...scompact NFA:0: */
+/* The lazy DFA (and other engines that step through the input one
+ * character at a time) use a compact copy of the epsilon-free FSM.
+ * Only states reachable from the start state are kept, and string
+ * edges are split into chains of single character edges through
+ * extra states, so that every consuming edge reads exactly one
+ * character. The edges of each state are stored contiguously, in
+ * the same order in which walk_fsm tries them.
+ *
+ * Characters that all edges treat alike are folded into one byte
+ * class, so a DFA only needs a transition per class. */
 
-            printf("\n");
-        }
+typedef struct
+{
+    ETYPE etype;                // ETYPE_CHAR ... ETYPE_ESUB, never ETYPE_STRING
+    union
+    {
+        char character;
+        const unsigned char *cclass;
+    }
+    u;
+    int to_pc;
 }
-
-#endif
-
-/*...sextended regular expressions:0: */
-/* An ERE knows its original match tree and also the FSM it is compiled into.
- * Using a (largely epsilon move free) FSM makes for faster searching. */
+NFAEDGE;
 
 typedef struct
 {
-    MATCH *match;               // Parse tree for expression
-    int shortest_match;         // Shortest match possible
-    FSM *fsm;                   // Compiled FSM
-    int s;                      // Start state for FSM
+    int n_pcs;                  // States, including those inside strings
+    int start_pc;
+    int *first_edges;           // Edges of pc are [first_edges[pc], first_edges[pc + 1])
+    unsigned char *pc_flags;    // FLAG_FINISH
+    NFAEDGE *edges;
+    int n_classes;              // Number of byte classes
+    unsigned char byte_class[0x100];    // Class of each byte
+    unsigned char class_byte[0x100];    // A byte of each class
 }
-ERE;
+NFA;
 
-/*
- *@@ rxpCompile:
- *      compiles the regular expression str for later matching.
- *
- *      If ERECF_TOLOWER is passed with erecf, every character
- *      (or range of characters) to be matched are stored in the
- *      compiled ERE in lower case. Therefore, if strings to be
- *      matched are passed in lower case also, the result is a
- *      case-insensitive match.
- */
+#define is_consuming(etype) ((etype) <= ETYPE_NWORD)
 
-ERE* rxpCompile(const char *str,
-                int erecf,
-                int *rc)            // out: error code
+/*...srefine_classes:0: */
+/* Splits the byte classes so that no class has members both inside
+ * and outside of cclass. */
+
+STATIC void refine_classes(NFA * nfa, const unsigned char *cclass)
 {
-    ERE *ere;
-    const char *str_after;
-    FSM *fsm;
-    int s, f;
+    short new_class[0x100][2];
+    int i, n = 0;
 
-    *rc = NO_ERROR;
+    for (i = 0; i < nfa->n_classes; i++)
+        new_class[i][0] = new_class[i][1] = -1;
 
-    if ((ere = (ERE *) malloc(sizeof(ERE))) == NULL)
+    for (i = 0; i < 0x100; i++)
     {
-        *rc = ERROR_NOT_ENOUGH_MEMORY;
-        return NULL;
-    }
+        short *p = &new_class[nfa->byte_class[i]][match_cclass(i, cclass)];
 
-    if ((ere->match = compile_match(str, &str_after, erecf, rc)) == NULL)
-    {
-        free(ere);
-        return NULL;
+        if (*p == -1)
+        {
+            *p = (short)n;
+            nfa->class_byte[n++] = (unsigned char)i;
+        }
+        nfa->byte_class[i] = (unsigned char)*p;
     }
+    nfa->n_classes = n;
+}
 
-    if (thisch(str_after) == CH_RPAR)
+STATIC void make_byte_classes(NFA * nfa)
+{
+    unsigned char cclass[0x100 >> 3];
+    int i, edge_no;
+
+    memset(nfa->byte_class, 0, sizeof(nfa->byte_class));
+    nfa->class_byte[0] = 0;
+    nfa->n_classes = 1;
+
+    // The end of the string and word constituents are always
+    // distinguished, since the special edges test for them
+    zero_cclass(cclass);
+    add_to_cclass(0, cclass);
+    refine_classes(nfa, cclass);
+    zero_cclass(cclass);
+    for (i = 1; i < 0x100; i++)
+        if (isword(i))
+            add_to_cclass(i, cclass);
+    refine_classes(nfa, cclass);
+
+    for (edge_no = 0; edge_no < nfa->first_edges[nfa->n_pcs]; edge_no++)
     {
-        delete_match(ere->match);
-        free(ere);
-        *rc = EREE_UNEX_RPAR;
-        return NULL;
+        NFAEDGE *e = &(nfa->edges[edge_no]);
+
+        switch (e->etype)
+        {
+            case ETYPE_CHAR:
+            case ETYPE_NCHAR:
+                zero_cclass(cclass);
+                add_to_cclass(e->u.character, cclass);
+                refine_classes(nfa, cclass);
+                break;
+            case ETYPE_CCLASS:
+                refine_classes(nfa, e->u.cclass);
+                break;
+        }
     }
+}
 
-    if (count_sub(ere->match) > MAX_SUBS)
+/*...smake_nfa:0: */
+STATIC NFA *make_nfa(FSM * fsm, int s, int *rc)
+{
+    NFA *nfa;
+    int *pc_of_state, *state_of_pc;
+    int n_states = 0, n_pcs, n_edges = 0, n_real_edges = 0;
+    int i, edge_no, pc, next_virtual, next_real_edge;
+
+    if ((pc_of_state = (int *)malloc(fsm->n_states * 2 * sizeof(int))) == NULL)
     {
-        delete_match(ere->match);
-        free(ere);
-        *rc = EREE_TOO_MANY_SUB;
+        *rc = ERROR_NOT_ENOUGH_MEMORY;
         return NULL;
     }
+    state_of_pc = pc_of_state + fsm->n_states;
+    for (i = 0; i < fsm->n_states; i++)
+        pc_of_state[i] = -1;
+
+    // Number the states reachable from s in breadth first order,
+    // and count the edges we are going to need
+    pc_of_state[s] = n_states;
+    state_of_pc[n_states++] = s;
+    for (i = 0; i < n_states; i++)
+        for (edge_no = fsm->state_first_edges[state_of_pc[i]];
+             edge_no != -1;
+             edge_no = fsm->edges[edge_no].next_edge)
+        {
+            EDGE *e = &(fsm->edges[edge_no]);
 
-#ifdef DEBUG
-    print_tree(ere->match, 0);
-#endif
+            n_real_edges++;
+            if (e->etype == ETYPE_STRING)
+                n_edges += (unsigned char)e->u.string[0];
+            else
+                n_edges++;
+            if (pc_of_state[e->to_state] == -1)
+            {
+                pc_of_state[e->to_state] = n_states;
+                state_of_pc[n_states++] = e->to_state;
+            }
+        }
 
-    ere->shortest_match = (int)shortest_match(ere->match);
+    // Each string of n characters needs n - 1 extra states
+    n_pcs = n_states + (n_edges - n_real_edges);
 
-    if ((fsm = create_fsm(rc)) == NULL)
+    if ((nfa = (NFA *) malloc(sizeof(NFA) +
+                              (n_pcs + 1) * sizeof(int) +
+                              n_edges * sizeof(NFAEDGE) +
+                              n_pcs)) == NULL)
     {
-        delete_match(ere->match);
-        free(ere);
+        free(pc_of_state);
+        *rc = ERROR_NOT_ENOUGH_MEMORY;
         return NULL;
     }
-
-    if (!make_fsm_from_match(ere->match, fsm, &s, &f))
+    nfa->edges = (NFAEDGE *) (nfa + 1);
+    nfa->first_edges = (int *)(nfa->edges + n_edges);
+    nfa->pc_flags = (unsigned char *)(nfa->first_edges + n_pcs + 1);
+    nfa->n_pcs = n_pcs;
+    nfa->start_pc = 0;
+
+    // Edges of the real states come first, then one edge for each
+    // state inside a string
+    next_virtual = n_states;
+    next_real_edge = 0;
+    for (pc = 0; pc < n_states; pc++)
     {
-        delete_fsm(fsm);
-        delete_match(ere->match);
-        free(ere);
-        *rc = EREE_COMPILE_FSM;
-        return NULL;
-    }
+        nfa->first_edges[pc] = next_real_edge;
+        nfa->pc_flags[pc] = fsm->state_flags[state_of_pc[pc]] & FLAG_FINISH;
 
-#ifdef DEBUG
+        for (edge_no = fsm->state_first_edges[state_of_pc[pc]];
+             edge_no != -1;
+             edge_no = fsm->edges[edge_no].next_edge)
+        {
+            EDGE *e = &(fsm->edges[edge_no]);
+            NFAEDGE *ne = &(nfa->edges[next_real_edge++]);
+            int to_pc = pc_of_state[e->to_state];
+
+            if (e->etype == ETYPE_STRING)
+            {
+                int len = (unsigned char)e->u.string[0];
+
+                ne->etype = ETYPE_CHAR;
+                ne->u.character = e->u.string[1];
+                ne->to_pc = (len > 1) ? next_virtual : to_pc;
+                for (i = 1; i < len; i++)
+                {
+                    int v = next_virtual++;
+
+                    ne = &(nfa->edges[n_real_edges + (v - n_states)]);
+                    nfa->first_edges[v] = n_real_edges + (v - n_states);
+                    nfa->pc_flags[v] = 0;
+                    ne->etype = ETYPE_CHAR;
+                    ne->u.character = e->u.string[1 + i];
+                    ne->to_pc = (i < len - 1) ? next_virtual : to_pc;
+                }
+            }
+            else
+            {
+                ne->etype = e->etype;
+                if (e->etype == ETYPE_CCLASS)
+                    ne->u.cclass = e->u.cclass;
+                else
+                    ne->u.character = e->u.character;
+                ne->to_pc = to_pc;
+            }
+        }
+    }
+    nfa->first_edges[n_pcs] = n_edges;
+
+    free(pc_of_state);
+
+    make_byte_classes(nfa);
+
+    return nfa;
+}
+
+#define delete_nfa(nfa) free(nfa)
+
+/*...snfa_edge_consumes:0: */
+/* Does a consuming edge accept character c? Nothing can consume
+ * the end of the string. */
+
+STATIC BOOLEAN nfa_edge_consumes(const NFAEDGE * e, unsigned char c)
+{
+    if (c == '\0')
+        return FALSE;
+    switch (e->etype)
+    {
+        case ETYPE_CHAR:
+            return c == (unsigned char)e->u.character;
+        case ETYPE_NCHAR:
+            return c != (unsigned char)e->u.character;
+        case ETYPE_DOT:
+            return TRUE;
+        case ETYPE_CCLASS:
+            return match_cclass(c, e->u.cclass);
+        case ETYPE_WORD:
+            return isword(c);
+        case ETYPE_NWORD:
+            return !isword(c);
+    }
+    return FALSE;
+}
+
+/*...snfa_edge_passes:0: */
+/* Can a special (zero width) edge be taken between the character
+ * context left, which is one of the CTX_ values, and the character c,
+ * which is '\0' at the end of the string? These are the same tests as
+ * in walk_fsm. */
+
+#define CTX_BOS     0           // At start of string
+#define CTX_NWORD   1           // After a non word constituent
+#define CTX_WORD    2           // After a word constituent
+
+STATIC BOOLEAN nfa_edge_passes(const NFAEDGE * e, int left, unsigned char c)
+{
+    BOOLEAN sow = (isword(c) && left != CTX_WORD),
+            eow = (left == CTX_WORD && !isword(c));
+
+    switch (e->etype)
+    {
+        case ETYPE_SOL:
+            return left == CTX_BOS;
+        case ETYPE_EOL:
+            return c == '\0';
+        case ETYPE_SOW:
+            return sow;
+        case ETYPE_EOW:
+            return eow;
+        case ETYPE_IW:
+            return left == CTX_WORD && isword(c);
+        case ETYPE_EW:
+            return sow || eow;
+        case ETYPE_SSUB:
+        case ETYPE_ESUB:
+            return TRUE;
+    }
+    return FALSE;
+}
+
+#define ctx_of(str, str_init) \
+    (((str) == (str_init)) ? CTX_BOS : isword((unsigned char)(str)[-1]) ? CTX_WORD : CTX_NWORD)
+
+/*...slazy DFA:0: */
+/* walk_fsm tries every path through the FSM, which can take
+ * exponential time (consider (a|a)*b), and rxpMatch_fwd starts it
+ * again at every position of the string. For EREs without
+ * backreferences we can instead run a DFA, which reads every
+ * character exactly once. Building the whole DFA up front can take
+ * exponential space, so its states are only built when the input
+ * reaches them, and are kept in a cache of bounded size for the
+ * following characters and calls.
+ *
+ * A DFA state is the set of NFA states (pcs) that can be active at a
+ * position, before following the special edges, whose tests depend
+ * on the next character. To find the leftmost match without trying
+ * every start position separately, the set is split into groups by
+ * the position at which the paths started, in order, and a new group
+ * is started at every position. If a pc is reachable from several
+ * groups, only the leftmost group keeps it: both paths have the same
+ * future, and the leftmost would win. When a group reaches the
+ * finish state, the groups to its right are dropped and no more
+ * groups are started. The start positions of the groups are not part
+ * of the state; dfa_search keeps them alongside, and every
+ * transition records where its groups came from.
+ *
+ * When looking for the longest match, the matching group is kept
+ * running to see if it matches again later. When looking for the
+ * shortest match, it is dropped as well and only the groups to its
+ * left, which would still win, keep running. Either way, the search
+ * is over once no group is left. */
+
+#define DFA_CTX         0x03    // CTX_ value before the state
+#define DFA_SHORTEST    0x04    // Shortest match wanted
+#define DFA_ANCHORED    0x08    // Don't start new groups
+#define DFA_MATCHED     0x10    // Got a match, don't start new groups
+
+#define DFA_BUCKETS     256
+#define DFA_MAX_MEM     (256 * 1024L)   // Flush cache when it uses more
+#define DFA_MAX_FLUSHES 8       // Give up on a search after this many
+#define DFA_CHUNK       4096    // Allocation unit for group maps
+
+typedef struct dfa_state DFASTATE;
+
+typedef struct
+{
+    DFASTATE *next;             // NULL if not computed yet
+    int accept;                 // Group that matched before the character, or -1
+    int *map;                   // For each group of next, the group it came from
+                                // or -1 for a new group
+}
+DFATRANS;
+
+struct dfa_state
+{
+    DFASTATE *hash_next;
+    unsigned hash;
+    int flags;                  // DFA_ flags
+    int n_groups;
+    int n_items;
+    DFATRANS *trans;            // One per byte class
+    int *items;                 // pcs of each group, each group ends with -1
+};
+
+typedef struct dfa_chunk DFACHUNK;
+struct dfa_chunk
+{
+    DFACHUNK *next;
+    int used;
+    int ints[DFA_CHUNK];
+};
+
+typedef struct
+{
+    const NFA *nfa;
+    DFASTATE *buckets[DFA_BUCKETS];
+    long mem;                   // Memory used by states and maps
+    DFACHUNK *chunks;           // Where the group maps live
+    // Scratch space for building states, n_pcs + 1 entries each
+    int *marks;                 // pc visited in closure if == gen
+    int *next_marks;            // pc in next state if == gen
+    int gen;
+    int *stack;
+    int *closure;
+    int *items;                 // Key of state being built
+    int *map;
+    int *starts;                // Start positions of groups, during search
+    int *next_starts;
+}
+DFA;
+
+STATIC DFA *create_dfa(const NFA * nfa)
+{
+    DFA *dfa;
+    int n = nfa->n_pcs + 1;
+
+    if ((dfa = (DFA *) malloc(sizeof(DFA) + 9 * n * sizeof(int))) == NULL)
+        return NULL;
+    memset(dfa, 0, sizeof(DFA));
+    dfa->nfa = nfa;
+    dfa->marks = (int *)(dfa + 1);
+    dfa->next_marks = dfa->marks + n;
+    dfa->stack = dfa->next_marks + n;
+    dfa->closure = dfa->stack + n;
+    dfa->items = dfa->closure + n;      // up to 2 * n
+    dfa->map = dfa->items + 2 * n;
+    dfa->starts = dfa->map + n;
+    dfa->next_starts = dfa->starts + n;
+    memset(dfa->marks, 0, 2 * n * sizeof(int));
+    return dfa;
+}
+
+STATIC void flush_dfa(DFA * dfa)
+{
+    int i;
+
+    for (i = 0; i < DFA_BUCKETS; i++)
+        while (dfa->buckets[i] != NULL)
+        {
+            DFASTATE *d = dfa->buckets[i];
+
+            dfa->buckets[i] = d->hash_next;
+            free(d);
+        }
+    while (dfa->chunks != NULL)
+    {
+        DFACHUNK *c = dfa->chunks;
+
+        dfa->chunks = c->next;
+        free(c);
+    }
+    dfa->mem = 0;
+}
+
+STATIC void delete_dfa(DFA * dfa)
+{
+    if (dfa != NULL)
+    {
+        flush_dfa(dfa);
+        free(dfa);
+    }
+}
+
+/*...sdfa_alloc_map:0: */
+STATIC int *dfa_alloc_map(DFA * dfa, int n)
+{
+    DFACHUNK *c = dfa->chunks;
+    int *map;
+
+    if (c == NULL || c->used + n > DFA_CHUNK)
+    {
+        int size = (n > DFA_CHUNK) ? n : DFA_CHUNK;
+
+        if ((c = (DFACHUNK *) malloc(sizeof(DFACHUNK) + (size - DFA_CHUNK) * sizeof(int))) == NULL)
+            return NULL;
+        c->used = 0;
+        c->next = dfa->chunks;
+        dfa->chunks = c;
+        dfa->mem += sizeof(DFACHUNK) + (size - DFA_CHUNK) * sizeof(int);
+    }
+    map = c->ints + c->used;
+    c->used += n;
+    return map;
+}
+
+/*...sdfa_intern:0: */
+/* Finds or creates the state with the given flags and the n_items
+ * items (in dfa->items) that make up n_groups groups. */
+
+STATIC DFASTATE *dfa_intern(DFA * dfa, int flags, int n_groups, int n_items)
+{
+    unsigned hash = 2166136261U ^ (unsigned)flags;
+    DFASTATE *d;
+    int i;
+
+    for (i = 0; i < n_items; i++)
+        hash = (hash ^ (unsigned)dfa->items[i]) * 16777619U;
+
+    for (d = dfa->buckets[hash % DFA_BUCKETS]; d != NULL; d = d->hash_next)
+        if (d->hash == hash &&
+            d->flags == flags &&
+            d->n_items == n_items &&
+            !memcmp(d->items, dfa->items, n_items * sizeof(int)))
+            return d;
+
+    i = sizeof(DFASTATE) +
+        dfa->nfa->n_classes * sizeof(DFATRANS) +
+        n_items * sizeof(int);
+    if ((d = (DFASTATE *) malloc(i)) == NULL)
+        return NULL;
+    dfa->mem += i;
+
+    d->hash = hash;
+    d->flags = flags;
+    d->n_groups = n_groups;
+    d->n_items = n_items;
+    d->trans = (DFATRANS *) (d + 1);
+    memset(d->trans, 0, dfa->nfa->n_classes * sizeof(DFATRANS));
+    d->items = (int *)(d->trans + dfa->nfa->n_classes);
+    memcpy(d->items, dfa->items, n_items * sizeof(int));
+    d->hash_next = dfa->buckets[hash % DFA_BUCKETS];
+    dfa->buckets[hash % DFA_BUCKETS] = d;
+    return d;
+}
+
+/*...sdfa_start:0: */
+STATIC DFASTATE *dfa_start(DFA * dfa, int flags)
+{
+    dfa->items[0] = dfa->nfa->start_pc;
+    dfa->items[1] = -1;
+    return dfa_intern(dfa, flags, 1, 2);
+}
+
+STATIC int compare_ints(const void *p1, const void *p2)
+{
+    return *(const int *)p1 - *(const int *)p2;
+}
+
+/*...sdfa_compute:0: */
+/* Computes the transition of *pd for byte class cls. If the cache is
+ * full, it is flushed first, and *pd is replaced by its new copy.
+ * Returns NULL if out of memory. */
+
+STATIC DFATRANS *dfa_compute(DFA * dfa, DFASTATE ** pd, int cls)
+{
+    const NFA *nfa = dfa->nfa;
+    DFASTATE *d = *pd;
+    DFATRANS *t;
+    unsigned char c = nfa->class_byte[cls];
+    int left = d->flags & DFA_CTX;
+    int flags = d->flags & (DFA_SHORTEST | DFA_ANCHORED | DFA_MATCHED);
+    int accept = -1, n_items = 0, n_groups = 0;
+    int g, i, j, *item;
+
+    if (dfa->mem > DFA_MAX_MEM)
+    {
+        // Keep a copy of the current state while flushing
+        memcpy(dfa->items, d->items, d->n_items * sizeof(int));
+        i = d->flags;
+        g = d->n_groups;
+        j = d->n_items;
+        flush_dfa(dfa);
+        if ((d = *pd = dfa_intern(dfa, i, g, j)) == NULL)
+            return NULL;
+    }
+
+    if (++dfa->gen == 0)
+    {
+        memset(dfa->marks, 0, 2 * (nfa->n_pcs + 1) * sizeof(int));
+        dfa->gen = 1;
+    }
+
+    for (item = d->items, g = 0; g < d->n_groups; g++, item++)
+    {
+        int n_closure = 0, n_stack = 0, first_item = n_items;
+        BOOLEAN finish = FALSE;
+
+        // Follow the special edges that pass here
+        for (; *item != -1; item++)
+            if (dfa->marks[*item] != dfa->gen)
+            {
+                dfa->marks[*item] = dfa->gen;
+                dfa->stack[n_stack++] = *item;
+            }
+        while (n_stack > 0)
+        {
+            int pc = dfa->stack[--n_stack];
+
+            dfa->closure[n_closure++] = pc;
+            if (nfa->pc_flags[pc] & FLAG_FINISH)
+                finish = TRUE;
+            for (i = nfa->first_edges[pc]; i < nfa->first_edges[pc + 1]; i++)
+            {
+                const NFAEDGE *e = &(nfa->edges[i]);
+
+                if (!is_consuming(e->etype) &&
+                    dfa->marks[e->to_pc] != dfa->gen &&
+                    nfa_edge_passes(e, left, c))
+                {
+                    dfa->marks[e->to_pc] = dfa->gen;
+                    dfa->stack[n_stack++] = e->to_pc;
+                }
+            }
+        }
+
+        if (finish && accept == -1)
+            accept = g;
+
+        // Groups right of a match don't matter any more, and in
+        // shortest mode, neither does the matching group
+        if (accept != -1 &&
+            (g > accept || (flags & DFA_SHORTEST)))
+            continue;
+
+        // Step over c
+        for (j = 0; j < n_closure; j++)
+        {
+            int pc = dfa->closure[j];
+
+            for (i = nfa->first_edges[pc]; i < nfa->first_edges[pc + 1]; i++)
+            {
+                const NFAEDGE *e = &(nfa->edges[i]);
+
+                if (is_consuming(e->etype) &&
+                    dfa->next_marks[e->to_pc] != dfa->gen &&
+                    nfa_edge_consumes(e, c))
+                {
+                    dfa->next_marks[e->to_pc] = dfa->gen;
+                    dfa->items[n_items++] = e->to_pc;
+                }
+            }
+        }
+
+        if (n_items > first_item)
+        {
+            qsort(dfa->items + first_item, n_items - first_item, sizeof(int), compare_ints);
+            dfa->items[n_items++] = -1;
+            dfa->map[n_groups++] = g;
+        }
+    }
+
+    if (accept != -1)
+        flags |= DFA_MATCHED;
+
+    // Start a new group at the next position
+    if (!(flags & (DFA_ANCHORED | DFA_MATCHED)) &&
+        c != '\0' &&
+        dfa->next_marks[nfa->start_pc] != dfa->gen)
+    {
+        dfa->items[n_items++] = nfa->start_pc;
+        dfa->items[n_items++] = -1;
+        dfa->map[n_groups++] = -1;
+    }
+
+    flags |= (c == '\0') ? CTX_BOS : isword(c) ? CTX_WORD : CTX_NWORD;
+
+    t = &(d->trans[cls]);
+    if ((t->map = dfa_alloc_map(dfa, n_groups)) == NULL)
+        return NULL;
+    memcpy(t->map, dfa->map, n_groups * sizeof(int));
+    t->accept = accept;
+    if ((t->next = dfa_intern(dfa, flags, n_groups, n_items)) == NULL)
+        return NULL;
+    return t;
+}
+
+/*...sprefilter:0: */
+/* Most EREs start with some fixed text. Before running an automaton,
+ * the string is scanned for places where a match could start, which
+ * memchr can do much faster than any automaton. Two things are known
+ * about those places: every match starts with the literal prefix, if
+ * there is one, and (for EREs without backreferences) with one of the
+ * bytes that the start state of the NFA can consume. */
+
+#define PREFIX_MAX  64
+
+typedef struct
+{
+    int len_prefix;             // Every match starts with prefix, or 0
+    char prefix[PREFIX_MAX];
+    int n_first;                // Number of bytes set in first, 0 if unused
+    unsigned char first_byte;   // The byte, if n_first == 1
+    BOOLEAN first[0x100];       // Every match starts with one of these
+}
+PREFILTER;
+
+/*...sliteral_prefix:0: */
+/* Finds the text that every match of match starts with, and stores up
+ * to n_max characters of it in buf. *whole is set if this is all that
+ * match matches (zero width assertions aside), so that the text
+ * matched by whatever follows may be appended. */
+
+STATIC int literal_prefix(const MATCH * match, char *buf, int n_max, BOOLEAN * whole)
+{
+    int n;
+
+    *whole = FALSE;
+    switch (match->mtype)
+    {
+        case MTYPE_NULL:
+        case MTYPE_SOL:
+        case MTYPE_EOL:
+        case MTYPE_SOW:
+        case MTYPE_EOW:
+        case MTYPE_IW:
+        case MTYPE_EW:
+            *whole = TRUE;
+            return 0;
+        case MTYPE_CHAR:
+            if (n_max == 0)
+                return 0;
+            buf[0] = match->u.character;
+            *whole = TRUE;
+            return 1;
+        case MTYPE_STRING:
+            n = (unsigned char)match->u.string[0];
+            if (n > n_max)
+                n = n_max;
+            else
+                *whole = TRUE;
+            memcpy(buf, match->u.string + 1, n);
+            return n;
+        case MTYPE_PLUS:
+            n = literal_prefix(match->u.match, buf, n_max, whole);
+            *whole = FALSE;
+            return n;
+        case MTYPE_CREP:
+            if (match->u.crep.m == 0)
+                return 0;
+            n = literal_prefix(match->u.crep.match, buf, n_max, whole);
+            *whole = FALSE;
+            return n;
+        case MTYPE_SUB:
+            return literal_prefix(match->u.match, buf, n_max, whole);
+        case MTYPE_CAT:
+            n = literal_prefix(match->u.matchs[0], buf, n_max, whole);
+            if (*whole)
+                n += literal_prefix(match->u.matchs[1], buf + n, n_max - n, whole);
+            return n;
+        case MTYPE_OR:
+            {
+                char buf2[PREFIX_MAX];
+                BOOLEAN whole2;
+                int n2, i;
+
+                n = literal_prefix(match->u.matchs[0], buf, n_max, whole);
+                n2 = literal_prefix(match->u.matchs[1], buf2, n_max, &whole2);
+                for (i = 0; i < n && i < n2 && buf[i] == buf2[i]; i++)
+                    ;
+                *whole = (*whole && whole2 && i == n && i == n2);
+                return i;
+            }
+    }
+    return 0;
+}
+
+/*...smake_prefilter:0: */
+STATIC void make_prefilter(PREFILTER * pf, const MATCH * match, const NFA * nfa)
+{
+    BOOLEAN whole;
+
+    pf->len_prefix = literal_prefix(match, pf->prefix, PREFIX_MAX, &whole);
+    pf->n_first = 0;
+
+    if (nfa != NULL && pf->len_prefix == 0)
+    {
+        int *stack, n_stack = 0, pc, c, edge_no;
+        BOOLEAN *seen, empty = FALSE;
+
+        // Follow all special edges from the start, whatever their
+        // tests, and collect what the consuming edges accept
+        if ((stack = (int *)malloc(nfa->n_pcs * (sizeof(int) + sizeof(BOOLEAN)))) == NULL)
+            return;
+        seen = (BOOLEAN *) (stack + nfa->n_pcs);
+        memset(seen, 0, nfa->n_pcs * sizeof(BOOLEAN));
+        memset(pf->first, 0, sizeof(pf->first));
+        stack[n_stack++] = nfa->start_pc;
+        seen[nfa->start_pc] = TRUE;
+        while (n_stack > 0)
+        {
+            pc = stack[--n_stack];
+            if (nfa->pc_flags[pc] & FLAG_FINISH)
+            {
+                // Can match the empty string anywhere
+                empty = TRUE;
+                break;
+            }
+            for (edge_no = nfa->first_edges[pc]; edge_no < nfa->first_edges[pc + 1]; edge_no++)
+            {
+                const NFAEDGE *e = &(nfa->edges[edge_no]);
+
+                if (is_consuming(e->etype))
+                {
+                    for (c = 1; c < 0x100; c++)
+                        if (nfa_edge_consumes(e, (unsigned char)c))
+                            pf->first[c] = TRUE;
+                }
+                else if (!seen[e->to_pc])
+                {
+                    seen[e->to_pc] = TRUE;
+                    stack[n_stack++] = e->to_pc;
+                }
+            }
+        }
+        if (!empty)
+        {
+            for (c = 1; c < 0x100; c++)
+                if (pf->first[c])
+                {
+                    pf->first_byte = (unsigned char)c;
+                    pf->n_first++;
+                }
+            if (pf->n_first == 0xff)
+                // Nothing to skip
+                pf->n_first = 0;
+        }
+        free(stack);
+    }
+}
+
+/*...sprefilter_next:0: */
+/* Returns the first position at or after p, and before end, at which
+ * a match could start, or NULL if there is none. */
+
+STATIC const char *prefilter_next(const PREFILTER * pf, const char *p, const char *end)
+{
+    if (pf->len_prefix > 0)
+    {
+        while ((p = (const char *)memchr(p, pf->prefix[0], end - p)) != NULL)
+        {
+            if (end - p < pf->len_prefix)
+                return NULL;
+            if (!memcmp(p + 1, pf->prefix + 1, pf->len_prefix - 1))
+                return p;
+            p++;
+        }
+        return NULL;
+    }
+    if (pf->n_first == 1)
+        return (const char *)memchr(p, pf->first_byte, end - p);
+    if (pf->n_first > 0)
+    {
+        for (; p < end; p++)
+            if (pf->first[(unsigned char)*p])
+                return p;
+        return NULL;
+    }
+    return p;
+}
+
+/*...sprefilter_at:0: */
+/* Could a match start at p? */
+
+STATIC BOOLEAN prefilter_at(const PREFILTER * pf, const char *p, const char *end)
+{
+    if (pf->len_prefix > 0)
+        return end - p >= pf->len_prefix && !memcmp(p, pf->prefix, pf->len_prefix);
+    return pf->n_first == 0 || (p < end && pf->first[(unsigned char)*p]);
+}
+
+#define prefilter_used(pf) ((pf)->len_prefix > 0 || (pf)->n_first > 0)
+
+/*...sdfa_search:0: */
+/* Searches for the leftmost match at or after pos (or only at pos if
+ * anchored). Returns 1 and the span of the match if found, 0 if there
+ * is none, or -1 if the DFA can't be used (out of memory, or the cache
+ * keeps overflowing), in which case the caller should use walk_fsm.
+ *
+ * If pf is given, the search skips ahead to the next candidate whenever
+ * the DFA is back in its start state, ie: no match is in progress. end
+ * must then point to the end of the string. */
+
+STATIC int dfa_search(DFA * dfa,
+                      int eremf,
+                      BOOLEAN anchored,
+                      const PREFILTER * pf,
+                      const char *str,
+                      const char *end,
+                      int pos,
+                      int *pos_match,
+                      int *len_match)
+{
+    const NFA *nfa = dfa->nfa;
+    DFASTATE *d;
+    int flags = ctx_of(str + pos, str);
+    int match_start = -1, match_end = -1;
+    int flushes = 0;
+    const char *p;
+
+    if (eremf & (EREMF_SHORTEST | EREMF_ANY))
+        flags |= DFA_SHORTEST;
+    if (anchored)
+        flags |= DFA_ANCHORED;
+
+    if ((d = dfa_start(dfa, flags)) == NULL)
+        return -1;
+    dfa->starts[0] = pos;
+
+    for (p = str + pos;; p++)
+    {
+        int cls;
+        DFATRANS *t;
+        int g, *swap;
+
+        if (pf != NULL &&
+            d->n_groups == 1 && d->n_items == 2 && d->items[0] == nfa->start_pc &&
+            (d->flags & (DFA_ANCHORED | DFA_MATCHED)) == 0)
+            // Nothing but a new start here, skip to the next candidate
+        {
+            const char *q = prefilter_next(pf, p, end);
+
+            if (q == NULL)
+                break;
+            if (q != p)
+            {
+                p = q;
+                if ((d = dfa_start(dfa, (d->flags & ~DFA_CTX) | ctx_of(p, str))) == NULL)
+                    return -1;
+                dfa->starts[0] = p - str;
+            }
+        }
+
+        cls = nfa->byte_class[(unsigned char)*p];
+        t = &(d->trans[cls]);
+        if (t->next == NULL)
+        {
+            long mem = dfa->mem;
+
+            if ((t = dfa_compute(dfa, &d, cls)) == NULL)
+                return -1;
+            if (dfa->mem < mem && ++flushes > DFA_MAX_FLUSHES)
+                return -1;
+        }
+
+        if (t->accept != -1)
+        {
+            match_start = dfa->starts[t->accept];
+            match_end = p - str;
+        }
+
+        d = t->next;
+        for (g = 0; g < d->n_groups; g++)
+            dfa->next_starts[g] = (t->map[g] == -1) ? (p + 1 - str) : dfa->starts[t->map[g]];
+        swap = dfa->starts;
+        dfa->starts = dfa->next_starts;
+        dfa->next_starts = swap;
+
+        if (*p == '\0' || d->n_groups == 0)
+            break;
+    }
+
+    if (match_start == -1)
+        return 0;
+    *pos_match = match_start;
+    *len_match = match_end - match_start;
+    return 1;
+}
+
+/*...sPike VM:0: */
+/* walk_fsm also records the sub-matches, but may take exponential
+ * time to do so. The Pike VM gets the same results by running all
+ * paths through the NFA in lockstep, one character at a time, with
+ * each thread carrying its own copy of the spans.
+ *
+ * The threads at each position are kept in the order in which
+ * walk_fsm would try their paths. If two threads reach the same pc at
+ * the same position, only the first is kept: anything the second
+ * could still match, the first matches too, and walk_fsm would find
+ * the first one first. The match recorded is therefore the one
+ * walk_fsm records: the first path to reach the longest end.
+ *
+ * In shortest mode, walk_fsm records the last path to reach the
+ * shortest end instead, so there the last thread to reach a pc wins,
+ * and takes the place of the earlier one in the list.
+ *
+ * Within the closure of one thread, pcs may be reached more than once
+ * though, as walk_fsm only refuses to take the same special edge
+ * twice at one position. This matters for groups that can match the
+ * empty string inside a loop, eg: ((a)?)*, where walk_fsm records an
+ * extra empty span. The closure only depends on the ERE, so this does
+ * not make matching any less linear in the length of the string. */
+
+typedef struct
+{
+    int n_spans;
+    ERE_SPAN spans[MAX_SPANS];
+}
+PIKECAPS;
+
+typedef struct
+{
+    int pc;
+    PIKECAPS caps;
+}
+PIKETHREAD;
+
+typedef struct
+{
+    const NFA *nfa;
+    int eremf;
+    int limit;                  // Matches must end at or before this
+    int pos;                    // Position being processed
+    int left;                   // CTX_ before pos
+    unsigned char c;            // Character at pos
+    int stamp;                  // Number of the thread being run
+    int first_stamp;            // Number of the first thread at pos
+    int *visited;               // Thread which last reached pc
+    int *queued;                // Position + 1 at which pc was queued
+    int *queued_at;             // Index in next at which it was queued
+    int *gates;                 // Thread which has edge on its path
+    PIKETHREAD *next;           // Threads for pos + 1, pc -1 if dropped
+    int n_next;
+    int max_next;
+    int best;                   // End of best match so far, or -1
+    PIKECAPS best_caps;
+}
+PIKEVM;
+
+/*...spike_compact:0: */
+/* Removes dropped threads from next. At most n_pcs are left, so there
+ * is at least as much room again afterwards. */
+
+STATIC void pike_compact(PIKEVM * vm)
+{
+    int i, n = 0;
+
+    for (i = 0; i < vm->n_next; i++)
+        if (vm->next[i].pc != -1)
+        {
+            vm->next[n] = vm->next[i];
+            vm->queued_at[vm->next[n].pc] = n;
+            n++;
+        }
+    vm->n_next = n;
+}
+
+/*...spike_add:0: */
+/* Follows the closure of the current thread from pc, like walk_fsm:
+ * records a match at finish states, queues the thread on consuming
+ * edges for the next position and takes special edges right away. */
+
+STATIC void pike_add(PIKEVM * vm, int pc, const PIKECAPS * caps)
+{
+    const NFA *nfa = vm->nfa;
+    int edge_no;
+
+    if (vm->visited[pc] >= vm->first_stamp && vm->visited[pc] != vm->stamp &&
+        (vm->eremf & EREMF_SHORTEST) == 0)
+        // An earlier thread got here first
+        return;
+    vm->visited[pc] = vm->stamp;
+
+    if (nfa->pc_flags[pc] & FLAG_FINISH)
+    {
+        if (vm->pos <= vm->limit &&
+            (vm->best == -1 ||
+             ((vm->eremf & EREMF_SHORTEST) ? (vm->pos <= vm->best) : (vm->pos > vm->best))))
+        {
+            vm->best = vm->pos;
+            vm->best_caps = *caps;
+        }
+        if (vm->eremf & EREMF_ANY)
+            return;
+    }
+
+    for (edge_no = nfa->first_edges[pc]; edge_no < nfa->first_edges[pc + 1]; edge_no++)
+    {
+        const NFAEDGE *e = &(nfa->edges[edge_no]);
+
+        if (is_consuming(e->etype))
+        {
+            if (nfa_edge_consumes(e, vm->c))
+            {
+                if (vm->queued[e->to_pc] == vm->pos + 1)
+                {
+                    if ((vm->eremf & EREMF_SHORTEST) == 0)
+                        continue;
+                    vm->next[vm->queued_at[e->to_pc]].pc = -1;
+                }
+                if (vm->n_next == vm->max_next)
+                    pike_compact(vm);
+                vm->queued[e->to_pc] = vm->pos + 1;
+                vm->queued_at[e->to_pc] = vm->n_next;
+                vm->next[vm->n_next].pc = e->to_pc;
+                vm->next[vm->n_next].caps = *caps;
+                vm->n_next++;
+            }
+        }
+        else if (vm->gates[edge_no] != vm->stamp &&
+                 nfa_edge_passes(e, vm->left, vm->c))
+        {
+            PIKECAPS caps2 = *caps;
+            int gate = vm->gates[edge_no];
+
+            if (e->etype == ETYPE_SSUB)
+            {
+                if (caps2.n_spans < MAX_SPANS)
+                    caps2.spans[caps2.n_spans].pos = vm->pos;
+            }
+            else if (e->etype == ETYPE_ESUB)
+            {
+                if (caps2.n_spans < MAX_SPANS)
+                {
+                    caps2.spans[caps2.n_spans].len = vm->pos - caps2.spans[caps2.n_spans].pos;
+                    ++caps2.n_spans;
+                }
+            }
+            vm->gates[edge_no] = vm->stamp;
+            pike_add(vm, e->to_pc, &caps2);
+            vm->gates[edge_no] = gate;
+        }
+    }
+}
+
+/*...spike_size:0: */
+/* Returns the size of the space pike_match needs for the NFA. Each pc
+ * is queued at most once per position, but in shortest mode, the
+ * dropped threads take up room until compacted. */
+
+STATIC size_t pike_size(const NFA * nfa)
+{
+    return 4 * nfa->n_pcs * sizeof(PIKETHREAD) +
+        (3 * nfa->n_pcs + nfa->first_edges[nfa->n_pcs]) * sizeof(int);
+}
+
+/*...spike_match:0: */
+/* Matches at posn only, like match_fsm. Returns the position of the
+ * end of the match, -1 if there is none, or -2 if out of memory. The
+ * space is allocated for the call if the caller passes none. */
+
+STATIC int pike_match(const NFA * nfa,
+                      void *space,
+                      int eremf,
+                      const char *str,
+                      int posn,
+                      int limit,
+                      ERE_MATCHINFO * mi)
+{
+    PIKEVM vm;
+    PIKETHREAD *threads = (PIKETHREAD *) space, *current;
+    int n_current, n_edges = nfa->first_edges[nfa->n_pcs], i;
+
+    if (space == NULL &&
+        (threads = (PIKETHREAD *) malloc(pike_size(nfa))) == NULL)
+        return -2;
+    vm.max_next = 2 * nfa->n_pcs;
+    vm.visited = (int *)(threads + 2 * vm.max_next);
+    vm.queued = vm.visited + nfa->n_pcs;
+    vm.queued_at = vm.queued + nfa->n_pcs;
+    vm.gates = vm.queued_at + nfa->n_pcs;
+    for (i = 0; i < nfa->n_pcs; i++)
+        vm.visited[i] = vm.queued[i] = -1;
+    for (i = 0; i < n_edges; i++)
+        vm.gates[i] = -1;
+
+    vm.nfa = nfa;
+    vm.eremf = eremf;
+    vm.limit = limit;
+    vm.stamp = 0;
+    vm.best = -1;
+
+    current = threads;
+    current[0].pc = nfa->start_pc;
+    memset(&(current[0].caps), 0, sizeof(PIKECAPS));
+    n_current = 1;
+    vm.next = threads + vm.max_next;
+
+    for (vm.pos = posn; n_current > 0 && vm.pos <= limit; vm.pos++)
+    {
+        PIKETHREAD *swap;
+
+        vm.left = ctx_of(str + vm.pos, str);
+        vm.c = (unsigned char)str[vm.pos];
+        vm.n_next = 0;
+        vm.first_stamp = vm.stamp;
+
+        for (i = 0; i < n_current; i++, vm.stamp++)
+            if (current[i].pc != -1)
+                pike_add(&vm, current[i].pc, &(current[i].caps));
+
+        if (vm.c == '\0' ||
+            ((eremf & EREMF_SHORTEST) && vm.best != -1))
+            // No better match can come later
+            break;
+
+        swap = current;
+        current = vm.next;
+        vm.next = swap;
+        n_current = vm.n_next;
+    }
+
+    if (space == NULL)
+        free(threads);
+
+    if (vm.best != -1 && mi != NULL)
+    {
+        mi->n_spans = vm.best_caps.n_spans;
+        for (i = 0; i < mi->n_spans; i++)
+            mi->spans[i] = vm.best_caps.spans[i];
+    }
+    return vm.best;
+}
+
+#ifdef DEBUG
+/*...sprint_fsm:0: */
+STATIC void print_fsm(FSM * fsm, int s, BOOLEAN not_just_reachable)
+{
+    int state_no, edge_no;
+
+    printf("Starting state %02d\n", s);
+    for (state_no = 0; state_no < fsm->n_states; state_no++)
+        if ((fsm->state_flags[state_no] & FLAG_REACHABLE) != 0 ||
+            not_just_reachable)
+        {
+            printf("%02d:%c\t", state_no, ((fsm->state_flags[state_no] & FLAG_FINISH) != 0) ? 'F' : ' ');
+            for (edge_no = fsm->state_first_edges[state_no];
+                 edge_no != -1;
+                 edge_no = fsm->edges[edge_no].next_edge)
+/*...sshow edge:32: */
+            {
+                EDGE *e = &(fsm->edges[edge_no]);
+
+                switch (e->etype)
+                {
+                    case ETYPE_CHAR:
+                        printf("%c", e->u.character);
+                        break;
+                    case ETYPE_NCHAR:
+                        printf("~%c", e->u.character);
+                        break;
+                    case ETYPE_STRING:
+                        printf("%*.*s",
+                               (unsigned char)e->u.string[0],
+                               (unsigned char)e->u.string[0],
+                               e->u.string + 1);
+                        break;
+                    case ETYPE_DOT:
+                        printf(".");
+                        break;
+                    case ETYPE_CCLASS:
+                        printf("[");
+                        break;
+                    case ETYPE_WORD:
+                        printf("\\w");
+                        break;
+                    case ETYPE_NWORD:
+                        printf("\\W");
+                        break;
+                    case ETYPE_EPSILON:
+                        printf("e");
+                        break;
+                    case ETYPE_SOL:
+                        printf("^");
+                        break;
+                    case ETYPE_EOL:
+                        printf("$");
+                        break;
+                    case ETYPE_SOW:
+                        printf("\\<");
+                        break;
+                    case ETYPE_EOW:
+                        printf("\\>");
+                        break;
+                    case ETYPE_IW:
+                        printf("\\B");
+                        break;
+                    case ETYPE_EW:
+                        printf("\\y");
+                        break;
+                    case ETYPE_SSUB:
+                        printf("(");
+                        break;
+                    case ETYPE_ESUB:
+                        printf(")");
+                        break;
+                    case ETYPE_BACK:
+                        printf("\\%d", e->u.n_span + 1);
+                        break;
+                }
+                printf("->%02d\t", e->to_state);
+            }
+
+            printf("\n");
+        }
+}
+
+#endif
+
+/*...sextended regular expressions:0: */
+/* An ERE knows its original match tree and also the FSM it is compiled into.
+ * Using a (largely epsilon move free) FSM makes for faster searching.
+ *
+ * Matching never writes to the ERE. What it does write to, the lazy DFA
+ * and the space for the Pike VM, is kept in an ERESCRATCH, which only
+ * one thread may use at a time. Each ERE has one of these for callers
+ * that don't pass their own, and a thread that finds it in use makes a
+ * temporary one instead. So an ERE can be shared by many threads, but
+ * threads that match a lot should each have their own ERESCRATCH. */
+
+typedef struct
+{
+    DFA *dfa;                   // Lazy DFA, NULL if ERE has backreferences
+    void *pike;                 // Space for the Pike VM, or NULL
+}
+ERESCRATCH;
+
+typedef struct cached_ere CACHED;
+
+typedef struct
+{
+    MATCH *match;               // Parse tree for expression
+    int shortest_match;         // Shortest match possible
+    FSM *fsm;                   // Compiled FSM
+    int s;                      // Start state for FSM
+    NFA *nfa;                   // Compact FSM, NULL if got backreferences
+    PREFILTER pf;               // Where matches can start
+    ERESCRATCH *scratch;        // For callers without one, created on first use
+    LONG busy;                  // Non-zero while scratch is in use
+    CACHED *cached;             // Cache entry, if from rxpCompileCached
+}
+ERE;
+
+/*...sdelete_scratch:0: */
+STATIC void delete_scratch(ERESCRATCH * sc)
+{
+    if (sc != NULL)
+    {
+        delete_dfa(sc->dfa);
+        free(sc->pike);
+        free(sc);
+    }
+}
+
+/*...screate_scratch:0: */
+STATIC ERESCRATCH *create_scratch(const ERE * ere)
+{
+    ERESCRATCH *sc;
+
+    if ((sc = (ERESCRATCH *) malloc(sizeof(ERESCRATCH))) == NULL)
+        return NULL;
+    sc->dfa = NULL;
+    sc->pike = NULL;
+    if (ere->nfa != NULL &&
+        ((sc->dfa = create_dfa(ere->nfa)) == NULL ||
+         (sc->pike = malloc(pike_size(ere->nfa))) == NULL))
+    {
+        delete_scratch(sc);
+        return NULL;
+    }
+    return sc;
+}
+
+/*...sclaim_scratch:0: */
+/* Returns the scratch space of the ERE, or a temporary one if another
+ * thread is using it. Either way, give it back with release_scratch.
+ * Returns NULL if out of memory, and matching then falls back to
+ * walk_fsm, which needs none. */
+
+STATIC ERESCRATCH *claim_scratch(const ERE * ere)
+{
+    ERE *e = (ERE *) ere;
+
+    if (lockExchange(&(e->busy), 1) != 0)
+        return create_scratch(ere);
+
+    if (e->scratch == NULL &&
+        (e->scratch = create_scratch(ere)) == NULL)
+        lockExchange(&(e->busy), 0);
+    return e->scratch;
+}
+
+/*...srelease_scratch:0: */
+STATIC void release_scratch(const ERE * ere, ERESCRATCH * sc)
+{
+    if (sc == NULL)
+        return;
+    if (sc == ere->scratch)
+        lockExchange(&(((ERE *) ere)->busy), 0);
+    else
+        delete_scratch(sc);
+}
+
+/*...sere_match_at:0: */
+/* Matches at posn only. This uses the Pike VM if possible, as it
+ * takes linear time, and walk_fsm otherwise. */
+
+STATIC const char *ere_match_at(const ERE * ere,
+                                const ERESCRATCH * sc,
+                                int eremf,
+                                const char *str,
+                                int posn,
+                                int limit,
+                                ERE_MATCHINFO * mi)
+{
+    if (ere->nfa != NULL)
+    {
+        int end = pike_match(ere->nfa, (sc != NULL) ? sc->pike : NULL,
+                             eremf, str, posn, limit, mi);
+
+        if (end != -2)
+            return (end == -1) ? NULL : str + end;
+    }
+    return match_fsm(ere->fsm, eremf, str, posn, limit, ere->s, mi);
+}
+
+/*
+ *@@ rxpCompile:
+ *      compiles the regular expression str for later matching.
+ *
+ *      If ERECF_TOLOWER is passed with erecf, every character
+ *      (or range of characters) to be matched are stored in the
+ *      compiled ERE in lower case. Therefore, if strings to be
+ *      matched are passed in lower case also, the result is a
+ *      case-insensitive match.
+ *
+ *      If ERECF_UTF8 is passed, the ERE and the strings it will
+ *      be matched against are UTF-8. ".", "~c", "\W" and bracket
+ *      expressions then match one whole character, which may be
+ *      several bytes, and a quantifier after a character applies
+ *      to all of its bytes. "\xhh" stands for U+00hh. POSIX
+ *      classes like "[:alpha:]" and ERECF_TOLOWER still only
+ *      know about ASCII. Returns EREE_BAD_UTF8 if the ERE is not
+ *      valid UTF-8. Bytes in the string that are not valid UTF-8
+ *      are not matched by anything but themselves.
+ *
+ *@@changed V1.0.24 (2026-10-18) [agent]: FSM tables grow as needed, no more size limit
+ *@@changed V1.0.24 (2026-10-18) [agent]: added ERECF_UTF8
+ */
+
+ERE* rxpCompile(const char *str,
+                int erecf,
+                int *rc)            // out: error code
+{
+    ERE *ere;
+    const char *str_after;
+    FSM *fsm;
+    int s, f;
+
+    *rc = NO_ERROR;
+
+    if ((ere = (ERE *) malloc(sizeof(ERE))) == NULL)
+    {
+        *rc = ERROR_NOT_ENOUGH_MEMORY;
+        return NULL;
+    }
+
+    if ((ere->match = compile_match(str, &str_after, erecf, rc)) == NULL)
+    {
+        free(ere);
+        return NULL;
+    }
+
+    if (thisch(str_after) == CH_RPAR)
+    {
+        delete_match(ere->match);
+        free(ere);
+        *rc = EREE_UNEX_RPAR;
+        return NULL;
+    }
+
+    if (count_sub(ere->match) > MAX_SUBS)
+    {
+        delete_match(ere->match);
+        free(ere);
+        *rc = EREE_TOO_MANY_SUB;
+        return NULL;
+    }
+
+#ifdef DEBUG
+    print_tree(ere->match, 0);
+#endif
+
+    ere->shortest_match = (int)shortest_match(ere->match);
+
+    if ((fsm = create_fsm(rc)) == NULL)
+    {
+        delete_match(ere->match);
+        free(ere);
+        return NULL;
+    }
+
+    if (!make_fsm_from_match(ere->match, fsm, &s, &f))
+    {
+        delete_fsm(fsm);
+        delete_match(ere->match);
+        free(ere);
+        *rc = EREE_COMPILE_FSM;
+        return NULL;
+    }
+
+#ifdef DEBUG
     print_fsm(fsm, s, TRUE);
 #endif
 
-    if ((ere->fsm = create_fsm(rc)) == NULL)
+    if ((ere->fsm = create_fsm(rc)) == NULL)
+    {
+        delete_fsm(fsm);
+        delete_match(ere->match);
+        free(ere);
+        *rc = EREE_COMPILE_FSM;
+        return NULL;
+    }
+
+    if (!remove_epsilons(s, f, fsm, ere->fsm))
+    {
+        delete_fsm(ere->fsm);
+        delete_fsm(fsm);
+        delete_match(ere->match);
+        free(ere);
+        *rc = EREE_COMPILE_FSM;
+        return NULL;
+    }
+
+    // The FSM with epsilon moves is no longer needed, and the one
+    // without won't grow any more
+    delete_fsm(fsm);
+    compact_fsm(ere->fsm);
+
+    ere->s = s;
+    ere->nfa = NULL;
+    ere->scratch = NULL;
+    ere->busy = 0;
+    ere->cached = NULL;
+
+    if (!got_backrefs(ere->match) &&
+        (ere->nfa = make_nfa(ere->fsm, s, rc)) == NULL)
+    {
+        delete_fsm(ere->fsm);
+        delete_match(ere->match);
+        free(ere);
+        return NULL;
+    }
+
+    make_prefilter(&(ere->pf), ere->match, ere->nfa);
+
+#ifdef DEBUG
+    print_fsm(ere->fsm, s, FALSE);
+#endif
+
+    return ere;
+}
+
+/*
+ *@@ rxpMinLen:
+ *
+ */
+
+int rxpMinLen(const ERE * ere)
+{
+    return ere->shortest_match;
+}
+
+/*
+ *@@ rxpScratchCreate:
+ *      creates scratch space for matching the ERE, for use with
+ *      rxpMatchEx, rxpMatch_fwdEx and rxpMatch_bwdEx. This holds
+ *      everything that a match writes to, such as the lazy DFA, so
+ *      that a compiled ERE can be matched by many threads at once.
+ *
+ *      A scratch space may only be used by one thread at a time, and
+ *      only for this ERE. Free it with rxpScratchFree before freeing
+ *      the ERE.
+ *
+ *      The functions without the Ex suffix are safe to call from many
+ *      threads too. They use scratch space kept in the ERE, but if
+ *      another thread is using that, they create a temporary one for
+ *      the call, and the DFA states built in it are lost afterwards.
+ *      A thread which does many matches should have its own.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+ERESCRATCH* rxpScratchCreate(const ERE *ere,    // in: compiled ERE (from rxpCompile)
+                             int *rc)           // out: error code
+{
+    ERESCRATCH *sc;
+
+    if ((sc = create_scratch(ere)) == NULL)
+    {
+        *rc = ERROR_NOT_ENOUGH_MEMORY;
+        return NULL;
+    }
+    *rc = NO_ERROR;
+    return sc;
+}
+
+/*
+ *@@ rxpScratchFree:
+ *      frees scratch space created by rxpScratchCreate.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+void rxpScratchFree(ERESCRATCH *scratch)
+{
+    delete_scratch(scratch);
+}
+
+/*
+ *@@ rxpMatchEx:
+ *      returns the number of characters in the match, starting from
+ *      pos characters into the string to be searched. Details of
+ *      sub-matches can also be returned. Returns -1 if no match.
+ *
+ *      If EREMF_SHORTEST is passed with eremf, the code looks for
+ *      the shortest match, instead of the longest match.
+ *
+ *      If EREMF_ANY is passed with eremf, the code doesn't try to
+ *      find the longest (or shortest) match, it will return with the
+ *      first match it finds (which could be of any length).
+ *      This can speed up matching.
+ *
+ *      scratch is the scratch space of the calling thread (from
+ *      rxpScratchCreate), or NULL, as with rxpMatch.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+int rxpMatchEx(const ERE *ere,              // in: compiled ERE (from rxpCompile)
+               int eremf,                   // in: EREMF_* flags
+               const char *str,             // in: string to test
+               int pos,                     // in: start position
+               ERE_MATCHINFO *mi,           // out: match info (for rxpSubsWith)
+               ERESCRATCH *scratch)         // in: scratch space or NULL
+{
+    int len = pos + strlen(str + pos);
+    int len_best = -2;          // Not known yet
+    ERESCRATCH *sc;
+
+    if (!prefilter_at(&(ere->pf), str + pos, str + len))
+        return -1;
+
+    sc = (scratch != NULL) ? scratch : claim_scratch(ere);
+
+    if (mi == NULL && sc != NULL && sc->dfa != NULL)
+    {
+        int pos_match, len_match;
+
+        switch (dfa_search(sc->dfa, eremf, TRUE, NULL, str, NULL, pos, &pos_match, &len_match))
+        {
+            case 1:
+                len_best = len_match;
+                break;
+            case 0:
+                len_best = -1;
+                break;
+        }
+        // else fall back to walk_fsm
+    }
+
+    if (len_best == -2)
+    {
+        const char *str_best = ere_match_at(ere, sc, eremf, str, pos, len, mi);
+
+        len_best = (str_best == NULL) ? -1 : (str_best - str) - pos;
+    }
+
+    if (scratch == NULL)
+        release_scratch(ere, sc);
+    return len_best;
+}
+
+/*
+ *@@ rxpMatch:
+ *      returns the number of characters in the match, starting from
+ *      pos characters into the string to be searched. Details of
+ *      sub-matches can also be returend. Returns -1 if no match.
+ *
+ *      If EREMF_SHORTEST is passed with eremf, the code looks for
+ *      the shortest match, instead of the longest match.
+ *
+ *      If EREMF_ANY is passed with eremf, the code doesn't try to
+ *      find the longest (or shortest) match, it will return with the
+ *      first match it finds (which could be of any length).
+ *      This can speed up matching.
+ *
+ *      This is rxpMatchEx without scratch space of the caller's.
+ *
+ *@@changed V1.0.24 (2026-10-18) [agent]: uses lazy DFA if mi is NULL
+ *@@changed V1.0.24 (2026-10-18) [agent]: uses Pike VM for sub-matches
+ *@@changed V1.0.24 (2026-10-18) [agent]: checks the literal prefix first
+ *@@changed V1.0.24 (2026-10-18) [agent]: now thread-safe, see rxpScratchCreate
+ */
+
+int rxpMatch(const ERE * ere,
+             int eremf,
+             const char *str,
+             int pos,
+             ERE_MATCHINFO * mi)
+{
+    return rxpMatchEx(ere, eremf, str, pos, mi, NULL);
+}
+
+/*
+ *@@ rxpMatch_fwdEx:
+ *      match forwards within a string from a specified start position.
+ *
+ *      If a match, return TRUE, and also return pos and len of the match.
+ *
+ *      If EREMF_SHORTEST is passed with eremf, the code looks for
+ *      the shortest match, instead of the longest match.
+ *
+ *      If EREMF_ANY is passed with eremf, the code doesn't try to
+ *      find the longest (or shortest) match, it will return with the
+ *      first match it finds (which could be of any length).
+ *      This can speed up matching.
+ *
+ *      If the ERE has no backreferences, this runs the lazy DFA,
+ *      which reads every character of the string once, no matter
+ *      where the match starts or how complex the ERE is. If mi is
+ *      given, the sub-matches are then determined by the Pike VM at
+ *      the start position found, which also runs in linear time.
+ *
+ *      Either way, positions at which no match can start are skipped
+ *      using memchr, if rxpCompile found a literal prefix or a small
+ *      set of bytes that every match starts with.
+ *
+ *      scratch is the scratch space of the calling thread (from
+ *      rxpScratchCreate), or NULL, as with rxpMatch_fwd.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+BOOLEAN rxpMatch_fwdEx(const ERE *ere,      // in: compiled ERE (from rxpCompile)
+                       int eremf,           // in: EREMF_* flags
+                       const char *str,     // in: string to test
+                       int pos,             // in: start position
+                       int *pos_match,      // out: position of match
+                       int *len_match,      // out: length of match
+                       ERE_MATCHINFO *mi,   // out: match info (for rxpSubsWith)
+                       ERESCRATCH *scratch) // in: scratch space or NULL
+{
+    int len = pos + strlen(str + pos);
+    int i, found = -1;          // Not known yet
+    ERESCRATCH *sc = (scratch != NULL) ? scratch : claim_scratch(ere);
+
+    if (sc != NULL && sc->dfa != NULL)
+    {
+        found = dfa_search(sc->dfa, eremf, FALSE,
+                           prefilter_used(&(ere->pf)) ? &(ere->pf) : NULL,
+                           str, str + len,
+                           pos, pos_match, len_match);
+        if (found == 1 && mi != NULL)
+        {
+            // Get the sub-matches at the position we know
+            const char *str_best = ere_match_at(ere, sc, eremf, str, *pos_match, len, mi);
+
+            *len_match = (str_best - str) - *pos_match;
+        }
+    }
+
+    if (found == -1)
+        // Fall back to walk_fsm at every position
+    {
+        found = 0;
+        for (i = pos; i <= len - ere->shortest_match; i++)
+        {
+            const char *str_best;
+
+            if ((str_best = prefilter_next(&(ere->pf), str + i, str + len)) == NULL)
+                break;
+            if ((i = str_best - str) > len - ere->shortest_match)
+                break;
+            if ((str_best = ere_match_at(ere, sc, eremf, str, i, len, mi)) != NULL)
+            {
+                *pos_match = i;
+                *len_match = (str_best - str) - i;
+                found = 1;
+                break;
+            }
+        }
+    }
+
+    if (scratch == NULL)
+        release_scratch(ere, sc);
+    return found == 1;
+}
+
+/*
+ *@@ rxpMatch_fwd:
+ *      match forwards within a string from a specified start position.
+ *
+ *      If a match, return TRUE, and also return pos and len of the match.
+ *
+ *      This is rxpMatch_fwdEx without scratch space of the caller's;
+ *      see remarks there.
+ *
+ *@@changed V1.0.24 (2026-10-18) [agent]: added lazy DFA
+ *@@changed V1.0.24 (2026-10-18) [agent]: uses Pike VM for sub-matches
+ *@@changed V1.0.24 (2026-10-18) [agent]: added prefilter
+ *@@changed V1.0.24 (2026-10-18) [agent]: now thread-safe, see rxpScratchCreate
+ */
+
+BOOLEAN rxpMatch_fwd(const ERE *ere,        // in: compiled ERE (from rxpCompile)
+                     int eremf,             // in: EREMF_* flags
+                     const char *str,       // in: string to test
+                     int pos,               // in: start position
+                     int *pos_match,        // out: position of match
+                     int *len_match,        // out: length of match
+                     ERE_MATCHINFO *mi)     // out: match info (for rxpSubsWith)
+{
+    return rxpMatch_fwdEx(ere, eremf, str, pos, pos_match, len_match, mi, NULL);
+}
+
+/*
+ *@@ rxpMatch_bwdEx:
+ *      match backwards within a string not passing a
+ *      specified end position.
+ *
+ *      If a match, return TRUE, and also return pos and
+ *      len of the match. We need to consider matches from
+ *      the beginning of the line. We want the one which
+ *      ends up in the rightmost position. Of those which
+ *      end up equally far right, we want the one which
+ *      extends the furthest (or shortest if EREMF_SHORTEST)
+ *      left. See how we get this as a side effect of the
+ *      loop ordering and the '>= + delta' test.
+ *
+ *      This may not look as efficient as scanning the string
+ *      backwards, but note that this would require a reversed
+ *      ERE too, and we can't reverse EREs as they may
+ *      contain backreferences.
+ *
+ *      If EREMF_SHORTEST is passed with eremf, the code looks for
+ *      the shortest match, instead of the longest match.
+ *
+ *      If EREMF_ANY is passed with eremf, the code doesn't try to
+ *      find the longest (or shortest) match, it will return with the
+ *      first match it finds (which could be of any length).
+ *      This can speed up matching.
+ *
+ *      scratch is the scratch space of the calling thread (from
+ *      rxpScratchCreate), or NULL, as with rxpMatch_bwd.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+BOOLEAN rxpMatch_bwdEx(const ERE *ere,      // in: compiled ERE (from rxpCompile)
+                       int eremf,           // in: EREMF_* flags
+                       const char *str,     // in: string to test
+                       int pos,             // in: start position
+                       int *pos_match,      // out: position of match
+                       int *len_match,      // out: length of match
+                       ERE_MATCHINFO *mi,   // out: match info (for rxpSubsWith)
+                       ERESCRATCH *scratch) // in: scratch space or NULL
+{
+    int i, j;
+    int delta = (eremf & EREMF_SHORTEST) ? 0 : 1;
+    const char *rightmost = NULL;
+    ERE_MATCHINFO mi2;
+    ERESCRATCH *sc = (scratch != NULL) ? scratch : claim_scratch(ere);
+
+    for (i = 0; i <= pos - ere->shortest_match; i++)
+    {
+        const char *str_best;
+
+        if ((str_best = prefilter_next(&(ere->pf), str + i, str + pos)) == NULL)
+            break;
+        if ((i = str_best - str) > pos - ere->shortest_match)
+            break;
+        if ((str_best = ere_match_at(ere, sc, eremf, str, i, pos, &mi2)) != NULL)
+        {
+            if (rightmost == NULL ||
+                str_best >= rightmost + delta)
+            {
+                *pos_match = i;
+                *len_match = (str_best - str) - i;
+                rightmost = str_best;
+                if (mi != NULL)
+                {
+                    mi->n_spans = mi2.n_spans;
+                    for (j = 0; j < mi->n_spans; j++)
+                        mi->spans[j] = mi2.spans[j];
+                }
+            }
+        }
+    }
+
+    if (scratch == NULL)
+        release_scratch(ere, sc);
+    return rightmost != NULL;
+}
+
+/*
+ *@@ rxpMatch_bwd:
+ *      match backwards within a string not passing a
+ *      specified end position.
+ *
+ *      If a match, return TRUE, and also return pos and
+ *      len of the match.
+ *
+ *      This is rxpMatch_bwdEx without scratch space of the
+ *      caller's; see remarks there.
+ *
+ *@@changed V1.0.24 (2026-10-18) [agent]: uses Pike VM for sub-matches
+ *@@changed V1.0.24 (2026-10-18) [agent]: fixed copying mi clobbering the loop counter
+ *@@changed V1.0.24 (2026-10-18) [agent]: added prefilter
+ *@@changed V1.0.24 (2026-10-18) [agent]: now thread-safe, see rxpScratchCreate
+ */
+
+BOOLEAN rxpMatch_bwd(const ERE *ere,        // in: compiled ERE (from rxpCompile)
+                     int eremf,             // in: EREMF_* flags
+                     const char *str,       // in: string to test
+                     int pos,               // in: start position
+                     int *pos_match,        // out: position of match
+                     int *len_match,        // out: length of match
+                     ERE_MATCHINFO * mi)    // out: match info (for rxpSubsWith)
+{
+    return rxpMatch_bwdEx(ere, eremf, str, pos, pos_match, len_match, mi, NULL);
+}
+
+/*...sfree_ere:0: */
+STATIC void free_ere(ERE * ere)
+{
+    delete_scratch(ere->scratch);
+    if (ere->nfa != NULL)
+        delete_nfa(ere->nfa);
+    delete_match(ere->match);
+    delete_fsm(ere->fsm);
+    free(ere);
+}
+
+STATIC void cache_release(CACHED * c);
+
+/*
+ *@@ rxpFree:
+ *      frees all resources allocated by rxpCompile.
+ *
+ *      For an ERE from rxpCompileCached, this only tells the cache
+ *      that the caller no longer uses it.
+ *
+ *@@changed V1.0.24 (2026-10-18) [agent]: added rxpCompileCached support
+ */
+
+void rxpFree(ERE * ere)
+{
+    if (ere)
+    {
+        if (ere->cached != NULL)
+            cache_release(ere->cached);
+        else
+            free_ere(ere);
+    }
+}
+
+/*
+ *@@ rxpSubsWith:
+ *      perform a substitution based upon an earlier found match.
+ *      This allows for implementing a "find and replace" function.
+ *
+ *      The sub-spans in mi are the ones the Pike VM found for the
+ *      leftmost-longest (or shortest) match, so \1 etc. refer to the
+ *      same text as with the old walk_fsm matcher.
+ *
+ *@@changed V1.0.24 (2026-10-18) [agent]: fixed length of the tail copied and overflow checks
+ */
+
+BOOLEAN rxpSubsWith(const char *str,    // in: original string searched (same as str given to rxpMatch_fwd)
+                    int pos,            // in: span of the entire match (pos_match from rxpMatch_fwd)
+                    int len,            // in: span of the entire match (len_match from rxpMatch_fwd)
+                    ERE_MATCHINFO *mi,  // in: details of match sub-spans (as from rxpMatch_fwd)
+                    const char *with,   // in: replacement string with \1 etc.
+                    char *out,          // out: buffer for string substitutions
+                    int len_out,        // in: sizeof *out
+                    int *rc)            // out: error, if FALSE returned
+{
+    int i = 0;
+    int j;
+
+    if (pos >= len_out)
     {
-        delete_fsm(fsm);
-        delete_match(ere->match);
-        free(ere);
-        *rc = EREE_COMPILE_FSM;
-        return NULL;
+        *rc = EREE_SUBS_LEN;
+        return FALSE;
     }
+    memcpy(out, str, pos);
+    i += pos;
+    while (*with != '\0')
+    {
+        const char *rep;
+        int len_rep;
 
-    if (!remove_epsilons(s, f, fsm, ere->fsm))
+        if (*with != '\\')
+        {
+            rep = with++;
+            len_rep = 1;
+        }
+        else
+        {
+            ++with;
+            if (*with >= '1' && *with <= '9')
+            {
+                int span = *with - '1';
+
+                ++with;
+                if (span >= mi->n_spans)
+                {
+                    *rc = EREE_BAD_BACKREF;
+                    return FALSE;
+                }
+                rep = str + mi->spans[span].pos;
+                len_rep = mi->spans[span].len;
+            }
+            else if (*with != '\0')
+            {
+                rep = with++;
+                len_rep = 1;
+            }
+            else
+            {
+                *rc = EREE_BAD_BACKSLASH;
+                return FALSE;
+            }
+        }
+        if (i + len_rep > len_out)
+        {
+            *rc = EREE_SUBS_LEN;
+            return FALSE;
+        }
+        memcpy(out + i, rep, len_rep);
+        i += len_rep;
+    }
+    j = strlen(str + pos + len);
+    if (i + j >= len_out)
     {
-        delete_fsm(ere->fsm);
-        delete_fsm(fsm);
-        delete_match(ere->match);
-        free(ere);
-        *rc = EREE_COMPILE_FSM;
-        return NULL;
+        *rc = EREE_SUBS_LEN;
+        return FALSE;
     }
+    memcpy(out + i, str + pos + len, j);
+    i += j;
+    out[i] = '\0';
+    return TRUE;
+}
 
-    delete_fsm(fsm);
+/*...sERE cache:0: */
+/* rxpCompileCached keeps compiled EREs, keyed by their text and
+ * compile flags, so that code which compiles the same ERE over and
+ * over only does so once. Callers share the ERE, and rxpFree only
+ * drops their reference. EREs nobody uses stay in the cache until it
+ * takes more memory than its budget, and then the least recently
+ * used ones are freed first. EREs in use are never freed, but their
+ * memory counts against the budget too.
+ *
+ * The cache is guarded by a fast mutex (see sem.c), which is only
+ * held while looking up or linking entries, never while compiling.
+ * semRequest creates its event semaphore on first use; LockCount
+ * starts at -1, which is what semCreate would set. */
 
-    ere->s = s;
+#define CACHE_BUCKETS   256
+#define CACHE_MAX_MEM   (1024 * 1024L)  // Default budget
 
-#ifdef DEBUG
-    print_fsm(ere->fsm, s, FALSE);
-#endif
+struct cached_ere
+{
+    CACHED *hash_next;
+    CACHED *lru_prev;           // Used more recently
+    CACHED *lru_next;           // Used less recently
+    unsigned hash;
+    int erecf;
+    ERE *ere;
+    int refs;                   // Callers using ere
+    long mem;                   // Memory used by ere and this
+    char str[1];                // Text of ere
+};
 
-    return ere;
+STATIC FASTMTX cache_mtx = {-1, 0, 0, 0, 0};
+STATIC CACHED *cache_buckets[CACHE_BUCKETS];
+STATIC CACHED *cache_mru = NULL;
+STATIC CACHED *cache_lru = NULL;
+STATIC ERE_CACHESTATS cache_stats = {0, 0, 0, 0, 0, CACHE_MAX_MEM};
+
+/*...scache_enter:0: */
+STATIC void cache_enter(void)
+{
+    semRequest(&cache_mtx);
+}
+
+/*...scache_leave:0: */
+STATIC void cache_leave(void)
+{
+    semRelease(&cache_mtx);
+}
+
+/*...scache_hash:0: */
+STATIC unsigned cache_hash(const char *str, int erecf)
+{
+    unsigned hash = 2166136261U ^ (unsigned)erecf;
+
+    while (*str)
+        hash = (hash ^ (unsigned char)*str++) * 16777619U;
+    return hash;
+}
+
+/*...scache_find:0: */
+/* Returns the entry for the ERE and marks it as most recently used,
+ * or returns NULL. */
+
+STATIC CACHED *cache_find(const char *str, int erecf, unsigned hash)
+{
+    CACHED *c;
+
+    for (c = cache_buckets[hash % CACHE_BUCKETS]; c != NULL; c = c->hash_next)
+        if (c->hash == hash && c->erecf == erecf && !strcmp(c->str, str))
+            break;
+    if (c != NULL && c != cache_mru)
+    {
+        // Move to the front of the LRU list
+        c->lru_prev->lru_next = c->lru_next;
+        if (c->lru_next != NULL)
+            c->lru_next->lru_prev = c->lru_prev;
+        else
+            cache_lru = c->lru_prev;
+        c->lru_prev = NULL;
+        c->lru_next = cache_mru;
+        cache_mru->lru_prev = c;
+        cache_mru = c;
+    }
+    return c;
+}
+
+/*...scache_evict:0: */
+/* Unlinks unused EREs, least recently used first, until the cache
+ * takes no more than max_mem. Returns them chained by hash_next, to
+ * be freed by cache_free once the lock is released. */
+
+STATIC CACHED *cache_evict(long max_mem)
+{
+    CACHED *c = cache_lru, *evicted = NULL;
+
+    while (c != NULL && cache_stats.mem > max_mem)
+    {
+        CACHED *prev = c->lru_prev;
+
+        if (c->refs == 0)
+        {
+            CACHED **pc = &(cache_buckets[c->hash % CACHE_BUCKETS]);
+
+            while (*pc != c)
+                pc = &((*pc)->hash_next);
+            *pc = c->hash_next;
+
+            if (prev != NULL)
+                prev->lru_next = c->lru_next;
+            else
+                cache_mru = c->lru_next;
+            if (c->lru_next != NULL)
+                c->lru_next->lru_prev = prev;
+            else
+                cache_lru = prev;
+
+            cache_stats.mem -= c->mem;
+            cache_stats.n_eres--;
+            cache_stats.evictions++;
+            c->hash_next = evicted;
+            evicted = c;
+        }
+        c = prev;
+    }
+    return evicted;
+}
+
+/*...scache_free:0: */
+STATIC void cache_free(CACHED * c)
+{
+    while (c != NULL)
+    {
+        CACHED *next = c->hash_next;
+
+        free_ere(c->ere);
+        free(c);
+        c = next;
+    }
+}
+
+/*...scache_release:0: */
+STATIC void cache_release(CACHED * c)
+{
+    CACHED *evicted;
+
+    cache_enter();
+    c->refs--;
+    evicted = cache_evict(cache_stats.max_mem);
+    cache_leave();
+    cache_free(evicted);
+}
+
+/*...sere_mem:0: */
+/* Returns roughly how much memory the ERE takes. The lazy DFA is not
+ * counted, as its cache is limited to DFA_MAX_MEM anyway. */
+
+STATIC long ere_mem(const ERE * ere)
+{
+    const FSM *fsm = ere->fsm;
+    long mem = sizeof(ERE) + sizeof(FSM) +
+        fsm->max_states * (sizeof(int) + sizeof(unsigned char)) +
+        fsm->max_edges * sizeof(EDGE);
+
+    if (ere->nfa != NULL)
+        mem += sizeof(NFA) +
+            (ere->nfa->n_pcs + 1) * sizeof(int) +
+            ere->nfa->first_edges[ere->nfa->n_pcs] * sizeof(NFAEDGE) +
+            ere->nfa->n_pcs;
+    return mem;
 }
 
 /*
- *@@ rxpMinLen:
+ *@@ rxpCompileCached:
+ *      like rxpCompile, but returns an ERE from the cache if the
+ *      same text has been compiled with the same flags before.
+ *
+ *      The ERE may be shared with other callers, including other
+ *      threads, and must not be changed. Call rxpFree when done
+ *      with it as usual; this only frees it once nobody uses it
+ *      and the cache needs the room (see rxpCacheLimit).
+ *
+ *      Errors are not cached.
  *
+ *@@added V1.0.24 (2026-10-18) [agent]
  */
 
-int rxpMinLen(const ERE * ere)
+ERE* rxpCompileCached(const char *str,      // in: ERE text
+                      int erecf,            // in: ERECF_* flags
+                      int *rc)              // out: error code
 {
-    return ere->shortest_match;
+    unsigned hash = cache_hash(str, erecf);
+    CACHED *c, *c2, *evicted;
+    ERE *ere;
+    int len;
+
+    cache_enter();
+    if ((c = cache_find(str, erecf, hash)) != NULL)
+    {
+        c->refs++;
+        cache_stats.hits++;
+        cache_leave();
+        *rc = NO_ERROR;
+        return c->ere;
+    }
+    cache_stats.misses++;
+    cache_leave();
+
+    if ((ere = rxpCompile(str, erecf, rc)) == NULL)
+        return NULL;
+
+    len = strlen(str);
+    if ((c = (CACHED *) malloc(sizeof(CACHED) + len)) == NULL)
+        // Still usable, just not cached
+        return ere;
+    c->hash = hash;
+    c->erecf = erecf;
+    c->ere = ere;
+    c->refs = 1;
+    c->mem = ere_mem(ere) + sizeof(CACHED) + len;
+    memcpy(c->str, str, len + 1);
+    ere->cached = c;
+
+    cache_enter();
+    if ((c2 = cache_find(str, erecf, hash)) != NULL)
+        // Another thread compiled it meanwhile, use theirs
+    {
+        c2->refs++;
+        cache_leave();
+        cache_free(c);
+        return c2->ere;
+    }
+
+    c->hash_next = cache_buckets[hash % CACHE_BUCKETS];
+    cache_buckets[hash % CACHE_BUCKETS] = c;
+    c->lru_prev = NULL;
+    c->lru_next = cache_mru;
+    if (cache_mru != NULL)
+        cache_mru->lru_prev = c;
+    else
+        cache_lru = c;
+    cache_mru = c;
+    cache_stats.mem += c->mem;
+    cache_stats.n_eres++;
+
+    evicted = cache_evict(cache_stats.max_mem);
+    cache_leave();
+    cache_free(evicted);
+    return ere;
 }
 
 /*
- *@@ rxpMatch:
- *      returns the number of characters in the match, starting from
- *      pos characters into the string to be searched. Details of
- *      sub-matches can also be returend. Returns -1 if no match.
+ *@@ rxpCacheLimit:
+ *      sets the memory budget of the cache of rxpCompileCached,
+ *      freeing EREs that are not in use until it fits. Pass 0
+ *      to free all of them. The default is 1 MB.
  *
- *      If EREMF_SHORTEST is passed with eremf, the code looks for
- *      the shortest match, instead of the longest match.
+ *      Returns the previous budget.
  *
- *      If EREMF_ANY is passed with eremf, the code doesn't try to
- *      find the longest (or shortest) match, it will return with the
- *      first match it finds (which could be of any length).
- *      This can speed up matching.
+ *@@added V1.0.24 (2026-10-18) [agent]
  */
 
-int rxpMatch(const ERE * ere,
-             int eremf,
-             const char *str,
-             int pos,
-             ERE_MATCHINFO * mi)
+long rxpCacheLimit(long max_mem)         // in: budget in bytes
 {
-    int len = pos + strlen(str + pos);
-    const char *str_best;
+    long prev;
+    CACHED *evicted;
+
+    cache_enter();
+    prev = cache_stats.max_mem;
+    cache_stats.max_mem = max_mem;
+    evicted = cache_evict(max_mem);
+    cache_leave();
+    cache_free(evicted);
+    return prev;
+}
+
+/*
+ *@@ rxpCacheQuery:
+ *      returns statistics on the cache of rxpCompileCached.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+void rxpCacheQuery(ERE_CACHESTATS *stats)   // out: statistics
+{
+    cache_enter();
+    *stats = cache_stats;
+    cache_leave();
+}
+
+/*...sERE sets:0: */
+/* An ERE set runs several EREs over a string in one pass. The NFAs of
+ * the EREs are copied side by side into one NFA, which has a start pc
+ * for each ERE, and each pc remembers which ERE it came from. A lazy
+ * DFA is run over this, much as in dfa_search, except that there are
+ * no groups: a state is just the set of pcs active at a position, and
+ * the start pcs of all EREs are added at every position. A transition
+ * lists the EREs that reached their finish state before its character.
+ * EREs with backreferences don't have an NFA, and are matched one at a
+ * time by rxpMatch_fwd instead. */
+
+#define DFA_SET         0x20    // State of an ERE set
+
+typedef struct
+{
+    int n_eres;
+    ERE **eres;                 // Each ERE compiled on its own
+    NFA *nfa;                   // The NFAs of eres side by side, or NULL
+    int *ere_of_pc;             // Index into eres of each pc of nfa
+    int n_starts;
+    int *starts;                // Start pc of each ERE in nfa
+    DFA *dfa;                   // Lazy DFA over nfa, created on first use
+    LONG busy;                  // Non-zero while dfa is in use
+}
+ERESET;
+
+/*...smerge_nfas:0: */
+/* Copies the NFAs of the EREs which have one into one NFA, and fills in
+ * ere_of_pc and starts of the set. */
+
+STATIC BOOLEAN merge_nfas(ERESET * set)
+{
+    NFA *nfa;
+    int n_pcs = 0, n_edges = 0, i, pc, edge_no;
+
+    for (i = 0; i < set->n_eres; i++)
+        if (set->eres[i]->nfa != NULL)
+        {
+            n_pcs += set->eres[i]->nfa->n_pcs;
+            n_edges += set->eres[i]->nfa->first_edges[set->eres[i]->nfa->n_pcs];
+            set->n_starts++;
+        }
+    if (set->n_starts == 0)
+        return TRUE;
+
+    if ((nfa = (NFA *) malloc(sizeof(NFA) +
+                              (n_pcs + 1) * sizeof(int) +
+                              n_edges * sizeof(NFAEDGE) +
+                              n_pcs)) == NULL)
+        return FALSE;
+    if ((set->ere_of_pc = (int *)malloc((n_pcs + set->n_starts) * sizeof(int))) == NULL)
+    {
+        free(nfa);
+        return FALSE;
+    }
+    set->starts = set->ere_of_pc + n_pcs;
+    nfa->edges = (NFAEDGE *) (nfa + 1);
+    nfa->first_edges = (int *)(nfa->edges + n_edges);
+    nfa->pc_flags = (unsigned char *)(nfa->first_edges + n_pcs + 1);
+    nfa->n_pcs = n_pcs;
+
+    n_pcs = n_edges = set->n_starts = 0;
+    for (i = 0; i < set->n_eres; i++)
+    {
+        const NFA *from = set->eres[i]->nfa;
+
+        if (from == NULL)
+            continue;
+        set->starts[set->n_starts++] = n_pcs + from->start_pc;
+        for (pc = 0; pc < from->n_pcs; pc++)
+        {
+            nfa->first_edges[n_pcs + pc] = n_edges + from->first_edges[pc];
+            nfa->pc_flags[n_pcs + pc] = from->pc_flags[pc];
+            set->ere_of_pc[n_pcs + pc] = i;
+        }
+        for (edge_no = 0; edge_no < from->first_edges[from->n_pcs]; edge_no++)
+        {
+            nfa->edges[n_edges + edge_no] = from->edges[edge_no];
+            nfa->edges[n_edges + edge_no].to_pc += n_pcs;
+        }
+        n_pcs += from->n_pcs;
+        n_edges += from->first_edges[from->n_pcs];
+    }
+    nfa->first_edges[n_pcs] = n_edges;
+    nfa->start_pc = set->starts[0];
+
+    make_byte_classes(nfa);
+    set->nfa = nfa;
+    return TRUE;
+}
+
+/*...sset_dfa_compute:0: */
+/* Like dfa_compute, for an ERE set. The EREs which matched are stored
+ * in the map of the transition, and accept is their number. */
+
+STATIC DFATRANS *set_dfa_compute(const ERESET * set, DFA * dfa, DFASTATE ** pd, int cls)
+{
+    const NFA *nfa = dfa->nfa;
+    DFASTATE *d = *pd;
+    DFATRANS *t;
+    unsigned char c = nfa->class_byte[cls];
+    int left = d->flags & DFA_CTX;
+    int n_items = 0, n_accept = 0, n_stack = 0;
+    int i, j;
+
+    if (dfa->mem > DFA_MAX_MEM)
+    {
+        memcpy(dfa->items, d->items, d->n_items * sizeof(int));
+        i = d->flags;
+        j = d->n_items;
+        flush_dfa(dfa);
+        if ((d = *pd = dfa_intern(dfa, i, 1, j)) == NULL)
+            return NULL;
+    }
+
+    if (++dfa->gen == 0)
+    {
+        memset(dfa->marks, 0, 2 * (nfa->n_pcs + 1) * sizeof(int));
+        dfa->gen = 1;
+    }
+
+    // Follow the special edges that pass here, from the active pcs
+    // and from a new start of every ERE
+    for (i = 0; i < d->n_items + set->n_starts; i++)
+    {
+        int pc = (i < d->n_items) ? d->items[i] : set->starts[i - d->n_items];
+
+        if (pc != -1 && dfa->marks[pc] != dfa->gen)
+        {
+            dfa->marks[pc] = dfa->gen;
+            dfa->stack[n_stack++] = pc;
+        }
+    }
+    while (n_stack > 0)
+    {
+        int pc = dfa->stack[--n_stack];
+
+        if (nfa->pc_flags[pc] & FLAG_FINISH)
+            dfa->map[n_accept++] = set->ere_of_pc[pc];
+        for (i = nfa->first_edges[pc]; i < nfa->first_edges[pc + 1]; i++)
+        {
+            const NFAEDGE *e = &(nfa->edges[i]);
+
+            if (is_consuming(e->etype))
+            {
+                if (dfa->next_marks[e->to_pc] != dfa->gen &&
+                    nfa_edge_consumes(e, c))
+                {
+                    dfa->next_marks[e->to_pc] = dfa->gen;
+                    dfa->items[n_items++] = e->to_pc;
+                }
+            }
+            else if (dfa->marks[e->to_pc] != dfa->gen &&
+                     nfa_edge_passes(e, left, c))
+            {
+                dfa->marks[e->to_pc] = dfa->gen;
+                dfa->stack[n_stack++] = e->to_pc;
+            }
+        }
+    }
+
+    qsort(dfa->items, n_items, sizeof(int), compare_ints);
+    dfa->items[n_items++] = -1;
+
+    t = &(d->trans[cls]);
+    if (n_accept > 0)
+    {
+        if ((t->map = dfa_alloc_map(dfa, n_accept)) == NULL)
+            return NULL;
+        memcpy(t->map, dfa->map, n_accept * sizeof(int));
+    }
+    t->accept = n_accept;
+    if ((t->next = dfa_intern(dfa,
+                              DFA_SET | ((c == '\0') ? CTX_BOS : isword(c) ? CTX_WORD : CTX_NWORD),
+                              1,
+                              n_items)) == NULL)
+        return NULL;
+    return t;
+}
+
+/*...sset_dfa_search:0: */
+/* Runs the DFA of the set over the string, setting matched[] for every
+ * ERE that matches. Returns the number of EREs newly matched, or -1 if
+ * the DFA can't be used. */
+
+STATIC int set_dfa_search(const ERESET * set,
+                          DFA * dfa,
+                          const char *str,
+                          int pos,
+                          BOOLEAN * matched,
+                          int n_unmatched)
+{
+    DFASTATE *d;
+    int n_matched = 0, flushes = 0;
+    const char *p;
+
+    dfa->items[0] = -1;
+    if ((d = dfa_intern(dfa, DFA_SET | ctx_of(str + pos, str), 1, 1)) == NULL)
+        return -1;
+
+    for (p = str + pos;; p++)
+    {
+        int cls = dfa->nfa->byte_class[(unsigned char)*p];
+        DFATRANS *t = &(d->trans[cls]);
+        int i;
+
+        if (t->next == NULL)
+        {
+            long mem = dfa->mem;
 
-    if ((str_best = match_fsm(ere->fsm, eremf, str, pos, len, ere->s, mi)) == NULL)
-        return -1;
-    return (str_best - str) - pos;
+            if ((t = set_dfa_compute(set, dfa, &d, cls)) == NULL)
+                return -1;
+            if (dfa->mem < mem && ++flushes > DFA_MAX_FLUSHES)
+                return -1;
+        }
+
+        for (i = 0; i < t->accept; i++)
+            if (!matched[t->map[i]])
+            {
+                matched[t->map[i]] = TRUE;
+                if (++n_matched == n_unmatched)
+                    // Nothing left to find
+                    return n_matched;
+            }
+
+        d = t->next;
+        if (*p == '\0')
+            break;
+    }
+    return n_matched;
 }
 
+void rxpFreeSet(ERESET * set);
+
 /*
- *@@ rxpMatch_fwd:
- *      match forwards within a string from a specified start position.
+ *@@ rxpCompileSet:
+ *      compiles several regular expressions for matching them all
+ *      at once with rxpMatchSet.
  *
- *      If a match, return TRUE, and also return pos and len of the match.
- *
- *      If EREMF_SHORTEST is passed with eremf, the code looks for
- *      the shortest match, instead of the longest match.
+ *      erecf is as with rxpCompile. If one of the EREs can't be
+ *      compiled, NULL is returned, with the error in *rc and the
+ *      index of the ERE in *bad_ere (if not NULL).
  *
- *      If EREMF_ANY is passed with eremf, the code doesn't try to
- *      find the longest (or shortest) match, it will return with the
- *      first match it finds (which could be of any length).
- *      This can speed up matching.
+ *@@added V1.0.24 (2026-10-18) [agent]
  */
 
-BOOLEAN rxpMatch_fwd(const ERE *ere,        // in: compiled ERE (from rxpCompile)
-                     int eremf,             // in: EREMF_* flags
-                     const char *str,       // in: string to test
-                     int pos,               // in: start position
-                     int *pos_match,        // out: position of match
-                     int *len_match,        // out: length of match
-                     ERE_MATCHINFO *mi)     // out: match info (for rxpSubsWith)
+ERESET* rxpCompileSet(const char * const *strs,  // in: EREs
+                      int n_strs,                // in: number of EREs
+                      int erecf,                 // in: ERECF_* flags
+                      int *rc,                   // out: error code
+                      int *bad_ere)              // out: ERE that failed (ptr can be NULL)
 {
-    int len = pos + strlen(str + pos);
+    ERESET *set;
     int i;
 
-    for (i = pos; i <= len - ere->shortest_match; i++)
+    *rc = NO_ERROR;
+
+    if ((set = (ERESET *) malloc(sizeof(ERESET) + n_strs * sizeof(ERE *))) == NULL)
     {
-        const char *str_best;
+        *rc = ERROR_NOT_ENOUGH_MEMORY;
+        return NULL;
+    }
+    memset(set, 0, sizeof(ERESET));
+    set->eres = (ERE **) (set + 1);
 
-        if ((str_best = match_fsm(ere->fsm, eremf, str, i, len, ere->s, mi)) != NULL)
+    for (i = 0; i < n_strs; i++)
+    {
+        if ((set->eres[i] = rxpCompile(strs[i], erecf, rc)) == NULL)
         {
-            *pos_match = i;
-            *len_match = (str_best - str) - i;
-            return TRUE;
+            if (bad_ere != NULL)
+                *bad_ere = i;
+            rxpFreeSet(set);
+            return NULL;
         }
+        set->n_eres++;
     }
-    return FALSE;
+
+    if (!merge_nfas(set))
+    {
+        rxpFreeSet(set);
+        *rc = ERROR_NOT_ENOUGH_MEMORY;
+        return NULL;
+    }
+
+    return set;
 }
 
 /*
- *@@ rxpMatch_bwd:
- *      match backwards within a string not passing a
- *      specified end position.
+ *@@ rxpMatchSet:
+ *      matches all EREs of a set (from rxpCompileSet) against the
+ *      string, starting pos characters into it, like rxpMatch_fwd
+ *      would for each of them.
  *
- *      If a match, return TRUE, and also return pos and
- *      len of the match. We need to consider matches from
- *      the beginning of the line. We want the one which
- *      ends up in the rightmost position. Of those which
- *      end up equally far right, we want the one which
- *      extends the furthest (or shortest if EREMF_SHORTEST)
- *      left. See how we get this as a side effect of the
- *      loop ordering and the '>= + delta' test.
+ *      matched must point to an array of as many BOOLEANs as there
+ *      are EREs in the set. For each ERE that matches somewhere,
+ *      the entry with its index is set to TRUE, otherwise to FALSE.
+ *      Returns the number of EREs that matched.
  *
- *      This may not look as efficient as scanning the string
- *      backwards, but note that this would require a reversed
- *      ERE too, and we can't reverse EREs as they may
- *      contain backreferences.
+ *      The EREs without backreferences are run together, in a
+ *      single pass over the string, no matter how many there are.
+ *      The pass ends early once every one of them has matched.
+ *      EREs with backreferences are tried one by one after that.
  *
- *      If EREMF_SHORTEST is passed with eremf, the code looks for
- *      the shortest match, instead of the longest match.
+ *      Like rxpMatch, this may be called by many threads at once
+ *      for the same set.
  *
- *      If EREMF_ANY is passed with eremf, the code doesn't try to
- *      find the longest (or shortest) match, it will return with the
- *      first match it finds (which could be of any length).
- *      This can speed up matching.
+ *@@added V1.0.24 (2026-10-18) [agent]
  */
 
-BOOLEAN rxpMatch_bwd(const ERE *ere,        // in: compiled ERE (from rxpCompile)
-                     int eremf,             // in: EREMF_* flags
-                     const char *str,       // in: string to test
-                     int pos,               // in: start position
-                     int *pos_match,        // out: position of match
-                     int *len_match,        // out: length of match
-                     ERE_MATCHINFO * mi)    // out: match info (for rxpSubsWith)
+int rxpMatchSet(const ERESET *set,         // in: compiled EREs (from rxpCompileSet)
+                const char *str,           // in: string to test
+                int pos,                   // in: start position
+                BOOLEAN *matched)          // out: TRUE for each ERE that matched
 {
-    int i;
-    int delta = (eremf & EREMF_SHORTEST) ? 0 : 1;
-    const char *rightmost = NULL;
-    ERE_MATCHINFO mi2;
+    int i, n_matched = 0;
+    BOOLEAN all = TRUE;         // Try each ERE on its own
 
-    for (i = 0; i <= pos - ere->shortest_match; i++)
+    for (i = 0; i < set->n_eres; i++)
+        matched[i] = FALSE;
+
+    if (set->nfa != NULL)
     {
-        const char *str_best;
+        ERESET *set2 = (ERESET *) set;
+        DFA *dfa;
+        BOOLEAN own = (lockExchange(&(set2->busy), 1) == 0);
+
+        // If another thread is using the DFA, use a temporary one
+        if (!own)
+            dfa = create_dfa(set->nfa);
+        else
+        {
+            if (set->dfa == NULL)
+                set2->dfa = create_dfa(set->nfa);
+            dfa = set->dfa;
+        }
 
-        if ((str_best = match_fsm(ere->fsm, eremf, str, i, pos, ere->s, &mi2)) != NULL)
+        if (dfa != NULL &&
+            (n_matched = set_dfa_search(set, dfa, str, pos, matched, set->n_starts)) != -1)
+            all = FALSE;
+        else
         {
-            if (rightmost == NULL ||
-                str_best >= rightmost + delta)
+            // Forget what we found before the DFA gave up
+            n_matched = 0;
+            for (i = 0; i < set->n_eres; i++)
+                matched[i] = FALSE;
+        }
+
+        if (own)
+            lockExchange(&(set2->busy), 0);
+        else
+            delete_dfa(dfa);
+    }
+
+    for (i = 0; i < set->n_eres; i++)
+        if (all || set->eres[i]->nfa == NULL)
+        {
+            int pos_match, len_match;
+
+            if (rxpMatch_fwd(set->eres[i], EREMF_ANY, str, pos, &pos_match, &len_match, NULL))
             {
-                *pos_match = i;
-                *len_match = (str_best - str) - i;
-                rightmost = str_best;
-                if (mi != NULL)
-                {
-                    mi->n_spans = mi2.n_spans;
-                    for (i = 0; i < mi->n_spans; i++)
-                        mi->spans[i] = mi2.spans[i];
-                }
+                matched[i] = TRUE;
+                n_matched++;
             }
         }
-    }
-    return rightmost != NULL;
+
+    return n_matched;
 }
 
 /*
- *@@ rxpFree:
- *      frees all resources allocated by rxpCompile.
+ *@@ rxpFreeSet:
+ *      frees all resources allocated by rxpCompileSet.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
  */
 
-void rxpFree(ERE * ere)
+void rxpFreeSet(ERESET *set)
 {
-    if (ere)
+    if (set)
     {
-        delete_match(ere->match);
-        delete_fsm(ere->fsm);
-        free(ere);
+        int i;
+
+        delete_dfa(set->dfa);
+        if (set->nfa != NULL)
+            delete_nfa(set->nfa);
+        free(set->ere_of_pc);
+        for (i = 0; i < set->n_eres; i++)
+            rxpFree(set->eres[i]);
+        free(set);
     }
 }
 
-/*
- *@@ rxpSubsWith:
- *      perform a substitution based upon an earlier found match.
- *      This allows for implementing a "find and replace" function.
- */
+/*...sstreaming:0: */
+/* A stream feeds a string to the lazy DFA in chunks, as they are read
+ * from a file, say, and reports every match, much like repeatedly
+ * calling rxpMatch_fwd from the end of the last match would.
+ *
+ * Whether a match is the longest one is only known once the DFA has
+ * read past its end, and the search for the next match must start
+ * over from the end of the match. So the stream keeps the data from
+ * the leftmost position that may still be part of a match in its own
+ * buffer, and discards the rest after every chunk. This is also where
+ * the text of a match, which may span several chunks, is found when
+ * it is reported. Each stream has its own DFA, so that other matches
+ * on the ERE can't flush the state it is in between chunks. */
 
-BOOLEAN rxpSubsWith(const char *str,    // in: original string searched (same as str given to rxpMatch_fwd)
-                    int pos,            // in: span of the entire match (pos_match from rxpMatch_fwd)
-                    int len,            // in: span of the entire match (len_match from rxpMatch_fwd)
-                    ERE_MATCHINFO *mi,  // in: details of match sub-spans (as from rxpMatch_fwd)
-                    const char *with,   // in: replacement string with \1 etc.
-                    char *out,          // out: buffer for string substitutions
-                    int len_out,        // in: sizeof *out
-                    int *rc)            // out: error, if FALSE returned
+typedef struct
 {
-    int i = 0;
-    int j;
+    const ERE *ere;
+    const PREFILTER *pf;        // NULL if not used
+    DFA *dfa;
+    int flags;                  // DFA_SHORTEST or 0
+    DFASTATE *d;                // State before buf[scan]
+    char *buf;                  // Data that may be needed again
+    int len_buf, max_buf;
+    unsigned long ofs_buf;      // Position of buf[0] in the stream
+    int scan;                   // Next byte of buf to feed to the DFA
+    int match_start, match_end; // Match found so far, or -1
+    BOOLEAN finished;           // No more matches can be found
+}
+ERESTREAM;
 
-    memcpy(out, str, pos);
-    i += pos;
-    while (*with != '\0')
-    {
-        const char *rep;
-        int len_rep;
+/*...sstream_restart:0: */
+/* Starts searching for a match at buf[pos]. */
 
-        if (*with != '\\')
-        {
-            rep = with++;
-            len_rep = 1;
-        }
+STATIC BOOLEAN stream_restart(ERESTREAM * st, int pos)
+{
+    int left;
+
+    if (pos == 0 && st->ofs_buf == 0)
+        left = CTX_BOS;
+    else if (st->buf[pos - 1] == '\0')
+        // A null byte ends a string, as far as matching goes
+        left = CTX_BOS;
+    else
+        left = isword((unsigned char)st->buf[pos - 1]) ? CTX_WORD : CTX_NWORD;
+
+    if ((st->d = dfa_start(st->dfa, st->flags | left)) == NULL)
+        return FALSE;
+    st->dfa->starts[0] = pos;
+    st->scan = pos;
+    st->match_start = -1;
+    return TRUE;
+}
+
+/*...sstream_scan:0: */
+/* Feeds the unscanned part of the buffer to the DFA, and the end of
+ * the string too if at_end, reporting all matches found. */
+
+STATIC int stream_scan(ERESTREAM * st,
+                       BOOLEAN at_end,
+                       ERESTREAMFN * fn,
+                       void *user)
+{
+    DFA *dfa = st->dfa;
+    const NFA *nfa = dfa->nfa;
+
+    while (!st->finished)
+    {
+        int p = st->scan;
+        unsigned char c;
+        DFASTATE *d = st->d;
+        DFATRANS *t;
+        int g, *swap;
+
+        if (p < st->len_buf)
+            c = (unsigned char)st->buf[p];
+        else if (at_end)
+            c = '\0';
         else
+            // Need more data
+            break;
+
+        if (st->pf != NULL && p < st->len_buf &&
+            d->n_groups == 1 && d->n_items == 2 && d->items[0] == nfa->start_pc &&
+            (d->flags & DFA_MATCHED) == 0)
+            // Nothing but a new start here, skip to the next candidate
         {
-            ++with;
-            if (*with >= '1' && *with <= '9')
-            {
-                int span = *with - '1';
+            const char *q = prefilter_next(st->pf, st->buf + p, st->buf + st->len_buf);
+            int pos;
 
-                ++with;
-                if (span >= mi->n_spans)
+            if (q != NULL)
+                pos = q - st->buf;
+            else if (at_end)
+            {
+                // Nothing left that could match
+                st->finished = TRUE;
+                break;
+            }
+            else
+            {
+                // The prefix may continue in the next chunk
+                pos = st->len_buf;
+                if (st->pf->len_prefix > 1)
                 {
-                    *rc = EREE_BAD_BACKREF;
-                    return FALSE;
+                    pos -= st->pf->len_prefix - 1;
+                    if (pos < p)
+                        pos = p;
                 }
-                rep = str + mi->spans[span].pos;
-                len_rep = mi->spans[span].len;
             }
-            else if (*with != '\0')
+            if (pos != p)
             {
-                rep = with++;
-                len_rep = 1;
+                if (!stream_restart(st, pos))
+                    return ERROR_NOT_ENOUGH_MEMORY;
+                continue;
             }
-            else
+        }
+
+        t = &(d->trans[nfa->byte_class[c]]);
+        if (t->next == NULL)
+        {
+            if ((t = dfa_compute(dfa, &(st->d), nfa->byte_class[c])) == NULL)
+                return ERROR_NOT_ENOUGH_MEMORY;
+        }
+
+        if (t->accept != -1)
+        {
+            st->match_start = dfa->starts[t->accept];
+            st->match_end = p;
+        }
+
+        st->d = d = t->next;
+        for (g = 0; g < d->n_groups; g++)
+            dfa->next_starts[g] = (t->map[g] == -1) ? (p + 1) : dfa->starts[t->map[g]];
+        swap = dfa->starts;
+        dfa->starts = dfa->next_starts;
+        dfa->next_starts = swap;
+        st->scan = p + 1;
+
+        if (d->n_groups == 0)
+            // The search is over
+        {
+            int next;
+
+            if (st->match_start != -1)
             {
-                *rc = EREE_BAD_BACKSLASH;
-                return FALSE;
+                fn(st->ofs_buf + st->match_start,
+                   st->match_end - st->match_start,
+                   st->buf + st->match_start,
+                   user);
+                // Go on after the match, but don't find the same
+                // empty match again
+                next = st->match_end;
+                if (st->match_end == st->match_start)
+                    next++;
             }
+            else
+                // Got to a null byte (or the end) without a match
+                next = p + 1;
+
+            if (next > st->len_buf)
+                st->finished = TRUE;
+            else if (!stream_restart(st, next))
+                return ERROR_NOT_ENOUGH_MEMORY;
         }
-        if (i + len_rep > len_out)
+    }
+    return NO_ERROR;
+}
+
+void rxpStreamClose(ERESTREAM * st);
+
+/*
+ *@@ rxpStreamOpen:
+ *      prepares for matching an ERE against a stream of data,
+ *      which is passed in chunks to rxpStreamFeed, followed by
+ *      a call to rxpStreamEnd. Free the stream with rxpStreamClose.
+ *
+ *      eremf is as with rxpMatch_fwd. The ERE must stay valid until
+ *      the stream is closed, and must not have backreferences
+ *      (EREE_STREAM_BACKREF is returned in *rc otherwise).
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+ERESTREAM* rxpStreamOpen(const ERE *ere,     // in: compiled ERE (from rxpCompile)
+                         int eremf,          // in: EREMF_* flags
+                         int *rc)            // out: error code
+{
+    ERESTREAM *st;
+
+    if (ere->nfa == NULL)
+    {
+        *rc = EREE_STREAM_BACKREF;
+        return NULL;
+    }
+
+    if ((st = (ERESTREAM *) malloc(sizeof(ERESTREAM))) == NULL)
+    {
+        *rc = ERROR_NOT_ENOUGH_MEMORY;
+        return NULL;
+    }
+    memset(st, 0, sizeof(ERESTREAM));
+    st->ere = ere;
+    st->pf = prefilter_used(&(ere->pf)) ? &(ere->pf) : NULL;
+    st->flags = (eremf & (EREMF_SHORTEST | EREMF_ANY)) ? DFA_SHORTEST : 0;
+
+    if ((st->dfa = create_dfa(ere->nfa)) == NULL ||
+        !stream_restart(st, 0))
+    {
+        rxpStreamClose(st);
+        *rc = ERROR_NOT_ENOUGH_MEMORY;
+        return NULL;
+    }
+
+    *rc = NO_ERROR;
+    return st;
+}
+
+/*
+ *@@ rxpStreamFeed:
+ *      passes the next len bytes of the stream. For every match
+ *      that is complete, fn is called with the position of the
+ *      match in the stream, its length and its text (which is not
+ *      null-terminated, and only valid during the call). Matches
+ *      are reported in order, and do not overlap.
+ *
+ *      The whole stream is matched as one string, so a match may
+ *      span any number of chunks, "^" only matches at the start of
+ *      the stream, and "$" only at its end. A null byte in the data
+ *      ends one string and starts another, as far as matching is
+ *      concerned: nothing matches across it.
+ *
+ *      The stream only keeps as much of the data as may still be
+ *      part of a match, which is usually little.
+ *
+ *      Returns NO_ERROR or ERROR_NOT_ENOUGH_MEMORY.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+int rxpStreamFeed(ERESTREAM *st,        // in: stream (from rxpStreamOpen)
+                  const char *data,     // in: next chunk of data
+                  int len,              // in: length of data
+                  ERESTREAMFN *fn,      // in: called for each match
+                  void *user)           // in: passed to fn
+{
+    int keep, shift, g;
+
+    if (st->len_buf + len > st->max_buf)
+    {
+        int max_buf = st->max_buf * 2;
+        char *buf;
+
+        if (max_buf < st->len_buf + len)
+            max_buf = st->len_buf + len;
+        if ((buf = (char *)realloc(st->buf, max_buf)) == NULL)
+            return ERROR_NOT_ENOUGH_MEMORY;
+        st->buf = buf;
+        st->max_buf = max_buf;
+    }
+    if (len > 0)
+    {
+        memcpy(st->buf + st->len_buf, data, len);
+        st->len_buf += len;
+    }
+
+    if ((g = stream_scan(st, FALSE, fn, user)) != NO_ERROR)
+        return g;
+
+    // Drop what can't be needed again, except for one byte before
+    // that, which decides whether "^", "\<" etc. match
+    keep = st->scan;
+    if (st->d->n_groups > 0 && st->dfa->starts[0] < keep)
+        keep = st->dfa->starts[0];
+    if (st->match_start != -1 && st->match_start < keep)
+        keep = st->match_start;
+    if ((shift = keep - 1) > 0)
+    {
+        memmove(st->buf, st->buf + shift, st->len_buf - shift);
+        st->len_buf -= shift;
+        st->ofs_buf += shift;
+        st->scan -= shift;
+        if (st->match_start != -1)
         {
-            *rc = EREE_SUBS_LEN;
-            return FALSE;
+            st->match_start -= shift;
+            st->match_end -= shift;
         }
-        memcpy(out + i, rep, len_rep);
-        i += len_rep;
+        for (g = 0; g < st->d->n_groups; g++)
+            st->dfa->starts[g] -= shift;
     }
-    j = pos + len + strlen(str + pos + len);
-    if (i + j > len_out)
+    return NO_ERROR;
+}
+
+/*
+ *@@ rxpStreamEnd:
+ *      tells the stream that there is no more data, and reports the
+ *      remaining matches, as with rxpStreamFeed.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+int rxpStreamEnd(ERESTREAM *st,         // in: stream (from rxpStreamOpen)
+                 ERESTREAMFN *fn,       // in: called for each match
+                 void *user)            // in: passed to fn
+{
+    return stream_scan(st, TRUE, fn, user);
+}
+
+/*
+ *@@ rxpStreamClose:
+ *      frees all resources allocated by rxpStreamOpen.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+void rxpStreamClose(ERESTREAM *st)
+{
+    if (st)
     {
-        *rc = EREE_SUBS_LEN;
-        return FALSE;
+        delete_dfa(st->dfa);
+        free(st->buf);
+        free(st);
     }
-    memcpy(out + i, str + pos + len, j);
-    i += j;
-    out[i] = '\0';
-    return TRUE;
 }
 
 #ifdef __TESTCASE__
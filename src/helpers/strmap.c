@@ -0,0 +1,482 @@
+
+/*
+ *@@sourcefile strmap.c:
+ *      contains helper functions for maintaining hash maps
+ *      which are keyed by strings.
+ *
+ *      Usage: All C programs; not OS/2-specific.
+ *
+ *      Function prefixes:
+ *      --  smap*   string map functions
+ *
+ *      <B>Introduction</B>
+ *
+ *      Many parts of the helpers look up items by name in a
+ *      tree.c tree with a strcmp-based comparison function.
+ *      Each such lookup costs about lg n string comparisons,
+ *      each of which touches a different heap node. If all you
+ *      ever do is look up exact names, a hash map is much
+ *      faster: a lookup hashes the key once and then usually
+ *      needs a single string comparison.
+ *
+ *      The STRMAP here uses open addressing with "Robin Hood"
+ *      linear probing. All slots are stored in one array, which
+ *      stores the full hash and length of every key next to the
+ *      key pointer, so most mismatches are rejected without
+ *      touching the key string at all. When inserting, an item
+ *      that is further away from its home slot than the item
+ *      currently in a slot takes that slot over. This keeps the
+ *      probe sequences short even at high load, and a lookup
+ *      can stop as soon as it finds an item that is closer to
+ *      its home slot than the key would be.
+ *
+ *      Differences compared to tree.c:
+ *
+ *      -- A STRMAP is not sorted. smapEnum returns the items in
+ *         table order.
+ *
+ *      -- Keys are compared case-sensitively and byte by byte,
+ *         like strcmp.
+ *
+ *      -- The map does not copy the key strings. As with string
+ *         trees, the key must stay valid as long as the item is
+ *         in the map, which is easiest if the key is part of the
+ *         item's own data.
+ *
+ *      If you look up the same key in several maps, or you know
+ *      its length already, compute the hash once with smapHash
+ *      and use the *Hash variants of the functions.
+ *
+ *      <B>Example</B>
+ *
+ +          STRMAP  Map;
+ +          smapInit(&Map);
+ +          smapInsert(&Map, pItem->szName, pItem);
+ +          ...
+ +          pItem = (PMYITEM)smapFind(&Map, "name");
+ +          ...
+ +          smapClear(&Map);
+ *
+ *      Note: Version numbering in this file relates to XWorkplace version
+ *            numbering.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ *@@header "helpers\strmap.h"
+ */
+
+/*
+ *      Copyright (C) 2026 the XWorkplace helpers authors.
+ *      This file is part of the "XWorkplace helpers" source package.
+ *      This is free software; you can redistribute it and/or modify
+ *      it under the terms of the GNU General Public License as published
+ *      by the Free Software Foundation, in version 2 as it comes in the
+ *      "COPYING" file of the XWorkplace main distribution.
+ *      This program is distributed in the hope that it will be useful,
+ *      but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *      MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *      GNU General Public License for more details.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "setup.h"                      // code generation and debugging options
+
+#include "helpers\strmap.h"
+
+#pragma hdrstop
+
+/*
+ *@@category: Helpers\C helpers\String hash maps
+ *      See strmap.c.
+ */
+
+/* ******************************************************************
+ *
+ *   Private declarations
+ *
+ ********************************************************************/
+
+#define MIN_SLOTS       16
+
+// distance of the slot at ul from the home slot of ulHash
+#define PROBEDIST(ulHash, ul, ulMask) (((ul) - ((ulHash) & (ulMask))) & (ulMask))
+
+/*
+ *@@ FindSlot:
+ *      returns the index of the slot with the given key
+ *      or -1 if there's none.
+ */
+
+STATIC long FindSlot(const STRMAP *pMap,
+                     const char *pcszKey,
+                     ULONG ulLength,
+                     ULONG ulHash)
+{
+    ULONG   ulMask,
+            ul,
+            ulDist = 0;
+
+    if (!pMap->cItems)
+        return -1;
+
+    ulMask = pMap->cSlots - 1;
+    ul = ulHash & ulMask;
+
+    while (TRUE)
+    {
+        PSTRMAPSLOT pSlot = &pMap->paSlots[ul];
+
+        if (    (!pSlot->ulHash)
+                // Robin Hood: if the key were in the map, it would
+                // have taken over this slot
+             || (PROBEDIST(pSlot->ulHash, ul, ulMask) < ulDist)
+           )
+            return -1;
+
+        if (    (pSlot->ulHash == ulHash)
+             && (pSlot->ulLength == ulLength)
+             && (!memcmp(pSlot->pcszKey, pcszKey, ulLength))
+           )
+            return (long)ul;
+
+        ul = (ul + 1) & ulMask;
+        ulDist++;
+    }
+}
+
+/*
+ *@@ PutSlot:
+ *      stores a slot in the table without checking
+ *      for duplicates or the load factor.
+ */
+
+STATIC void PutSlot(PSTRMAP pMap,
+                    STRMAPSLOT Slot)
+{
+    ULONG   ulMask = pMap->cSlots - 1,
+            ul = Slot.ulHash & ulMask,
+            ulDist = 0;
+
+    while (TRUE)
+    {
+        PSTRMAPSLOT pSlot = &pMap->paSlots[ul];
+        ULONG       ulDistThis;
+
+        if (!pSlot->ulHash)
+        {
+            *pSlot = Slot;
+            break;
+        }
+
+        if ((ulDistThis = PROBEDIST(pSlot->ulHash, ul, ulMask)) < ulDist)
+        {
+            // the new item is poorer than this one: swap
+            STRMAPSLOT Temp = *pSlot;
+            *pSlot = Slot;
+            Slot = Temp;
+            ulDist = ulDistThis;
+        }
+
+        ul = (ul + 1) & ulMask;
+        ulDist++;
+    }
+
+    pMap->cItems++;
+}
+
+/*
+ *@@ Resize:
+ *      reallocates the table with cSlots slots (which
+ *      must be a power of 2) and rehashes all items.
+ */
+
+STATIC BOOL Resize(PSTRMAP pMap,
+                   ULONG cSlots)
+{
+    PSTRMAPSLOT paOld = pMap->paSlots,
+                paNew;
+    ULONG       cOld = pMap->cSlots,
+                ul;
+
+    if (!(paNew = (PSTRMAPSLOT)malloc(cSlots * sizeof(STRMAPSLOT))))
+        return FALSE;
+
+    memset(paNew, 0, cSlots * sizeof(STRMAPSLOT));
+    pMap->paSlots = paNew;
+    pMap->cSlots = cSlots;
+    pMap->cItems = 0;
+
+    for (ul = 0; ul < cOld; ul++)
+        if (paOld[ul].ulHash)
+            PutSlot(pMap, paOld[ul]);
+
+    if (paOld)
+        free(paOld);
+
+    return TRUE;
+}
+
+/* ******************************************************************
+ *
+ *   String map functions
+ *
+ ********************************************************************/
+
+/*
+ *@@ smapHash:
+ *      computes the hash of the given string for the
+ *      *Hash functions. If ulLength is 0, strlen is
+ *      run on pcsz.
+ *
+ *      This is FNV-1a with a final bit mix so that the
+ *      low bits, which select the home slot, depend on
+ *      all characters. Never returns 0.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+ULONG smapHash(const char *pcsz,
+               ULONG ulLength)
+{
+    const unsigned char *p = (const unsigned char*)pcsz,
+                        *pEnd;
+    ULONG               ulHash = 2166136261UL;
+
+    if (!ulLength)
+        ulLength = strlen(pcsz);
+
+    for (pEnd = p + ulLength; p < pEnd; p++)
+        ulHash = ((ulHash ^ *p) * 16777619UL) & 0xFFFFFFFFUL;
+
+    ulHash ^= ulHash >> 16;
+    ulHash = (ulHash * 0x7FEB352DUL) & 0xFFFFFFFFUL;
+    ulHash ^= ulHash >> 15;
+
+    return (ulHash) ? ulHash : 1;
+}
+
+/*
+ *@@ smapInit:
+ *      initializes a string map. This does not
+ *      allocate memory yet.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+void smapInit(PSTRMAP pMap)
+{
+    memset(pMap, 0, sizeof(STRMAP));
+}
+
+/*
+ *@@ smapClear:
+ *      removes all items from the map and frees the
+ *      table. Neither the keys nor the data are freed;
+ *      use smapEnum first if you need to.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+void smapClear(PSTRMAP pMap)
+{
+    if (pMap->paSlots)
+        free(pMap->paSlots);
+
+    memset(pMap, 0, sizeof(STRMAP));
+}
+
+/*
+ *@@ smapInsertHash:
+ *      adds an item with the given key and pvData to
+ *      the map. ulLength must be the key length and
+ *      ulHash must be smapHash(pcszKey, ulLength).
+ *
+ *      The key is not copied. It needs not be null-
+ *      terminated, but only ulLength bytes are ever
+ *      looked at.
+ *
+ *      Returns:
+ *
+ *      --  SMAP_OK
+ *
+ *      --  SMAP_DUPLICATE_KEY: the key is already in the map.
+ *
+ *      --  SMAP_NO_MEMORY
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+int smapInsertHash(PSTRMAP pMap,
+                   const char *pcszKey,      // in: key (not copied)
+                   ULONG ulLength,           // in: key length
+                   ULONG ulHash,             // in: smapHash(pcszKey, ulLength)
+                   void *pvData)             // in: data
+{
+    STRMAPSLOT  Slot;
+
+    if (FindSlot(pMap, pcszKey, ulLength, ulHash) >= 0)
+        return SMAP_DUPLICATE_KEY;
+
+    // keep the load factor below 80%
+    if ((pMap->cItems + 1) * 5 > pMap->cSlots * 4)
+        if (!Resize(pMap,
+                    (pMap->cSlots) ? pMap->cSlots * 2 : MIN_SLOTS))
+            return SMAP_NO_MEMORY;
+
+    Slot.ulHash = ulHash;
+    Slot.ulLength = ulLength;
+    Slot.pcszKey = pcszKey;
+    Slot.pvData = pvData;
+    PutSlot(pMap, Slot);
+
+    return SMAP_OK;
+}
+
+/*
+ *@@ smapInsert:
+ *      like smapInsertHash, but computes the length and
+ *      hash of the null-terminated pcszKey.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+int smapInsert(PSTRMAP pMap,
+               const char *pcszKey,
+               void *pvData)
+{
+    ULONG ulLength = strlen(pcszKey);
+
+    return smapInsertHash(pMap,
+                          pcszKey,
+                          ulLength,
+                          smapHash(pcszKey, ulLength),
+                          pvData);
+}
+
+/*
+ *@@ smapFindHash:
+ *      returns the data of the item with the given key
+ *      or NULL if it is not in the map. ulLength and
+ *      ulHash are as with smapInsertHash.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+void* smapFindHash(const STRMAP *pMap,
+                   const char *pcszKey,
+                   ULONG ulLength,
+                   ULONG ulHash)
+{
+    long l;
+
+    if ((l = FindSlot(pMap, pcszKey, ulLength, ulHash)) < 0)
+        return NULL;
+
+    return pMap->paSlots[l].pvData;
+}
+
+/*
+ *@@ smapFind:
+ *      like smapFindHash, but computes the length and
+ *      hash of the null-terminated pcszKey.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+void* smapFind(const STRMAP *pMap,
+               const char *pcszKey)
+{
+    ULONG ulLength;
+
+    if (!pMap->cItems)
+        return NULL;
+
+    ulLength = strlen(pcszKey);
+    return smapFindHash(pMap,
+                        pcszKey,
+                        ulLength,
+                        smapHash(pcszKey, ulLength));
+}
+
+/*
+ *@@ smapRemove:
+ *      removes the item with the given key from the
+ *      map. If ppvData is not NULL, it receives the
+ *      item's data.
+ *
+ *      Returns SMAP_OK or SMAP_NOT_FOUND.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+int smapRemove(PSTRMAP pMap,
+               const char *pcszKey,
+               void **ppvData)          // out: data of removed item (ptr can be NULL)
+{
+    ULONG   ulLength = strlen(pcszKey),
+            ulMask,
+            ul,
+            ulNext;
+    long    l;
+
+    if ((l = FindSlot(pMap,
+                      pcszKey,
+                      ulLength,
+                      smapHash(pcszKey, ulLength))) < 0)
+        return SMAP_NOT_FOUND;
+
+    if (ppvData)
+        *ppvData = pMap->paSlots[l].pvData;
+
+    // shift the following items of the same probe
+    // sequence back by one, so no tombstones are needed
+    ulMask = pMap->cSlots - 1;
+    ul = (ULONG)l;
+    ulNext = (ul + 1) & ulMask;
+    while (    (pMap->paSlots[ulNext].ulHash)
+            && (PROBEDIST(pMap->paSlots[ulNext].ulHash, ulNext, ulMask))
+          )
+    {
+        pMap->paSlots[ul] = pMap->paSlots[ulNext];
+        ul = ulNext;
+        ulNext = (ul + 1) & ulMask;
+    }
+
+    pMap->paSlots[ul].ulHash = 0;
+    pMap->cItems--;
+
+    return SMAP_OK;
+}
+
+/*
+ *@@ smapEnum:
+ *      enumerates all items in the map in table order.
+ *      Set *pulIndex to 0 before the first call. Returns
+ *      the next used slot or NULL if there are no more.
+ *
+ +          ULONG       ul = 0;
+ +          PSTRMAPSLOT pSlot;
+ +          while (pSlot = smapEnum(&Map, &ul))
+ +          {
+ +              ... pSlot->pcszKey, pSlot->pvData
+ +          }
+ *
+ *      The map must not be modified during the enumeration.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+PSTRMAPSLOT smapEnum(const STRMAP *pMap,
+                     PULONG pulIndex)       // in/out: enumeration index
+{
+    while (*pulIndex < pMap->cSlots)
+    {
+        PSTRMAPSLOT pSlot = &pMap->paSlots[(*pulIndex)++];
+        if (pSlot->ulHash)
+            return pSlot;
+    }
+
+    return NULL;
+}
+
@@ -232,6 +232,18 @@
  *      You can then use treeFind to very quickly find a node
  *      with a specified ulKey member.
  *
+ *      <B>Order statistics</B>
+ *
+ *      If __TREE_ORDER_STATISTICS__ is defined when compiling
+ *      tree.c and all code using trees, every TREE node also
+ *      keeps the number of nodes in its subtree (TREE.ulSize).
+ *      This costs one ULONG per node plus a few additions per
+ *      rotation, but then treeSelect finds the n-th node,
+ *      treeRank returns the index of a key and treeCountRange
+ *      counts the keys between two bounds, all in O(lg n)
+ *      without having to build an array with treeBuildArray
+ *      first.
+ *
  *      This file was new with V0.9.5 (2000-09-29) [umoeller].
  *      With V0.9.13, all the code has been replaced with the public
  *      domain code found at http://epaperpress.com/sortsearch/index.html
@@ -269,6 +281,11 @@
 
 #define LEAF &sentinel           // all leafs are sentinels
 STATIC TREE sentinel = { LEAF, LEAF, 0, BLACK};
+                // with __TREE_ORDER_STATISTICS__, ulSize is 0 here
+
+#ifdef __TREE_ORDER_STATISTICS__
+    #define UPDATESIZE(x) (x)->ulSize = (x)->left->ulSize + (x)->right->ulSize + 1
+#endif
 
 /*
 A binary search tree is a red-black tree if:
@@ -388,6 +405,15 @@ STATIC void rotateLeft(TREE **root,
     y->left = x;
     if (x != LEAF)
         x->parent = y;
+
+#ifdef __TREE_ORDER_STATISTICS__
+    // y takes over x's subtree, x lost y's right subtree
+    if (y != LEAF)
+    {
+        y->ulSize = x->ulSize;
+        UPDATESIZE(x);
+    }
+#endif
 }
 
 /*
@@ -425,6 +451,15 @@ STATIC void rotateRight(TREE **root,
     y->right = x;
     if (x != LEAF)
         x->parent = y;
+
+#ifdef __TREE_ORDER_STATISTICS__
+    // y takes over x's subtree, x lost y's left subtree
+    if (y != LEAF)
+    {
+        y->ulSize = x->ulSize;
+        UPDATESIZE(x);
+    }
+#endif
 }
 
 /*
@@ -523,6 +558,7 @@ STATIC void insertFixup(TREE **root,
  *      same ulKey already exists.
  *
  *@@changed V0.9.16 (2001-10-19) [umoeller]: added plCount
+ *@@changed V1.0.24 (2026-10-18) [agent]: added __TREE_ORDER_STATISTICS__ support
  */
 
 int treeInsert(TREE **root,                     // in: root of the tree
@@ -568,6 +604,16 @@ int treeInsert(TREE **root,                     // in: root of the tree
     else
         *root = x;
 
+#ifdef __TREE_ORDER_STATISTICS__
+    // all ancestors have one more node now
+    x->ulSize = 1;
+    while (parent)
+    {
+        parent->ulSize++;
+        parent = parent->parent;
+    }
+#endif
+
     insertFixup(root,
                 x);
 
@@ -579,11 +625,19 @@ int treeInsert(TREE **root,                     // in: root of the tree
 
 /*
  *@@ deleteFixup:
+ *      private function during rebalancing.
  *
+ *      Since "tree" can be LEAF, its parent is passed
+ *      in separately. We never write to the shared
+ *      sentinel's parent field, which is not safe if
+ *      several threads work on different trees.
+ *
+ *@@changed V1.0.24 (2026-10-18) [agent]: added parent param, fixed corruption if tree is LEAF
  */
 
 STATIC void deleteFixup(TREE **root,
-                        TREE *tree)
+                        TREE *tree,
+                        TREE *parent)
 {
     TREE    *s;
 
@@ -591,22 +645,23 @@ STATIC void deleteFixup(TREE **root,
             && tree->color == BLACK
           )
     {
-        if (tree == tree->parent->left)
+        if (tree == parent->left)
         {
-            s = tree->parent->right;
+            s = parent->right;
             if (s->color == RED)
             {
                 s->color = BLACK;
-                tree->parent->color = RED;
-                rotateLeft(root, tree->parent);
-                s = tree->parent->right;
+                parent->color = RED;
+                rotateLeft(root, parent);
+                s = parent->right;
             }
             if (    (s->left->color == BLACK)
                  && (s->right->color == BLACK)
                )
             {
                 s->color = RED;
-                tree = tree->parent;
+                tree = parent;
+                parent = tree->parent;
             }
             else
             {
@@ -615,31 +670,32 @@ STATIC void deleteFixup(TREE **root,
                     s->left->color = BLACK;
                     s->color = RED;
                     rotateRight(root, s);
-                    s = tree->parent->right;
+                    s = parent->right;
                 }
-                s->color = tree->parent->color;
-                tree->parent->color = BLACK;
+                s->color = parent->color;
+                parent->color = BLACK;
                 s->right->color = BLACK;
-                rotateLeft(root, tree->parent);
+                rotateLeft(root, parent);
                 tree = *root;
             }
         }
         else
         {
-            s = tree->parent->left;
+            s = parent->left;
             if (s->color == RED)
             {
                 s->color = BLACK;
-                tree->parent->color = RED;
-                rotateRight(root, tree->parent);
-                s = tree->parent->left;
+                parent->color = RED;
+                rotateRight(root, parent);
+                s = parent->left;
             }
             if (    (s->right->color == BLACK)
                  && (s->left->color == BLACK)
                )
             {
                 s->color = RED;
-                tree = tree->parent;
+                tree = parent;
+                parent = tree->parent;
             }
             else
             {
@@ -648,18 +704,19 @@ STATIC void deleteFixup(TREE **root,
                     s->right->color = BLACK;
                     s->color = RED;
                     rotateLeft(root, s);
-                    s = tree->parent->left;
+                    s = parent->left;
                 }
-                s->color = tree->parent->color;
-                tree->parent->color = BLACK;
+                s->color = parent->color;
+                parent->color = BLACK;
                 s->left->color = BLACK;
-                rotateRight (root, tree->parent);
+                rotateRight (root, parent);
                 tree = *root;
             }
         }
     }
 
-    tree->color = BLACK;
+    if (tree != LEAF)
+        tree->color = BLACK;
 }
 
 /*
@@ -674,6 +731,8 @@ STATIC void deleteFixup(TREE **root,
  *      STATUS_INVALID_NODE if not.
  *
  *@@changed V0.9.16 (2001-10-19) [umoeller]: added plCount
+ *@@changed V1.0.24 (2026-10-18) [agent]: added __TREE_ORDER_STATISTICS__ support
+ *@@changed V1.0.24 (2026-10-18) [agent]: fixed rebalancing when removing a black node without children
  */
 
 int treeDelete(TREE **root,         // in: root of the tree
@@ -681,7 +740,8 @@ int treeDelete(TREE **root,         // in: root of the tree
                TREE *tree)          // in: tree node to delete
 {
     TREE        *y,
-                *d;
+                *d,
+                *yParent;
     nodeColor   color;
 
     if (    (!tree)
@@ -708,9 +768,11 @@ int treeDelete(TREE **root,         // in: root of the tree
     else
         y = d->right;
 
-    // remove d from the parent chain
+    // remove d from the parent chain; remember y's new
+    // parent separately since y can be LEAF
+    yParent = d->parent;
     if (y != LEAF)
-        y->parent = d->parent;
+        y->parent = yParent;
 
     if (d->parent)
     {
@@ -722,6 +784,19 @@ int treeDelete(TREE **root,         // in: root of the tree
     else
         *root = y;
 
+#ifdef __TREE_ORDER_STATISTICS__
+    {
+        // all of d's former ancestors have one node less now
+        // (this includes tree if d is its successor)
+        TREE *p = d->parent;
+        while (p)
+        {
+            p->ulSize--;
+            p = p->parent;
+        }
+    }
+#endif
+
     color = d->color;
 
     if (d != tree)
@@ -732,6 +807,9 @@ int treeDelete(TREE **root,         // in: root of the tree
         d->right  = tree->right;
         d->parent = tree->parent;
         d->color  = tree->color;
+#ifdef __TREE_ORDER_STATISTICS__
+        d->ulSize = tree->ulSize;
+#endif
 
         if (d->parent)
         {
@@ -748,13 +826,18 @@ int treeDelete(TREE **root,         // in: root of the tree
 
         if (d->right != LEAF)
             d->right->parent = d;
+
+        // if d was tree's direct child, y now hangs off d
+        if (yParent == tree)
+            yParent = d;
     }
 
-    if (    (y != LEAF)
-         && (color == BLACK)
-       )
+    // removing a black node breaks the black height, even
+    // if it had no children (y == LEAF) V1.0.24 (2026-10-18) [agent]
+    if (color == BLACK)
         deleteFixup(root,
-                    y);
+                    y,
+                    yParent);
 
     if (plCount)
         (*plCount)--;       // V0.9.16 (2001-10-19) [umoeller]
@@ -1001,6 +1084,248 @@ TREE** treeBuildArray(TREE* pRoot,
     return papNodes;
 }
 
+/*
+ *@@ buildSubtree:
+ *      private helper for treeBuildFromSorted. Links
+ *      apNodes[lLo..lHi] into a balanced subtree below
+ *      pParent and returns its root (or LEAF if the
+ *      range is empty).
+ *
+ *      Nodes at depth ulRedDepth are colored RED, all
+ *      others BLACK. Since splitting at the middle puts
+ *      all leafs on the last two levels, this keeps the
+ *      black height identical on every path.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+STATIC TREE* buildSubtree(TREE **apNodes,
+                          long lLo,
+                          long lHi,
+                          TREE *pParent,
+                          ULONG ulDepth,
+                          ULONG ulRedDepth)
+{
+    TREE    *p;
+    long    lMid;
+
+    if (lLo > lHi)
+        return LEAF;
+
+    lMid = lLo + (lHi - lLo) / 2;
+    p = apNodes[lMid];
+
+    p->parent = pParent;
+    p->color = (ulDepth && ulDepth == ulRedDepth) ? RED : BLACK;
+#ifdef __TREE_ORDER_STATISTICS__
+    p->ulSize = lHi - lLo + 1;
+#endif
+    p->left = buildSubtree(apNodes,
+                           lLo,
+                           lMid - 1,
+                           p,
+                           ulDepth + 1,
+                           ulRedDepth);
+    p->right = buildSubtree(apNodes,
+                            lMid + 1,
+                            lHi,
+                            p,
+                            ulDepth + 1,
+                            ulRedDepth);
+
+    return p;
+}
+
+/*
+ *@@ treeBuildFromSorted:
+ *      builds a complete red-black tree from an array
+ *      of TREE* pointers which must already be sorted
+ *      in ascending key order without duplicates.
+ *
+ *      This is the reverse of treeBuildArray. As opposed
+ *      to calling treeInsert for every node, this does
+ *      not compare any keys and needs no rebalancing,
+ *      so it runs in O(n) instead of O(n lg n). The
+ *      resulting tree has minimal height.
+ *
+ *      Any previous contents of *root are discarded
+ *      (but not freed). The left, right, parent and
+ *      color members of all nodes are overwritten;
+ *      only ulKey must be set up by the caller. The
+ *      tree item count is c afterwards.
+ *
+ *      Since there is no comparison function, it is
+ *      the caller's responsibility to make sure the
+ *      array is sorted according to the comparison
+ *      function that will later be used with treeFind
+ *      and treeInsert on the new tree.
+ *
+ *      Example for rebuilding a tree after the keys
+ *      have been changed in a way that keeps their
+ *      order intact:
+ *
+ +          LONG    cItems = G_cTreeItems;
+ +          TREE**  papNodes = treeBuildArray(G_TreeRoot,
+ +                                            &cItems);
+ +          if (papNodes)
+ +          {
+ +              ... // modify keys
+ +              treeBuildFromSorted(&G_TreeRoot,
+ +                                  papNodes,
+ +                                  cItems);
+ +              free(papNodes);
+ +          }
+ *
+ *      Returns STATUS_OK.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+int treeBuildFromSorted(TREE **root,        // out: root of the new tree
+                        TREE **apNodes,     // in: sorted array of nodes
+                        ULONG c)            // in: array item count
+{
+    ULONG   ulRedDepth = 0;
+
+    // the last level is at depth floor(lg c); its nodes
+    // become red so that all paths have the same number
+    // of black nodes, even if that level is incomplete
+    while ((c >> (ulRedDepth + 1)) != 0)
+        ulRedDepth++;
+
+    *root = buildSubtree(apNodes,
+                         0,
+                         (long)c - 1,
+                         NULL,
+                         0,
+                         ulRedDepth);
+
+    return STATUS_OK;
+}
+
+#ifdef __TREE_ORDER_STATISTICS__
+
+/*
+ *@@ treeSelect:
+ *      returns the node at the zero-based index ulIndex
+ *      in sorted order, or NULL if ulIndex is out of range.
+ *
+ *      treeSelect(root, 0) is the same as treeFirst(root).
+ *      This runs in O(lg n).
+ *
+ *      Only available if __TREE_ORDER_STATISTICS__ is
+ *      defined.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+TREE* treeSelect(TREE *root,        // in: root of the tree
+                 ULONG ulIndex)     // in: zero-based index of node to find
+{
+    TREE *current = root;
+    while (current != LEAF)
+    {
+        ULONG ulLeft = current->left->ulSize;
+
+        if (ulIndex < ulLeft)
+            current = current->left;
+        else if (ulIndex == ulLeft)
+            return current;
+        else
+        {
+            ulIndex -= ulLeft + 1;
+            current = current->right;
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ *@@ CountBelow:
+ *      returns the number of nodes whose keys are
+ *      less than key (or less than or equal to key
+ *      if fInclusive is TRUE).
+ */
+
+STATIC ULONG CountBelow(TREE *root,
+                        ULONG key,
+                        BOOL fInclusive,
+                        FNTREE_COMPARE *pfnCompare)
+{
+    ULONG   ulCount = 0;
+    TREE    *current = root;
+
+    while (current != LEAF)
+    {
+        int iResult = pfnCompare(key, current->ulKey);
+        if (    (iResult > 0)
+             || (!iResult && fInclusive)
+           )
+        {
+            // current and its whole left subtree are below key
+            ulCount += current->left->ulSize + 1;
+            current = current->right;
+        }
+        else
+            current = current->left;
+    }
+
+    return ulCount;
+}
+
+/*
+ *@@ treeRank:
+ *      returns the number of nodes in the tree whose
+ *      keys are less than the specified key. If a node
+ *      with that key exists, this is its zero-based
+ *      index, so that treeSelect(root, treeRank(root, key, ...))
+ *      returns that node.
+ *
+ *      This runs in O(lg n).
+ *
+ *      Only available if __TREE_ORDER_STATISTICS__ is
+ *      defined.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+ULONG treeRank(TREE *root,                    // in: root of the tree
+               ULONG key,                     // in: key to find
+               FNTREE_COMPARE *pfnCompare)    // in: comparison func
+{
+    return CountBelow(root, key, FALSE, pfnCompare);
+}
+
+/*
+ *@@ treeCountRange:
+ *      returns the number of nodes in the tree whose
+ *      keys are in the range keyLo to keyHi (both
+ *      inclusive). Returns 0 if keyLo is greater than
+ *      keyHi.
+ *
+ *      This runs in O(lg n).
+ *
+ *      Only available if __TREE_ORDER_STATISTICS__ is
+ *      defined.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+ULONG treeCountRange(TREE *root,                    // in: root of the tree
+                     ULONG keyLo,                   // in: lower bound
+                     ULONG keyHi,                   // in: upper bound
+                     FNTREE_COMPARE *pfnCompare)    // in: comparison func
+{
+    if (pfnCompare(keyLo, keyHi) > 0)
+        return 0;
+
+    return (  CountBelow(root, keyHi, TRUE, pfnCompare)
+            - CountBelow(root, keyLo, FALSE, pfnCompare));
+}
+
+#endif // __TREE_ORDER_STATISTICS__
+
 /* void main(int argc, char **argv) {
     int maxnum, ct;
     recType rec;
@@ -24,6 +24,11 @@
  *          2)  Create a DOM tree in memory and write an XML
  *              document from that. See xmlCreateDocument.
  *
+ *          For documents too large for a tree, there is a
+ *          streaming (SAX-like) variant of 1) as well, which
+ *          calls you back for every element instead but can
+ *          still validate. See xmlCreateSAX.
+ *
  *      <B>XML</B>
  *
  *      In order to understand XML myself, I have written a couple of
@@ -76,6 +81,10 @@
  *      However, we do implement node management as in the standard.
  *      See xmlCreateDomNode and xmlDeleteNode.
  *
+ *      Instead of getElementsByTagName and friends, nodes can be
+ *      found with a subset of XPath; see xmlCompilePath and
+ *      xmlSelectNodes.
+ *
  *      The main entry point into this is xmlCreateDOM. See remarks
  *      there for how this will be typically used.
  *
@@ -90,17 +99,25 @@
  *      -- If you pass DF_PARSEDTD to xmlCreateDOM, the DTD will be
  *         parsed and the document will be validated against it.
  *         Validation is working as far as elements and attributes
- *         are checked for proper nesting. However, we cannot fully
- *         check for proper ordering etc. in (children) mode of
- *         @element_declarations. This will only check for whether
- *         elements may appear in another element at all -- not for
- *         the correct order.
+ *         are checked for proper nesting. In (children) mode of
+ *         @element_declarations, the order and number of the child
+ *         elements is checked too: each such content model is
+ *         compiled into a small automaton when the DTD is parsed,
+ *         which takes one step per child element.
  *
  *      -- Otherwise the @DTD entries will not be stored in the DOM
  *         nodes, and no validation occurs. Still, if a DTD exists,
  *         @expat will insert attributes that have a default value
  *         in their @attribute declaraion and have not been specified.
  *
+ *      If many documents use the same external DTD, compile it once
+ *      with xmlCreateDTD and hand it to xmlSetDTD or xmlParseFiles;
+ *      the latter also parses a list of files on several threads.
+ *
+ *      A document that is loaded over and over, such as a large
+ *      configuration file, can be kept in a binary snapshot next
+ *      to it instead; see xmlLoadBinary.
+ *
  *@@header "helpers\xml.h"
  *@@added V0.9.6 (2000-10-29) [umoeller]
  */
@@ -123,6 +140,8 @@
     // emx will define PSZ as _signed_ char, otherwise
     // as unsigned char
 
+#define INCL_DOSPROCESS
+#define INCL_DOSFILEMGR
 #define INCL_DOSERRORS
 #include <os2.h>
 
@@ -135,9 +154,11 @@
 #include "expat\expat.h"
 
 #include "helpers\linklist.h"
+#include "helpers\sem.h"
 #include "helpers\standards.h"
 #include "helpers\stringh.h"
 #include "helpers\tree.h"
+#include "helpers\strmap.h"
 #include "helpers\xstring.h"
 #include "helpers\xml.h"
 
@@ -167,6 +188,9 @@
  *
  *@@changed V0.9.9 (2001-02-14) [umoeller]: adjusted for new error codes
  *@@changed V0.9.9 (2001-02-16) [umoeller]: moved this here from xmlparse.c
+ *@@changed V1.0.24 (2026-10-18) [agent]: added ERROR_DOM_INVALID_PATH
+ *@@changed V1.0.24 (2026-10-18) [agent]: added ERROR_DOM_INCOMPLETE_CONTENT
+ *@@changed V1.0.24 (2026-10-18) [agent]: added ERROR_DOM_INVALID_SNAPSHOT
  */
 
 const char* xmlDescribeError(int code)
@@ -281,6 +305,15 @@ const char* xmlDescribeError(int code)
 
         case ERROR_DOM_INVALID_EXTERNAL_HANDLER:
             return "Invalid 'external' handler specified";
+
+        case ERROR_DOM_INVALID_PATH:
+            return "Invalid path expression";
+
+        case ERROR_DOM_INCOMPLETE_CONTENT:
+            return "Element content is incomplete";
+
+        case ERROR_DOM_INVALID_SNAPSHOT:
+            return "Invalid binary DOM snapshot";
     }
 
     return NULL;
@@ -319,2766 +352,7052 @@ VOID xmlSetError(PXMLDOM pDom,
 
 /* ******************************************************************
  *
- *   Most basic node management
+ *   DOM arena
  *
  ********************************************************************/
 
 /*
- *@@ CompareXStrings:
- *      tree comparison func for NodeBases.
- *      This works for all trees which contain structures
- *      whose first item is a _NODEBASE because NODEBASE's first
- *      member is a TREE.
- *
- *      Used in two places:
+ *@@ ARENABLOCK:
+ *      header of one block of a DOMARENA. The block's
+ *      memory follows the header, at ARENA_HEADER.
  *
- *      --  to insert _CMELEMENTDECLNODE nodes into
- *          _DOMDOCTYPENODE.ElementDeclsTree;
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+typedef struct _ARENABLOCK
+{
+    struct _ARENABLOCK  *pNext;
+    ULONG               cb;             // size of the memory after the header
+    ULONG               cbUsed;         // bytes used thereof
+} ARENABLOCK, *PARENABLOCK;
+
+#define ARENA_ALIGN(cb)     (((cb) + 7) & ~7)
+#define ARENA_HEADER        ARENA_ALIGN(sizeof(ARENABLOCK))
+#define ARENA_BLOCKSIZE     (64 * 1024 - ARENA_HEADER)
+
+/*
+ *@@ DOMARENA:
+ *      memory pool for the nodes, names and values of a
+ *      DOM that was parsed with DF_ARENA. Memory is only
+ *      ever handed out from the current block (the first
+ *      on the list) and is freed all at once by ArenaFree.
  *
- *      --  to insert _CMELEMENTPARTICLE nodes into
- *          _CMELEMENTDECLNODE.ElementNamesTree.
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+typedef struct _DOMARENA
+{
+    PARENABLOCK pBlocks;                // current block first
+} DOMARENA, *PDOMARENA;
+
+/*
+ *@@ ArenaCreate:
  *
- *@@added V0.9.9 (2001-02-16) [umoeller]
- *@@changed V0.9.14 (2001-08-09) [umoeller]: fixed map bug which caused the whole XML stuff to fail
+ *@@added V1.0.24 (2026-10-18) [agent]
  */
 
-STATIC int TREEENTRY CompareXStrings(ULONG ul1,
-                                     ULONG ul2)
+STATIC PDOMARENA ArenaCreate(VOID)
 {
-    return strhcmp(((PXSTRING)ul1)->psz,
-                   ((PXSTRING)ul2)->psz);
+    PDOMARENA pArena;
+    if (pArena = (PDOMARENA)malloc(sizeof(DOMARENA)))
+        memset(pArena, 0, sizeof(DOMARENA));
+
+    return pArena;
 }
 
 /*
- *@@ xmlCreateNodeBase:
- *      creates a new NODEBASE node.
+ *@@ ArenaAlloc:
+ *      returns cb bytes of uninitialized memory from the
+ *      arena, aligned on eight bytes, or NULL if we're out
+ *      of memory.
  *
- *      Gets called from xmlCreateDomNode also to create
- *      a DOMNODE, since that in turn has a NODEBASE.
+ *      Requests that do not fit into the current block get
+ *      a new block, which becomes the current one unless
+ *      the request is large, in which case the block is
+ *      made for it alone and the current block is kept.
  *
- *@@added V0.9.9 (2001-02-16) [umoeller]
+ *@@added V1.0.24 (2026-10-18) [agent]
  */
 
-APIRET xmlCreateNodeBase(NODEBASETYPE ulNodeType,     // in: node type
-                         ULONG cb,                    // in: size of struct
-                         const char *pcszNodeName,    // in: node name or NULL
-                         ULONG ulNodeNameLength,      // in: node name length
-                                                      // or 0 to run strlen(pcszNodeName)
-                         PNODEBASE *ppNew)            // out: new node
+STATIC PVOID ArenaAlloc(PDOMARENA pArena,
+                        ULONG cb)
 {
-    APIRET      arc = NO_ERROR;
-    PNODEBASE   pNewNode = (PNODEBASE)malloc(cb);
+    PARENABLOCK pBlock = pArena->pBlocks;
+    PBYTE       pb;
 
-    if (!pNewNode)
-        arc = ERROR_NOT_ENOUGH_MEMORY;
+    cb = ARENA_ALIGN(cb);
+
+    if (    (pBlock)
+         && (pBlock->cb - pBlock->cbUsed >= cb)
+       )
+    {
+        pb = (PBYTE)pBlock + ARENA_HEADER + pBlock->cbUsed;
+        pBlock->cbUsed += cb;
+    }
     else
     {
-        memset(pNewNode, 0, cb);
-        pNewNode->ulNodeType = ulNodeType;
+        BOOL fLarge = (cb > ARENA_BLOCKSIZE / 4);
+        ULONG cbBlock = (fLarge) ? cb : ARENA_BLOCKSIZE;
 
-        pNewNode->Tree.ulKey = (ULONG)&pNewNode->strNodeName;
+        if (!(pBlock = (PARENABLOCK)malloc(ARENA_HEADER + cbBlock)))
+            return NULL;
 
-        xstrInit(&pNewNode->strNodeName, 0);
-        if (pcszNodeName)
+        pBlock->cb = cbBlock;
+        pBlock->cbUsed = cb;
+        pb = (PBYTE)pBlock + ARENA_HEADER;
+
+        if (    (fLarge)
+             && (pArena->pBlocks)
+           )
         {
-            xstrcpy(&pNewNode->strNodeName,
-                    pcszNodeName,
-                    ulNodeNameLength);
+            // keep using the current block for small stuff
+            pBlock->pNext = pArena->pBlocks->pNext;
+            pArena->pBlocks->pNext = pBlock;
+            return pb;
         }
 
-        *ppNew = pNewNode;
+        pBlock->pNext = pArena->pBlocks;
+        pArena->pBlocks = pBlock;
     }
 
-    return arc;
+    return pb;
 }
 
 /*
- *@@ xmlDeleteNode:
- *      deletes a NODEBASE and frees memory that was
- *      associated with its members.
- *
- *      After calling this, pNode is no longer valid.
+ *@@ ArenaFree:
+ *      frees the arena and everything that was
+ *      allocated from it.
  *
- *      If you invoke this on a DOCUMENT node, the
- *      entire DOM tree will get deleted recursively.
- *
- *@@added V0.9.9 (2001-02-16) [umoeller]
- *@@changed V0.9.14 (2001-08-09) [umoeller]: fixed crash on string delete
+ *@@added V1.0.24 (2026-10-18) [agent]
  */
 
-VOID xmlDeleteNode(PNODEBASE pNode)
+STATIC VOID ArenaFree(PDOMARENA pArena)
 {
-    if (pNode)
+    PARENABLOCK pBlock = pArena->pBlocks;
+    while (pBlock)
     {
-        PLISTNODE   pNodeThis;
-        PDOMNODE    pDomNode = NULL;
-
-        LINKLIST    llDeleteNodes;          // list that nodes to be deleted
-                                            // can be appended to
-        PLISTNODE   pDelNode;
-        lstInit(&llDeleteNodes, FALSE);
-
-        // now handle special types and their allocations
-        switch (pNode->ulNodeType)
-        {
-            case DOMNODE_ELEMENT:
-            {
-                PDOMNODE pAttrib;
+        PARENABLOCK pNext = pBlock->pNext;
+        free(pBlock);
+        pBlock = pNext;
+    }
 
-                pDomNode = (PDOMNODE)pNode;
+    free(pArena);
+}
 
-                // delete all attribute nodes
-                pAttrib = (PDOMNODE)treeFirst(pDomNode->AttributesMap);
-                while (pAttrib)
-                {
-                    // call delete recursively
-                    PDOMNODE pNext = (PDOMNODE)treeNext((TREE*)pAttrib);
-                    xmlDeleteNode((PNODEBASE)pAttrib);
-                            // this will remove pAttrib from pNode's attrib
-                            // tree and rebalance the tree
-                    pAttrib = pNext;
-                }
-            break; }
+/*
+ *@@ ArenaSetString:
+ *      sets pxstr to a copy of the first cb bytes of pcsz
+ *      (or all of it if cb is 0), allocated from the arena.
+ *
+ *      The XSTRING must not be passed to the xstr* functions
+ *      that modify or free it afterwards.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
 
-            case DOMNODE_ATTRIBUTE:
-            case DOMNODE_TEXT:
-            case DOMNODE_PROCESSING_INSTRUCTION:
-            case DOMNODE_COMMENT:
-                pDomNode = (PDOMNODE)pNode;
-            break;
+STATIC APIRET ArenaSetString(PDOMARENA pArena,
+                             PXSTRING pxstr,
+                             const char *pcsz,
+                             ULONG cb)
+{
+    PSZ psz;
 
-            case DOMNODE_DOCUMENT:
-                if (((PDOMDOCUMENTNODE)pNode)->pDocType)
-                    xmlDeleteNode((PNODEBASE)((PDOMDOCUMENTNODE)pNode)->pDocType);
-                pDomNode = (PDOMNODE)pNode;
-            break;
+    if (!cb)
+        cb = strlen(pcsz);
 
-            case DOMNODE_DOCUMENT_TYPE:
-            {
-                PDOMDOCTYPENODE pDocType = (PDOMDOCTYPENODE)pNode;
-                PCMELEMENTDECLNODE pElDecl;
-                PCMATTRIBUTEDECLBASE pAttrDeclBase;
+    if (!(psz = (PSZ)ArenaAlloc(pArena, cb + 1)))
+        return ERROR_NOT_ENOUGH_MEMORY;
 
-                pDomNode = (PDOMNODE)pNode;
+    memcpy(psz, pcsz, cb);
+    psz[cb] = '\0';
 
-                pElDecl = (PCMELEMENTDECLNODE)treeFirst(pDocType->ElementDeclsTree);
-                while (pElDecl)
-                {
-                    lstAppendItem(&llDeleteNodes, pElDecl);
-                    pElDecl = (PCMELEMENTDECLNODE)treeNext((TREE*)pElDecl);
-                }
+    pxstr->psz = psz;
+    pxstr->ulLength = cb;
+    pxstr->cbAllocated = cb + 1;
+    pxstr->ulDelta = 0;
 
-                pAttrDeclBase = (PCMATTRIBUTEDECLBASE)treeFirst(pDocType->AttribDeclBasesTree);
-                while (pAttrDeclBase)
-                {
-                    lstAppendItem(&llDeleteNodes, pAttrDeclBase);
-                    pAttrDeclBase = (PCMATTRIBUTEDECLBASE)treeNext((TREE*)pAttrDeclBase);
-                }
+    return NO_ERROR;
+}
 
-                xstrClear(&pDocType->strPublicID);
-                xstrClear(&pDocType->strSystemID);
-            break; }
+/*
+ *@@ GetDocument:
+ *      returns the document that pDomNode belongs to,
+ *      which is pDomNode itself for DOCUMENT nodes, or
+ *      NULL if pDomNode has no document.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
 
-            case ELEMENTPARTICLE_EMPTY:
-            case ELEMENTPARTICLE_ANY:
-            case ELEMENTPARTICLE_MIXED:
-            case ELEMENTPARTICLE_CHOICE:
-            case ELEMENTPARTICLE_SEQ:
-            case ELEMENTPARTICLE_NAME:
-            {
-                PCMELEMENTPARTICLE pp = (PCMELEMENTPARTICLE)pNode;
-                if (pp->pllSubNodes)
-                {
-                    pDelNode = lstQueryFirstNode(pp->pllSubNodes);
-                    while (pDelNode)
-                    {
-                        PCMELEMENTPARTICLE
-                                pParticle = (PCMELEMENTPARTICLE)pDelNode->pItemData;
-                        xmlDeleteNode((PNODEBASE)pParticle);
-                        //  treeDelete(pp->         // @@todo
-                        pDelNode = pDelNode->pNext;
-                    }
-                }
-            break; }
+STATIC PDOMDOCUMENTNODE GetDocument(PDOMNODE pDomNode)
+{
+    if (pDomNode)
+    {
+        if (pDomNode->NodeBase.ulNodeType == DOMNODE_DOCUMENT)
+            return (PDOMDOCUMENTNODE)pDomNode;
 
-            // case ATTRIBUTE_DECLARATION_ENUM:     // this is a plain NODEBASE
+        return (PDOMDOCUMENTNODE)pDomNode->pDocumentNode;
+    }
 
-            case ATTRIBUTE_DECLARATION:
-            {
-                // PCMATTRIBUTEDECL pDecl = (PCMATTRIBUTEDECL)pNode;
-            break; }
+    return NULL;
+}
 
-            case ATTRIBUTE_DECLARATION_BASE:
-            break;
-        }
+/*
+ *@@ GetArena:
+ *      returns the arena of the document that pDomNode
+ *      belongs to, or NULL if the document has none or
+ *      pDomNode has no document.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
 
-        if (pDomNode)
-        {
-            // recurse into child nodes
-            while (pNodeThis = lstQueryFirstNode(&pDomNode->llChildren))
-                // recurse!!
-                xmlDeleteNode((PNODEBASE)(pNodeThis->pItemData));
-                            // this updates llChildren
+STATIC PDOMARENA GetArena(PDOMNODE pDomNode)
+{
+    PDOMDOCUMENTNODE pDocument;
+    if (pDocument = GetDocument(pDomNode))
+        return pDocument->pArena;
 
-            if (pDomNode->pParentNode)
-            {
-                // node has a parent:
-                if (pNode->ulNodeType == DOMNODE_ATTRIBUTE)
-                    // this is an attribute:
-                    // remove from parent's attributes map
-                    treeDelete(&pDomNode->pParentNode->AttributesMap,
-                               NULL,
-                               (TREE*)pNode);
-                else
-                    // remove this node from the parent's list
-                    // of child nodes before deleting this node
-                    lstRemoveItem(&pDomNode->pParentNode->llChildren,
-                                  pNode);
+    return NULL;
+}
 
-                pDomNode->pParentNode = NULL;
-            }
+/* ******************************************************************
+ *
+ *   Name interning
+ *
+ ********************************************************************/
 
-            xstrFree(&pDomNode->pstrNodeValue);
-            lstClear(&pDomNode->llChildren);
-        }
+/*
+ *@@ DOMSYMBOL:
+ *      one entry in a document's symbol table
+ *      (_DOMDOCUMENTNODE.SymbolsMap). Every distinct element,
+ *      attribute and PI name in a document is stored once,
+ *      in szName, and the strNodeName of all nodes with that
+ *      name point there. So two nodes of the same document
+ *      have the same name exactly if their strNodeName.psz
+ *      pointers are equal, and SymbolFromName gets from a
+ *      node to its symbol without hashing.
+ *
+ *      For element names, the symbol also caches the element's
+ *      declarations from the DTD, if any, for validation, and
+ *      has the elements with that name if the document's name
+ *      index has been built (see BuildNameIndex).
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
 
-        pDelNode = lstQueryFirstNode(&llDeleteNodes);
-        while (pDelNode)
-        {
-            PNODEBASE pNodeBase = (PNODEBASE)pDelNode->pItemData;
-            xmlDeleteNode(pNodeBase);
-            pDelNode = pDelNode->pNext;
-        }
+typedef struct _DOMSYMBOL
+{
+    ULONG                   ulHash;         // smapHash(szName)
+    ULONG                   ulLength;       // strlen(szName)
+    PCMELEMENTDECLNODE      pElementDecl;   // <!ELEMENT> for this name or NULL
+    PCMATTRIBUTEDECLBASE    pAttribDeclBase; // <!ATTLIST> for this name or NULL
+    PDOMNODE                *papElements;   // name index: elements in document order,
+                                            // always on the heap
+    ULONG                   cElements;      // no. of items in papElements
+    ULONG                   ulIndex;        // scratch for xmlSaveBinary
+    CHAR                    szName[1];      // name, null-terminated
+} DOMSYMBOL, *PDOMSYMBOL;
+
+#define SymbolFromName(pstr) \
+            ((PDOMSYMBOL)((pstr)->psz - FIELDOFFSET(DOMSYMBOL, szName)))
 
-        lstClear(&llDeleteNodes);
+/*
+ *@@ IsInterned:
+ *      returns TRUE if pNode's name is in its document's
+ *      symbol table, which is the case for all nodes but
+ *      DOCUMENT and DOCTYPE nodes that have a document.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
 
-        xstrClear(&pNode->strNodeName);
-        free(pNode);
+STATIC BOOL IsInterned(PNODEBASE pNode)
+{
+    switch (pNode->ulNodeType)
+    {
+        case DOMNODE_ELEMENT:
+        case DOMNODE_ATTRIBUTE:
+        case DOMNODE_TEXT:
+        case DOMNODE_PROCESSING_INSTRUCTION:
+        case DOMNODE_COMMENT:
+            return (((PDOMNODE)pNode)->pDocumentNode != NULL);
     }
+
+    return FALSE;
 }
 
 /*
- *@@ xmlCreateDomNode:
- *      creates a new DOMNODE with the specified
- *      type and parent. Other than that, the
- *      node fields are zeroed.
- *
- *      If pParentNode is specified (which is required,
- *      unless you are creating a document node),
- *      its children list is automatically updated
- *      (unless this is an attribute node, which updates
- *      the attributes map).
- *
- *      This returns the following errors:
- *
- *      --  ERROR_NOT_ENOUGH_MEMORY
- *
- *      --  ERROR_DOM_NOT_SUPPORTED: invalid ulNodeType
- *          specified.
+ *@@ FindSymbol:
+ *      returns the symbol for the given name from the
+ *      document's symbol table, or NULL if no node in
+ *      the document has ever had that name.
  *
- *      --  ERROR_DOM_WRONG_DOCUMENT: cannot find the
- *          document for this node. This happens if you do
- *          not have a document node at the root of your tree.
+ *@@added V1.0.24 (2026-10-18) [agent]
  */
 
-APIRET xmlCreateDomNode(PDOMNODE pParentNode,        // in: parent node or NULL if root
-                        NODEBASETYPE ulNodeType,     // in: DOMNODE_* type
-                        const char *pcszNodeName,    // in: node name or NULL
-                        ULONG ulNodeNameLength,      // in: node name length
-                                                     // or 0 to run strlen(pcszNodeName)
-                        PDOMNODE *ppNew)             // out: new node
+STATIC PDOMSYMBOL FindSymbol(PDOMDOCUMENTNODE pDocument,
+                             const char *pcszName,
+                             ULONG ulLength)         // in: length of name or 0 to run strlen
 {
-    PDOMNODE pNewNode = NULL;
-    APIRET  arc = NO_ERROR;
+    if (!ulLength)
+        ulLength = strlen(pcszName);
 
-    ULONG   cb = 0;
+    return (PDOMSYMBOL)smapFindHash(&pDocument->SymbolsMap,
+                                    pcszName,
+                                    ulLength,
+                                    smapHash(pcszName, ulLength));
+}
 
-    switch (ulNodeType)
-    {
-        case DOMNODE_DOCUMENT:
-            cb = sizeof(DOMDOCUMENTNODE);
-        break;
+/*
+ *@@ InternName:
+ *      returns the symbol for the given name from the
+ *      document's symbol table, adding it if it's not
+ *      there yet. With DF_ARENA, the symbol is allocated
+ *      from the document's arena, otherwise from the heap.
+ *
+ *      Returns NULL if we're out of memory.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
 
-        case DOMNODE_DOCUMENT_TYPE:
-            cb = sizeof(DOMDOCTYPENODE);
-        break;
+STATIC PDOMSYMBOL InternName(PDOMDOCUMENTNODE pDocument,
+                             const char *pcszName,
+                             ULONG ulLength)         // in: length of name or 0 to run strlen
+{
+    ULONG       ulHash;
+    PDOMSYMBOL  pSymbol;
 
-        default:
-            cb = sizeof(DOMNODE);
-        break;
-    }
+    if (!ulLength)
+        ulLength = strlen(pcszName);
 
-    if (!(arc = xmlCreateNodeBase(ulNodeType,
-                                  cb,
-                                  pcszNodeName,
-                                  ulNodeNameLength,
-                                  (PNODEBASE*)&pNewNode)))
+    ulHash = smapHash(pcszName, ulLength);
+    if (!(pSymbol = (PDOMSYMBOL)smapFindHash(&pDocument->SymbolsMap,
+                                             pcszName,
+                                             ulLength,
+                                             ulHash)))
     {
-        pNewNode->pParentNode = pParentNode;
+        ULONG cb = sizeof(DOMSYMBOL) + ulLength;
 
-        if (pParentNode)
+        if (pDocument->pArena)
+            pSymbol = (PDOMSYMBOL)ArenaAlloc(pDocument->pArena, cb);
+        else
+            pSymbol = (PDOMSYMBOL)malloc(cb);
+
+        if (!pSymbol)
+            return NULL;
+
+        memset(pSymbol, 0, sizeof(DOMSYMBOL));
+        pSymbol->ulHash = ulHash;
+        pSymbol->ulLength = ulLength;
+        memcpy(pSymbol->szName, pcszName, ulLength);
+        pSymbol->szName[ulLength] = '\0';
+
+        if (smapInsertHash(&pDocument->SymbolsMap,
+                           pSymbol->szName,
+                           ulLength,
+                           ulHash,
+                           pSymbol))
         {
-            // parent specified:
-            // check if this is an attribute
-            if (ulNodeType == DOMNODE_ATTRIBUTE)
-            {
-                // attribute:
-                // add to parent's attributes list
-                if (treeInsert(&pParentNode->AttributesMap,
-                               NULL,
-                               &pNewNode->NodeBase.Tree,
-                               CompareXStrings))
-                    arc = ERROR_DOM_DUPLICATE_ATTRIBUTE;
-                                // shouldn't happen, because expat takes care of this
-            }
-            else
-                // append this new node to the parent's
-                // list of child nodes
-                lstAppendItem(&pParentNode->llChildren,
-                              pNewNode);
+            if (!pDocument->pArena)
+                free(pSymbol);
+            return NULL;
+        }
+    }
 
-            if (!arc)
+    return pSymbol;
+}
+
+/*
+ *@@ ClearSymbolDecls:
+ *      resets the cached DTD declarations in all symbols
+ *      of the document. Called when the DOCTYPE goes away.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+STATIC VOID ClearSymbolDecls(PDOMDOCUMENTNODE pDocument)
+{
+    PSTRMAPSLOT pSlot;
+    ULONG       ul = 0;
+    while (pSlot = smapEnum(&pDocument->SymbolsMap, &ul))
+    {
+        PDOMSYMBOL pSymbol = (PDOMSYMBOL)pSlot->pvData;
+        pSymbol->pElementDecl = NULL;
+        pSymbol->pAttribDeclBase = NULL;
+    }
+}
+
+/*
+ *@@ FreeNameIndex:
+ *      frees the document's name index, if it has one.
+ *      This must be called whenever an element is added
+ *      to or removed from the document, as the index would
+ *      be wrong then. The next query will rebuild it.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+STATIC VOID FreeNameIndex(PDOMDOCUMENTNODE pDocument)
+{
+    if (pDocument->fNameIndex)
+    {
+        PSTRMAPSLOT pSlot;
+        ULONG       ul = 0;
+        while (pSlot = smapEnum(&pDocument->SymbolsMap, &ul))
+        {
+            PDOMSYMBOL pSymbol = (PDOMSYMBOL)pSlot->pvData;
+            if (pSymbol->papElements)
             {
-                // set document pointer...
-                // if the parent node has a document pointer,
-                // we can copy that
-                if (pParentNode->pDocumentNode)
-                    pNewNode->pDocumentNode = pParentNode->pDocumentNode;
-                else
-                    // parent has no document pointer: then it is probably
-                    // the document itself... check
-                    if (pParentNode->NodeBase.ulNodeType == DOMNODE_DOCUMENT)
-                        pNewNode->pDocumentNode = pParentNode;
-                    else
-                        arc = ERROR_DOM_NO_DOCUMENT;
+                free(pSymbol->papElements);
+                pSymbol->papElements = NULL;
             }
+            pSymbol->cElements = 0;
         }
 
-        lstInit(&pNewNode->llChildren, FALSE);
-        treeInit(&pNewNode->AttributesMap, NULL);
+        pDocument->fNameIndex = FALSE;
     }
+}
 
-    if (!arc)
-        *ppNew = pNewNode;
-    else
-        if (pNewNode)
-            free(pNewNode);
+/*
+ *@@ FreeSymbols:
+ *      frees the document's symbol table. With DF_ARENA,
+ *      the symbols themselves go with the arena.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
 
-    return arc;
+STATIC VOID FreeSymbols(PDOMDOCUMENTNODE pDocument)
+{
+    FreeNameIndex(pDocument);
+
+    if (!pDocument->pArena)
+    {
+        PSTRMAPSLOT pSlot;
+        ULONG       ul = 0;
+        while (pSlot = smapEnum(&pDocument->SymbolsMap, &ul))
+            free(pSlot->pvData);
+    }
+
+    smapClear(&pDocument->SymbolsMap);
 }
 
 /* ******************************************************************
  *
- *   Specific DOM node constructors
+ *   Content model automata
  *
  ********************************************************************/
 
 /*
- *@@ xmlCreateElementNode:
- *      creates a new element node with the specified name.
- *
- *@@added V0.9.9 (2001-02-14) [umoeller]
+ *@@ CMCONTENTDFA:
+ *      deterministic automaton for a (children) content
+ *      model, which CompileContentModel builds when the
+ *      element declaration is created. ValidateElement
+ *      then checks each child element with one transition
+ *      and ValidateContentEnd checks the final state.
+ *
+ *      Each distinct element name in the model has a
+ *      column in the transition table. State 0 is the
+ *      dead state, which has no transitions; state 1 is
+ *      the start state, before the first child.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
  */
 
-APIRET xmlCreateElementNode(PDOMNODE pParent,         // in: parent node (either document or element)
-                            const char *pcszElement,  // in: element name (null-terminated)
-                            PDOMNODE *ppNew)
+typedef struct _CMCONTENTDFA
 {
-    PDOMNODE pNew = NULL;
-    APIRET arc;
+    STRMAP          NamesMap;       // column + 1 by element name; the keys
+                                    // are the names of the NAME particles
+    ULONG           cColumns;       // no. of distinct names
+    ULONG           cStates;        // no. of states, including the dead one
+    PBYTE           pafAccepting;   // cStates flags, TRUE if the content
+                                    // may end in that state
+    PUSHORT         pausNext;       // cStates * cColumns next states
+} CMCONTENTDFA, *PCMCONTENTDFA;
+
+#define CM_MAX_DFA_STATES       1024
+                // models that need more states than this are
+                // only checked for which children may appear
 
-    if (!(arc = xmlCreateDomNode(pParent,
-                                 DOMNODE_ELEMENT,
-                                 pcszElement,
-                                 0,
-                                 &pNew)))
-        *ppNew = pNew;
+/*
+ *      Sets of positions, i.e. NAME particles, while building
+ *      the automaton; these are arrays of cWords ULONGs with
+ *      32 positions each.
+ */
 
-    return arc;
-}
+#define SETPOS(paul, ul)        ((paul)[(ul) >> 5] |= 1UL << ((ul) & 31))
+#define ISPOS(paul, ul)         ((paul)[(ul) >> 5] & (1UL << ((ul) & 31)))
 
 /*
- *@@ xmlCreateAttributeNode:
- *      creates a new attribute node with the specified data.
- *
- *      NOTE: Attributes have no "parent" node, technically.
- *      They are added to a special, separate list in @DOM_ELEMENT
- *      nodes.
- *
- *      This returns the following errors:
+ *@@ DFABUILD:
+ *      temporary data for CompileContentModel.
  *
- *      --  Error codes from xmlCreateDomNode.
- *
- *      --  ERROR_DOM_NO_ELEMENT: pElement is invalid or does
- *          not point to an @DOM_ELEMENT node.
- *
- *@@added V0.9.9 (2001-02-14) [umoeller]
- *@@changed V1.0.2 (2003-02-07) [umoeller]: added lenValue param
+ *@@added V1.0.24 (2026-10-18) [agent]
  */
 
-APIRET xmlCreateAttributeNode(PDOMNODE pElement,        // in: element node
-                              const char *pcszName,     // in: attribute name (null-terminated)
-                              const char *pcszValue,    // in: attribute value (null-terminated)
-                              ULONG lenValue,           // in: length of value (must be specified)
-                              PDOMNODE *ppNew)
+typedef struct _DFABUILD
 {
-    APIRET      arc;
-    PDOMNODE    pNew = NULL;
+    PCMCONTENTDFA   pDFA;
+    ULONG           cPositions;     // no. of NAME particles in the model
+    ULONG           cWords;         // ULONGs per set of positions
+    ULONG           ulNextPos;      // next position for AnalyzeParticle
+    PULONG          paulColumns;    // cPositions: column of each position
+    PULONG          paulFollow;     // cPositions sets: positions that
+                                    // may come after each position
+} DFABUILD, *PDFABUILD;
 
-    if (    (!pElement)
-         || (pElement->NodeBase.ulNodeType != DOMNODE_ELEMENT)
-       )
-        return ERROR_DOM_NO_ELEMENT;
+/*
+ *@@ CountPositions:
+ *      returns the number of NAME particles in the
+ *      given particle and its sub-particles.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
 
-    if (!(arc = xmlCreateDomNode(pElement,          // this takes care of adding to the list
-                                 DOMNODE_ATTRIBUTE,
-                                 pcszName,
-                                 0,
-                                 &pNew)))
-    {
-        pNew->pstrNodeValue = xstrCreate(lenValue + 1);
-        xstrcpy(pNew->pstrNodeValue, pcszValue, lenValue);
+STATIC ULONG CountPositions(PCMELEMENTPARTICLE pParticle)
+{
+    ULONG       cPositions = 0;
+    PLISTNODE   pNode;
 
-        *ppNew = pNew;
-    }
+    if (pParticle->NodeBase.ulNodeType == ELEMENTPARTICLE_NAME)
+        return 1;
 
-    return arc;
+    if (pParticle->pllSubNodes)
+        for (pNode = lstQueryFirstNode(pParticle->pllSubNodes);
+             pNode;
+             pNode = pNode->pNext)
+            cPositions += CountPositions((PCMELEMENTPARTICLE)pNode->pItemData);
+
+    return cPositions;
 }
 
 /*
- *@@ xmlCreateTextNode:
- *      creates a new text node with the specified content.
- *
- *      Note: This differs from the createText method
- *      as specified by DOM, which has no ulLength parameter.
- *      We need this for speed with @expat though.
+ *@@ AddFollow:
+ *      adds the positions in paulSet to the follow
+ *      sets of all positions in paulFrom.
  *
- *@@added V0.9.9 (2001-02-14) [umoeller]
+ *@@added V1.0.24 (2026-10-18) [agent]
  */
 
-APIRET xmlCreateTextNode(PDOMNODE pParent,         // in: parent element node
-                         const char *pcszText,     // in: ptr to start of text
-                         ULONG lenText,            // in: length of *pcszText
-                         PDOMNODE *ppNew)
+STATIC VOID AddFollow(PDFABUILD pBuild,
+                      const ULONG *paulFrom,
+                      const ULONG *paulSet)
 {
-    PDOMNODE pNew = NULL;
-    APIRET arc;
+    ULONG ulPos,
+          ul;
 
-    if (!(arc = xmlCreateDomNode(pParent,
-                                 DOMNODE_TEXT,
-                                 NULL,
-                                 0,
-                                 &pNew)))
-    {
-        PSZ pszNodeValue;
-        if (pszNodeValue = (PSZ)malloc(lenText + 1))
+    for (ulPos = 0;
+         ulPos < pBuild->cPositions;
+         ++ulPos)
+        if (ISPOS(paulFrom, ulPos))
         {
-            memcpy(pszNodeValue, pcszText, lenText);
-            pszNodeValue[lenText] = '\0';
-            pNew->pstrNodeValue = xstrCreate(0);
-            xstrset(pNew->pstrNodeValue, pszNodeValue);
+            PULONG paulFollow = pBuild->paulFollow + ulPos * pBuild->cWords;
+            for (ul = 0;
+                 ul < pBuild->cWords;
+                 ++ul)
+                paulFollow[ul] |= paulSet[ul];
+        }
+}
 
-            *ppNew = pNew;
+/*
+ *@@ AnalyzeParticle:
+ *      computes the positions that can come first and
+ *      last in the given particle, and whether it can
+ *      be empty, and adds to the follow sets of the
+ *      positions in it. This is the usual construction
+ *      of a position (Glushkov) automaton; recurses
+ *      into the sub-particles.
+ *
+ *      Positions are numbered in the order in which the
+ *      NAME particles appear. Names are given columns in
+ *      the automaton as they are found.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+STATIC APIRET AnalyzeParticle(PDFABUILD pBuild,
+                              PCMELEMENTPARTICLE pParticle,
+                              PULONG paulFirst,     // out: positions that can come first
+                              PULONG paulLast,      // out: positions that can come last
+                              PBOOL pfNullable)     // out: TRUE if particle can be empty
+{
+    APIRET  arc = NO_ERROR;
+    ULONG   cWords = pBuild->cWords,
+            ul;
+    BOOL    fNullable;
+
+    memset(paulFirst, 0, cWords * sizeof(ULONG));
+    memset(paulLast, 0, cWords * sizeof(ULONG));
+
+    if (pParticle->NodeBase.ulNodeType == ELEMENTPARTICLE_NAME)
+    {
+        PCMCONTENTDFA   pDFA = pBuild->pDFA;
+        PCSZ            pcszName = pParticle->NodeBase.strNodeName.psz;
+        ULONG           ulPos = pBuild->ulNextPos++,
+                        ulColumn;
+
+        if (!(ulColumn = (ULONG)smapFind(&pDFA->NamesMap, pcszName)))
+        {
+            ulColumn = ++pDFA->cColumns;
+            if (smapInsert(&pDFA->NamesMap,
+                           pcszName,
+                           (PVOID)ulColumn))
+                return ERROR_NOT_ENOUGH_MEMORY;
         }
-        else
+
+        pBuild->paulColumns[ulPos] = ulColumn - 1;
+        SETPOS(paulFirst, ulPos);
+        SETPOS(paulLast, ulPos);
+        fNullable = FALSE;
+    }
+    else
+    {
+        // CHOICE or SEQ
+        BOOL        fSeq = (pParticle->NodeBase.ulNodeType == ELEMENTPARTICLE_SEQ);
+        PULONG      paulSubFirst,
+                    paulSubLast;
+        PLISTNODE   pNode;
+
+        if (!(paulSubFirst = (PULONG)malloc(2 * cWords * sizeof(ULONG))))
+            return ERROR_NOT_ENOUGH_MEMORY;
+        paulSubLast = paulSubFirst + cWords;
+
+        fNullable = fSeq;
+        for (pNode = (pParticle->pllSubNodes) ? lstQueryFirstNode(pParticle->pllSubNodes) : NULL;
+             (pNode) && (!arc);
+             pNode = pNode->pNext)
         {
-            arc = ERROR_NOT_ENOUGH_MEMORY;
-            xmlDeleteNode((PNODEBASE)pNew);
+            BOOL fSubNullable;
+
+            if (!(arc = AnalyzeParticle(pBuild,
+                                        (PCMELEMENTPARTICLE)pNode->pItemData,
+                                        paulSubFirst,
+                                        paulSubLast,
+                                        &fSubNullable)))
+            {
+                if (fSeq)
+                {
+                    // whatever can end the sequence so far can
+                    // be followed by the start of this particle
+                    AddFollow(pBuild, paulLast, paulSubFirst);
+                    for (ul = 0;
+                         ul < cWords;
+                         ++ul)
+                    {
+                        if (fNullable)
+                            paulFirst[ul] |= paulSubFirst[ul];
+                        if (fSubNullable)
+                            paulLast[ul] |= paulSubLast[ul];
+                        else
+                            paulLast[ul] = paulSubLast[ul];
+                    }
+                    fNullable = (fNullable && fSubNullable);
+                }
+                else
+                {
+                    for (ul = 0;
+                         ul < cWords;
+                         ++ul)
+                    {
+                        paulFirst[ul] |= paulSubFirst[ul];
+                        paulLast[ul] |= paulSubLast[ul];
+                    }
+                    fNullable = (fNullable || fSubNullable);
+                }
+            }
         }
+
+        free(paulSubFirst);
+    }
+
+    switch (pParticle->ulRepeater)
+    {
+        case XML_CQUANT_REP:
+            fNullable = TRUE;
+            // and repeat like with PLUS
+        case XML_CQUANT_PLUS:
+            AddFollow(pBuild, paulLast, paulFirst);
+        break;
+
+        case XML_CQUANT_OPT:
+            fNullable = TRUE;
+        break;
     }
 
+    *pfNullable = fNullable;
+
     return arc;
 }
 
 /*
- *@@ xmlCreateCommentNode:
- *      creates a new comment node with the specified
- *      content.
+ *@@ FreeContentDFA:
  *
- *@@added V0.9.9 (2001-02-14) [umoeller]
+ *@@added V1.0.24 (2026-10-18) [agent]
  */
 
-APIRET xmlCreateCommentNode(PDOMNODE pParent,         // in: parent element node
-                            const char *pcszText,     // in: comment (null-terminated)
-                            PDOMNODE *ppNew)
+STATIC VOID FreeContentDFA(PCMCONTENTDFA pDFA)
 {
-    PDOMNODE pNew = NULL;
-    APIRET arc;
-    if (!(arc = xmlCreateDomNode(pParent,
-                                 DOMNODE_COMMENT,
-                                 NULL,
-                                 0,
-                                 &pNew)))
+    if (pDFA)
     {
-        pNew->pstrNodeValue = xstrCreate(0);
-        xstrcpy(pNew->pstrNodeValue, pcszText, 0);
-        *ppNew = pNew;
+        smapClear(&pDFA->NamesMap);
+        if (pDFA->pafAccepting)
+            free(pDFA->pafAccepting);
+        if (pDFA->pausNext)
+            free(pDFA->pausNext);
+        free(pDFA);
     }
-
-    return arc;
 }
 
 /*
- *@@ xmlCreatePINode:
- *      creates a new processing instruction node with the
- *      specified data.
- *
- *@@added V0.9.9 (2001-02-14) [umoeller]
+ *@@ BuildStates:
+ *      turns the position automaton from AnalyzeParticle
+ *      into a deterministic one by the subset construction.
+ *      Each state but the start state is the set of positions
+ *      that the last child may have matched. XML requires
+ *      content models to be deterministic, in which case
+ *      these sets have one position each, but we handle
+ *      the others as well.
+ *
+ *      Returns ERROR_BUFFER_OVERFLOW if more than
+ *      CM_MAX_DFA_STATES states would be needed.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
  */
 
-APIRET xmlCreatePINode(PDOMNODE pParent,         // in: parent element node
-                       const char *pcszTarget,   // in: PI target (null-terminated)
-                       const char *pcszData,     // in: PI data (null-terminated)
-                       PDOMNODE *ppNew)
+STATIC APIRET BuildStates(PDFABUILD pBuild,
+                          const ULONG *paulFirst,   // in: from AnalyzeParticle for the model
+                          const ULONG *paulLast,    // in: from AnalyzeParticle for the model
+                          BOOL fNullable)           // in: from AnalyzeParticle for the model
 {
-    PDOMNODE pNew = NULL;
-    APIRET arc;
+    PCMCONTENTDFA   pDFA = pBuild->pDFA;
+    ULONG           cWords = pBuild->cWords,
+                    cColumns = pDFA->cColumns,
+                    cAlloc = 16,
+                    ulState,
+                    ul;
+    PULONG          paulStates,         // cAlloc sets; the ones for states 0 and 1 are unused
+                    paulCandidates;     // positions that can come next
+    APIRET          arc = NO_ERROR;
+
+    paulStates = (PULONG)malloc((cAlloc + 2) * cWords * sizeof(ULONG));
+    pDFA->pafAccepting = (PBYTE)malloc(cAlloc);
+    pDFA->pausNext = (PUSHORT)malloc(cAlloc * cColumns * sizeof(USHORT));
+    if (    (!paulStates)
+         || (!pDFA->pafAccepting)
+         || (!pDFA->pausNext)
+       )
+        arc = ERROR_NOT_ENOUGH_MEMORY;
+    else
+    {
+        // the last two sets are scratch space for the
+        // candidates and the next state
+        paulCandidates = paulStates + cAlloc * cWords;
+
+        memset(pDFA->pausNext, 0, 2 * cColumns * sizeof(USHORT));
+        pDFA->pafAccepting[0] = FALSE;
+        pDFA->pafAccepting[1] = fNullable;
+        pDFA->cStates = 2;
+    }
 
-    if (!(arc = xmlCreateDomNode(pParent,
-                                 DOMNODE_PROCESSING_INSTRUCTION,
-                                 pcszTarget,
-                                 0,
-                                 &pNew)))
+    for (ulState = 1;
+         (!arc) && (ulState < pDFA->cStates);
+         ++ulState)
     {
-        pNew->pstrNodeValue = xstrCreate(0);
-        xstrcpy(pNew->pstrNodeValue, pcszData, 0);
+        ULONG ulColumn;
 
-        *ppNew = pNew;
+        // from the start state, the model's first positions
+        // can come next; otherwise whatever can follow the
+        // positions in the state
+        if (ulState == 1)
+            memcpy(paulCandidates, paulFirst, cWords * sizeof(ULONG));
+        else
+        {
+            PULONG paulState = paulStates + ulState * cWords;
+            memset(paulCandidates, 0, cWords * sizeof(ULONG));
+            for (ul = 0;
+                 ul < pBuild->cPositions;
+                 ++ul)
+                if (ISPOS(paulState, ul))
+                {
+                    const ULONG *paulFollow = pBuild->paulFollow + ul * cWords;
+                    ULONG ulWord;
+                    for (ulWord = 0;
+                         ulWord < cWords;
+                         ++ulWord)
+                        paulCandidates[ulWord] |= paulFollow[ulWord];
+                }
+        }
+
+        for (ulColumn = 0;
+             (!arc) && (ulColumn < cColumns);
+             ++ulColumn)
+        {
+            PULONG  paulNext = paulCandidates + cWords;
+            BOOL    fEmpty = TRUE,
+                    fAccepting = FALSE;
+            ULONG   ulNext = 0;
+
+            memset(paulNext, 0, cWords * sizeof(ULONG));
+            for (ul = 0;
+                 ul < pBuild->cPositions;
+                 ++ul)
+                if (    (ISPOS(paulCandidates, ul))
+                     && (pBuild->paulColumns[ul] == ulColumn)
+                   )
+                {
+                    SETPOS(paulNext, ul);
+                    fEmpty = FALSE;
+                    if (ISPOS(paulLast, ul))
+                        fAccepting = TRUE;
+                }
+
+            if (!fEmpty)
+            {
+                // look for a state with the same set
+                for (ulNext = 2;
+                     ulNext < pDFA->cStates;
+                     ++ulNext)
+                    if (!memcmp(paulStates + ulNext * cWords,
+                                paulNext,
+                                cWords * sizeof(ULONG)))
+                        break;
+
+                if (ulNext == pDFA->cStates)
+                {
+                    // new state
+                    if (ulNext == CM_MAX_DFA_STATES)
+                        arc = ERROR_BUFFER_OVERFLOW;
+                    else
+                    {
+                        if (ulNext == cAlloc)
+                        {
+                            PULONG  paulNewStates;
+                            PBYTE   pafNewAccepting;
+                            PUSHORT pausNewNext;
+
+                            cAlloc *= 2;
+                            if (paulNewStates = (PULONG)realloc(paulStates,
+                                                                (cAlloc + 2) * cWords * sizeof(ULONG)))
+                                paulStates = paulNewStates;
+                            if (pafNewAccepting = (PBYTE)realloc(pDFA->pafAccepting,
+                                                                 cAlloc))
+                                pDFA->pafAccepting = pafNewAccepting;
+                            if (pausNewNext = (PUSHORT)realloc(pDFA->pausNext,
+                                                               cAlloc * cColumns * sizeof(USHORT)))
+                                pDFA->pausNext = pausNewNext;
+
+                            if (    (!paulNewStates)
+                                 || (!pafNewAccepting)
+                                 || (!pausNewNext)
+                               )
+                            {
+                                arc = ERROR_NOT_ENOUGH_MEMORY;
+                                break;
+                            }
+
+                            // the scratch sets have moved
+                            memcpy(paulStates + cAlloc * cWords,
+                                   paulStates + (cAlloc / 2) * cWords,
+                                   2 * cWords * sizeof(ULONG));
+                            paulCandidates = paulStates + cAlloc * cWords;
+                            paulNext = paulCandidates + cWords;
+                        }
+
+                        memcpy(paulStates + ulNext * cWords,
+                               paulNext,
+                               cWords * sizeof(ULONG));
+                        pDFA->pafAccepting[ulNext] = fAccepting;
+                        memset(pDFA->pausNext + ulNext * cColumns,
+                               0,
+                               cColumns * sizeof(USHORT));
+                        pDFA->cStates++;
+                    }
+                }
+            }
+
+            pDFA->pausNext[ulState * cColumns + ulColumn] = (USHORT)ulNext;
+        }
     }
 
+    if (paulStates)
+        free(paulStates);
+
     return arc;
 }
 
 /*
- *@@ xmlCreateDocumentTypeNode:
- *      creates a new document type node with the
- *      specified data.
+ *@@ CompileContentModel:
+ *      compiles the content model of a CHOICE or SEQ
+ *      element declaration into a CMCONTENTDFA.
  *
- *@@added V0.9.9 (2001-02-14) [umoeller]
+ *      If the model needs too many states, *ppDFA is
+ *      set to NULL, and ValidateElement falls back to
+ *      checking only whether a child may appear at all.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
  */
 
-APIRET xmlCreateDocumentTypeNode(PDOMDOCUMENTNODE pDocumentNode,            // in: document node
-                                 const char *pcszDoctypeName,
-                                 const char *pcszSysid,
-                                 const char *pcszPubid,
-                                 int fHasInternalSubset,
-                                 PDOMDOCTYPENODE *ppNew)
+STATIC APIRET CompileContentModel(PCMELEMENTDECLNODE pDecl,
+                                  PCMCONTENTDFA *ppDFA)
 {
-    APIRET arc = NO_ERROR;
-
-    if (pDocumentNode->pDocType)
-        // we already have a doctype:
-        arc = ERROR_DOM_DUPLICATE_DOCTYPE;
+    APIRET      arc = NO_ERROR;
+    DFABUILD    Build;
+    PULONG      paulFirst = NULL;
+    BOOL        fNullable;
+
+    *ppDFA = NULL;
+
+    memset(&Build, 0, sizeof(Build));
+    Build.cPositions = CountPositions(&pDecl->Particle);
+    Build.cWords = (Build.cPositions + 31) / 32;
+    if (!Build.cWords)
+        Build.cWords = 1;
+
+    if (    (!(Build.pDFA = (PCMCONTENTDFA)malloc(sizeof(CMCONTENTDFA))))
+         || (!(Build.paulColumns = (PULONG)malloc((Build.cPositions + 1) * sizeof(ULONG))))
+         || (!(Build.paulFollow = (PULONG)calloc(Build.cPositions + 1,
+                                                 Build.cWords * sizeof(ULONG))))
+         || (!(paulFirst = (PULONG)malloc(2 * Build.cWords * sizeof(ULONG))))
+       )
+        arc = ERROR_NOT_ENOUGH_MEMORY;
     else
     {
-        // create doctype node
-        PDOMDOCTYPENODE pNew = NULL;
-        if (!(arc = xmlCreateDomNode((PDOMNODE)pDocumentNode,
-                                     DOMNODE_DOCUMENT_TYPE,
-                                     pcszDoctypeName,
-                                     0,
-                                     (PDOMNODE*)&pNew)))
+        memset(Build.pDFA, 0, sizeof(CMCONTENTDFA));
+        smapInit(&Build.pDFA->NamesMap);
+
+        if (    (!(arc = AnalyzeParticle(&Build,
+                                         &pDecl->Particle,
+                                         paulFirst,
+                                         paulFirst + Build.cWords,
+                                         &fNullable)))
+             && (!(arc = BuildStates(&Build,
+                                     paulFirst,
+                                     paulFirst + Build.cWords,
+                                     fNullable)))
+           )
         {
-            // the node has already been added to the children
-            // list of the document node... in addition, set
-            // the doctype field in the document
-            pDocumentNode->pDocType = pNew;
-
-            // initialize the extra fields
-            xstrcpy(&pNew->strPublicID, pcszPubid, 0);
-            xstrcpy(&pNew->strSystemID, pcszSysid, 0);
-            pNew->fHasInternalSubset = fHasInternalSubset;
-
-            treeInit(&pNew->ElementDeclsTree, NULL);
-            treeInit(&pNew->AttribDeclBasesTree, NULL);
-
-            *ppNew = pNew;
+            *ppDFA = Build.pDFA;
+            Build.pDFA = NULL;
         }
+        else if (arc == ERROR_BUFFER_OVERFLOW)
+            // too large: do without
+            arc = NO_ERROR;
     }
+
+    FreeContentDFA(Build.pDFA);
+    if (Build.paulColumns)
+        free(Build.paulColumns);
+    if (Build.paulFollow)
+        free(Build.paulFollow);
+    if (paulFirst)
+        free(paulFirst);
+
     return arc;
 }
 
 /* ******************************************************************
  *
- *   DOM level 3 content models
+ *   Most basic node management
  *
  ********************************************************************/
 
 /*
- *@@ SetupParticleAndSubs:
+ *@@ CompareXStrings:
+ *      tree comparison func for NodeBases.
+ *      This works for all trees which contain structures
+ *      whose first item is a _NODEBASE because NODEBASE's first
+ *      member is a TREE.
  *
- *      This creates sub-particles and recurses to set them up,
- *      if necessary.
+ *      Used for example to insert _CMELEMENTPARTICLE nodes
+ *      into _CMELEMENTDECLNODE.ParticleNamesTree. The DTD
+ *      declarations use STRMAP hash maps instead since
+ *      V1.0.24; see FindDecl.
+ *
+ *      Interned names (see DOMSYMBOL) are equal if they
+ *      are the same pointer, which is checked first.
  *
  *@@added V0.9.9 (2001-02-16) [umoeller]
+ *@@changed V0.9.14 (2001-08-09) [umoeller]: fixed map bug which caused the whole XML stuff to fail
+ *@@changed V1.0.24 (2026-10-18) [agent]: added pointer compare for interned names
  */
 
-STATIC APIRET SetupParticleAndSubs(PCMELEMENTPARTICLE pParticle,
-                                   PXMLCONTENT pModel,
-                                   TREE **ppElementNamesTree) // in: ptr to _CMELEMENTDECLNODE.ElementNamesTree
-                                                              // (passed to all recursions)
+STATIC int TREEENTRY CompareXStrings(ULONG ul1,
+                                     ULONG ul2)
 {
-    APIRET arc = NO_ERROR;
+    if (((PXSTRING)ul1)->psz == ((PXSTRING)ul2)->psz)
+        return 0;
 
-    // set up member NODEBASE
-    switch (pModel->type)
-    {
-        case XML_CTYPE_EMPTY: // that's easy
-            pParticle->NodeBase.ulNodeType = ELEMENTPARTICLE_EMPTY;
-        break;
+    return strhcmp(((PXSTRING)ul1)->psz,
+                   ((PXSTRING)ul2)->psz);
+}
 
-        case XML_CTYPE_ANY:   // that's easy
-            pParticle->NodeBase.ulNodeType = ELEMENTPARTICLE_ANY;
-        break;
+/*
+ *@@ FindDecl:
+ *      looks up a NODEBASE by name in one of the declaration
+ *      hash maps (_DOMDOCTYPENODE.ElementDeclsMap,
+ *      _DOMDOCTYPENODE.AttribDeclBasesMap,
+ *      _CMATTRIBUTEDECLBASE.AttribDeclsMap).
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
 
-        case XML_CTYPE_NAME:   // that's easy
-            pParticle->NodeBase.ulNodeType = ELEMENTPARTICLE_NAME;
-            xstrcpy(&pParticle->NodeBase.strNodeName, pModel->name, 0);
-            treeInsert(ppElementNamesTree,
-                       NULL,
-                       &pParticle->NodeBase.Tree,
-                       CompareXStrings);
-        break;
+STATIC PNODEBASE FindDecl(const STRMAP *pMap,
+                          const XSTRING *pcstrName)
+{
+    return (PNODEBASE)smapFindHash(pMap,
+                                   pcstrName->psz,
+                                   pcstrName->ulLength,
+                                   smapHash(pcstrName->psz,
+                                            pcstrName->ulLength));
+}
 
-        case XML_CTYPE_MIXED:
-            pParticle->NodeBase.ulNodeType = ELEMENTPARTICLE_MIXED;
-        break;
+/*
+ *@@ InsertDecl:
+ *      adds a NODEBASE to one of the declaration hash maps,
+ *      keyed by its strNodeName. Returns SMAP_DUPLICATE_KEY
+ *      if a declaration with the same name exists or
+ *      SMAP_NO_MEMORY if the map could not grow.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
 
-        case XML_CTYPE_CHOICE:
-            pParticle->NodeBase.ulNodeType = ELEMENTPARTICLE_CHOICE;
-        break;
+STATIC int InsertDecl(PSTRMAP pMap,
+                      PNODEBASE pNode)
+{
+    return smapInsertHash(pMap,
+                          pNode->strNodeName.psz,
+                          pNode->strNodeName.ulLength,
+                          smapHash(pNode->strNodeName.psz,
+                                   pNode->strNodeName.ulLength),
+                          pNode);
+}
 
-        case XML_CTYPE_SEQ:
-            pParticle->NodeBase.ulNodeType = ELEMENTPARTICLE_SEQ;
-        break;
-    }
+/*
+ *@@ CreateNodeBase:
+ *      implementation for xmlCreateNodeBase. If pArena is
+ *      specified, the node and its name are allocated from
+ *      it.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
 
-    pParticle->ulRepeater = pModel->quant;
+STATIC APIRET CreateNodeBase(PDOMARENA pArena,            // in: arena or NULL for heap
+                             NODEBASETYPE ulNodeType,     // in: node type
+                             ULONG cb,                    // in: size of struct
+                             const char *pcszNodeName,    // in: node name or NULL
+                             ULONG ulNodeNameLength,      // in: node name length
+                                                          // or 0 to run strlen(pcszNodeName)
+                             PNODEBASE *ppNew)            // out: new node
+{
+    PNODEBASE   pNewNode;
 
-    if (pModel->numchildren)
+    if (pArena)
     {
-        // these are the three cases where we have subnodes
-        // in the XMLCONTENT... go for these and recurse
-        ULONG ul;
-        pParticle->pllSubNodes = lstCreate(FALSE);
-        for (ul = 0;
-             ul < pModel->numchildren;
-             ul++)
-        {
-            PXMLCONTENT pSubModel = &pModel->children[ul];
-            PCMELEMENTPARTICLE pSubNew = NULL;
-            if (!(arc = xmlCreateNodeBase(TYPE_UNKNOWN, //       node type... for now
-                                          sizeof(CMELEMENTPARTICLE),
-                                          0,
-                                          0,
-                                          (PNODEBASE*)&pSubNew)))
-            {
-                if (!(arc = SetupParticleAndSubs(pSubNew,
-                                                 pSubModel,
-                                                 ppElementNamesTree)))
-                {
-                    // no error: append sub-particle to this particle's
-                    // children list
-                    lstAppendItem(pParticle->pllSubNodes,
-                                  pSubNew);
-                    // and store this particle as the parent in the
-                    // sub-particle
-                    pSubNew->pParentParticle = pParticle;
-                }
-            }
+        if (!(pNewNode = (PNODEBASE)ArenaAlloc(pArena, cb)))
+            return ERROR_NOT_ENOUGH_MEMORY;
 
-            if (arc)
-                break;
+        memset(pNewNode, 0, cb);
+
+        if (    (pcszNodeName)
+             && (ArenaSetString(pArena,
+                                &pNewNode->strNodeName,
+                                pcszNodeName,
+                                ulNodeNameLength))
+           )
+            return ERROR_NOT_ENOUGH_MEMORY;
+    }
+    else
+    {
+        if (!(pNewNode = (PNODEBASE)malloc(cb)))
+            return ERROR_NOT_ENOUGH_MEMORY;
+
+        memset(pNewNode, 0, cb);
+
+        xstrInit(&pNewNode->strNodeName, 0);
+        if (pcszNodeName)
+        {
+            xstrcpy(&pNewNode->strNodeName,
+                    pcszNodeName,
+                    ulNodeNameLength);
         }
     }
 
-    return arc;
+    pNewNode->ulNodeType = ulNodeType;
+    pNewNode->Tree.ulKey = (ULONG)&pNewNode->strNodeName;
+
+    *ppNew = pNewNode;
+
+    return NO_ERROR;
 }
 
 /*
- *@@ xmlCreateElementDecl:
- *      creates a new _CMELEMENTDECLNODE for the specified
- *      _XMLCONTENT content model (which is the @expat structure).
- *      This recurses, if necessary.
+ *@@ xmlCreateNodeBase:
+ *      creates a new NODEBASE node.
  *
- *      NOTE: As opposed to the other "create" functions,
- *      this does not take a parent node as input. If this
- *      returns NO_ERROR, it is the caller's responsibility
- *      to add the produced node to the document's DOCTYPE node.
+ *      Gets called from xmlCreateDomNode also to create
+ *      a DOMNODE, since that in turn has a NODEBASE.
  *
  *@@added V0.9.9 (2001-02-16) [umoeller]
  */
 
-APIRET xmlCreateElementDecl(const char *pcszName,
-                            PXMLCONTENT pModel,
-                            PCMELEMENTDECLNODE *ppNew)
+APIRET xmlCreateNodeBase(NODEBASETYPE ulNodeType,     // in: node type
+                         ULONG cb,                    // in: size of struct
+                         const char *pcszNodeName,    // in: node name or NULL
+                         ULONG ulNodeNameLength,      // in: node name length
+                                                      // or 0 to run strlen(pcszNodeName)
+                         PNODEBASE *ppNew)            // out: new node
 {
-    APIRET arc = NO_ERROR;
-    PCMELEMENTDECLNODE pNew = NULL;
+    return CreateNodeBase(NULL,
+                          ulNodeType,
+                          cb,
+                          pcszNodeName,
+                          ulNodeNameLength,
+                          ppNew);
+}
 
-    if (!(arc = xmlCreateNodeBase(TYPE_UNKNOWN,      // for now
-                                  sizeof(CMELEMENTDECLNODE),
-                                  pcszName,
-                                  0,
-                                  (PNODEBASE*)&pNew)))
+/*
+ *@@ UnlinkDomNode:
+ *      removes pDomNode from its parent's attributes map
+ *      or children, if it has a parent. For elements, this
+ *      drops the document's name index.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+STATIC VOID UnlinkDomNode(PDOMNODE pDomNode)
+{
+    PDOMNODE pParent;
+
+    if (pParent = pDomNode->pParentNode)
     {
-        treeInit(&pNew->ParticleNamesTree, NULL);
+        if (    (pDomNode->NodeBase.ulNodeType == DOMNODE_ELEMENT)
+             && (pDomNode->pDocumentNode)
+           )
+            // element goes away: the name index would be wrong
+            FreeNameIndex((PDOMDOCUMENTNODE)pDomNode->pDocumentNode);
 
-        // set up the "particle" member and recurse into sub-particles
-        if (!(arc = SetupParticleAndSubs(&pNew->Particle,
-                                         pModel,
-                                         &pNew->ParticleNamesTree)))
-            *ppNew = pNew;
+        if (pDomNode->NodeBase.ulNodeType == DOMNODE_ATTRIBUTE)
+            // this is an attribute:
+            // remove from parent's attributes map
+            treeDelete(&pParent->AttributesMap,
+                       NULL,
+                       (TREE*)pDomNode);
         else
-            free(pNew);
-    }
+        {
+            // remove this node from the parent's
+            // chain of child nodes
+            PDOMNODE *ppThis = &pParent->pFirstChild,
+                     pPrev = NULL;
+            while (*ppThis)
+            {
+                if (*ppThis == pDomNode)
+                {
+                    *ppThis = pDomNode->pNextSibling;
+                    if (pParent->pLastChild == pDomNode)
+                        pParent->pLastChild = pPrev;
+                    break;
+                }
 
-    return arc;
+                pPrev = *ppThis;
+                ppThis = &pPrev->pNextSibling;
+            }
+
+            pDomNode->pNextSibling = NULL;
+        }
+
+        pDomNode->pParentNode = NULL;
+    }
 }
 
 /*
- *@@ ValidateElementChildren
- *      validates the specified element against the document's @DTD,
- *      more specifically, against the element declaration of the
- *      new element's parent.
- *
- *      This sets arcDOM in XMLDOM on errors.
- *
- *      According to the XML spec, an element is valid if there
- *      is a declaration matching the element declaration where the
- *      element's name matches the element type, and _one_ of the
- *      following holds:
- *
- *      (1) The declaration matches EMPTY and the element has no @content. (done)
- *
- *      (2) The declaration matches (children) (see @element_declaration)
- *          and the sequence of child elements belongs to the language
- *          generated by the regular expression in the content model, with
- *          optional @white_space between the start-tag and the first child
- *          element, between child elements, or between the last
- *          child element and the end-tag. Note that a CDATA section
- *          is never considered "whitespace", even if it contains
- *          white space only. @@todo
+ *@@ xmlDeleteNode:
+ *      deletes a NODEBASE and frees memory that was
+ *      associated with its members.
  *
- *      (3) The declaration matches (mixed) (see @element_declaration)
- *          and the content consists of @content and child elements
- *          whose types match names in the content model. (done)
+ *      After calling this, pNode is no longer valid.
  *
- *      (4) The declaration matches ANY, and the types of any child
- *          elements have been declared. (done)
+ *      If you invoke this on a DOCUMENT node, the
+ *      entire DOM tree will get deleted recursively.
  *
- *      Preconditions: The element must already have been inserted
- *      into the parent element's list, or we cannot validate sequences.
+ *      With a DOM that was parsed with DF_ARENA, deleting
+ *      a node other than the DOCUMENT or DOCTYPE only unlinks
+ *      it from its parent; its memory is reclaimed with the
+ *      document's arena. Deleting the DOCUMENT then frees
+ *      the arena in one go instead of visiting every node.
  *
  *@@added V0.9.9 (2001-02-16) [umoeller]
+ *@@changed V0.9.14 (2001-08-09) [umoeller]: fixed crash on string delete
+ *@@changed V1.0.24 (2026-10-18) [agent]: DTD declarations are now in STRMAP hash maps
+ *@@changed V1.0.24 (2026-10-18) [agent]: added DF_ARENA support
+ *@@changed V1.0.24 (2026-10-18) [agent]: added symbol table
+ *@@changed V1.0.24 (2026-10-18) [agent]: now freeing content model automata
  */
 
-STATIC VOID ValidateElement(PXMLDOM pDom,
-                            PDOMNODE pNewElement,     // in: new element
-                            PCMELEMENTDECLNODE pParentElementDecl)
-                                                      // in: element decl of element's parent
+VOID xmlDeleteNode(PNODEBASE pNode)
 {
-    if (pDom && pNewElement)
+    if (pNode)
     {
-        if (!pParentElementDecl)
+        PDOMNODE    pDomNode = NULL;
+        PDOMARENA   pArena = NULL;
+
+        LINKLIST    llDeleteNodes;          // list that nodes to be deleted
+                                            // can be appended to
+        PLISTNODE   pDelNode;
+        lstInit(&llDeleteNodes, FALSE);
+
+        // now handle special types and their allocations
+        switch (pNode->ulNodeType)
         {
-            // this is always missing for the root element, of course,
-            // because the parent is the document
-            if (pNewElement->pParentNode == (PDOMNODE)pDom->pDocumentNode)
-                return;     // that's OK
-            else
-                xmlSetError(pDom,
-                            ERROR_DOM_VALIDATE_INVALID_ELEMENT,
-                            pNewElement->NodeBase.strNodeName.psz,
-                            TRUE);
+            case DOMNODE_ELEMENT:
+            case DOMNODE_ATTRIBUTE:
+            case DOMNODE_TEXT:
+            case DOMNODE_PROCESSING_INSTRUCTION:
+            case DOMNODE_COMMENT:
+                if (GetArena((PDOMNODE)pNode))
+                {
+                    // the node and everything below it is in
+                    // the document's arena: just unlink it
+                    UnlinkDomNode((PDOMNODE)pNode);
+                    return;
+                }
+            break;
         }
-        else
-        {
-            ULONG ulDeclType = pParentElementDecl->Particle.NodeBase.ulNodeType;
 
-            switch (ulDeclType)
-            {
-                case ELEMENTPARTICLE_EMPTY:
-                    // this is an error for sure
-                    xmlSetError(pDom,
-                                ERROR_DOM_SUBELEMENT_IN_EMPTY_ELEMENT,
-                                pNewElement->NodeBase.strNodeName.psz,
-                                TRUE);
-                break;
+        switch (pNode->ulNodeType)
+        {
+            case DOMNODE_ELEMENT:
+            {
+                PDOMNODE pAttrib;
 
-                case ELEMENTPARTICLE_ANY:
-                    // that's always OK
-                break;
+                pDomNode = (PDOMNODE)pNode;
 
-                case ELEMENTPARTICLE_MIXED:
-                case ELEMENTPARTICLE_CHOICE:
-                case ELEMENTPARTICLE_SEQ:
+                // delete all attribute nodes
+                pAttrib = (PDOMNODE)treeFirst(pDomNode->AttributesMap);
+                while (pAttrib)
                 {
-                    PXSTRING pstrNewElementName
-                        = &pNewElement->NodeBase.strNodeName;
+                    // call delete recursively
+                    PDOMNODE pNext = (PDOMNODE)treeNext((TREE*)pAttrib);
+                    xmlDeleteNode((PNODEBASE)pAttrib);
+                            // this will remove pAttrib from pNode's attrib
+                            // tree and rebalance the tree
+                    pAttrib = pNext;
+                }
+            break; }
 
-                    // for all these, we first need to check if
-                    // the element is allowed at all
-                    PCMELEMENTPARTICLE pParticle
-                        = (PCMELEMENTPARTICLE)treeFind(
-                                         pParentElementDecl->ParticleNamesTree,
-                                         (ULONG)pstrNewElementName,
-                                         CompareXStrings);
-                    if (!pParticle)
-                        // not found: then this element is not allowed within this
-                        // parent
-                        xmlSetError(pDom,
-                                    ERROR_DOM_INVALID_SUBELEMENT,
-                                    pstrNewElementName->psz,
-                                    TRUE);
-                    else
-                    {
-                        // the element is allowed at all: now check for the
-                        // lists case... @@todo
-                        switch (ulDeclType)
-                        {
-                            case ELEMENTPARTICLE_CHOICE:
-                            break;
+            case DOMNODE_ATTRIBUTE:
+            case DOMNODE_TEXT:
+            case DOMNODE_PROCESSING_INSTRUCTION:
+            case DOMNODE_COMMENT:
+                pDomNode = (PDOMNODE)pNode;
+            break;
 
-                            case ELEMENTPARTICLE_SEQ:
-                            break;
-                        }
-                    }
+            case DOMNODE_DOCUMENT:
+                if (((PDOMDOCUMENTNODE)pNode)->pDocType)
+                    xmlDeleteNode((PNODEBASE)((PDOMDOCUMENTNODE)pNode)->pDocType);
+                pDomNode = (PDOMNODE)pNode;
+                pArena = ((PDOMDOCUMENTNODE)pNode)->pArena;
+            break;
 
-                break; }
-            }
-        }
-    }
-    else
-        pDom->arcDOM = ERROR_INVALID_PARAMETER;
+            case DOMNODE_DOCUMENT_TYPE:
+            {
+                PDOMDOCTYPENODE pDocType = (PDOMDOCTYPENODE)pNode;
+                PSTRMAPSLOT pSlot;
+                ULONG ul;
 
-    // yes: get the element decl from the tree
-    /* PCMELEMENTDECLNODE pElementDecl = xmlFindElementDecl(pDom,
-                                                         &pElement->NodeBase.strNodeName);
-    if (!pElementDecl)
-    {
-        xmlSetError(pDom,
-                    ERROR_DOM_UNDECLARED_ELEMENT,
-                    pElement->NodeBase.strNodeName.psz,
-                    TRUE);
-    }
-    else
-    {
-        // element has been declared:
-        // check if it may appear in this element's parent...
-        PDOMNODE pParentElement = pElement->pParentNode;
+                pDomNode = (PDOMNODE)pNode;
 
-        if (!pParentElement)
-            pDom->arcDOM = ERROR_DOM_INTEGRITY;
-        else switch (pParentElement->NodeBase.ulNodeType)
-        {
-            case DOMNODE_DOCUMENT:
-            {
-                // if this is the root element, compare its name
-                // to the DOCTYPE name
-                if (pParentElement != (PDOMNODE)pDom->pDocumentNode)
-                    xmlSetError(pDom,
-                                ERROR_DOM_INVALID_ROOT_ELEMENT,
-                                pElement->NodeBase.strNodeName.psz,
-                                TRUE);
-                else if (strcmp(pDom->pDocumentNode->DomNode.NodeBase.strNodeName.psz,
-                                pElement->NodeBase.strNodeName.psz))
-                    // no match:
-                    xmlSetError(pDom,
-                                ERROR_DOM_ROOT_ELEMENT_MISNAMED,
-                                pElement->NodeBase.strNodeName.psz,
-                                TRUE);
+                // the symbols must forget the declarations
+                if (pDomNode->pDocumentNode)
+                    ClearSymbolDecls((PDOMDOCUMENTNODE)pDomNode->pDocumentNode);
+
+                ul = 0;
+                while (pSlot = smapEnum(&pDocType->ElementDeclsMap, &ul))
+                    lstAppendItem(&llDeleteNodes, pSlot->pvData);
+
+                ul = 0;
+                while (pSlot = smapEnum(&pDocType->AttribDeclBasesMap, &ul))
+                    lstAppendItem(&llDeleteNodes, pSlot->pvData);
+
+                // the nodes are deleted below, which frees the
+                // key strings, so we can't use the maps after that
+                smapClear(&pDocType->ElementDeclsMap);
+                smapClear(&pDocType->AttribDeclBasesMap);
+
+                xstrClear(&pDocType->strPublicID);
+                xstrClear(&pDocType->strSystemID);
             break; }
 
-            case DOMNODE_ELEMENT:
+            case ELEMENTPARTICLE_EMPTY:
+            case ELEMENTPARTICLE_ANY:
+            case ELEMENTPARTICLE_MIXED:
+            case ELEMENTPARTICLE_CHOICE:
+            case ELEMENTPARTICLE_SEQ:
+            case ELEMENTPARTICLE_NAME:
             {
-                // parent of element is another element:
-                // check the parent in the DTD and find out if
-                // this element may appear in the parent element
-                PCMELEMENTDECLNODE pParentElementDecl
-                        = xmlFindElementDecl(pDom,
-                                             &pParentElement->NodeBase.strNodeName);
-                if (!pParentElementDecl)
-                    pDom->arcDOM = ERROR_DOM_INTEGRITY;
-                else
+                PCMELEMENTPARTICLE pp = (PCMELEMENTPARTICLE)pNode;
+
+                // the root particle is the element declaration
+                if (    (!pp->pParentParticle)
+                     && (    (pNode->ulNodeType == ELEMENTPARTICLE_CHOICE)
+                          || (pNode->ulNodeType == ELEMENTPARTICLE_SEQ)
+                        )
+                   )
+                    FreeContentDFA(((PCMELEMENTDECLNODE)pp)->pDFA);
+
+                if (pp->pllSubNodes)
                 {
-                    // now check the element names tree of the parent element decl
-                    // for whether this element is allowed as a sub-element at all
-                    PCMELEMENTPARTICLE pParticle
-                        = treeFindEQData(&pParentElementDecl->ParticleNamesTree,
-                                         (void*)pElement->NodeBase.strNodeName.psz,
-                                         CompareNodeBaseData);
-                    if (!pParticle)
-                        // not found: then this element is not allowed within this
-                        // parent
-                        xmlSetError(pDom,
-                                    ERROR_DOM_INVALID_SUBELEMENT,
-                                    pElement->NodeBase.strNodeName.psz,
-                                    TRUE);
+                    pDelNode = lstQueryFirstNode(pp->pllSubNodes);
+                    while (pDelNode)
+                    {
+                        PCMELEMENTPARTICLE
+                                pParticle = (PCMELEMENTPARTICLE)pDelNode->pItemData;
+                        xmlDeleteNode((PNODEBASE)pParticle);
+                        //  treeDelete(pp->         // @@todo
+                        pDelNode = pDelNode->pNext;
+                    }
                 }
             break; }
-        }
-    }
-    */
-}
-
-/*
- *@@ ValidateAttributeType:
- *      validates the specified attribute's type against the
- *      document's @DTD.
- *
- *      This sets arcDOM in XMLDOM on errors.
- *
- *@@added V0.9.9 (2001-02-16) [umoeller]
- */
 
-STATIC VOID ValidateAttributeType(PXMLDOM pDom,
-                                  PDOMNODE pAttrib,
-                                  PCMATTRIBUTEDECLBASE *ppAttribDeclBase)
-{
-    PDOMNODE pElement = pAttrib->pParentNode;
+            // case ATTRIBUTE_DECLARATION_ENUM:     // this is a plain NODEBASE
 
-    PCMATTRIBUTEDECL pAttribDecl = xmlFindAttribDecl(pDom,
-                                                     &pElement->NodeBase.strNodeName,
-                                                     &pAttrib->NodeBase.strNodeName,
-                                                     ppAttribDeclBase);
-    if (!pAttribDecl)
-        xmlSetError(pDom,
-                    ERROR_DOM_UNDECLARED_ATTRIBUTE,
-                    pAttrib->NodeBase.strNodeName.psz,
-                    TRUE);
-    else
-    {
-        // check if the attribute value is allowed
-        switch (pAttribDecl->ulAttrType)
-        {
-            case CMAT_CDATA:
-            case CMAT_ID:
-            case CMAT_IDREF:
-            case CMAT_IDREFS:       // ###
-            case CMAT_ENTITY:
-            case CMAT_ENTITIES:
-            case CMAT_NMTOKEN:
-            case CMAT_NMTOKENS:
-            break;
+            case ATTRIBUTE_DECLARATION:
+            {
+                // PCMATTRIBUTEDECL pDecl = (PCMATTRIBUTEDECL)pNode;
+            break; }
 
-            case CMAT_ENUM:
+            case ATTRIBUTE_DECLARATION_BASE:
             {
-                // enumeration: then check if it has one of the
-                // allowed values
-                PNODEBASE pValue = (PNODEBASE)treeFind(
-                                                pAttribDecl->ValuesTree,
-                                                (ULONG)pAttrib->pstrNodeValue,
-                                                CompareXStrings);
-                if (!pValue)
-                    xmlSetError(pDom,
-                                ERROR_DOM_INVALID_ATTRIB_VALUE,
-                                pAttrib->NodeBase.strNodeName.psz,
-                                TRUE);
-            }
+                PCMATTRIBUTEDECLBASE pBase = (PCMATTRIBUTEDECLBASE)pNode;
+                PSTRMAPSLOT pSlot;
+                ULONG ul = 0;
+                while (pSlot = smapEnum(&pBase->AttribDeclsMap, &ul))
+                    lstAppendItem(&llDeleteNodes, pSlot->pvData);
+
+                smapClear(&pBase->AttribDeclsMap);
+            break; }
         }
 
-        if (pAttribDecl->ulConstraint == CMAT_FIXED_VALUE)
-            if (strcmp(pAttrib->pstrNodeValue->psz, pAttribDecl->pstrDefaultValue->psz))
-                // fixed value doesn't match:
-                xmlSetError(pDom,
-                            ERROR_DOM_INVALID_ATTRIB_VALUE,
-                            pAttrib->NodeBase.strNodeName.psz,
-                            TRUE);
-    }
-}
+        if (pDomNode)
+        {
+            if (!pArena)
+                // recurse into child nodes
+                while (pDomNode->pFirstChild)
+                    // recurse!!
+                    xmlDeleteNode((PNODEBASE)pDomNode->pFirstChild);
+                            // this updates pFirstChild
 
-/*
- *@@ ValidateAllAttributes:
- *      validates the constraints of all attributes of the specified
- *      element against the document's @DTD.
- *
- *@@added V0.9.9 (2001-02-16) [umoeller]
- */
+            if (pNode->ulNodeType == DOMNODE_DOCUMENT)
+                FreeSymbols((PDOMDOCUMENTNODE)pNode);
 
-STATIC VOID ValidateAllAttributes(PXMLDOM pDom,
-                                  PCMATTRIBUTEDECLBASE pAttribDeclBase,
-                                  PDOMNODE pNewElement)
-{
-    PCMATTRIBUTEDECL pDeclThis
-        = (PCMATTRIBUTEDECL)treeFirst(pAttribDeclBase->AttribDeclsTree);
+            if (pArena)
+                // DF_ARENA document: this frees all
+                // nodes but the doctype, which is gone already
+                ArenaFree(pArena);
 
-    while ((pDeclThis) && (!pDom->arcDOM))
-    {
-        // if attribute is all optional: then we don't need
-        // to check for whether it's here
-        if (    (pDeclThis->ulConstraint != CMAT_IMPLIED)
-             && (pDeclThis->ulConstraint != CMAT_DEFAULT_VALUE)
-                    // we don't have to check this case because expat
-                    // already adds default attributes for us
-           )
-        {
-            // for all others , we need to find the attribute
-            PXSTRING pstrAttrNameThis = &pDeclThis->NodeBase.strNodeName;
-            PDOMNODE pAttrNode = (PDOMNODE)treeFind(
-                                            pNewElement->AttributesMap,
-                                            (ULONG)pstrAttrNameThis,
-                                            CompareXStrings);
+            // remove this node from the parent's children
+            // or attributes before deleting this node
+            UnlinkDomNode(pDomNode);
 
-            // now switch again
-            switch (pDeclThis->ulConstraint)
-            {
-                case CMAT_REQUIRED:
-                    if (!pAttrNode)
-                        // required, but no attribute with this name exists:
-                        xmlSetError(pDom,
-                                    ERROR_DOM_REQUIRED_ATTRIBUTE_MISSING,
-                                    pstrAttrNameThis->psz,
-                                    TRUE);
-                break;
-            }
+            xstrFree(&pDomNode->pstrNodeValue);
+        }
+
+        pDelNode = lstQueryFirstNode(&llDeleteNodes);
+        while (pDelNode)
+        {
+            PNODEBASE pNodeBase = (PNODEBASE)pDelNode->pItemData;
+            xmlDeleteNode(pNodeBase);
+            pDelNode = pDelNode->pNext;
         }
 
-        pDeclThis = (PCMATTRIBUTEDECL)treeNext((TREE*)pDeclThis);
+        lstClear(&llDeleteNodes);
+
+        if (!IsInterned(pNode))
+            xstrClear(&pNode->strNodeName);
+        free(pNode);
     }
 }
 
-/* ******************************************************************
+/*
+ *@@ xmlCreateDomNode:
+ *      creates a new DOMNODE with the specified
+ *      type and parent. Other than that, the
+ *      node fields are zeroed.
  *
- *   Expat stack
+ *      If pParentNode is specified (which is required,
+ *      unless you are creating a document node),
+ *      its children list is automatically updated
+ *      (unless this is an attribute node, which updates
+ *      the attributes map).
  *
- ********************************************************************/
-
-/*
- *@@ DOMSTACKITEM:
+ *      This returns the following errors:
  *
- *@@added V0.9.9 (2001-02-16) [umoeller]
+ *      --  ERROR_NOT_ENOUGH_MEMORY
+ *
+ *      --  ERROR_DOM_NOT_SUPPORTED: invalid ulNodeType
+ *          specified.
+ *
+ *      --  ERROR_DOM_WRONG_DOCUMENT: cannot find the
+ *          document for this node. This happens if you do
+ *          not have a document node at the root of your tree.
+ *
+ *      If the document was parsed with DF_ARENA, the new node
+ *      is allocated from its arena, unless it is a DOCTYPE.
+ *
+ *      Except for DOCUMENT and DOCTYPE nodes, the new node's
+ *      name is not copied but points into the document's
+ *      symbol table (see DOMSYMBOL), so it must not be
+ *      modified or freed.
+ *
+ *@@changed V1.0.24 (2026-10-18) [agent]: added DF_ARENA support, replaced llChildren
+ *@@changed V1.0.24 (2026-10-18) [agent]: names are now interned
+ *@@changed V1.0.24 (2026-10-18) [agent]: new elements drop the document's name index
  */
 
-typedef struct _DOMSTACKITEM
+APIRET xmlCreateDomNode(PDOMNODE pParentNode,        // in: parent node or NULL if root
+                        NODEBASETYPE ulNodeType,     // in: DOMNODE_* type
+                        const char *pcszNodeName,    // in: node name or NULL
+                        ULONG ulNodeNameLength,      // in: node name length
+                                                     // or 0 to run strlen(pcszNodeName)
+                        PDOMNODE *ppNew)             // out: new node
 {
-    PDOMNODE                pDomNode;
-    PCMELEMENTDECLNODE      pElementDecl;
+    PDOMNODE pNewNode = NULL;
+    APIRET  arc = NO_ERROR;
 
-} DOMSTACKITEM, *PDOMSTACKITEM;
+    ULONG   cb = 0;
+    PDOMDOCUMENTNODE pDocument = NULL;
+    PDOMARENA pArena = NULL;
+    PDOMSYMBOL pSymbol = NULL;
 
-/*
- *@@ PopElementStack:
- *
- *      NOTE:
- *
- *@@added V0.9.9 (2001-02-16) [umoeller]
- */
+    switch (ulNodeType)
+    {
+        case DOMNODE_DOCUMENT:
+            cb = sizeof(DOMDOCUMENTNODE);
+        break;
 
-STATIC PDOMSTACKITEM PopElementStack(PXMLDOM pDom,
-                                     PLISTNODE *ppListNode)
-{
-    PDOMSTACKITEM   pStackItem = NULL;
-    PLISTNODE       pParentLN = lstPop(&pDom->llElementStack);
+        case DOMNODE_DOCUMENT_TYPE:
+            // always on the heap, as the DTD declarations are
+            cb = sizeof(DOMDOCTYPENODE);
+        break;
 
-    if (!pParentLN)
-        pDom->arcDOM = ERROR_DOM_NO_ELEMENT;
-    else
+        default:
+            cb = sizeof(DOMNODE);
+            if (pDocument = GetDocument(pParentNode))
+            {
+                pArena = pDocument->pArena;
+
+                // the name comes from the document's symbol table
+                if (    (pcszNodeName)
+                     && (!(pSymbol = InternName(pDocument,
+                                                pcszNodeName,
+                                                ulNodeNameLength)))
+                   )
+                    return ERROR_NOT_ENOUGH_MEMORY;
+            }
+        break;
+    }
+
+    if (!(arc = CreateNodeBase(pArena,
+                               ulNodeType,
+                               cb,
+                               (pSymbol) ? NULL : pcszNodeName,
+                               ulNodeNameLength,
+                               (PNODEBASE*)&pNewNode)))
     {
-        // we have at least one node:
-        pStackItem = (PDOMSTACKITEM)pParentLN->pItemData;
+        if (pSymbol)
+        {
+            pNewNode->NodeBase.strNodeName.psz = pSymbol->szName;
+            pNewNode->NodeBase.strNodeName.ulLength = pSymbol->ulLength;
+            pNewNode->NodeBase.strNodeName.cbAllocated = pSymbol->ulLength + 1;
+        }
+        else if (ulNodeType == DOMNODE_DOCUMENT)
+            smapInit(&((PDOMDOCUMENTNODE)pNewNode)->SymbolsMap);
 
-        if (ppListNode)
-            *ppListNode = pParentLN;
+        pNewNode->pParentNode = pParentNode;
+
+        if (pParentNode)
+        {
+            // parent specified:
+            // set document pointer first...
+            // if the parent node has a document pointer,
+            // we can copy that
+            if (pParentNode->pDocumentNode)
+                pNewNode->pDocumentNode = pParentNode->pDocumentNode;
+            else
+                // parent has no document pointer: then it is probably
+                // the document itself... check
+                if (pParentNode->NodeBase.ulNodeType == DOMNODE_DOCUMENT)
+                    pNewNode->pDocumentNode = pParentNode;
+                else
+                    arc = ERROR_DOM_NO_DOCUMENT;
+
+            if (!arc)
+            {
+                // check if this is an attribute
+                if (ulNodeType == DOMNODE_ATTRIBUTE)
+                {
+                    // attribute:
+                    // add to parent's attributes list
+                    if (treeInsert(&pParentNode->AttributesMap,
+                                   NULL,
+                                   &pNewNode->NodeBase.Tree,
+                                   CompareXStrings))
+                        arc = ERROR_DOM_DUPLICATE_ATTRIBUTE;
+                                    // shouldn't happen, because expat takes care of this
+                }
+                else
+                {
+                    // append this new node to the parent's
+                    // chain of child nodes
+                    if (pParentNode->pLastChild)
+                        pParentNode->pLastChild->pNextSibling = pNewNode;
+                    else
+                        pParentNode->pFirstChild = pNewNode;
+                    pParentNode->pLastChild = pNewNode;
+
+                    // new element: the name index would be wrong
+                    if (ulNodeType == DOMNODE_ELEMENT)
+                        FreeNameIndex(pDocument);
+                }
+            }
+        }
+
+        treeInit(&pNewNode->AttributesMap, NULL);
     }
 
-    return pStackItem;
+    if (!arc)
+        *ppNew = pNewNode;
+    else
+        if (    (pNewNode)
+             && (!pArena)
+           )
+        {
+            // the node was not linked anywhere
+            if (!pSymbol)
+                xstrClear(&pNewNode->NodeBase.strNodeName);
+            free(pNewNode);
+        }
+
+    return arc;
 }
 
 /*
- *@@ PushElementStack:
- *
- *      NOTE: pDomNode will most frequently be an element
- *      node, but will also be the document for root and
- *      a DOCTYPE node while parsing the DTD.
+ *@@ SetNodeValue:
+ *      sets the value of a new ATTRIBUTE, TEXT, COMMENT
+ *      or PI node to a copy of the first cb bytes of pcsz
+ *      (or all of it if cb is 0). With DF_ARENA, both the
+ *      XSTRING and the string are allocated from the arena.
  *
- *@@added V0.9.9 (2001-02-16) [umoeller]
+ *@@added V1.0.24 (2026-10-18) [agent]
  */
 
-STATIC VOID PushElementStack(PXMLDOM pDom,
-                             PDOMNODE pDomNode)
+STATIC APIRET SetNodeValue(PDOMNODE pNode,
+                           const char *pcsz,
+                           ULONG cb)
 {
-    PDOMSTACKITEM pNew = (PDOMSTACKITEM)malloc(sizeof(*pNew));
-    if (!pNew)
-        pDom->arcDOM = ERROR_NOT_ENOUGH_MEMORY;
-    else
-    {
-        memset(pNew, 0, sizeof(*pNew));
-        pNew->pDomNode = pDomNode;
+    PDOMARENA pArena;
 
-        // shall we validate?
-        if (    (pDom->pDocTypeNode)
-             && (pDomNode->NodeBase.ulNodeType == DOMNODE_ELEMENT)
-           )
-            pNew->pElementDecl = xmlFindElementDecl(pDom,
-                                                    &pDomNode->NodeBase.strNodeName);
+    if (pArena = GetArena(pNode))
+    {
+        if (!(pNode->pstrNodeValue = (PXSTRING)ArenaAlloc(pArena, sizeof(XSTRING))))
+            return ERROR_NOT_ENOUGH_MEMORY;
 
-        lstPush(&pDom->llElementStack,
-                pNew);
+        return ArenaSetString(pArena,
+                              pNode->pstrNodeValue,
+                              pcsz,
+                              cb);
     }
+
+    if (!cb)
+        cb = strlen(pcsz);
+
+    if (!(pNode->pstrNodeValue = xstrCreate(cb + 1)))
+        return ERROR_NOT_ENOUGH_MEMORY;
+
+    xstrcpy(pNode->pstrNodeValue, pcsz, cb);
+
+    return NO_ERROR;
 }
 
 /* ******************************************************************
  *
- *   Expat handlers
+ *   Specific DOM node constructors
  *
  ********************************************************************/
 
 /*
- *@@ UnknownEncodingHandler:
- *      @expat handler called when the xml
- *      @text_declaration has an @encoding that is not
- *      one of the four encodings built into expat.
- *
- *      See XML_SetUnknownEncodingHandler.
+ *@@ xmlCreateElementNode:
+ *      creates a new element node with the specified name.
  *
- *@@added V0.9.14 (2001-08-09) [umoeller]
+ *@@added V0.9.9 (2001-02-14) [umoeller]
  */
 
-STATIC int EXPATENTRY UnknownEncodingHandler(void *pUserData,   // in: out PXMLDOM really
-                                             const XML_Char *pcszName,
-                                             XML_Encoding *pEncoding)
-{
-    PXMLDOM     pDom = (PXMLDOM)pUserData;
-
-    ULONG ulCP;
-    if (    (pDom->pfnGetCPData)            // callback exists?
-         && (!strncmp(pcszName, "cp", 2))
-         && (strlen(pcszName) > 4)              // at least five chars (e.g. "cp850")
-         && (ulCP = atoi(pcszName + 2))
-       )
-    {
-        // this is a PC codepage:
-/* typedef struct _XML_Encoding
+APIRET xmlCreateElementNode(PDOMNODE pParent,         // in: parent node (either document or element)
+                            const char *pcszElement,  // in: element name (null-terminated)
+                            PDOMNODE *ppNew)
 {
-  int           map[256];
-  void          *data;
-  int           (* EXPATENTRY convert)(void *data, const char *s);
-  void          (* EXPATENTRY release)(void *data);
-} XML_Encoding; */
-
-        // ZERO(pEncoding);
-
-        pEncoding->convert = NULL;
-        pEncoding->release = NULL;
-
-        memset(&pEncoding->map, -1, sizeof(pEncoding->map));
+    PDOMNODE pNew = NULL;
+    APIRET arc;
 
-        if (pDom->pfnGetCPData(pDom,
-                               ulCP,
-                               pEncoding->map))
-        {
-            // go check if there's any -1 chars left
-            ULONG ul;
-            for (ul = 0;
-                 ul < 256;
-                 ul++)
-            {
-                if (pEncoding->map[ul] < 0)
-                    xmlSetError(pDom,
-                                ERROR_DOM_INCOMPLETE_ENCODING_MAP,
-                                NULL,
-                                FALSE);
-            }
-            // return success
-            return 1;
-        }
-    }
+    if (!(arc = xmlCreateDomNode(pParent,
+                                 DOMNODE_ELEMENT,
+                                 pcszElement,
+                                 0,
+                                 &pNew)))
+        *ppNew = pNew;
 
-    // error
-    return 0;
+    return arc;
 }
 
 /*
- *@@ StartElementHandler:
- *      @expat handler called when a new element is
- *      found.
+ *@@ xmlCreateAttributeNode:
+ *      creates a new attribute node with the specified data.
  *
- *      We create a new record in the container and
- *      push it onto our stack so we can insert
- *      children into it. We first start with the
- *      attributes.
+ *      NOTE: Attributes have no "parent" node, technically.
+ *      They are added to a special, separate list in @DOM_ELEMENT
+ *      nodes.
+ *
+ *      This returns the following errors:
+ *
+ *      --  Error codes from xmlCreateDomNode.
+ *
+ *      --  ERROR_DOM_NO_ELEMENT: pElement is invalid or does
+ *          not point to an @DOM_ELEMENT node.
+ *
+ *@@added V0.9.9 (2001-02-14) [umoeller]
+ *@@changed V1.0.2 (2003-02-07) [umoeller]: added lenValue param
  */
 
-STATIC void EXPATENTRY StartElementHandler(void *pUserData,      // in: our PXMLDOM really
-                                           const char *pcszElement,
-                                           const char **papcszAttribs)
+APIRET xmlCreateAttributeNode(PDOMNODE pElement,        // in: element node
+                              const char *pcszName,     // in: attribute name (null-terminated)
+                              const char *pcszValue,    // in: attribute value (null-terminated)
+                              ULONG lenValue,           // in: length of value (must be specified)
+                              PDOMNODE *ppNew)
 {
-    PXMLDOM     pDom = (PXMLDOM)pUserData;
+    APIRET      arc;
+    PDOMNODE    pNew = NULL;
 
-    // continue parsing only if we had no errors so far
-    if (!pDom->arcDOM)
-    {
-        ULONG       i;
+    if (    (!pElement)
+         || (pElement->NodeBase.ulNodeType != DOMNODE_ELEMENT)
+       )
+        return ERROR_DOM_NO_ELEMENT;
 
-        PDOMSTACKITEM pSI = PopElementStack(pDom,
-                                            NULL);     // no free
-        if (!pDom->arcDOM)
-        {
-            PDOMNODE    pParent = pSI->pDomNode,
-                        pNew = NULL;
-
-            if (!(pDom->arcDOM = xmlCreateElementNode(pParent,
-                                                      pcszElement,
-                                                      &pNew)))
-                // OK, node is valid:
-                // push this on the stack so we can add child elements
-                PushElementStack(pDom,
-                                 pNew);
-
-            // shall we validate?
-            if (    (!pDom->arcDOM)
-                 && (pDom->pDocTypeNode)
-               )
-                ValidateElement(pDom,
-                                pNew,                // new element
-                                pSI->pElementDecl);  // parent's elem decl
-
-            if (!pDom->arcDOM)
-            {
-                PCMATTRIBUTEDECLBASE pAttribDeclBase = NULL;
-
-                // shall we validate?
-                if (pDom->pDocTypeNode)
-                    // yes: get attrib decl base for speed
-                    pAttribDeclBase
-                        = xmlFindAttribDeclBase(pDom,
-                                                &pNew->NodeBase.strNodeName);
-
-                // now for the attribs
-                for (i = 0;
-                     (papcszAttribs[i]) && (!pDom->arcDOM);
-                     i += 2)
-                {
-                    PDOMNODE pAttrib;
-                    PCSZ    pcszValue = papcszAttribs[i + 1];  // attr value
-                    if (!(pDom->arcDOM = xmlCreateAttributeNode(pNew,                  // element,
-                                                                papcszAttribs[i],      // attr name
-                                                                pcszValue,
-                                                                strlen(pcszValue),
-                                                                &pAttrib)))
-                    {
-                        // shall we validate?
-                        if (pDom->pDocTypeNode)
-                            ValidateAttributeType(pDom,
-                                                  pAttrib,
-                                                  &pAttribDeclBase);
-                    }
-                    else
-                    {
-                        xmlSetError(pDom,
-                                    pDom->arcDOM,
-                                    papcszAttribs[i],
-                                    FALSE);      // validation
-                        break;
-                    }
-                }
-
-                // OK, now we got all attributes:
-                // now look for defaults in the DTD,
-                // if we shall validate
-                if (    (pDom->pDocTypeNode)
-                     && (!pDom->arcDOM)
-                     && (pAttribDeclBase)
-                   )
-                    ValidateAllAttributes(pDom,
-                                          pAttribDeclBase,
-                                          pNew);
-            }
-        }
-
-        pDom->pLastWasTextNode = NULL;
+    if (!(arc = xmlCreateDomNode(pElement,          // this takes care of adding to the list
+                                 DOMNODE_ATTRIBUTE,
+                                 pcszName,
+                                 0,
+                                 &pNew)))
+    {
+        if (!(arc = SetNodeValue(pNew, pcszValue, lenValue)))
+            *ppNew = pNew;
+        else
+            xmlDeleteNode((PNODEBASE)pNew);
     }
+
+    return arc;
 }
 
 /*
- *@@ EndElementHandler:
- *      @expat handler for when parsing an element is done.
- *      We pop the element off of our stack then.
+ *@@ xmlCreateTextNode:
+ *      creates a new text node with the specified content.
+ *
+ *      Note: This differs from the createText method
+ *      as specified by DOM, which has no ulLength parameter.
+ *      We need this for speed with @expat though.
+ *
+ *@@added V0.9.9 (2001-02-14) [umoeller]
+ *@@changed V1.0.24 (2026-10-18) [agent]: added DF_ARENA support
  */
 
-STATIC void EXPATENTRY EndElementHandler(void *pUserData,      // in: our PXMLDOM really
-                                         const XML_Char *name)
+APIRET xmlCreateTextNode(PDOMNODE pParent,         // in: parent element node
+                         const char *pcszText,     // in: ptr to start of text
+                         ULONG lenText,            // in: length of *pcszText
+                         PDOMNODE *ppNew)
 {
-    PXMLDOM     pDom = (PXMLDOM)pUserData;
-    // continue parsing only if we had no errors so far
-    if (!pDom->arcDOM)
+    PDOMNODE pNew = NULL;
+    APIRET arc;
+
+    if (!(arc = xmlCreateDomNode(pParent,
+                                 DOMNODE_TEXT,
+                                 NULL,
+                                 0,
+                                 &pNew)))
     {
-        PLISTNODE pStackLN = NULL;
-        PDOMSTACKITEM pSI = PopElementStack(pDom,
-                                            &pStackLN);
+        PSZ pszNodeValue;
 
-        if (!pDom->arcDOM)
+        if (GetArena(pNew))
         {
-            // shall we validate?
-            /* if (pDom->pDocTypeNode)
-                // yes:
-                ValidateElementChildren(pDom,
-                                        pSI->pDomNode); */
+            if (!(arc = SetNodeValue(pNew, pcszText, lenText)))
+                *ppNew = pNew;
+            else
+                xmlDeleteNode((PNODEBASE)pNew);
+        }
+        else if (pszNodeValue = (PSZ)malloc(lenText + 1))
+        {
+            memcpy(pszNodeValue, pcszText, lenText);
+            pszNodeValue[lenText] = '\0';
+            pNew->pstrNodeValue = xstrCreate(0);
+            xstrset(pNew->pstrNodeValue, pszNodeValue);
 
-            lstRemoveNode(&pDom->llElementStack, pStackLN); // auto-free
+            *ppNew = pNew;
         }
         else
-            pDom->arcDOM = ERROR_DOM_INTEGRITY;
-
-        pDom->pLastWasTextNode = NULL;
+        {
+            arc = ERROR_NOT_ENOUGH_MEMORY;
+            xmlDeleteNode((PNODEBASE)pNew);
+        }
     }
+
+    return arc;
 }
 
 /*
- *@@ CharacterDataHandler:
- *      @expat handler for character data (@content).
+ *@@ xmlCreateCommentNode:
+ *      creates a new comment node with the specified
+ *      content.
  *
- *      Note: expat passes chunks of content without zero-terminating
- *      them. We must concatenate the chunks to a full text node.
+ *@@added V0.9.9 (2001-02-14) [umoeller]
  */
 
-STATIC void EXPATENTRY CharacterDataHandler(void *pUserData,      // in: our PXMLDOM really
-                                            const XML_Char *s,
-                                            int len)
+APIRET xmlCreateCommentNode(PDOMNODE pParent,         // in: parent element node
+                            const char *pcszText,     // in: comment (null-terminated)
+                            PDOMNODE *ppNew)
 {
-    PXMLDOM     pDom = (PXMLDOM)pUserData;
-
-    // continue parsing only if we had no errors so far
-    if (    (!pDom->arcDOM)
-         && (len)
-       )
+    PDOMNODE pNew = NULL;
+    APIRET arc;
+    if (!(arc = xmlCreateDomNode(pParent,
+                                 DOMNODE_COMMENT,
+                                 NULL,
+                                 0,
+                                 &pNew)))
     {
-        // we need a new text node:
-        PDOMSTACKITEM pSI = PopElementStack(pDom,
-                                            NULL);     // no free
-        if (!pDom->arcDOM)
-        {
-            PDOMNODE    pParent = pSI->pDomNode;
-                        // pNew = NULL;
-
-            BOOL fIsWhitespace = FALSE;
-
-            // shall we validate?
-            if (pDom->pDocTypeNode)
-            {
-                // yes: check if the parent element allows
-                // for content at all (must be "mixed" model)
-
-                // get the element decl from the tree
-                PCMELEMENTDECLNODE pElementDecl;
-                if (pElementDecl = pSI->pElementDecl)
-                {
-                    switch (pElementDecl->Particle.NodeBase.ulNodeType)
-                    {
-                        case ELEMENTPARTICLE_ANY:
-                        case ELEMENTPARTICLE_MIXED:
-                            // those two are okay
-                        break;
-
-                        case ELEMENTPARTICLE_EMPTY:
-                            // that's an error for sure
-                            pDom->arcDOM = ERROR_ELEMENT_CANNOT_HAVE_CONTENT;
-                        break;
-
-                        default:
-                        {
-                            // ELEMENTPARTICLE_CHOICE:
-                            // ELEMENTPARTICLE_SEQ:
-                            // with these two, we accept whitespace, but nothing
-                            // else... so if we have characters other than
-                            // whitespace, terminate
-                            ULONG ul;
-                            const char *p = s;
-
-                            if (pDom->flParserFlags & DF_DROP_WHITESPACE)
-                                fIsWhitespace = TRUE;
-
-                            for (ul = 0;
-                                 ul < len;
-                                 ul++, p++)
-                                if (!strchr("\r\n\t ", *p))
-                                {
-                                    // other character:
-                                    xmlSetError(pDom,
-                                                ERROR_ELEMENT_CANNOT_HAVE_CONTENT,
-                                                pParent->NodeBase.strNodeName.psz,
-                                                TRUE);
-                                    fIsWhitespace = FALSE;
-                                    break;
-                                }
-                        }
-                    }
-                }
-
-            } // end if (pDom->pDocTypeNode)
-
-            if (!fIsWhitespace)
-                // this is false if any of the following
-                // is true:
-                // --  we are not validating at all
-                // --  we are validating, but the the element
-                //     can have mixed content
-                // --  we are validating and the element does
-                //     _not_ have mixed content and DF_DROP_WHITESPACE
-                //     is set, but the string is whitespace only
-                //     --> drop it then
-
-            if (pDom->pLastWasTextNode)
-                // we had a text node, and no elements or other
-                // stuff in between:
-                xstrcat(pDom->pLastWasTextNode->pstrNodeValue,
-                        s,
-                        len);
-            else
-                pDom->arcDOM = xmlCreateTextNode(pParent,
-                                                 s,
-                                                 len,
-                                                 &pDom->pLastWasTextNode);
-        }
+        if (!(arc = SetNodeValue(pNew, pcszText, 0)))
+            *ppNew = pNew;
+        else
+            xmlDeleteNode((PNODEBASE)pNew);
     }
+
+    return arc;
 }
 
 /*
- *@@ CommentHandler:
- *      @expat handler for @comments.
- *
- *      Note: This is only set if DF_PARSECOMMENTS is
- *      flagged with xmlCreateDOM.
+ *@@ xmlCreatePINode:
+ *      creates a new processing instruction node with the
+ *      specified data.
  *
  *@@added V0.9.9 (2001-02-14) [umoeller]
  */
 
-STATIC void EXPATENTRY CommentHandler(void *pUserData,      // in: our PXMLDOM really
-                                      const XML_Char *data)
+APIRET xmlCreatePINode(PDOMNODE pParent,         // in: parent element node
+                       const char *pcszTarget,   // in: PI target (null-terminated)
+                       const char *pcszData,     // in: PI data (null-terminated)
+                       PDOMNODE *ppNew)
 {
-    PXMLDOM     pDom = (PXMLDOM)pUserData;
+    PDOMNODE pNew = NULL;
+    APIRET arc;
 
-    // continue parsing only if we had no errors so far
-    if (!pDom->arcDOM)
+    if (!(arc = xmlCreateDomNode(pParent,
+                                 DOMNODE_PROCESSING_INSTRUCTION,
+                                 pcszTarget,
+                                 0,
+                                 &pNew)))
     {
-        // we need a new text node:
-        PDOMSTACKITEM pSI = PopElementStack(pDom,
-                                            NULL);     // no free
-        if (!pDom->arcDOM)
-        {
-            PDOMNODE    pParent = pSI->pDomNode,
-                        pNew = NULL;
-
-            pDom->arcDOM = xmlCreateCommentNode(pParent,
-                                                data,
-                                                &pNew);
-        }
+        if (!(arc = SetNodeValue(pNew, pcszData, 0)))
+            *ppNew = pNew;
+        else
+            xmlDeleteNode((PNODEBASE)pNew);
     }
+
+    return arc;
 }
 
 /*
- *@@ StartDoctypeDeclHandler:
- *      @expat handler that is called at the start of a DOCTYPE
- *      declaration, before any external or internal subset is
- *      parsed.
- *
- *      Both pcszSysid and pcszPubid may be NULL. "fHasInternalSubset"
- *      will be non-zero if the DOCTYPE declaration has an internal subset.
+ *@@ xmlCreateDocumentTypeNode:
+ *      creates a new document type node with the
+ *      specified data.
  *
  *@@added V0.9.9 (2001-02-14) [umoeller]
+ *@@changed V1.0.24 (2026-10-18) [agent]: DTD declarations are now in STRMAP hash maps
  */
 
-STATIC void EXPATENTRY StartDoctypeDeclHandler(void *pUserData,
-                                               const XML_Char *pcszDoctypeName,
-                                               const XML_Char *pcszSysid,
-                                               const XML_Char *pcszPubid,
-                                               int fHasInternalSubset)
+APIRET xmlCreateDocumentTypeNode(PDOMDOCUMENTNODE pDocumentNode,            // in: document node
+                                 const char *pcszDoctypeName,
+                                 const char *pcszSysid,
+                                 const char *pcszPubid,
+                                 int fHasInternalSubset,
+                                 PDOMDOCTYPENODE *ppNew)
 {
-    PXMLDOM     pDom = (PXMLDOM)pUserData;
+    APIRET arc = NO_ERROR;
 
-    // continue parsing only if we had no errors so far
-    if (!pDom->arcDOM)
+    if (pDocumentNode->pDocType)
+        // we already have a doctype:
+        arc = ERROR_DOM_DUPLICATE_DOCTYPE;
+    else
     {
-        // get the document node
-        PDOMDOCUMENTNODE pDocumentNode = pDom->pDocumentNode;
-        if (!pDocumentNode)
-            pDom->arcDOM = ERROR_DOM_NO_DOCUMENT;
-        else
-        {
-            // doctype must be null
-            if (pDom->pDocTypeNode)
-                pDom->arcDOM = ERROR_DOM_DUPLICATE_DOCTYPE;
-            else
-                pDom->arcDOM = xmlCreateDocumentTypeNode(pDocumentNode,
-                                                         pcszDoctypeName,
-                                                         pcszSysid,
-                                                         pcszPubid,
-                                                         fHasInternalSubset,
-                                                         &pDom->pDocTypeNode);
+        // create doctype node
+        PDOMDOCTYPENODE pNew = NULL;
+        if (!(arc = xmlCreateDomNode((PDOMNODE)pDocumentNode,
+                                     DOMNODE_DOCUMENT_TYPE,
+                                     pcszDoctypeName,
+                                     0,
+                                     (PDOMNODE*)&pNew)))
+        {
+            // the node has already been added to the children
+            // list of the document node... in addition, set
+            // the doctype field in the document
+            pDocumentNode->pDocType = pNew;
+
+            // initialize the extra fields
+            xstrcpy(&pNew->strPublicID, pcszPubid, 0);
+            xstrcpy(&pNew->strSystemID, pcszSysid, 0);
+            pNew->fHasInternalSubset = fHasInternalSubset;
+
+            smapInit(&pNew->ElementDeclsMap);
+            smapInit(&pNew->AttribDeclBasesMap);
+
+            *ppNew = pNew;
         }
     }
+    return arc;
 }
 
+/* ******************************************************************
+ *
+ *   DOM level 3 content models
+ *
+ ********************************************************************/
+
 /*
- *@@ EndDoctypeDeclHandler:
- *      @expat handler that is called at the end of a DOCTYPE
- *      declaration, after parsing any external subset.
+ *@@ SetupParticleAndSubs:
  *
- *@@added V0.9.9 (2001-02-14) [umoeller]
+ *      This creates sub-particles and recurses to set them up,
+ *      if necessary.
+ *
+ *@@added V0.9.9 (2001-02-16) [umoeller]
  */
 
-STATIC void EXPATENTRY EndDoctypeDeclHandler(void *pUserData)      // in: our PXMLDOM really
+STATIC APIRET SetupParticleAndSubs(PCMELEMENTPARTICLE pParticle,
+                                   PXMLCONTENT pModel,
+                                   TREE **ppElementNamesTree) // in: ptr to _CMELEMENTDECLNODE.ElementNamesTree
+                                                              // (passed to all recursions)
 {
-    PXMLDOM     pDom = (PXMLDOM)pUserData;
+    APIRET arc = NO_ERROR;
 
-    // continue parsing only if we had no errors so far
-    if (!pDom->arcDOM)
+    // set up member NODEBASE
+    switch (pModel->type)
+    {
+        case XML_CTYPE_EMPTY: // that's easy
+            pParticle->NodeBase.ulNodeType = ELEMENTPARTICLE_EMPTY;
+        break;
+
+        case XML_CTYPE_ANY:   // that's easy
+            pParticle->NodeBase.ulNodeType = ELEMENTPARTICLE_ANY;
+        break;
+
+        case XML_CTYPE_NAME:   // that's easy
+            pParticle->NodeBase.ulNodeType = ELEMENTPARTICLE_NAME;
+            xstrcpy(&pParticle->NodeBase.strNodeName, pModel->name, 0);
+            treeInsert(ppElementNamesTree,
+                       NULL,
+                       &pParticle->NodeBase.Tree,
+                       CompareXStrings);
+        break;
+
+        case XML_CTYPE_MIXED:
+            pParticle->NodeBase.ulNodeType = ELEMENTPARTICLE_MIXED;
+        break;
+
+        case XML_CTYPE_CHOICE:
+            pParticle->NodeBase.ulNodeType = ELEMENTPARTICLE_CHOICE;
+        break;
+
+        case XML_CTYPE_SEQ:
+            pParticle->NodeBase.ulNodeType = ELEMENTPARTICLE_SEQ;
+        break;
+    }
+
+    pParticle->ulRepeater = pModel->quant;
+
+    if (pModel->numchildren)
     {
+        // these are the three cases where we have subnodes
+        // in the XMLCONTENT... go for these and recurse
+        ULONG ul;
+        pParticle->pllSubNodes = lstCreate(FALSE);
+        for (ul = 0;
+             ul < pModel->numchildren;
+             ul++)
+        {
+            PXMLCONTENT pSubModel = &pModel->children[ul];
+            PCMELEMENTPARTICLE pSubNew = NULL;
+            if (!(arc = xmlCreateNodeBase(TYPE_UNKNOWN, //       node type... for now
+                                          sizeof(CMELEMENTPARTICLE),
+                                          0,
+                                          0,
+                                          (PNODEBASE*)&pSubNew)))
+            {
+                if (!(arc = SetupParticleAndSubs(pSubNew,
+                                                 pSubModel,
+                                                 ppElementNamesTree)))
+                {
+                    // no error: append sub-particle to this particle's
+                    // children list
+                    lstAppendItem(pParticle->pllSubNodes,
+                                  pSubNew);
+                    // and store this particle as the parent in the
+                    // sub-particle
+                    pSubNew->pParentParticle = pParticle;
+                }
+            }
+
+            if (arc)
+                break;
+        }
     }
+
+    return arc;
 }
 
 /*
- *@@ NotationDeclHandler:
- *      @expat handler for @notation_declarations.
+ *@@ xmlCreateElementDecl:
+ *      creates a new _CMELEMENTDECLNODE for the specified
+ *      _XMLCONTENT content model (which is the @expat structure).
+ *      This recurses, if necessary.
  *
- *      @@todo
+ *      NOTE: As opposed to the other "create" functions,
+ *      this does not take a parent node as input. If this
+ *      returns NO_ERROR, it is the caller's responsibility
+ *      to add the produced node to the document's DOCTYPE node.
  *
- *@@added V0.9.9 (2001-02-14) [umoeller]
+ *@@added V0.9.9 (2001-02-16) [umoeller]
+ *@@changed V1.0.24 (2026-10-18) [agent]: now compiling CHOICE and SEQ models
  */
 
-STATIC void EXPATENTRY NotationDeclHandler(void *pUserData,      // in: our PXMLDOM really
-                                           const XML_Char *pcszNotationName,
-                                           const XML_Char *pcszBase,
-                                           const XML_Char *pcszSystemId,
-                                           const XML_Char *pcszPublicId)
+APIRET xmlCreateElementDecl(const char *pcszName,
+                            PXMLCONTENT pModel,
+                            PCMELEMENTDECLNODE *ppNew)
 {
-    PXMLDOM     pDom = (PXMLDOM)pUserData;
+    APIRET arc = NO_ERROR;
+    PCMELEMENTDECLNODE pNew = NULL;
 
-    // continue parsing only if we had no errors so far
-    if (!pDom->arcDOM)
+    if (!(arc = xmlCreateNodeBase(TYPE_UNKNOWN,      // for now
+                                  sizeof(CMELEMENTDECLNODE),
+                                  pcszName,
+                                  0,
+                                  (PNODEBASE*)&pNew)))
     {
+        treeInit(&pNew->ParticleNamesTree, NULL);
+
+        // set up the "particle" member and recurse into sub-particles
+        if (    (!(arc = SetupParticleAndSubs(&pNew->Particle,
+                                              pModel,
+                                              &pNew->ParticleNamesTree)))
+             && (    (pNew->Particle.NodeBase.ulNodeType == ELEMENTPARTICLE_CHOICE)
+                  || (pNew->Particle.NodeBase.ulNodeType == ELEMENTPARTICLE_SEQ)
+                )
+           )
+            // (children) content: compile for ValidateElement
+            arc = CompileContentModel(pNew,
+                                      &pNew->pDFA);
+
+        if (!arc)
+            *ppNew = pNew;
+        else
+            free(pNew);
     }
+
+    return arc;
 }
 
 /*
- *@@ ExternalEntityRefHandler:
- *      @expat handler for references to @external_entities.
- *
- *      This handler is also called for processing an external DTD
- *      subset if parameter entity parsing is in effect.
- *      (See XML_SetParamEntityParsing.)
- *
- *      The pcszContext argument specifies the parsing context in the
- *      format expected by the context argument to
- *      XML_ExternalEntityParserCreate; pcszContext is valid only until
- *      the handler returns, so if the referenced entity is to be
- *      parsed later, it must be copied.
+ *@@ ValidateElementChildren
+ *      validates the specified element against the document's @DTD,
+ *      more specifically, against the element declaration of the
+ *      new element's parent.
  *
- *      The pcszBase parameter is the base to use for relative system
- *      identifiers. It is set by XML_SetBase and may be null.
+ *      This sets arcDOM in XMLDOM on errors.
  *
- *      The pcszPublicId parameter is the public id given in the entity
- *      declaration and may be null (since XML doesn't require public
- *      identifiers).
+ *      According to the XML spec, an element is valid if there
+ *      is a declaration matching the element declaration where the
+ *      element's name matches the element type, and _one_ of the
+ *      following holds:
  *
- *      The pcszSystemId is the system identifier specified in the
- *      entity declaration and is never null. This is an exact copy
- *      of what was specified in the reference.
+ *      (1) The declaration matches EMPTY and the element has no @content. (done)
  *
- *      There are a couple of ways in which this handler differs
- *      from others. First, this handler returns an integer. A
- *      non-zero value should be returned for successful handling
- *      of the external entity reference. Returning a zero indicates
- *      failure, and causes the calling parser to return an
- *      ERROR_EXPAT_EXTERNAL_ENTITY_HANDLING error.
+ *      (2) The declaration matches (children) (see @element_declaration)
+ *          and the sequence of child elements belongs to the language
+ *          generated by the regular expression in the content model, with
+ *          optional @white_space between the start-tag and the first child
+ *          element, between child elements, or between the last
+ *          child element and the end-tag. Note that a CDATA section
+ *          is never considered "whitespace", even if it contains
+ *          white space only. (done, with the automaton compiled by
+ *          CompileContentModel; ValidateContentEnd checks that the
+ *          sequence is complete)
  *
- *      Second, instead of having pUserData as its first argument,
- *      it receives the parser that encountered the entity reference.
- *      This, along with the context parameter, may be used as
- *      arguments to a call to XML_ExternalEntityParserCreate.
- *      Using the returned parser, the body of the external entity
- *      can be recursively parsed.
+ *      (3) The declaration matches (mixed) (see @element_declaration)
+ *          and the content consists of @content and child elements
+ *          whose types match names in the content model. (done)
  *
- *      Since this handler may be called recursively, it should not
- *      be saving information into global or static variables.
+ *      (4) The declaration matches ANY, and the types of any child
+ *          elements have been declared. (done)
  *
- *      Your handler isn't actually responsible for parsing the entity,
- *      but it is responsible for creating a subsidiary parser with
- *      XML_ExternalEntityParserCreate that will do the job. That returns
- *      an instance of XML_Parser that has handlers and other data
- *      structures initialized from the parent parser. You may then use
- *      XML_Parse or XML_ParseBuffer calls against that parser. Since
- *      external entities may refer to other external entities, your
- *      handler should be prepared to be called recursively.
+ *      This only needs the element's name and the parent's
+ *      declaration, so it works for both the DOM and the SAX
+ *      handlers.
  *
- *@@added V0.9.14 (2001-08-09) [umoeller]
- *@@changed V0.9.20 (2002-07-06) [umoeller]: added automatic doctype support
+ *@@added V0.9.9 (2001-02-16) [umoeller]
+ *@@changed V1.0.24 (2026-10-18) [agent]: now taking the element name instead of the node, for SAX
+ *@@changed V1.0.24 (2026-10-18) [agent]: now checking the order of children with the content model automaton
  */
 
-STATIC int EXPATENTRY ExternalEntityRefHandler(void *pUserData,      // in: our PXMLDOM really
-                                               XML_Parser parser,
-                                               const XML_Char *pcszContext,
-                                               const XML_Char *pcszBase,
-                                               const XML_Char *pcszSystemId,
-                                               const XML_Char *pcszPublicId)
+STATIC VOID ValidateElement(PXMLDOM pDom,
+                            const XSTRING *pstrNewElementName,  // in: name of new element
+                            ULONG ulHash,             // in: smapHash of the name
+                            BOOL fIsRoot,             // in: TRUE if parent is the document
+                            PCMELEMENTDECLNODE pParentElementDecl,
+                                                      // in: element decl of element's parent
+                            PULONG pulParentState)    // in/out: parent's state in the decl's automaton
 {
-    PXMLDOM     pDom = (PXMLDOM)pUserData;
+    if (pDom && pstrNewElementName)
+    {
+        if (!pParentElementDecl)
+        {
+            // this is always missing for the root element, of course,
+            // because the parent is the document
+            if (fIsRoot)
+                return;     // that's OK
+            else
+                xmlSetError(pDom,
+                            ERROR_DOM_VALIDATE_INVALID_ELEMENT,
+                            pstrNewElementName->psz,
+                            TRUE);
+        }
+        else
+        {
+            ULONG ulDeclType = pParentElementDecl->Particle.NodeBase.ulNodeType;
 
-    int i = 0;          // return error per default
-
-    // store the previous parser because
-    // all the callbacks use the parser pointer
-    XML_Parser pOldParser = pDom->pParser;
-    pDom->pParser = NULL;
+            switch (ulDeclType)
+            {
+                case ELEMENTPARTICLE_EMPTY:
+                    // this is an error for sure
+                    xmlSetError(pDom,
+                                ERROR_DOM_SUBELEMENT_IN_EMPTY_ELEMENT,
+                                pstrNewElementName->psz,
+                                TRUE);
+                break;
 
-    if (    (    (pDom->pfnExternalHandler)
-              || (pDom->cSystemIds)      // V0.9.20 (2002-07-06) [umoeller]
-            )
-            // create sub-parser and replace the one
-            // in the DOM with it
-         && (pDom->pParser = XML_ExternalEntityParserCreate(parser,
-                                                            pcszContext,
-                                                            "US-ASCII"))
-       )
-    {
-        // run through the predefined doctypes given to us
-        // in xmlCreateDOM, if any
-        // V0.9.20 (2002-07-06) [umoeller]
-        BOOL fCallExternal = TRUE;
-        ULONG ul;
+                case ELEMENTPARTICLE_ANY:
+                    // that's always OK
+                break;
 
-        for (ul = 0;
-             ul < pDom->cSystemIds;
-             ++ul)
-        {
-            const STATICSYSTEMID *pThis = &pDom->paSystemIds[ul];
-            if (!strcmp(pThis->pcszSystemId, pcszSystemId))
-            {
-                // this one matches:
-                // then parse the corresponding entry given
-                // to us
-                if (XML_Parse(pDom->pParser,
-                              pThis->pcszContent,
-                              strlen(pThis->pcszContent),
-                              TRUE))
-                    i = 1;      // success
+                case ELEMENTPARTICLE_CHOICE:
+                case ELEMENTPARTICLE_SEQ:
+                {
+                    PCMCONTENTDFA pDFA;
+                    if (pDFA = pParentElementDecl->pDFA)
+                    {
+                        // (children) content: one step in the automaton,
+                        // which fails if the element is not allowed at
+                        // all or not at this point
+                        ULONG ulColumn = (ULONG)smapFindHash(&pDFA->NamesMap,
+                                                             pstrNewElementName->psz,
+                                                             pstrNewElementName->ulLength,
+                                                             ulHash);
+                        if (    (!ulColumn)
+                             || (!(*pulParentState = pDFA->pausNext[  *pulParentState * pDFA->cColumns
+                                                                    + ulColumn - 1]))
+                           )
+                            xmlSetError(pDom,
+                                        ERROR_DOM_INVALID_SUBELEMENT,
+                                        pstrNewElementName->psz,
+                                        TRUE);
+                        break;
+                    }
+                }
+                // else the model was too large to compile:
+                // check if the element is allowed at all then
 
-                fCallExternal = FALSE;
+                case ELEMENTPARTICLE_MIXED:
+                {
+                    // we need to check if the element is allowed at all
+                    PCMELEMENTPARTICLE pParticle
+                        = (PCMELEMENTPARTICLE)treeFind(
+                                         pParentElementDecl->ParticleNamesTree,
+                                         (ULONG)pstrNewElementName,
+                                         CompareXStrings);
+                    if (!pParticle)
+                        // not found: then this element is not allowed within this
+                        // parent
+                        xmlSetError(pDom,
+                                    ERROR_DOM_INVALID_SUBELEMENT,
+                                    pstrNewElementName->psz,
+                                    TRUE);
 
-                break;
+                break; }
             }
         }
+    }
+    else
+        pDom->arcDOM = ERROR_INVALID_PARAMETER;
 
-        if (    (fCallExternal)     // not handled above
-             && (pDom->pfnExternalHandler) // user handler set
-           )
-        {
-            APIRET  arc;
+    // yes: get the element decl from the tree
+    /* PCMELEMENTDECLNODE pElementDecl = xmlFindElementDecl(pDom,
+                                                         &pElement->NodeBase.strNodeName);
+    if (!pElementDecl)
+    {
+        xmlSetError(pDom,
+                    ERROR_DOM_UNDECLARED_ELEMENT,
+                    pElement->NodeBase.strNodeName.psz,
+                    TRUE);
+    }
+    else
+    {
+        // element has been declared:
+        // check if it may appear in this element's parent...
+        PDOMNODE pParentElement = pElement->pParentNode;
 
-            if (!(arc = pDom->pfnExternalHandler(pDom,
-                                                 pDom->pParser,
-                                                 pcszSystemId,
-                                                 pcszPublicId)))
-                i = 1;      // success
-            else
+        if (!pParentElement)
+            pDom->arcDOM = ERROR_DOM_INTEGRITY;
+        else switch (pParentElement->NodeBase.ulNodeType)
+        {
+            case DOMNODE_DOCUMENT:
             {
-                // error:
-                // now this needs special handling, since we're
-                // dealing with a sub-handler here...
+                // if this is the root element, compare its name
+                // to the DOCTYPE name
+                if (pParentElement != (PDOMNODE)pDom->pDocumentNode)
+                    xmlSetError(pDom,
+                                ERROR_DOM_INVALID_ROOT_ELEMENT,
+                                pElement->NodeBase.strNodeName.psz,
+                                TRUE);
+                else if (strcmp(pDom->pDocumentNode->DomNode.NodeBase.strNodeName.psz,
+                                pElement->NodeBase.strNodeName.psz))
+                    // no match:
+                    xmlSetError(pDom,
+                                ERROR_DOM_ROOT_ELEMENT_MISNAMED,
+                                pElement->NodeBase.strNodeName.psz,
+                                TRUE);
+            break; }
 
-                if (arc == -1)
-                    // parser error: well, then xmlSetError has been
-                    // called from somewhere in the callbacks already,
-                    // and we can safely ignore this
-                    ;
+            case DOMNODE_ELEMENT:
+            {
+                // parent of element is another element:
+                // check the parent in the DTD and find out if
+                // this element may appear in the parent element
+                PCMELEMENTDECLNODE pParentElementDecl
+                        = xmlFindElementDecl(pDom,
+                                             &pParentElement->NodeBase.strNodeName);
+                if (!pParentElementDecl)
+                    pDom->arcDOM = ERROR_DOM_INTEGRITY;
                 else
                 {
-                    pDom->arcDOM = arc;
-                    if (pcszSystemId)
-                    {
-                        if (!pDom->pxstrFailingNode)
-                            pDom->pxstrFailingNode = xstrCreate(0);
-                        xstrcpy(pDom->pxstrFailingNode, pcszSystemId, 0);
-                    }
-                    pDom->pcszErrorDescription = xmlDescribeError(arc);
-                    pDom->ulErrorLine = XML_GetCurrentLineNumber(pDom->pParser);
-                    pDom->ulErrorColumn = XML_GetCurrentColumnNumber(pDom->pParser);
+                    // now check the element names tree of the parent element decl
+                    // for whether this element is allowed as a sub-element at all
+                    PCMELEMENTPARTICLE pParticle
+                        = treeFindEQData(&pParentElementDecl->ParticleNamesTree,
+                                         (void*)pElement->NodeBase.strNodeName.psz,
+                                         CompareNodeBaseData);
+                    if (!pParticle)
+                        // not found: then this element is not allowed within this
+                        // parent
+                        xmlSetError(pDom,
+                                    ERROR_DOM_INVALID_SUBELEMENT,
+                                    pElement->NodeBase.strNodeName.psz,
+                                    TRUE);
                 }
-            }
+            break; }
         }
     }
-    else
-        xmlSetError(pDom,
-                    ERROR_DOM_INVALID_EXTERNAL_HANDLER,
-                    NULL,
-                    FALSE);
-
-    if (pDom->pParser)
-        XML_ParserFree(pDom->pParser);
+    */
+}
 
-    pDom->pParser = pOldParser;
+/*
+ *@@ ValidateContentEnd:
+ *      called when an element ends to check that its
+ *      children are complete according to its (children)
+ *      content model, i.e. that its automaton is in an
+ *      accepting state.
+ *
+ *      This sets arcDOM in XMLDOM on errors.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
 
-    return i;
+STATIC VOID ValidateContentEnd(PXMLDOM pDom,
+                               const char *pcszElement,
+                               PCMELEMENTDECLNODE pElementDecl,  // in: element's decl or NULL
+                               ULONG ulState)            // in: element's state in the decl's automaton
+{
+    if (    (pElementDecl)
+         && (pElementDecl->pDFA)
+         && (!pElementDecl->pDFA->pafAccepting[ulState])
+       )
+        xmlSetError(pDom,
+                    ERROR_DOM_INCOMPLETE_CONTENT,
+                    pcszElement,
+                    TRUE);
 }
 
 /*
- *@@ ElementDeclHandler:
- *      @expat handler for element declarations in a DTD. The
- *      handler gets called with the name of the element in
- *      the declaration and a pointer to a structure that contains
- *      the element model.
+ *@@ ValidateAttributeType:
+ *      validates the specified attribute's type against the
+ *      document's @DTD.
  *
- *      It is the application's responsibility to free this data
- *      structure. @@todo
+ *      The caller looks up the attribute's declaration in
+ *      the element's attlist; if there is none, the attribute
+ *      is undeclared, which is an error.
  *
- *      The XML spec defines that no element may be declared more
- *      than once.
+ *      This sets arcDOM in XMLDOM on errors.
  *
- *@@added V0.9.9 (2001-02-14) [umoeller]
+ *@@added V0.9.9 (2001-02-16) [umoeller]
+ *@@changed V1.0.24 (2026-10-18) [agent]: now using the symbol table instead of xmlFindAttribDecl
+ *@@changed V1.0.24 (2026-10-18) [agent]: now taking the decl, name and value instead of the node, for SAX
  */
 
-STATIC void EXPATENTRY ElementDeclHandler(void *pUserData,      // in: our PXMLDOM really
-                                          const XML_Char *pcszName,
-                                          XMLCONTENT *pModel)
+STATIC VOID ValidateAttributeType(PXMLDOM pDom,
+                                  PCMATTRIBUTEDECL pAttribDecl,    // in: attribute decl or NULL
+                                  const char *pcszAttribName,
+                                  const XSTRING *pstrValue)
 {
-    PXMLDOM     pDom = (PXMLDOM)pUserData;
-
-    // continue parsing only if we had no errors so far
-    if (!pDom->arcDOM)
+    if (!pAttribDecl)
+        xmlSetError(pDom,
+                    ERROR_DOM_UNDECLARED_ATTRIBUTE,
+                    pcszAttribName,
+                    TRUE);
+    else
     {
-        // OK, we're in a DOCTYPE node:
-        PDOMDOCTYPENODE pDocType = pDom->pDocTypeNode;
-        if (!pDocType)
-            xmlSetError(pDom,
-                        ERROR_DOM_ELEMENT_DECL_OUTSIDE_DOCTYPE,
-                        pcszName,
-                        TRUE);
-        else
+        // check if the attribute value is allowed
+        switch (pAttribDecl->ulAttrType)
         {
-            // create an element declaration and push it unto the
-            // declarations tree
-            PCMELEMENTDECLNODE pNew = NULL;
-            if (!(pDom->arcDOM = xmlCreateElementDecl(pcszName,
-                                                      pModel,
-                                                      &pNew)))
-                                    // this recurses!!
-                                    // after this, pModel is invalid
+            case CMAT_CDATA:
+            case CMAT_ID:
+            case CMAT_IDREF:
+            case CMAT_IDREFS:       // ###
+            case CMAT_ENTITY:
+            case CMAT_ENTITIES:
+            case CMAT_NMTOKEN:
+            case CMAT_NMTOKENS:
+            break;
+
+            case CMAT_ENUM:
             {
-                // add this to the doctype's declarations tree
-                if (treeInsert(&pDocType->ElementDeclsTree,
-                               NULL,
-                               (TREE*)pNew,
-                               CompareXStrings))
-                    // element already declared:
-                    // according to the XML specs, this is a validity
-                    // constraint, so we report a validation error
+                // enumeration: then check if it has one of the
+                // allowed values
+                PNODEBASE pValue = (PNODEBASE)treeFind(
+                                                pAttribDecl->ValuesTree,
+                                                (ULONG)pstrValue,
+                                                CompareXStrings);
+                if (!pValue)
                     xmlSetError(pDom,
-                                ERROR_DOM_DUPLICATE_ELEMENT_DECL,
-                                pNew->Particle.NodeBase.strNodeName.psz,
+                                ERROR_DOM_INVALID_ATTRIB_VALUE,
+                                pcszAttribName,
                                 TRUE);
             }
         }
-    }
-}
 
-/*
- *@@ AddEnum:
- *
- *@@added V0.9.9 (2001-02-16) [umoeller]
- */
-
-STATIC APIRET AddEnum(PCMATTRIBUTEDECL pDecl,
-                      const char *p,           // in: start of name
-                      const char *pNext)       // in: end of name (not included)
-{
-    // PSZ pszType = strhSubstr(p, pNext);
-    PNODEBASE pNew = NULL;
-    APIRET arc;
-
-    if (!(arc = xmlCreateNodeBase(ATTRIBUTE_DECLARATION_ENUM,
-                                  sizeof(NODEBASE),
-                                  p,
-                                  (pNext - p),
-                                  &pNew)))
-        treeInsert(&pDecl->ValuesTree,
-                   NULL,
-                   (TREE*)pNew,
-                   CompareXStrings);
-
-    return arc;
+        if (pAttribDecl->ulConstraint == CMAT_FIXED_VALUE)
+            if (strcmp(pstrValue->psz, pAttribDecl->pstrDefaultValue->psz))
+                // fixed value doesn't match:
+                xmlSetError(pDom,
+                            ERROR_DOM_INVALID_ATTRIB_VALUE,
+                            pcszAttribName,
+                            TRUE);
+    }
 }
 
 /*
- *@@ AttlistDeclHandler:
- *      @expat handler for attlist declarations in the DTD.
- *
- *      This handler is called for each attribute. So a single attlist
- *      declaration with multiple attributes declared will generate
- *      multiple calls to this handler.
- *
- *      --  pcszElementName is the name of the  element for which the
- *          attribute is being declared.
- *
- *      --  pcszAttribName has the attribute name being declared.
+ *@@ ValidateAllAttributes:
+ *      validates the constraints of all attributes of the specified
+ *      element against the document's @DTD.
  *
- *      --  pcszAttribType is the attribute type.
- *          It is the string representing the type in the declaration
- *          with whitespace removed.
+ *      papcszAttribs is the attributes array that @expat gave to
+ *      the start element handler, which has the defaulted
+ *      attributes too. Elements rarely have more than a few
+ *      attributes, so we search that array instead of a map.
  *
- *      --  pcszDefault holds the default value. It will be
- *          NULL in the case of "#IMPLIED" or "#REQUIRED" attributes.
- *          You can distinguish these two cases by checking the
- *          fIsRequired parameter, which will be true in the case of
- *          "#REQUIRED" attributes. Attributes which are "#FIXED"
- *          will have also have a TRUE fIsRequired, but they will have
- *          the non-NULL fixed value in the pcszDefault parameter.
+ *      The declarations are enumerated in hash order. If several
+ *      required attributes are missing, the one that is reported
+ *      is therefore not necessarily the first in alphabetical
+ *      order, as it was with the sorted tree before V1.0.24.
  *
- *@@added V0.9.9 (2001-02-14) [umoeller]
+ *@@added V0.9.9 (2001-02-16) [umoeller]
+ *@@changed V1.0.24 (2026-10-18) [agent]: DTD declarations are now in STRMAP hash maps
+ *@@changed V1.0.24 (2026-10-18) [agent]: now taking expat's attributes array instead of the node, for SAX
  */
 
-STATIC void EXPATENTRY AttlistDeclHandler(void *pUserData,      // in: our PXMLDOM really
-                                          const XML_Char *pcszElementName,
-                                          const XML_Char *pcszAttribName,
-                                          const XML_Char *pcszAttribType,
-                                          const XML_Char *pcszDefault,
-                                          int fIsRequired)
+STATIC VOID ValidateAllAttributes(PXMLDOM pDom,
+                                  PCMATTRIBUTEDECLBASE pAttribDeclBase,
+                                  const char **papcszAttribs)   // in: name/value pairs from expat
 {
-    PXMLDOM     pDom = (PXMLDOM)pUserData;
+    PSTRMAPSLOT pSlot;
+    ULONG       ul = 0;
 
-    // continue parsing only if we had no errors so far
-    if (!pDom->arcDOM)
+    while (    (!pDom->arcDOM)
+            && (pSlot = smapEnum(&pAttribDeclBase->AttribDeclsMap, &ul))
+          )
     {
-        // OK, we're in a DOCTYPE node:
-        PDOMDOCTYPENODE pDocType = pDom->pDocTypeNode;
-        if (!pDocType)
-            xmlSetError(pDom,
-                        ERROR_DOM_ATTLIST_DECL_OUTSIDE_DOCTYPE,
-                        pcszElementName,
-                        TRUE);
-        else
+        PCMATTRIBUTEDECL pDeclThis = (PCMATTRIBUTEDECL)pSlot->pvData;
+
+        // if attribute is all optional: then we don't need
+        // to check for whether it's here
+        if (    (pDeclThis->ulConstraint != CMAT_IMPLIED)
+             && (pDeclThis->ulConstraint != CMAT_DEFAULT_VALUE)
+                    // we don't have to check this case because expat
+                    // already adds default attributes for us
+           )
         {
-            PCMATTRIBUTEDECLBASE    pThis = NULL,
-                                    pCache = pDom->pAttListDeclCache;
+            // for all others , we need to find the attribute
+            PXSTRING pstrAttrNameThis = &pDeclThis->NodeBase.strNodeName;
+            ULONG i;
 
-            // check if this is for the same attlist as the previous
-            // call (we cache the pointer for speed)
-            if (    (pCache)
-                 && (!strhcmp(pCache->NodeBase.strNodeName.psz,
-                              pcszElementName))
-               )
-                // this attdecl is for the same element:
-                // use that (we won't have to search the tree)
-                pThis = pDom->pAttListDeclCache;
+            for (i = 0;
+                 papcszAttribs[i];
+                 i += 2)
+                if (!strcmp(papcszAttribs[i], pstrAttrNameThis->psz))
+                    break;
 
-            if (!pThis)
+            // now switch again
+            switch (pDeclThis->ulConstraint)
             {
-                // cache didn't match: look up attributes tree then...
-                // note: cheap trick, we need an XSTRING for treeFind
-                // but don't want malloc, so we use xstrInitSet
-                XSTRING strElementName;
-                xstrInitSet(&strElementName, (PSZ)pcszElementName);
-                if (!(pThis = (PCMATTRIBUTEDECLBASE)treeFind(
-                                    pDocType->AttribDeclBasesTree,
-                                    (ULONG)&strElementName,
-                                    CompareXStrings)))
-                {
-                    // still not found:
-                    // we need a new node then
-                    if (!(pDom->arcDOM = xmlCreateNodeBase(ATTRIBUTE_DECLARATION_BASE,
-                                                     sizeof(CMATTRIBUTEDECLBASE),
-                                                     strElementName.psz,
-                                                     strElementName.ulLength,
-                                                     (PNODEBASE*)&pThis)))
-                    {
-                        // initialize the subtree
-                        treeInit(&pThis->AttribDeclsTree, NULL);
-
-                        treeInsert(&pDocType->AttribDeclBasesTree,
-                                   NULL,
-                                   (TREE*)pThis,
-                                   CompareXStrings);
-                    }
-                }
-
-                pDom->pAttListDeclCache = pThis;
+                case CMAT_REQUIRED:
+                    if (!papcszAttribs[i])
+                        // required, but no attribute with this name exists:
+                        xmlSetError(pDom,
+                                    ERROR_DOM_REQUIRED_ATTRIBUTE_MISSING,
+                                    pstrAttrNameThis->psz,
+                                    TRUE);
+                break;
             }
+        }
+    }
+}
 
-            if (pThis)
-            {
-                // pThis now has either an existing or a new CMATTRIBUTEDECLBASE;
-                // add a new attribute def (CMATTRIBUTEDEDECL) to that
-                PCMATTRIBUTEDECL  pNew = NULL;
-                if (!(pDom->arcDOM = xmlCreateNodeBase(ATTRIBUTE_DECLARATION,
-                                                       sizeof(CMATTRIBUTEDECL),
-                                                       pcszAttribName,
-                                                       0,
-                                                       (PNODEBASE*)&pNew)))
-                {
-                    treeInit(&pNew->ValuesTree, NULL);
+/*
+ *      XML @whitespace (space, tab, CR, LF) for IsWhitespace;
+ *      everything from 33 up is zero.
+ */
 
-                    // check the type... expat is too lazy to parse this for
-                    // us, so we must check manually. Expat only normalizes
-                    // the "type" string to kick out whitespace, so we get:
-                    // (TYPE1|TYPE2|TYPE3)
-                    if (*pcszAttribType == '(')
-                    {
-                        // enumeration:
-                        const char *p = pcszAttribType + 1,
-                                   *pNext;
-                        while (    (pNext = strchr(p, '|'))
-                                && (!pDom->arcDOM)
-                              )
-                        {
-                            pDom->arcDOM = AddEnum(pNew, p, pNext);
-                            p = pNext + 1;
-                        }
+static const BYTE G_abWhitespace[256] =
+    {
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 0, 0, 1, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        1
+    };
 
-                        if (!pDom->arcDOM)
-                        {
-                            pNext = strchr(p, ')');
-                            AddEnum(pNew, p, pNext);
+/*
+ *@@ IsWhitespace:
+ *      returns TRUE if the cch chars at pcch are all
+ *      @whitespace.
+ *
+ *      This looks at four chars at a time: runs of spaces,
+ *      which is what indentation mostly is, take a single
+ *      compare, and anything else a table lookup per char
+ *      without branching on every one of them.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
 
-                            pNew->ulAttrType = CMAT_ENUM;
-                        }
-                    }
-                    else if (!strcmp(pcszAttribType, "CDATA"))
-                        pNew->ulAttrType = CMAT_CDATA;
-                    else if (!strcmp(pcszAttribType, "ID"))
-                        pNew->ulAttrType = CMAT_ID;
-                    else if (!strcmp(pcszAttribType, "IDREF"))
-                        pNew->ulAttrType = CMAT_IDREF;
-                    else if (!strcmp(pcszAttribType, "IDREFS"))
-                        pNew->ulAttrType = CMAT_IDREFS;
-                    else if (!strcmp(pcszAttribType, "ENTITY"))
-                        pNew->ulAttrType = CMAT_ENTITY;
-                    else if (!strcmp(pcszAttribType, "ENTITIES"))
-                        pNew->ulAttrType = CMAT_ENTITIES;
-                    else if (!strcmp(pcszAttribType, "NMTOKEN"))
-                        pNew->ulAttrType = CMAT_NMTOKEN;
-                    else if (!strcmp(pcszAttribType, "NMTOKENS"))
-                        pNew->ulAttrType = CMAT_NMTOKENS;
+STATIC BOOL IsWhitespace(const char *pcch,
+                         ULONG cch)
+{
+    const char *pEnd = pcch + cch;
 
-                    if (!pDom->arcDOM)
-                    {
-                        if (pcszDefault)
-                        {
-                            // fixed or default:
-                            if (fIsRequired)
-                                // fixed:
-                                pNew->ulConstraint = CMAT_FIXED_VALUE;
-                            else
-                                pNew->ulConstraint = CMAT_DEFAULT_VALUE;
+    while (pEnd - pcch >= 4)
+    {
+        if (    (memcmp(pcch, "    ", 4))
+             && (!(   G_abWhitespace[(UCHAR)pcch[0]]
+                    & G_abWhitespace[(UCHAR)pcch[1]]
+                    & G_abWhitespace[(UCHAR)pcch[2]]
+                    & G_abWhitespace[(UCHAR)pcch[3]]
+                  ))
+           )
+            return FALSE;
+        pcch += 4;
+    }
 
-                            pNew->pstrDefaultValue = xstrCreate(0);
-                            xstrcpy(pNew->pstrDefaultValue, pcszDefault, 0);
-                        }
-                        else
-                            // implied or required:
-                            if (fIsRequired)
-                                pNew->ulConstraint = CMAT_REQUIRED;
-                            else
-                                pNew->ulConstraint = CMAT_IMPLIED;
+    while (pcch < pEnd)
+        if (!G_abWhitespace[(UCHAR)*pcch++])
+            return FALSE;
 
-                        if (treeInsert(&pThis->AttribDeclsTree,
-                                       NULL,
-                                       (TREE*)pNew,
-                                       CompareXStrings))
-                            xmlSetError(pDom,
-                                        ERROR_DOM_DUPLICATE_ATTRIBUTE_DECL,
-                                        pcszAttribName,
-                                        TRUE);
-                    }
-                }
-            }
-        }
-    }
+    return TRUE;
 }
 
 /*
- *@@ EntityDeclHandler:
- *      @expat handler that will be called for all entity declarations.
- *
- *      The fIsParameterEntity argument will be non-zero in the case
- *      of parameter entities and zero otherwise.
+ *@@ ValidateCharacterData:
+ *      validates a chunk of @content against the element
+ *      declaration of the element it appears in, i.e. checks
+ *      if the element allows for content at all (must be
+ *      "mixed" model).
  *
- *      For internal entities (<!ENTITY foo "bar">), pcszValue will be
- *      non-NULL and pcszSystemId, pcszPublicId, and pcszNotationName
- *      will all be NULL. The value string is not NULL terminated; the
- *      length is provided in the iValueLength parameter. Do not use
- *      iValueLength to test for internal entities, since it is legal
- *      to have zero-length values. Instead check for whether or not
- *      pcszValue is NULL.
+ *      This sets arcDOM in XMLDOM on errors.
  *
- *      The pcszNotationName argument will have a non-NULL value only
- *      for unparsed entity declarations.
+ *      Returns TRUE if the chunk is whitespace in an element
+ *      that can only have element content and DF_DROP_WHITESPACE
+ *      is set, i.e. if the caller should drop it.
  *
- *@@added V0.9.9 (2001-02-14) [umoeller]
+ *@@added V1.0.24 (2026-10-18) [agent]
+ *@@changed V1.0.24 (2026-10-18) [agent]: now using IsWhitespace
+ *@@changed V1.0.24 (2026-10-18) [agent]: content in EMPTY elements now sets fInvalid and the error position
  */
 
-STATIC void EXPATENTRY EntityDeclHandler(void *pUserData,      // in: our PXMLDOM really
-                                         const XML_Char *pcszEntityName,
-                                         int fIsParameterEntity,
-                                         const XML_Char *pcszValue,
-                                         int iValueLength,
-                                         const XML_Char *pcszBase,
-                                         const XML_Char *pcszSystemId,
-                                         const XML_Char *pcszPublicId,
-                                         const XML_Char *pcszNotationName)
+STATIC BOOL ValidateCharacterData(PXMLDOM pDom,
+                                  PCMELEMENTDECLNODE pElementDecl,    // in: decl of parent element
+                                  const XML_Char *s,
+                                  int len)
 {
-    PXMLDOM     pDom = (PXMLDOM)pUserData;
+    BOOL fIsWhitespace = FALSE;
 
-    // continue parsing only if we had no errors so far
-    if (!pDom->arcDOM)
+    switch (pElementDecl->Particle.NodeBase.ulNodeType)
     {
-    }
-}
-
-/* ******************************************************************
- *
- *   DOM parser APIs
- *
- ********************************************************************/
+        case ELEMENTPARTICLE_ANY:
+        case ELEMENTPARTICLE_MIXED:
+            // those two are okay
+        break;
+
+        case ELEMENTPARTICLE_EMPTY:
+            // that's an error for sure
+            xmlSetError(pDom,
+                        ERROR_ELEMENT_CANNOT_HAVE_CONTENT,
+                        pElementDecl->Particle.NodeBase.strNodeName.psz,
+                        TRUE);
+        break;
+
+        default:
+        {
+            // ELEMENTPARTICLE_CHOICE:
+            // ELEMENTPARTICLE_SEQ:
+            // with these two, we accept whitespace, but nothing
+            // else... so if we have characters other than
+            // whitespace, terminate
+            if (!IsWhitespace(s, len))
+                xmlSetError(pDom,
+                            ERROR_ELEMENT_CANNOT_HAVE_CONTENT,
+                            pElementDecl->Particle.NodeBase.strNodeName.psz,
+                            TRUE);
+            else if (pDom->flParserFlags & DF_DROP_WHITESPACE)
+                fIsWhitespace = TRUE;
+        }
+    }
+
+    return fIsWhitespace;
+}
+
+/* ******************************************************************
+ *
+ *   Expat stack
+ *
+ ********************************************************************/
+
+/*
+ *@@ DOMSTACKITEM:
+ *
+ *@@added V0.9.9 (2001-02-16) [umoeller]
+ */
+
+typedef struct _DOMSTACKITEM
+{
+    PDOMNODE                pDomNode;
+    PCMELEMENTDECLNODE      pElementDecl;
+    ULONG                   ulState;        // state in pElementDecl's content
+                                            // model automaton, if it has one
+
+} DOMSTACKITEM, *PDOMSTACKITEM;
+
+/*
+ *@@ PopElementStack:
+ *
+ *      NOTE:
+ *
+ *@@added V0.9.9 (2001-02-16) [umoeller]
+ */
+
+STATIC PDOMSTACKITEM PopElementStack(PXMLDOM pDom,
+                                     PLISTNODE *ppListNode)
+{
+    PDOMSTACKITEM   pStackItem = NULL;
+    PLISTNODE       pParentLN = lstPop(&pDom->llElementStack);
+
+    if (!pParentLN)
+        pDom->arcDOM = ERROR_DOM_NO_ELEMENT;
+    else
+    {
+        // we have at least one node:
+        pStackItem = (PDOMSTACKITEM)pParentLN->pItemData;
+
+        if (ppListNode)
+            *ppListNode = pParentLN;
+    }
+
+    return pStackItem;
+}
+
+/*
+ *@@ PushElementStack:
+ *
+ *      NOTE: pDomNode will most frequently be an element
+ *      node, but will also be the document for root and
+ *      a DOCTYPE node while parsing the DTD. With SAX, it
+ *      is NULL for elements, as there are no element nodes.
+ *
+ *@@added V0.9.9 (2001-02-16) [umoeller]
+ *@@changed V1.0.24 (2026-10-18) [agent]: element decl now comes from the symbol table
+ *@@changed V1.0.24 (2026-10-18) [agent]: element decl is now passed in by the caller, for SAX
+ */
+
+STATIC VOID PushElementStack(PXMLDOM pDom,
+                             PDOMNODE pDomNode,
+                             PCMELEMENTDECLNODE pElementDecl)    // in: element's decl or NULL
+{
+    PDOMSTACKITEM pNew = (PDOMSTACKITEM)malloc(sizeof(*pNew));
+    if (!pNew)
+        pDom->arcDOM = ERROR_NOT_ENOUGH_MEMORY;
+    else
+    {
+        memset(pNew, 0, sizeof(*pNew));
+        pNew->pDomNode = pDomNode;
+        pNew->pElementDecl = pElementDecl;
+        pNew->ulState = 1;          // start state
+
+        lstPush(&pDom->llElementStack,
+                pNew);
+    }
+}
+
+/* ******************************************************************
+ *
+ *   Expat handlers
+ *
+ ********************************************************************/
+
+/*
+ *@@ UnknownEncodingHandler:
+ *      @expat handler called when the xml
+ *      @text_declaration has an @encoding that is not
+ *      one of the four encodings built into expat.
+ *
+ *      See XML_SetUnknownEncodingHandler.
+ *
+ *@@added V0.9.14 (2001-08-09) [umoeller]
+ */
+
+STATIC int EXPATENTRY UnknownEncodingHandler(void *pUserData,   // in: out PXMLDOM really
+                                             const XML_Char *pcszName,
+                                             XML_Encoding *pEncoding)
+{
+    PXMLDOM     pDom = (PXMLDOM)pUserData;
+
+    ULONG ulCP;
+    if (    (pDom->pfnGetCPData)            // callback exists?
+         && (!strncmp(pcszName, "cp", 2))
+         && (strlen(pcszName) > 4)              // at least five chars (e.g. "cp850")
+         && (ulCP = atoi(pcszName + 2))
+       )
+    {
+        // this is a PC codepage:
+/* typedef struct _XML_Encoding
+{
+  int           map[256];
+  void          *data;
+  int           (* EXPATENTRY convert)(void *data, const char *s);
+  void          (* EXPATENTRY release)(void *data);
+} XML_Encoding; */
+
+        // ZERO(pEncoding);
+
+        pEncoding->convert = NULL;
+        pEncoding->release = NULL;
+
+        memset(&pEncoding->map, -1, sizeof(pEncoding->map));
+
+        if (pDom->pfnGetCPData(pDom,
+                               ulCP,
+                               pEncoding->map))
+        {
+            // go check if there's any -1 chars left
+            ULONG ul;
+            for (ul = 0;
+                 ul < 256;
+                 ul++)
+            {
+                if (pEncoding->map[ul] < 0)
+                    xmlSetError(pDom,
+                                ERROR_DOM_INCOMPLETE_ENCODING_MAP,
+                                NULL,
+                                FALSE);
+            }
+            // return success
+            return 1;
+        }
+    }
+
+    // error
+    return 0;
+}
+
+/*
+ *@@ FlushText:
+ *      creates a text node in the current element from the
+ *      character data that CharacterDataHandler has collected,
+ *      if any. This gets called before anything else is added
+ *      to the DOM, so that the text node ends up in the right
+ *      place.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+STATIC VOID FlushText(PXMLDOM pDom)
+{
+    if (    (pDom->strText.ulLength)
+         && (!pDom->arcDOM)
+       )
+    {
+        PDOMSTACKITEM pSI = PopElementStack(pDom,
+                                            NULL);     // no free
+        if (!pDom->arcDOM)
+        {
+            PDOMNODE pNew;
+            pDom->arcDOM = xmlCreateTextNode(pSI->pDomNode,
+                                             pDom->strText.psz,
+                                             pDom->strText.ulLength,
+                                             &pNew);
+        }
+    }
+
+    // keep the buffer for the next text node
+    pDom->strText.ulLength = 0;
+}
+
+/*
+ *@@ StartElementHandler:
+ *      @expat handler called when a new element is
+ *      found.
+ *
+ *      We create a new record in the container and
+ *      push it onto our stack so we can insert
+ *      children into it. We first start with the
+ *      attributes.
+ *
+ *@@changed V1.0.24 (2026-10-18) [agent]: adjusted for changed validation functions
+ *@@changed V1.0.24 (2026-10-18) [agent]: added FlushText
+ */
+
+STATIC void EXPATENTRY StartElementHandler(void *pUserData,      // in: our PXMLDOM really
+                                           const char *pcszElement,
+                                           const char **papcszAttribs)
+{
+    PXMLDOM     pDom = (PXMLDOM)pUserData;
+
+    FlushText(pDom);
+
+    // continue parsing only if we had no errors so far
+    if (!pDom->arcDOM)
+    {
+        ULONG       i;
+
+        PDOMSTACKITEM pSI = PopElementStack(pDom,
+                                            NULL);     // no free
+        if (!pDom->arcDOM)
+        {
+            PDOMNODE    pParent = pSI->pDomNode,
+                        pNew = NULL;
+
+            if (!(pDom->arcDOM = xmlCreateElementNode(pParent,
+                                                      pcszElement,
+                                                      &pNew)))
+                // OK, node is valid:
+                // push this on the stack so we can add child elements;
+                // if we validate, element names are interned, and the
+                // symbol has the decl
+                PushElementStack(pDom,
+                                 pNew,
+                                 (pDom->pDocTypeNode)
+                                    ? SymbolFromName(&pNew->NodeBase.strNodeName)->pElementDecl
+                                    : NULL);
+
+            // shall we validate?
+            if (    (!pDom->arcDOM)
+                 && (pDom->pDocTypeNode)
+               )
+                ValidateElement(pDom,
+                                &pNew->NodeBase.strNodeName, // new element
+                                SymbolFromName(&pNew->NodeBase.strNodeName)->ulHash,
+                                (pParent == (PDOMNODE)pDom->pDocumentNode),
+                                pSI->pElementDecl,  // parent's elem decl
+                                &pSI->ulState);
+
+            if (!pDom->arcDOM)
+            {
+                PCMATTRIBUTEDECLBASE pAttribDeclBase = NULL;
+
+                // shall we validate?
+                if (pDom->pDocTypeNode)
+                    // yes: get attrib decl base for speed
+                    pAttribDeclBase
+                        = SymbolFromName(&pNew->NodeBase.strNodeName)->pAttribDeclBase;
+
+                // now for the attribs
+                for (i = 0;
+                     (papcszAttribs[i]) && (!pDom->arcDOM);
+                     i += 2)
+                {
+                    PDOMNODE pAttrib;
+                    PCSZ    pcszValue = papcszAttribs[i + 1];  // attr value
+                    if (!(pDom->arcDOM = xmlCreateAttributeNode(pNew,                  // element,
+                                                                papcszAttribs[i],      // attr name
+                                                                pcszValue,
+                                                                strlen(pcszValue),
+                                                                &pAttrib)))
+                    {
+                        // shall we validate?
+                        if (pDom->pDocTypeNode)
+                        {
+                            PCMATTRIBUTEDECL pAttribDecl = NULL;
+                            PXSTRING pstrAttrib = &pAttrib->NodeBase.strNodeName;
+
+                            // the attribute name is interned too, so we
+                            // have its hash already
+                            if (pAttribDeclBase)
+                                pAttribDecl = (PCMATTRIBUTEDECL)smapFindHash(
+                                                    &pAttribDeclBase->AttribDeclsMap,
+                                                    pstrAttrib->psz,
+                                                    pstrAttrib->ulLength,
+                                                    SymbolFromName(pstrAttrib)->ulHash);
+
+                            ValidateAttributeType(pDom,
+                                                  pAttribDecl,
+                                                  pstrAttrib->psz,
+                                                  pAttrib->pstrNodeValue);
+                        }
+                    }
+                    else
+                    {
+                        xmlSetError(pDom,
+                                    pDom->arcDOM,
+                                    papcszAttribs[i],
+                                    FALSE);      // validation
+                        break;
+                    }
+                }
+
+                // OK, now we got all attributes:
+                // now look for defaults in the DTD,
+                // if we shall validate
+                if (    (pDom->pDocTypeNode)
+                     && (!pDom->arcDOM)
+                     && (pAttribDeclBase)
+                   )
+                    ValidateAllAttributes(pDom,
+                                          pAttribDeclBase,
+                                          papcszAttribs);
+            }
+        }
+    }
+}
+
+/*
+ *@@ EndElementHandler:
+ *      @expat handler for when parsing an element is done.
+ *      We pop the element off of our stack then.
+ *
+ *@@changed V1.0.24 (2026-10-18) [agent]: added FlushText
+ *@@changed V1.0.24 (2026-10-18) [agent]: now validating that the content is complete
+ */
+
+STATIC void EXPATENTRY EndElementHandler(void *pUserData,      // in: our PXMLDOM really
+                                         const XML_Char *name)
+{
+    PXMLDOM     pDom = (PXMLDOM)pUserData;
+
+    FlushText(pDom);
+    // continue parsing only if we had no errors so far
+    if (!pDom->arcDOM)
+    {
+        PLISTNODE pStackLN = NULL;
+        PDOMSTACKITEM pSI = PopElementStack(pDom,
+                                            &pStackLN);
+
+        if (!pDom->arcDOM)
+        {
+            // shall we validate?
+            if (pDom->pDocTypeNode)
+                // yes:
+                ValidateContentEnd(pDom,
+                                   name,
+                                   pSI->pElementDecl,
+                                   pSI->ulState);
+
+            lstRemoveNode(&pDom->llElementStack, pStackLN); // auto-free
+        }
+        else
+            pDom->arcDOM = ERROR_DOM_INTEGRITY;
+    }
+}
+
+/*
+ *@@ CharacterDataHandler:
+ *      @expat handler for character data (@content).
+ *
+ *      Note: expat passes chunks of content without zero-terminating
+ *      them, and a text node usually comes in several (expat
+ *      breaks them at line ends and entity references). We
+ *      collect the chunks in XMLDOM.strText, which is reused
+ *      for all text nodes, and FlushText creates the text node
+ *      from all of them when the next markup comes along. So
+ *      every text node is allocated once, with its final size.
+ *
+ *@@changed V1.0.24 (2026-10-18) [agent]: added DF_ARENA support
+ *@@changed V1.0.24 (2026-10-18) [agent]: moved validation to ValidateCharacterData
+ *@@changed V1.0.24 (2026-10-18) [agent]: now collecting the chunks for FlushText
+ */
+
+STATIC void EXPATENTRY CharacterDataHandler(void *pUserData,      // in: our PXMLDOM really
+                                            const XML_Char *s,
+                                            int len)
+{
+    PXMLDOM     pDom = (PXMLDOM)pUserData;
+
+    // continue parsing only if we had no errors so far
+    if (    (!pDom->arcDOM)
+         && (len)
+       )
+    {
+        PDOMSTACKITEM pSI = PopElementStack(pDom,
+                                            NULL);     // no free
+        if (!pDom->arcDOM)
+        {
+            PXSTRING    pstr = &pDom->strText;
+
+            // shall we validate?
+            if (    (pDom->pDocTypeNode)
+                 && (pSI->pElementDecl)
+                 // yes: check if the parent element allows
+                 // for content at all (must be "mixed" model);
+                 // this is TRUE if we are validating and the
+                 // element does _not_ have mixed content and
+                 // DF_DROP_WHITESPACE is set, but the string is
+                 // whitespace only --> drop it then
+                 && (ValidateCharacterData(pDom,
+                                           pSI->pElementDecl,
+                                           s,
+                                           len))
+               )
+                return;
+
+            if (pDom->arcDOM)
+                return;
+
+            // grow by doubling, as a long text comes in
+            // many chunks
+            if (pstr->ulLength + len + 1 > pstr->cbAllocated)
+            {
+                ULONG cbAllocate = pstr->cbAllocated * 2;
+                if (cbAllocate < pstr->ulLength + len + 1)
+                    cbAllocate = pstr->ulLength + len + 1;
+                if (!xstrReserve(pstr, cbAllocate))
+                {
+                    pDom->arcDOM = ERROR_NOT_ENOUGH_MEMORY;
+                    return;
+                }
+            }
+
+            memcpy(pstr->psz + pstr->ulLength, s, len);
+            pstr->ulLength += len;
+            pstr->psz[pstr->ulLength] = '\0';
+        }
+    }
+}
+
+/*
+ *@@ CommentHandler:
+ *      @expat handler for @comments.
+ *
+ *      Note: This is only set if DF_PARSECOMMENTS is
+ *      flagged with xmlCreateDOM.
+ *
+ *@@added V0.9.9 (2001-02-14) [umoeller]
+ *@@changed V1.0.24 (2026-10-18) [agent]: text after a comment was appended to the text before it
+ */
+
+STATIC void EXPATENTRY CommentHandler(void *pUserData,      // in: our PXMLDOM really
+                                      const XML_Char *data)
+{
+    PXMLDOM     pDom = (PXMLDOM)pUserData;
+
+    FlushText(pDom);
+
+    // continue parsing only if we had no errors so far
+    if (!pDom->arcDOM)
+    {
+        // we need a new text node:
+        PDOMSTACKITEM pSI = PopElementStack(pDom,
+                                            NULL);     // no free
+        if (!pDom->arcDOM)
+        {
+            PDOMNODE    pParent = pSI->pDomNode,
+                        pNew = NULL;
+
+            pDom->arcDOM = xmlCreateCommentNode(pParent,
+                                                data,
+                                                &pNew);
+        }
+    }
+}
+
+/*
+ *@@ StartDoctypeDeclHandler:
+ *      @expat handler that is called at the start of a DOCTYPE
+ *      declaration, before any external or internal subset is
+ *      parsed.
+ *
+ *      Both pcszSysid and pcszPubid may be NULL. "fHasInternalSubset"
+ *      will be non-zero if the DOCTYPE declaration has an internal subset.
+ *
+ *@@added V0.9.9 (2001-02-14) [umoeller]
+ */
+
+STATIC void EXPATENTRY StartDoctypeDeclHandler(void *pUserData,
+                                               const XML_Char *pcszDoctypeName,
+                                               const XML_Char *pcszSysid,
+                                               const XML_Char *pcszPubid,
+                                               int fHasInternalSubset)
+{
+    PXMLDOM     pDom = (PXMLDOM)pUserData;
+
+    // continue parsing only if we had no errors so far
+    if (!pDom->arcDOM)
+    {
+        // get the document node
+        PDOMDOCUMENTNODE pDocumentNode = pDom->pDocumentNode;
+        if (!pDocumentNode)
+            pDom->arcDOM = ERROR_DOM_NO_DOCUMENT;
+        else
+        {
+            // doctype must be null
+            if (pDom->pDocTypeNode)
+                pDom->arcDOM = ERROR_DOM_DUPLICATE_DOCTYPE;
+            else
+                pDom->arcDOM = xmlCreateDocumentTypeNode(pDocumentNode,
+                                                         pcszDoctypeName,
+                                                         pcszSysid,
+                                                         pcszPubid,
+                                                         fHasInternalSubset,
+                                                         &pDom->pDocTypeNode);
+        }
+    }
+}
+
+/*
+ *@@ EndDoctypeDeclHandler:
+ *      @expat handler that is called at the end of a DOCTYPE
+ *      declaration, after parsing any external subset.
+ *
+ *@@added V0.9.9 (2001-02-14) [umoeller]
+ */
+
+STATIC void EXPATENTRY EndDoctypeDeclHandler(void *pUserData)      // in: our PXMLDOM really
+{
+    PXMLDOM     pDom = (PXMLDOM)pUserData;
+
+    // continue parsing only if we had no errors so far
+    if (!pDom->arcDOM)
+    {
+    }
+}
+
+/*
+ *@@ NotationDeclHandler:
+ *      @expat handler for @notation_declarations.
+ *
+ *      @@todo
+ *
+ *@@added V0.9.9 (2001-02-14) [umoeller]
+ */
+
+STATIC void EXPATENTRY NotationDeclHandler(void *pUserData,      // in: our PXMLDOM really
+                                           const XML_Char *pcszNotationName,
+                                           const XML_Char *pcszBase,
+                                           const XML_Char *pcszSystemId,
+                                           const XML_Char *pcszPublicId)
+{
+    PXMLDOM     pDom = (PXMLDOM)pUserData;
+
+    // continue parsing only if we had no errors so far
+    if (!pDom->arcDOM)
+    {
+    }
+}
+
+/*
+ *@@ XMLDTD:
+ *      compiled DTD created by xmlCreateDTD. This is
+ *      a DOM of its own, which has parsed a DOCTYPE
+ *      referring to the DTD, so that pDom->pDocTypeNode
+ *      has all the declarations.
+ *
+ *      After xmlCreateDTD, nothing in here is ever
+ *      changed, so any number of DOMs on any number of
+ *      threads can use it at the same time.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+typedef struct _XMLDTD
+{
+    PXMLDOM         pDom;           // parser is freed after xmlCreateDTD
+    STATICSYSTEMID  SystemId;       // point into achData
+    ULONG           cbContent;      // strlen(SystemId.pcszContent)
+    CHAR            achData[1];     // system ID and content, null-terminated
+} XMLDTD;
+
+/*
+ *@@ GetDeclarations:
+ *      returns the DOCTYPE node whose maps have the
+ *      declarations for the document: the shared DTD's
+ *      if the document uses one, its own otherwise.
+ *      Returns NULL if the document has no DOCTYPE.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+STATIC PDOMDOCTYPENODE GetDeclarations(PXMLDOM pDom)
+{
+    if (    (pDom->pDocTypeNode)
+         && (pDom->pSharedDocType)
+       )
+        return pDom->pSharedDocType;
+
+    return pDom->pDocTypeNode;
+}
+
+/*
+ *@@ UseSharedDTD:
+ *      makes the document use the declarations of
+ *      the given shared DTD instead of building its
+ *      own. This only sets the declarations in the
+ *      document's symbols, which is where validation
+ *      looks for them, so it's a lot cheaper than
+ *      ElementDeclHandler and AttlistDeclHandler.
+ *
+ *      Returns FALSE if we're out of memory.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+STATIC BOOL UseSharedDTD(PXMLDOM pDom,
+                         const XMLDTD *pDTD)
+{
+    PDOMDOCTYPENODE pShared = pDTD->pDom->pDocTypeNode;
+    PSTRMAPSLOT     pSlot;
+    ULONG           ul = 0;
+
+    while (pSlot = smapEnum(&pShared->ElementDeclsMap, &ul))
+    {
+        PDOMSYMBOL pSymbol;
+        if (!(pSymbol = InternName(pDom->pDocumentNode,
+                                   pSlot->pcszKey,
+                                   pSlot->ulLength)))
+            return FALSE;
+        pSymbol->pElementDecl = (PCMELEMENTDECLNODE)pSlot->pvData;
+    }
+
+    ul = 0;
+    while (pSlot = smapEnum(&pShared->AttribDeclBasesMap, &ul))
+    {
+        PDOMSYMBOL pSymbol;
+        if (!(pSymbol = InternName(pDom->pDocumentNode,
+                                   pSlot->pcszKey,
+                                   pSlot->ulLength)))
+            return FALSE;
+        pSymbol->pAttribDeclBase = (PCMATTRIBUTEDECLBASE)pSlot->pvData;
+    }
+
+    pDom->pSharedDocType = pShared;
+
+    return TRUE;
+}
+
+/*
+ *@@ ExternalEntityRefHandler:
+ *      @expat handler for references to @external_entities.
+ *
+ *      This handler is also called for processing an external DTD
+ *      subset if parameter entity parsing is in effect.
+ *      (See XML_SetParamEntityParsing.)
+ *
+ *      The pcszContext argument specifies the parsing context in the
+ *      format expected by the context argument to
+ *      XML_ExternalEntityParserCreate; pcszContext is valid only until
+ *      the handler returns, so if the referenced entity is to be
+ *      parsed later, it must be copied.
+ *
+ *      The pcszBase parameter is the base to use for relative system
+ *      identifiers. It is set by XML_SetBase and may be null.
+ *
+ *      The pcszPublicId parameter is the public id given in the entity
+ *      declaration and may be null (since XML doesn't require public
+ *      identifiers).
+ *
+ *      The pcszSystemId is the system identifier specified in the
+ *      entity declaration and is never null. This is an exact copy
+ *      of what was specified in the reference.
+ *
+ *      There are a couple of ways in which this handler differs
+ *      from others. First, this handler returns an integer. A
+ *      non-zero value should be returned for successful handling
+ *      of the external entity reference. Returning a zero indicates
+ *      failure, and causes the calling parser to return an
+ *      ERROR_EXPAT_EXTERNAL_ENTITY_HANDLING error.
+ *
+ *      Second, instead of having pUserData as its first argument,
+ *      it receives the parser that encountered the entity reference.
+ *      This, along with the context parameter, may be used as
+ *      arguments to a call to XML_ExternalEntityParserCreate.
+ *      Using the returned parser, the body of the external entity
+ *      can be recursively parsed.
+ *
+ *      Since this handler may be called recursively, it should not
+ *      be saving information into global or static variables.
+ *
+ *      Your handler isn't actually responsible for parsing the entity,
+ *      but it is responsible for creating a subsidiary parser with
+ *      XML_ExternalEntityParserCreate that will do the job. That returns
+ *      an instance of XML_Parser that has handlers and other data
+ *      structures initialized from the parent parser. You may then use
+ *      XML_Parse or XML_ParseBuffer calls against that parser. Since
+ *      external entities may refer to other external entities, your
+ *      handler should be prepared to be called recursively.
+ *
+ *      If a shared DTD was given to xmlSetDTD and this is its
+ *      system ID, we parse its content. If the document has no
+ *      internal subset, which could add to the declarations,
+ *      the document then uses the shared declarations (see
+ *      UseSharedDTD), and expat only gets to see the DTD for
+ *      entities and attribute defaults.
+ *
+ *@@added V0.9.14 (2001-08-09) [umoeller]
+ *@@changed V0.9.20 (2002-07-06) [umoeller]: added automatic doctype support
+ *@@changed V1.0.24 (2026-10-18) [agent]: added shared DTD support
+ */
+
+STATIC int EXPATENTRY ExternalEntityRefHandler(void *pUserData,      // in: our PXMLDOM really
+                                               XML_Parser parser,
+                                               const XML_Char *pcszContext,
+                                               const XML_Char *pcszBase,
+                                               const XML_Char *pcszSystemId,
+                                               const XML_Char *pcszPublicId)
+{
+    PXMLDOM     pDom = (PXMLDOM)pUserData;
+
+    int i = 0;          // return error per default
+
+    // store the previous parser because
+    // all the callbacks use the parser pointer
+    XML_Parser pOldParser = pDom->pParser;
+    pDom->pParser = NULL;
+
+    if (    (    (pDom->pfnExternalHandler)
+              || (pDom->cSystemIds)      // V0.9.20 (2002-07-06) [umoeller]
+              || (pDom->pDTD)            // V1.0.24 (2026-10-18) [agent]
+            )
+            // create sub-parser and replace the one
+            // in the DOM with it
+         && (pDom->pParser = XML_ExternalEntityParserCreate(parser,
+                                                            pcszContext,
+                                                            "US-ASCII"))
+       )
+    {
+        // run through the predefined doctypes given to us
+        // in xmlCreateDOM, if any
+        // V0.9.20 (2002-07-06) [umoeller]
+        BOOL fCallExternal = TRUE;
+        ULONG ul;
+        const XMLDTD *pDTD = pDom->pDTD;
+
+        if (    (pDTD)
+             && (!strcmp(pDTD->SystemId.pcszSystemId, pcszSystemId))
+           )
+        {
+            if (    (pDom->pDocTypeNode)
+                 && (!pDom->pDocTypeNode->fHasInternalSubset)
+                 && (!pDom->pSharedDocType)
+               )
+            {
+                // we have the declarations already, so only
+                // expat needs to parse the DTD
+                XML_SetElementDeclHandler(pDom->pParser, NULL);
+                XML_SetAttlistDeclHandler(pDom->pParser, NULL);
+                if (!UseSharedDTD(pDom, pDTD))
+                    pDom->arcDOM = ERROR_NOT_ENOUGH_MEMORY;
+            }
+
+            if (    (!pDom->arcDOM)
+                 && (XML_Parse(pDom->pParser,
+                               pDTD->SystemId.pcszContent,
+                               pDTD->cbContent,
+                               TRUE))
+               )
+                i = 1;      // success
+
+            fCallExternal = FALSE;
+        }
+
+        for (ul = 0;
+             (fCallExternal) && (ul < pDom->cSystemIds);
+             ++ul)
+        {
+            const STATICSYSTEMID *pThis = &pDom->paSystemIds[ul];
+            if (!strcmp(pThis->pcszSystemId, pcszSystemId))
+            {
+                // this one matches:
+                // then parse the corresponding entry given
+                // to us
+                if (XML_Parse(pDom->pParser,
+                              pThis->pcszContent,
+                              strlen(pThis->pcszContent),
+                              TRUE))
+                    i = 1;      // success
+
+                fCallExternal = FALSE;
+
+                break;
+            }
+        }
+
+        if (    (fCallExternal)     // not handled above
+             && (pDom->pfnExternalHandler) // user handler set
+           )
+        {
+            APIRET  arc;
+
+            if (!(arc = pDom->pfnExternalHandler(pDom,
+                                                 pDom->pParser,
+                                                 pcszSystemId,
+                                                 pcszPublicId)))
+                i = 1;      // success
+            else
+            {
+                // error:
+                // now this needs special handling, since we're
+                // dealing with a sub-handler here...
+
+                if (arc == -1)
+                    // parser error: well, then xmlSetError has been
+                    // called from somewhere in the callbacks already,
+                    // and we can safely ignore this
+                    ;
+                else
+                {
+                    pDom->arcDOM = arc;
+                    if (pcszSystemId)
+                    {
+                        if (!pDom->pxstrFailingNode)
+                            pDom->pxstrFailingNode = xstrCreate(0);
+                        xstrcpy(pDom->pxstrFailingNode, pcszSystemId, 0);
+                    }
+                    pDom->pcszErrorDescription = xmlDescribeError(arc);
+                    pDom->ulErrorLine = XML_GetCurrentLineNumber(pDom->pParser);
+                    pDom->ulErrorColumn = XML_GetCurrentColumnNumber(pDom->pParser);
+                }
+            }
+        }
+    }
+    else
+        xmlSetError(pDom,
+                    ERROR_DOM_INVALID_EXTERNAL_HANDLER,
+                    NULL,
+                    FALSE);
+
+    if (pDom->pParser)
+        XML_ParserFree(pDom->pParser);
+
+    pDom->pParser = pOldParser;
+
+    return i;
+}
+
+/*
+ *@@ ElementDeclHandler:
+ *      @expat handler for element declarations in a DTD. The
+ *      handler gets called with the name of the element in
+ *      the declaration and a pointer to a structure that contains
+ *      the element model.
+ *
+ *      It is the application's responsibility to free this data
+ *      structure. @@todo
+ *
+ *      The XML spec defines that no element may be declared more
+ *      than once.
+ *
+ *@@added V0.9.9 (2001-02-14) [umoeller]
+ *@@changed V1.0.24 (2026-10-18) [agent]: DTD declarations are now in STRMAP hash maps
+ *@@changed V1.0.24 (2026-10-18) [agent]: the declaration is also cached in the symbol table
+ */
+
+STATIC void EXPATENTRY ElementDeclHandler(void *pUserData,      // in: our PXMLDOM really
+                                          const XML_Char *pcszName,
+                                          XMLCONTENT *pModel)
+{
+    PXMLDOM     pDom = (PXMLDOM)pUserData;
+
+    // continue parsing only if we had no errors so far
+    if (!pDom->arcDOM)
+    {
+        // OK, we're in a DOCTYPE node:
+        PDOMDOCTYPENODE pDocType = pDom->pDocTypeNode;
+        if (!pDocType)
+            xmlSetError(pDom,
+                        ERROR_DOM_ELEMENT_DECL_OUTSIDE_DOCTYPE,
+                        pcszName,
+                        TRUE);
+        else
+        {
+            // create an element declaration and push it unto the
+            // declarations tree
+            PCMELEMENTDECLNODE pNew = NULL;
+            if (!(pDom->arcDOM = xmlCreateElementDecl(pcszName,
+                                                      pModel,
+                                                      &pNew)))
+                                    // this recurses!!
+                                    // after this, pModel is invalid
+            {
+                PDOMSYMBOL pSymbol;
+                int i;
+
+                // add this to the doctype's declarations map
+                if ((i = InsertDecl(&pDocType->ElementDeclsMap,
+                                    (PNODEBASE)pNew))
+                        == SMAP_DUPLICATE_KEY)
+                    // element already declared:
+                    // according to the XML specs, this is a validity
+                    // constraint, so we report a validation error
+                    xmlSetError(pDom,
+                                ERROR_DOM_DUPLICATE_ELEMENT_DECL,
+                                pNew->Particle.NodeBase.strNodeName.psz,
+                                TRUE);
+                else if (i)
+                    pDom->arcDOM = ERROR_NOT_ENOUGH_MEMORY;
+                // and to the symbol for the element name, which
+                // is where validation will look for it
+                else if (pSymbol = InternName(pDom->pDocumentNode,
+                                              pcszName,
+                                              0))
+                    pSymbol->pElementDecl = pNew;
+                else
+                    pDom->arcDOM = ERROR_NOT_ENOUGH_MEMORY;
+            }
+        }
+    }
+}
+
+/*
+ *@@ AddEnum:
+ *
+ *@@added V0.9.9 (2001-02-16) [umoeller]
+ */
+
+STATIC APIRET AddEnum(PCMATTRIBUTEDECL pDecl,
+                      const char *p,           // in: start of name
+                      const char *pNext)       // in: end of name (not included)
+{
+    // PSZ pszType = strhSubstr(p, pNext);
+    PNODEBASE pNew = NULL;
+    APIRET arc;
+
+    if (!(arc = xmlCreateNodeBase(ATTRIBUTE_DECLARATION_ENUM,
+                                  sizeof(NODEBASE),
+                                  p,
+                                  (pNext - p),
+                                  &pNew)))
+        treeInsert(&pDecl->ValuesTree,
+                   NULL,
+                   (TREE*)pNew,
+                   CompareXStrings);
+
+    return arc;
+}
+
+/*
+ *@@ AttlistDeclHandler:
+ *      @expat handler for attlist declarations in the DTD.
+ *
+ *      This handler is called for each attribute. So a single attlist
+ *      declaration with multiple attributes declared will generate
+ *      multiple calls to this handler.
+ *
+ *      --  pcszElementName is the name of the  element for which the
+ *          attribute is being declared.
+ *
+ *      --  pcszAttribName has the attribute name being declared.
+ *
+ *      --  pcszAttribType is the attribute type.
+ *          It is the string representing the type in the declaration
+ *          with whitespace removed.
+ *
+ *      --  pcszDefault holds the default value. It will be
+ *          NULL in the case of "#IMPLIED" or "#REQUIRED" attributes.
+ *          You can distinguish these two cases by checking the
+ *          fIsRequired parameter, which will be true in the case of
+ *          "#REQUIRED" attributes. Attributes which are "#FIXED"
+ *          will have also have a TRUE fIsRequired, but they will have
+ *          the non-NULL fixed value in the pcszDefault parameter.
+ *
+ *@@added V0.9.9 (2001-02-14) [umoeller]
+ *@@changed V1.0.24 (2026-10-18) [agent]: DTD declarations are now in STRMAP hash maps
+ *@@changed V1.0.24 (2026-10-18) [agent]: the declaration is also cached in the symbol table
+ */
+
+STATIC void EXPATENTRY AttlistDeclHandler(void *pUserData,      // in: our PXMLDOM really
+                                          const XML_Char *pcszElementName,
+                                          const XML_Char *pcszAttribName,
+                                          const XML_Char *pcszAttribType,
+                                          const XML_Char *pcszDefault,
+                                          int fIsRequired)
+{
+    PXMLDOM     pDom = (PXMLDOM)pUserData;
+
+    // continue parsing only if we had no errors so far
+    if (!pDom->arcDOM)
+    {
+        // OK, we're in a DOCTYPE node:
+        PDOMDOCTYPENODE pDocType = pDom->pDocTypeNode;
+        if (!pDocType)
+            xmlSetError(pDom,
+                        ERROR_DOM_ATTLIST_DECL_OUTSIDE_DOCTYPE,
+                        pcszElementName,
+                        TRUE);
+        else
+        {
+            PCMATTRIBUTEDECLBASE    pThis = NULL,
+                                    pCache = pDom->pAttListDeclCache;
+
+            // check if this is for the same attlist as the previous
+            // call (we cache the pointer for speed)
+            if (    (pCache)
+                 && (!strhcmp(pCache->NodeBase.strNodeName.psz,
+                              pcszElementName))
+               )
+                // this attdecl is for the same element:
+                // use that (we won't have to search the tree)
+                pThis = pDom->pAttListDeclCache;
+
+            if (!pThis)
+            {
+                // cache didn't match: look up attributes map then...
+                // note: cheap trick, we need an XSTRING for FindDecl
+                // but don't want malloc, so we use xstrInitSet
+                XSTRING strElementName;
+                xstrInitSet(&strElementName, (PSZ)pcszElementName);
+                if (!(pThis = (PCMATTRIBUTEDECLBASE)FindDecl(
+                                    &pDocType->AttribDeclBasesMap,
+                                    &strElementName)))
+                {
+                    // still not found:
+                    // we need a new node then
+                    if (!(pDom->arcDOM = xmlCreateNodeBase(ATTRIBUTE_DECLARATION_BASE,
+                                                     sizeof(CMATTRIBUTEDECLBASE),
+                                                     strElementName.psz,
+                                                     strElementName.ulLength,
+                                                     (PNODEBASE*)&pThis)))
+                    {
+                        PDOMSYMBOL pSymbol;
+
+                        // initialize the submap
+                        smapInit(&pThis->AttribDeclsMap);
+
+                        if (    (!(pSymbol = InternName(pDom->pDocumentNode,
+                                                        strElementName.psz,
+                                                        strElementName.ulLength)))
+                             || (InsertDecl(&pDocType->AttribDeclBasesMap,
+                                            (PNODEBASE)pThis))
+                           )
+                        {
+                            // can only be out of memory
+                            xmlDeleteNode((PNODEBASE)pThis);
+                            pThis = NULL;
+                            pDom->arcDOM = ERROR_NOT_ENOUGH_MEMORY;
+                        }
+                        else
+                            // cache for validation
+                            pSymbol->pAttribDeclBase = pThis;
+                    }
+                }
+
+                pDom->pAttListDeclCache = pThis;
+            }
+
+            if (pThis)
+            {
+                // pThis now has either an existing or a new CMATTRIBUTEDECLBASE;
+                // add a new attribute def (CMATTRIBUTEDEDECL) to that
+                PCMATTRIBUTEDECL  pNew = NULL;
+                if (!(pDom->arcDOM = xmlCreateNodeBase(ATTRIBUTE_DECLARATION,
+                                                       sizeof(CMATTRIBUTEDECL),
+                                                       pcszAttribName,
+                                                       0,
+                                                       (PNODEBASE*)&pNew)))
+                {
+                    treeInit(&pNew->ValuesTree, NULL);
+
+                    // check the type... expat is too lazy to parse this for
+                    // us, so we must check manually. Expat only normalizes
+                    // the "type" string to kick out whitespace, so we get:
+                    // (TYPE1|TYPE2|TYPE3)
+                    if (*pcszAttribType == '(')
+                    {
+                        // enumeration:
+                        const char *p = pcszAttribType + 1,
+                                   *pNext;
+                        while (    (pNext = strchr(p, '|'))
+                                && (!pDom->arcDOM)
+                              )
+                        {
+                            pDom->arcDOM = AddEnum(pNew, p, pNext);
+                            p = pNext + 1;
+                        }
+
+                        if (!pDom->arcDOM)
+                        {
+                            pNext = strchr(p, ')');
+                            AddEnum(pNew, p, pNext);
+
+                            pNew->ulAttrType = CMAT_ENUM;
+                        }
+                    }
+                    else if (!strcmp(pcszAttribType, "CDATA"))
+                        pNew->ulAttrType = CMAT_CDATA;
+                    else if (!strcmp(pcszAttribType, "ID"))
+                        pNew->ulAttrType = CMAT_ID;
+                    else if (!strcmp(pcszAttribType, "IDREF"))
+                        pNew->ulAttrType = CMAT_IDREF;
+                    else if (!strcmp(pcszAttribType, "IDREFS"))
+                        pNew->ulAttrType = CMAT_IDREFS;
+                    else if (!strcmp(pcszAttribType, "ENTITY"))
+                        pNew->ulAttrType = CMAT_ENTITY;
+                    else if (!strcmp(pcszAttribType, "ENTITIES"))
+                        pNew->ulAttrType = CMAT_ENTITIES;
+                    else if (!strcmp(pcszAttribType, "NMTOKEN"))
+                        pNew->ulAttrType = CMAT_NMTOKEN;
+                    else if (!strcmp(pcszAttribType, "NMTOKENS"))
+                        pNew->ulAttrType = CMAT_NMTOKENS;
+
+                    if (!pDom->arcDOM)
+                    {
+                        int i;
+
+                        if (pcszDefault)
+                        {
+                            // fixed or default:
+                            if (fIsRequired)
+                                // fixed:
+                                pNew->ulConstraint = CMAT_FIXED_VALUE;
+                            else
+                                pNew->ulConstraint = CMAT_DEFAULT_VALUE;
+
+                            pNew->pstrDefaultValue = xstrCreate(0);
+                            xstrcpy(pNew->pstrDefaultValue, pcszDefault, 0);
+                        }
+                        else
+                            // implied or required:
+                            if (fIsRequired)
+                                pNew->ulConstraint = CMAT_REQUIRED;
+                            else
+                                pNew->ulConstraint = CMAT_IMPLIED;
+
+                        if ((i = InsertDecl(&pThis->AttribDeclsMap,
+                                            (PNODEBASE)pNew))
+                                == SMAP_DUPLICATE_KEY)
+                            xmlSetError(pDom,
+                                        ERROR_DOM_DUPLICATE_ATTRIBUTE_DECL,
+                                        pcszAttribName,
+                                        TRUE);
+                        else if (i)
+                            pDom->arcDOM = ERROR_NOT_ENOUGH_MEMORY;
+                    }
+                }
+            }
+        }
+    }
+}
+
+/*
+ *@@ EntityDeclHandler:
+ *      @expat handler that will be called for all entity declarations.
+ *
+ *      The fIsParameterEntity argument will be non-zero in the case
+ *      of parameter entities and zero otherwise.
+ *
+ *      For internal entities (<!ENTITY foo "bar">), pcszValue will be
+ *      non-NULL and pcszSystemId, pcszPublicId, and pcszNotationName
+ *      will all be NULL. The value string is not NULL terminated; the
+ *      length is provided in the iValueLength parameter. Do not use
+ *      iValueLength to test for internal entities, since it is legal
+ *      to have zero-length values. Instead check for whether or not
+ *      pcszValue is NULL.
+ *
+ *      The pcszNotationName argument will have a non-NULL value only
+ *      for unparsed entity declarations.
+ *
+ *@@added V0.9.9 (2001-02-14) [umoeller]
+ */
+
+STATIC void EXPATENTRY EntityDeclHandler(void *pUserData,      // in: our PXMLDOM really
+                                         const XML_Char *pcszEntityName,
+                                         int fIsParameterEntity,
+                                         const XML_Char *pcszValue,
+                                         int iValueLength,
+                                         const XML_Char *pcszBase,
+                                         const XML_Char *pcszSystemId,
+                                         const XML_Char *pcszPublicId,
+                                         const XML_Char *pcszNotationName)
+{
+    PXMLDOM     pDom = (PXMLDOM)pUserData;
+
+    // continue parsing only if we had no errors so far
+    if (!pDom->arcDOM)
+    {
+    }
+}
+
+/* ******************************************************************
+ *
+ *   DOM parser APIs
+ *
+ ********************************************************************/
+
+/*
+ *@@ xmlCreateDOM:
+ *      creates an XMLDOM instance, which can be used for parsing
+ *      an XML document and building a @DOM tree from it at the
+ *      same time.
+ *
+ *      Pass the XMLDOM returned here to xmlParse afterwards.
+ *
+ *      Simplest possible usage:
+ *
+ *      1) Create a DOM instance.
+ *
+ +          PXMLDOM pDom = NULL;
+ +          APIRET arc = xmlCreateDOM(flags, NULL, NULL, NULL, &pDom);
+ +
+ *      2) Give chunks of data (or an entire buffer)
+ *         to the DOM instance for parsing.
+ *
+ +          arc = xmlParse(pDom,
+ +                         pBuf,
+ +                         TRUE); // if last, this will clean up the parser
+ *
+ *      3) Process the data in the DOM tree.
+ *
+ *         Look at the DOMNODE definition to see how you
+ *         can traverse the data. Essentially, everything
+ *         is based on linked nodes and string maps.
+ *
+ *         A few helper functions have been added for
+ *         quick lookup. See xmlGetRootElement,
+ *         xmlGetFirstChild, xmlGetLastChild, xmlGetNextSibling,
+ *         xmlGetFirstText, xmlGetElementsByTagName, xmlGetAttribute.
+ *         For anything deeper, use xmlCompilePath with
+ *         xmlSelectNodes or xmlSelectSingleNode.
+ *
+ *      4) When done, call xmlFreeDOM, which will free all memory.
+ *
+ *      The above code has limitations: only a few character
+ *      @encodings are supported, and @external_entities are
+ *      silently ignored.
+ *
+ *      This function supports a number of callbacks and flags
+ *      to allow for maximum flexibility. Note however that
+ *      not all @expat features are supported yet.
+ *
+ *      flParserFlags is any combination of the following:
+ *
+ *      --  DF_PARSECOMMENTS: XML @comments are to be returned in
+ *          the DOM tree. Otherwise they are discarded.
+ *
+ *      --  DF_PARSEDTD: add the @DTD of the document into the DOM tree
+ *          as well and validate the document, if a DTD was found.
+ *          Otherwise just parse and do not validate.
+ *
+ *          DF_PARSEDTD is required for external entities to work
+ *          also.
+ *
+ *      --  DF_FAIL_IF_NO_DTD: fail if no @DTD was found. Useful
+ *          if you want to enforce validation. @@todo
+ *
+ *      --  DF_DROP_WHITESPACE: discard all @whitespace for those
+ *          elements that can only have element content. Whitespace
+ *          will be preserved only for elements that can have
+ *          mixed content. -- If this flag is not set, all whitespace
+ *          is preserved.
+ *
+ *      --  DF_ARENA: allocate the nodes, their names and their
+ *          values from large blocks owned by the document instead
+ *          of from the heap one by one, which takes much less
+ *          memory and time for large documents. xmlFreeDOM then
+ *          frees the blocks without visiting the nodes. The
+ *          DOCTYPE and the DTD declarations are still on the heap.
+ *
+ *          The strings of such a DOM must be treated as read-only:
+ *          do not pass them to xstr* functions that modify or free
+ *          them. xmlCreate*Node and xmlDeleteNode work as usual
+ *          (the latter only unlinks the node).
+ *
+ *      The following callbacks can be specified (any of these
+ *      can be NULL):
+ *
+ *      --  pfnGetCPData should be specified if you want to
+ *          support character @encodings other than the
+ *          four that built into expat itself (see
+ *          XML_SetUnknownEncodingHandler). This is probably
+ *          a good idea to do under OS/2 since most OS/2
+ *          documents are in a PC-specific codepage such as
+ *          CP 850.
+ *
+ *          This callback must have the following prototype:
+ *
+ +              int APIENTRY FNGETCPDATA(PXMLDOM pDom, ULONG ulCP, int *piMap)
+ *
+ *          The callback will only be called once for each
+ *          document if the "encoding" attribute of the
+ *          XML @text_declaration starts with "cp" (e.g.
+ *          "cp850") and will then receive the following
+ *          parameters:
+ *
+ *          --  "pDom" will be the XMLDOM created by this function.
+ *
+ *          --  ulCP has the IBM code page number, such as "850".
+ *
+ *          --  piMap is an array of 256 integer values which must
+ *              be filled with the callback. Each array item index
+ *              is the codepage value, and the value of each field
+ *              is the corresponding Unicode value, or -1 if the
+ *              character is invalid (shouldn't happen with codepages).
+ *
+ *              For example, the German o-umlaut character is
+ *              0x94 in CP850 and 0x00f6 in Unicode. So set
+ *              the int at index 0x94 to 0x00f6.
+ *
+ *      --  pfnExternalHandler should be specified if you want the
+ *          parser to be able to handle @external_entities. Since
+ *          the parser has no concept of storage whatsoever, it is
+ *          the responsibility of this callback to supply the parser
+ *          with additional XML data when an external entity reference
+ *          is encountered.
+ *
+ *          This callback must have the following prototype:
+ *
+ +              APIRET APIENTRY ParseExternal(PXMLDOM pDom,
+ +                                            XML_Parser pSubParser,
+ +                                            const char *pcszSystemID,
+ +                                            const char *pcszPublicID)
+ +
+ *
+ *          The callback will be called for each reference that refers
+ *          to an external entity. pSubParser is a sub-parser created
+ *          by the DOM engine, and pcszSystemID and pcszPublicID
+ *          reference the external entity by means of a URI. As always
+ *          with XML, the system ID is required, while the public ID is
+ *          optional.
+ *
+ *          In the simplest case, this code could look as follows:
+ *
+ +              APIRET arc = ERROR_FILE_NOT_FOUND;
+ +
+ +              if (pcszSystemID)
+ +              {
+ +                  PSZ pszContents = NULL;
+ +                  if (!(arc = doshLoadTextFile(pcszSystemID,
+ +                                               &pszContents,
+ +                                               NULL)))
+ +                  {
+ +                      if (!XML_Parse(pSubParser,
+ +                                     pszContents,
+ +                                     strlen(pszContents),
+ +                                     TRUE))
+ +                          arc = -1;
+ +
+ +                      free(pszContents);
+ +                  }
+ +              }
+ +
+ +              return arc;
+ *
+ *      --  pvCallbackUser is a user parameter which is simply stored
+ *          in the XMLDOM struct which is returned. Since the XMLDOM
+ *          is passed to all the callbacks, you can access that pointer
+ *          from them.
+ *
+ *@@added V0.9.9 (2001-02-14) [umoeller]
+ *@@changed V0.9.14 (2001-08-09) [umoeller]: added DF_DROP_WHITESPACE support
+ *@@changed V0.9.20 (2002-07-06) [umoeller]: added static system IDs
+ *@@changed V1.0.24 (2026-10-18) [agent]: added DF_ARENA
+ */
+
+APIRET xmlCreateDOM(ULONG flParserFlags,            // in: DF_* parser flags
+                    const STATICSYSTEMID *paSystemIds, // in: array of STATICSYSTEMID's or NULL
+                    ULONG cSystemIds,                // in: array item count
+                    PFNGETCPDATA pfnGetCPData,      // in: codepage callback or NULL
+                    PFNEXTERNALHANDLER pfnExternalHandler, // in: external entity callback or NULL
+                    PVOID pvCallbackUser,           // in: user param for callbacks
+                    PXMLDOM *ppDom)                 // out: XMLDOM struct created
+{
+    APIRET      arc = NO_ERROR;
+    PXMLDOM     pDom;
+    PDOMNODE    pDocument = NULL;
+
+    if (!(pDom = (PXMLDOM)malloc(sizeof(*pDom))))
+        return ERROR_NOT_ENOUGH_MEMORY;
+
+    memset(pDom, 0, sizeof(XMLDOM));
+
+    pDom->flParserFlags = flParserFlags;
+    pDom->pfnGetCPData = pfnGetCPData;
+    pDom->pfnExternalHandler = pfnExternalHandler;
+    pDom->pvCallbackUser = pvCallbackUser;
+
+    // these added with V0.9.20 (2002-07-06) [umoeller]
+    pDom->paSystemIds = paSystemIds;
+    pDom->cSystemIds = cSystemIds;
+
+    lstInit(&pDom->llElementStack,
+            TRUE);                 // auto-free
+
+    xstrInit(&pDom->strText, 0);
+
+    // create the document node
+    if (!(arc = xmlCreateDomNode(NULL, // no parent
+                                 DOMNODE_DOCUMENT,
+                                 NULL,
+                                 0,
+                                 &pDocument)))
+    {
+        // store the document in the DOM
+        pDom->pDocumentNode = (PDOMDOCUMENTNODE)pDocument;
+
+        // push the document on the stack so the handlers
+        // will append to that
+        PushElementStack(pDom,
+                         pDocument,
+                         NULL);
+
+        if (    (flParserFlags & DF_ARENA)
+             && (!(pDom->pDocumentNode->pArena = ArenaCreate()))
+           )
+            arc = ERROR_NOT_ENOUGH_MEMORY;
+        else if (!(pDom->pParser = XML_ParserCreate(NULL)))
+            arc = ERROR_NOT_ENOUGH_MEMORY;
+        else
+        {
+            if (pfnGetCPData)
+                XML_SetUnknownEncodingHandler(pDom->pParser,
+                                              UnknownEncodingHandler,
+                                              pDom);        // user data
+
+            XML_SetParamEntityParsing(pDom->pParser,
+                                      XML_PARAM_ENTITY_PARSING_ALWAYS);
+
+            XML_SetElementHandler(pDom->pParser,
+                                  StartElementHandler,
+                                  EndElementHandler);
+
+            XML_SetCharacterDataHandler(pDom->pParser,
+                                        CharacterDataHandler);
+
+            // XML_SetProcessingInstructionHandler(XML_Parser parser,
+            //                          XML_ProcessingInstructionHandler handler);
+
+
+            if (flParserFlags & DF_PARSECOMMENTS)
+                XML_SetCommentHandler(pDom->pParser,
+                                      CommentHandler);
+
+            if (    (pfnExternalHandler)
+                 || (cSystemIds)     // V0.9.20 (2002-07-06) [umoeller]
+               )
+                XML_SetExternalEntityRefHandler(pDom->pParser,
+                                                ExternalEntityRefHandler);
+
+            if (flParserFlags & DF_PARSEDTD)
+            {
+                XML_SetDoctypeDeclHandler(pDom->pParser,
+                                          StartDoctypeDeclHandler,
+                                          EndDoctypeDeclHandler);
+
+                XML_SetNotationDeclHandler(pDom->pParser,
+                                           NotationDeclHandler);
+
+                XML_SetElementDeclHandler(pDom->pParser,
+                                          ElementDeclHandler);
+
+                XML_SetAttlistDeclHandler(pDom->pParser,
+                                          AttlistDeclHandler);
+
+                XML_SetEntityDeclHandler(pDom->pParser,
+                                         EntityDeclHandler);
+
+                XML_SetParamEntityParsing(pDom->pParser,
+                                          XML_PARAM_ENTITY_PARSING_ALWAYS);
+            }
+
+            // XML_SetXmlDeclHandler ... do we care for this? I guess not
+
+            // pass the XMLDOM as user data to the handlers
+            XML_SetUserData(pDom->pParser,
+                            pDom);
+        }
+    }
+
+    if (arc == NO_ERROR)
+        *ppDom = pDom;
+    else
+        xmlFreeDOM(pDom);
+
+    return arc;
+}
+
+/*
+ *@@ xmlParse:
+ *      parses another chunk of XML data.
+ *
+ *      If (fIsLast == TRUE), the internal @expat parser
+ *      will be freed, but not the DOM itself.
+ *
+ *      You can pass an XML document to this function
+ *      in one flush. Set fIsLast = TRUE on the first
+ *      and only call then.
+ *
+ *      This returns NO_ERROR if the chunk was successfully
+ *      parsed. Otherwise one of the following errors is
+ *      returned:
+ *
+ *      -- ERROR_INVALID_PARAMETER
+ *
+ *      -- ERROR_DOM_PARSING: an @expat parsing error occurred.
+ *         This might also be memory problems.
+ *         With this error code, you will find specific
+ *         error information in the XMLDOM fields.
+ *
+ *      -- ERROR_DOM_VALIDITY: the document is not @valid.
+ *         This can only happen if @DTD parsing was enabled
+ *         with xmlCreateDOM.
+ *         With this error code, you will find specific
+ *         error information in the XMLDOM fields.
+ *
+ *      This works the same for an XMLDOM from xmlCreateSAX,
+ *      whose callbacks are called from here. If one of them
+ *      fails, its error code is returned.
+ *
+ *@@added V0.9.9 (2001-02-14) [umoeller]
+ */
+
+APIRET xmlParse(PXMLDOM pDom,               // in: DOM created by xmlCreateDOM
+                const char *pcszBuf,        // in: chunk of XML document data (or full document)
+                ULONG cb,                   // in: size of that chunk (required)
+                BOOL fIsLast)               // in: set to TRUE if this is the last chunk
+{
+    APIRET arc = NO_ERROR;
+
+    if (!pDom)
+        arc = ERROR_INVALID_PARAMETER;
+    else
+    {
+        // go parse then
+        if (!XML_Parse(pDom->pParser,
+                       pcszBuf,
+                       cb,
+                       fIsLast))
+        {
+            // expat parsing error:
+            xmlSetError(pDom,
+                        XML_GetErrorCode(pDom->pParser),
+                        NULL,
+                        FALSE);
+
+            if (pDom->pDocumentNode)
+            {
+                xmlDeleteNode((PNODEBASE)pDom->pDocumentNode);
+                pDom->pDocumentNode = NULL;
+            }
+
+            arc = ERROR_DOM_PARSING;
+        }
+        else if (pDom->fInvalid)
+        {
+            // expat was doing OK, but the handlers' validation failed:
+            arc = ERROR_DOM_VALIDITY;
+                        // error info has already been set
+        }
+        else
+            // expat was doing OK, but maybe we have integrity errors
+            // from our DOM callbacks:
+            if (pDom->arcDOM)
+                arc = pDom->arcDOM;
+
+        if (arc != NO_ERROR || fIsLast)
+        {
+            // last call or error: clean up
+            XML_ParserFree(pDom->pParser);
+            pDom->pParser = NULL;
+
+            // clean up the stack (but not the DOM itself)
+            lstClear(&pDom->llElementStack);
+            xstrClear(&pDom->strText);
+        }
+    }
+
+    return arc;
+}
+
+#ifdef __DEBUG__
+
+/*
+ *@@ Dump:
+ *
+ *@@added V0.9.20 (2002-07-03) [umoeller]
+ */
+
+STATIC VOID Dump(int iIndent,
+                 PDOMNODE pDomNode)
+{
+    PDOMNODE pChildNode;
+    int i;
+    for (i = 0;
+         i < iIndent;
+         ++i)
+    {
+        printf(" ");
+    }
+
+    switch (pDomNode->NodeBase.ulNodeType)
+    {
+        #define DUMPTYPE(t) case t: printf(#t); break;
+        DUMPTYPE(DOMNODE_ELEMENT)
+        DUMPTYPE(DOMNODE_ATTRIBUTE)
+        DUMPTYPE(DOMNODE_TEXT)
+        DUMPTYPE(DOMNODE_PROCESSING_INSTRUCTION)
+        DUMPTYPE(DOMNODE_COMMENT)
+        DUMPTYPE(DOMNODE_DOCUMENT)
+        DUMPTYPE(DOMNODE_DOCUMENT_TYPE)
+        DUMPTYPE(ELEMENTPARTICLE_EMPTY)
+        DUMPTYPE(ELEMENTPARTICLE_ANY)
+        DUMPTYPE(ELEMENTPARTICLE_MIXED)
+        DUMPTYPE(ELEMENTPARTICLE_CHOICE)
+        DUMPTYPE(ELEMENTPARTICLE_SEQ)
+        DUMPTYPE(ELEMENTPARTICLE_NAME)
+        DUMPTYPE(ATTRIBUTE_DECLARATION_BASE)
+        DUMPTYPE(ATTRIBUTE_DECLARATION)
+        DUMPTYPE(ATTRIBUTE_DECLARATION_ENUM)
+    }
+
+    printf(" \"%s\"\n", STRINGORNULL(pDomNode->NodeBase.strNodeName.psz));
+
+    ++iIndent;
+    for (pChildNode = pDomNode->pFirstChild;
+         pChildNode;
+         pChildNode = pChildNode->pNextSibling)
+    {
+        Dump(iIndent, pChildNode);
+    }
+    --iIndent;
+}
+
+#endif
+
+/*
+ *@@ xmlDump:
+ *      debug function which dumps the DOM to stdout.
+ *
+ *@@added V0.9.20 (2002-07-03) [umoeller]
+ */
+
+VOID xmlDump(PXMLDOM pDom)
+{
+#ifdef __DEBUG__
+    if (!pDom)
+    {
+        printf(__FUNCTION__ ": pDom is NULL\n");
+        return;
+    }
+
+    printf(__FUNCTION__ ": dumping document node ");
+
+    Dump(0, (PDOMNODE)pDom->pDocumentNode);
+#endif
+}
+
+/*
+ *@@ xmlFreeDOM:
+ *      cleans up all resources allocated by
+ *      xmlCreateDOM and xmlParse, including
+ *      the entire DOM tree.
+ *
+ *      If you wish to keep any data, make
+ *      a copy of the respective pointers in pDom
+ *      or subitems and set them to NULL before
+ *      calling this function.
+ *
+ *@@added V0.9.9 (2001-02-14) [umoeller]
+ */
+
+APIRET xmlFreeDOM(PXMLDOM pDom)
+{
+    APIRET arc = NO_ERROR;
+    if (pDom)
+    {
+        // if the parser is still alive for some reason, close it.
+        if (pDom->pParser)
+        {
+            XML_ParserFree(pDom->pParser);
+            pDom->pParser = NULL;
+        }
+
+        xmlDeleteNode((PNODEBASE)pDom->pDocumentNode);
+
+        if (pDom->pxstrSystemID)
+            xstrFree(&pDom->pxstrSystemID);
+        if (pDom->pxstrFailingNode)
+            xstrFree(&pDom->pxstrFailingNode);
+
+        lstClear(&pDom->llElementStack);
+        xstrClear(&pDom->strText);
+
+        free(pDom);
+    }
+
+    return arc;
+}
+
+/* ******************************************************************
+ *
+ *   SAX parser APIs
+ *
+ ********************************************************************/
+
+/*
+ *@@ SaxStartElementHandler:
+ *      @expat handler called when a new element is
+ *      found, for xmlCreateSAX.
+ *
+ *      If we validate, we push the element's declaration on
+ *      the element stack, which is all we need to validate
+ *      its children and content later. Then we pass the
+ *      element on to the user's handler.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+STATIC void EXPATENTRY SaxStartElementHandler(void *pUserData,      // in: our PXMLDOM really
+                                              const char *pcszElement,
+                                              const char **papcszAttribs)
+{
+    PXMLDOM     pDom = (PXMLDOM)pUserData;
+
+    // continue parsing only if we had no errors so far
+    if (!pDom->arcDOM)
+    {
+        // shall we validate?
+        if (pDom->pDocTypeNode)
+        {
+            PDOMSTACKITEM pSI = PopElementStack(pDom,
+                                                NULL);     // no free
+            if (!pDom->arcDOM)
+            {
+                // the DTD handlers have interned all declared
+                // names, so if there's no symbol, there's no decl
+                PDOMSYMBOL pSymbol = FindSymbol(pDom->pDocumentNode,
+                                                pcszElement,
+                                                0);
+                PCMATTRIBUTEDECLBASE pAttribDeclBase = NULL;
+                XSTRING strElement;
+                ULONG i;
+
+                // cheap trick again, no malloc for the XSTRING
+                xstrInitSet(&strElement, (PSZ)pcszElement);
+
+                ValidateElement(pDom,
+                                &strElement,
+                                (pSymbol) ? pSymbol->ulHash
+                                          : smapHash(strElement.psz, strElement.ulLength),
+                                (pSI->pDomNode == (PDOMNODE)pDom->pDocumentNode),
+                                pSI->pElementDecl,  // parent's elem decl
+                                &pSI->ulState);
+
+                if (pSymbol)
+                    pAttribDeclBase = pSymbol->pAttribDeclBase;
+
+                for (i = 0;
+                     (papcszAttribs[i]) && (!pDom->arcDOM);
+                     i += 2)
+                {
+                    PCMATTRIBUTEDECL pAttribDecl = NULL;
+                    XSTRING strValue;
+
+                    if (pAttribDeclBase)
+                        pAttribDecl = (PCMATTRIBUTEDECL)smapFind(
+                                            &pAttribDeclBase->AttribDeclsMap,
+                                            papcszAttribs[i]);
+
+                    xstrInitSet(&strValue, (PSZ)papcszAttribs[i + 1]);
+                    ValidateAttributeType(pDom,
+                                          pAttribDecl,
+                                          papcszAttribs[i],
+                                          &strValue);
+                }
+
+                if (    (!pDom->arcDOM)
+                     && (pAttribDeclBase)
+                   )
+                    ValidateAllAttributes(pDom,
+                                          pAttribDeclBase,
+                                          papcszAttribs);
+
+                // there are no element nodes with SAX, so the
+                // stack only has the decl
+                if (!pDom->arcDOM)
+                    PushElementStack(pDom,
+                                     NULL,
+                                     (pSymbol) ? pSymbol->pElementDecl : NULL);
+            }
+        }
+
+        if (    (!pDom->arcDOM)
+             && (pDom->SaxHandlers.pfnStartElement)
+           )
+        {
+            APIRET arc;
+            if (arc = pDom->SaxHandlers.pfnStartElement(pDom,
+                                                        pcszElement,
+                                                        papcszAttribs))
+                xmlSetError(pDom,
+                            arc,
+                            pcszElement,
+                            FALSE);
+        }
+    }
+}
 
 /*
- *@@ xmlCreateDOM:
- *      creates an XMLDOM instance, which can be used for parsing
- *      an XML document and building a @DOM tree from it at the
- *      same time.
+ *@@ SaxEndElementHandler:
+ *      @expat handler for when parsing an element is done,
+ *      for xmlCreateSAX. We pop the element off of our stack
+ *      if we validate and call the user's handler.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+STATIC void EXPATENTRY SaxEndElementHandler(void *pUserData,      // in: our PXMLDOM really
+                                            const XML_Char *pcszElement)
+{
+    PXMLDOM     pDom = (PXMLDOM)pUserData;
+
+    // continue parsing only if we had no errors so far
+    if (!pDom->arcDOM)
+    {
+        if (pDom->pDocTypeNode)
+        {
+            PLISTNODE pStackLN = NULL;
+            PDOMSTACKITEM pSI = PopElementStack(pDom,
+                                                &pStackLN);
+            if (!pDom->arcDOM)
+            {
+                ValidateContentEnd(pDom,
+                                   pcszElement,
+                                   pSI->pElementDecl,
+                                   pSI->ulState);
+                lstRemoveNode(&pDom->llElementStack, pStackLN); // auto-free
+            }
+            else
+                pDom->arcDOM = ERROR_DOM_INTEGRITY;
+        }
+
+        if (    (!pDom->arcDOM)
+             && (pDom->SaxHandlers.pfnEndElement)
+           )
+        {
+            APIRET arc;
+            if (arc = pDom->SaxHandlers.pfnEndElement(pDom,
+                                                      pcszElement))
+                xmlSetError(pDom,
+                            arc,
+                            pcszElement,
+                            FALSE);
+        }
+    }
+}
+
+/*
+ *@@ SaxCharacterDataHandler:
+ *      @expat handler for character data (@content), for
+ *      xmlCreateSAX.
+ *
+ *      Unlike CharacterDataHandler, this does not concatenate
+ *      the chunks that expat gives us, but passes each of them
+ *      on as it is, so that we need no memory for them.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+STATIC void EXPATENTRY SaxCharacterDataHandler(void *pUserData,      // in: our PXMLDOM really
+                                               const XML_Char *s,
+                                               int len)
+{
+    PXMLDOM     pDom = (PXMLDOM)pUserData;
+
+    // continue parsing only if we had no errors so far
+    if (    (!pDom->arcDOM)
+         && (len)
+       )
+    {
+        BOOL fIsWhitespace = FALSE;
+
+        // shall we validate?
+        if (pDom->pDocTypeNode)
+        {
+            PDOMSTACKITEM pSI = PopElementStack(pDom,
+                                                NULL);     // no free
+            if (    (!pDom->arcDOM)
+                 && (pSI->pElementDecl)
+               )
+                fIsWhitespace = ValidateCharacterData(pDom,
+                                                      pSI->pElementDecl,
+                                                      s,
+                                                      len);
+        }
+
+        if (    (!pDom->arcDOM)
+             && (!fIsWhitespace)
+             && (pDom->SaxHandlers.pfnCharacterData)
+           )
+        {
+            APIRET arc;
+            if (arc = pDom->SaxHandlers.pfnCharacterData(pDom,
+                                                         s,
+                                                         len))
+                xmlSetError(pDom,
+                            arc,
+                            NULL,
+                            FALSE);
+        }
+    }
+}
+
+/*
+ *@@ SaxCommentHandler:
+ *      @expat handler for @comments, for xmlCreateSAX.
+ *
+ *      Note: This is only set if DF_PARSECOMMENTS is
+ *      flagged with xmlCreateSAX.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+STATIC void EXPATENTRY SaxCommentHandler(void *pUserData,      // in: our PXMLDOM really
+                                         const XML_Char *data)
+{
+    PXMLDOM     pDom = (PXMLDOM)pUserData;
+
+    // continue parsing only if we had no errors so far
+    if (    (!pDom->arcDOM)
+         && (pDom->SaxHandlers.pfnComment)
+       )
+    {
+        APIRET arc;
+        if (arc = pDom->SaxHandlers.pfnComment(pDom,
+                                               data))
+            xmlSetError(pDom,
+                        arc,
+                        NULL,
+                        FALSE);
+    }
+}
+
+/*
+ *@@ xmlCreateSAX:
+ *      creates an XMLDOM instance for parsing an XML document
+ *      without building a @DOM tree. Instead, the callbacks
+ *      in *pHandlers are called for the elements, content and
+ *      comments as @expat finds them. That is much faster and
+ *      takes memory in proportion to the element nesting depth
+ *      and the @DTD only, no matter how large the document is.
+ *
+ *      Pass the XMLDOM returned here to xmlParse afterwards,
+ *      just like with xmlCreateDOM, and to xmlFreeDOM when
+ *      done. xmlParse returns the same error codes and sets
+ *      the same error information in the XMLDOM.
+ *
+ *      All parameters but pHandlers are as with xmlCreateDOM;
+ *      the same @encodings and @external_entities are supported,
+ *      and the same static system IDs. Of the flags, DF_ARENA
+ *      is ignored since there are no nodes, and the others
+ *      work as follows:
+ *
+ *      --  DF_PARSECOMMENTS: call pfnComment for @comments.
+ *
+ *      --  DF_PARSEDTD: parse the @DTD and validate the document
+ *          against it, as with the DOM. The DTD is then stored in
+ *          pDom->pDocTypeNode. The document node has no children
+ *          though.
+ *
+ *      --  DF_DROP_WHITESPACE: with a DTD, do not call
+ *          pfnCharacterData for @whitespace in elements that
+ *          can only have element content.
+ *
+ *      The XMLSAXHANDLERS structure is copied, and any of its
+ *      callbacks can be NULL. They all get the XMLDOM as their
+ *      first parameter, so pvCallbackUser is available to them.
+ *      If a callback returns something other than NO_ERROR, no
+ *      more callbacks are called, and xmlParse returns that
+ *      error. The callbacks are:
+ *
+ +          APIRET APIENTRY FNSAXSTARTELEMENT(PXMLDOM pDom,
+ +                                            const char *pcszElement,
+ +                                            const char **papcszAttribs);
+ *
+ *      for the start of an element. papcszAttribs has the
+ *      attributes as name/value pairs followed by a NULL, like
+ *      with expat's XML_StartElementHandler. With a DTD, that
+ *      includes the attributes with default values.
+ *
+ +          APIRET APIENTRY FNSAXENDELEMENT(PXMLDOM pDom,
+ +                                          const char *pcszElement);
+ *
+ *      for the end of an element.
+ *
+ +          APIRET APIENTRY FNSAXCHARACTERDATA(PXMLDOM pDom,
+ +                                             const char *pcch,
+ +                                             ULONG cch);
+ *
+ *      for @content. pcch is NOT null-terminated, and expat may
+ *      split the text between two elements into several chunks
+ *      (e.g. at line breaks and entity references), so there can
+ *      be several calls in a row.
+ *
+ +          APIRET APIENTRY FNSAXCOMMENT(PXMLDOM pDom,
+ +                                       const char *pcszComment);
+ *
+ *      for @comments, only with DF_PARSECOMMENTS.
+ *
+ *      All strings are UTF-8 and only valid during the callback.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+APIRET xmlCreateSAX(ULONG flParserFlags,            // in: DF_* parser flags
+                    const XMLSAXHANDLERS *pHandlers, // in: event callbacks
+                    const STATICSYSTEMID *paSystemIds, // in: array of STATICSYSTEMID's or NULL
+                    ULONG cSystemIds,                // in: array item count
+                    PFNGETCPDATA pfnGetCPData,      // in: codepage callback or NULL
+                    PFNEXTERNALHANDLER pfnExternalHandler, // in: external entity callback or NULL
+                    PVOID pvCallbackUser,           // in: user param for callbacks
+                    PXMLDOM *ppDom)                 // out: XMLDOM struct created
+{
+    APIRET      arc;
+    PXMLDOM     pDom;
+
+    if (!pHandlers)
+        return ERROR_INVALID_PARAMETER;
+
+    // this sets up the parser with the encoding, external
+    // entity and DTD handlers, which we all want too...
+    if (!(arc = xmlCreateDOM(flParserFlags & ~DF_ARENA,
+                             paSystemIds,
+                             cSystemIds,
+                             pfnGetCPData,
+                             pfnExternalHandler,
+                             pvCallbackUser,
+                             &pDom)))
+    {
+        memcpy(&pDom->SaxHandlers, pHandlers, sizeof(XMLSAXHANDLERS));
+
+        // ...but replace the handlers that build the tree;
+        // expat copies these to the sub-parsers for external
+        // entities too
+        XML_SetElementHandler(pDom->pParser,
+                              SaxStartElementHandler,
+                              SaxEndElementHandler);
+
+        XML_SetCharacterDataHandler(pDom->pParser,
+                                    SaxCharacterDataHandler);
+
+        if (flParserFlags & DF_PARSECOMMENTS)
+            XML_SetCommentHandler(pDom->pParser,
+                                  SaxCommentHandler);
+
+        *ppDom = pDom;
+    }
+
+    return arc;
+}
+
+/* ******************************************************************
+ *
+ *   Shared DTDs and batch parsing
+ *
+ ********************************************************************/
+
+/*
+ *@@ xmlCreateDTD:
+ *      compiles an external @DTD so that many documents
+ *      can be validated against it without each of them
+ *      building the declarations again. Give the result
+ *      to xmlSetDTD or xmlParseFiles.
+ *
+ *      pcszSystemId is the system ID that documents use
+ *      in their DOCTYPE to refer to the DTD, pcszContent
+ *      the DTD itself, like with STATICSYSTEMID. Both are
+ *      copied.
+ *
+ *      The XMLDTD is read-only after this, so it can be
+ *      used by any number of DOMs on any number of threads
+ *      at the same time. It must not be freed with xmlFreeDTD
+ *      before the last of them has been freed.
+ *
+ *      If the DTD has errors, this returns the detailed
+ *      error code that xmlParse would have put into
+ *      XMLDOM.arcDOM, such as ERROR_DOM_DUPLICATE_ELEMENT_DECL.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+APIRET xmlCreateDTD(const char *pcszSystemId,  // in: system ID of the DTD
+                    const char *pcszContent,   // in: DTD content
+                    PXMLDTD *ppDTD)            // out: compiled DTD
+{
+    APIRET  arc;
+    ULONG   cbSystemId,
+            cbContent;
+    PXMLDTD pDTD;
+    PSZ     pszDoctype;
+    CHAR    cQuote = '"';
+
+    if (    (!pcszSystemId)
+         || (!pcszContent)
+         || (!ppDTD)
+       )
+        return ERROR_INVALID_PARAMETER;
+
+    if (strchr(pcszSystemId, '"'))
+    {
+        if (strchr(pcszSystemId, '\''))
+            return ERROR_INVALID_PARAMETER;
+        cQuote = '\'';
+    }
+
+    cbSystemId = strlen(pcszSystemId) + 1;
+    cbContent = strlen(pcszContent);
+    if (!(pDTD = (PXMLDTD)malloc(sizeof(XMLDTD) + cbSystemId + cbContent)))
+        return ERROR_NOT_ENOUGH_MEMORY;
+
+    memset(pDTD, 0, sizeof(XMLDTD));
+    memcpy(pDTD->achData, pcszSystemId, cbSystemId);
+    memcpy(pDTD->achData + cbSystemId, pcszContent, cbContent + 1);
+    pDTD->SystemId.pcszSystemId = pDTD->achData;
+    pDTD->SystemId.pcszContent = pDTD->achData + cbSystemId;
+    pDTD->cbContent = cbContent;
+
+    if (!(pszDoctype = (PSZ)malloc(cbSystemId + 30)))
+        arc = ERROR_NOT_ENOUGH_MEMORY;
+    else
+    {
+        // parse a DOCTYPE that refers to the DTD, which puts
+        // the declarations into the DOCTYPE node of our DOM
+        sprintf(pszDoctype,
+                "<!DOCTYPE DTD SYSTEM %c%s%c>",
+                cQuote,
+                pcszSystemId,
+                cQuote);
+
+        if (!(arc = xmlCreateDOM(DF_PARSEDTD,
+                                 &pDTD->SystemId,
+                                 1,
+                                 NULL,
+                                 NULL,
+                                 NULL,
+                                 &pDTD->pDom)))
+        {
+            PXMLDOM pDom = pDTD->pDom;
+
+            // not the last chunk, as there's no root element
+            if (arc = xmlParse(pDom,
+                               pszDoctype,
+                               strlen(pszDoctype),
+                               FALSE))
+            {
+                if (pDom->arcDOM)
+                    arc = pDom->arcDOM;
+            }
+            else if (!pDom->pDocTypeNode)
+                arc = ERROR_DOM_PARSING;
+            else
+            {
+                // done with the parser
+                XML_ParserFree(pDom->pParser);
+                pDom->pParser = NULL;
+                lstClear(&pDom->llElementStack);
+                xstrClear(&pDom->strText);
+
+                pDom->paSystemIds = NULL;
+                pDom->cSystemIds = 0;
+            }
+        }
+
+        free(pszDoctype);
+    }
+
+    if (arc)
+        xmlFreeDTD(pDTD);
+    else
+        *ppDTD = pDTD;
+
+    return arc;
+}
+
+/*
+ *@@ xmlFreeDTD:
+ *      frees a DTD from xmlCreateDTD. All DOMs that
+ *      use it must have been freed before.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+VOID xmlFreeDTD(PXMLDTD pDTD)
+{
+    if (pDTD)
+    {
+        xmlFreeDOM(pDTD->pDom);
+        free(pDTD);
+    }
+}
+
+/*
+ *@@ xmlSetDTD:
+ *      makes a DOM from xmlCreateDOM or xmlCreateSAX use
+ *      the given DTD from xmlCreateDTD. Call this before
+ *      the first xmlParse. The DOM must have been created
+ *      with DF_PARSEDTD.
+ *
+ *      If the document's DOCTYPE then refers to the DTD's
+ *      system ID, the document is validated against the
+ *      shared declarations, and the DTD is only run through
+ *      @expat for its entities and attribute defaults. For
+ *      a document with an internal subset, the DTD is parsed
+ *      into the document's own declarations as usual,
+ *      since the internal subset can add to them.
+ *
+ *      The DTD comes before the STATICSYSTEMID's and the
+ *      external entity callback given to xmlCreateDOM.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+APIRET xmlSetDTD(PXMLDOM pDom,          // in: DOM from xmlCreateDOM or xmlCreateSAX
+                 PXMLDTD pDTD)          // in: DTD from xmlCreateDTD
+{
+    if (    (!pDom)
+         || (!pDom->pParser)
+         || (!(pDom->flParserFlags & DF_PARSEDTD))
+         || (!pDTD)
+       )
+        return ERROR_INVALID_PARAMETER;
+
+    pDom->pDTD = pDTD;
+    XML_SetExternalEntityRefHandler(pDom->pParser,
+                                    ExternalEntityRefHandler);
+
+    return NO_ERROR;
+}
+
+#define BATCH_BUFSIZE       0x10000
+#define BATCH_STACKSIZE     0x40000
+
+/*
+ *@@ XMLBATCH:
+ *      work list for xmlParseFiles, shared by all
+ *      its threads.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+typedef struct _XMLBATCH
+{
+    PXMLBATCHFILE   paFiles;
+    ULONG           cFiles;
+    ULONG           flParserFlags;
+    PXMLDTD         pDTD;
+    PFNGETCPDATA    pfnGetCPData;
+    PVOID           pvCallbackUser;
+    LONG            lNext;          // index of next file to parse,
+                                    // with lockIncrement
+} XMLBATCH, *PXMLBATCH;
+
+/*
+ *@@ ParseFromFile:
+ *      feeds the given file to xmlParse, in chunks of
+ *      BATCH_BUFSIZE.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+STATIC APIRET ParseFromFile(PXMLDOM pDom,
+                            PCSZ pcszFilename,
+                            PSZ pszBuf)         // in: buffer of BATCH_BUFSIZE bytes
+{
+    APIRET  arc = NO_ERROR;
+    FILE    *file;
+
+    if (!(file = fopen(pcszFilename, "rb")))
+        arc = ERROR_FILE_NOT_FOUND;
+    else
+    {
+        BOOL fIsLast = FALSE;
+
+        while (    (!arc)
+                && (!fIsLast)
+              )
+        {
+            size_t cb = fread(pszBuf, 1, BATCH_BUFSIZE, file);
+            if (ferror(file))
+                arc = ERROR_READ_FAULT;
+            else
+                arc = xmlParse(pDom,
+                               pszBuf,
+                               cb,
+                               (fIsLast = (feof(file) != 0)));
+        }
+
+        fclose(file);
+    }
+
+    return arc;
+}
+
+/*
+ *@@ ParseFile:
+ *      parses one file of the batch into a new DOM.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+STATIC APIRET ParseFile(PXMLBATCH pBatch,
+                        PXMLBATCHFILE pFile,
+                        PSZ pszBuf)             // in: buffer of BATCH_BUFSIZE bytes
+{
+    APIRET  arc;
+
+    if (    (!(arc = xmlCreateDOM(pBatch->flParserFlags,
+                                  NULL,
+                                  0,
+                                  pBatch->pfnGetCPData,
+                                  NULL,
+                                  pBatch->pvCallbackUser,
+                                  &pFile->pDom)))
+         && (    (!pBatch->pDTD)
+              || (!(arc = xmlSetDTD(pFile->pDom, pBatch->pDTD)))
+            )
+       )
+        arc = ParseFromFile(pFile->pDom,
+                            pFile->pcszFilename,
+                            pszBuf);
+
+    return arc;
+}
+
+/*
+ *@@ ParseBatch:
+ *      takes files off the batch and parses them
+ *      until none are left. This runs on all threads
+ *      of xmlParseFiles, including the calling one.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+STATIC VOID ParseBatch(PXMLBATCH pBatch)
+{
+    PSZ     pszBuf = (PSZ)malloc(BATCH_BUFSIZE);
+    ULONG   ul;
+
+    while ((ul = lockIncrement(&pBatch->lNext) - 1) < pBatch->cFiles)
+    {
+        PXMLBATCHFILE pFile = &pBatch->paFiles[ul];
+        if (!pszBuf)
+            pFile->arc = ERROR_NOT_ENOUGH_MEMORY;
+        else
+            pFile->arc = ParseFile(pBatch, pFile, pszBuf);
+    }
+
+    if (pszBuf)
+        free(pszBuf);
+}
+
+/*
+ *@@ fntParseBatch:
+ *      thread func for xmlParseFiles.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+STATIC VOID APIENTRY fntParseBatch(ULONG ulBatch)
+{
+    ParseBatch((PXMLBATCH)ulBatch);
+}
+
+/*
+ *@@ xmlParseFiles:
+ *      parses a list of XML files into one DOM each,
+ *      on up to cThreads threads at once, counting the
+ *      calling thread. With cThreads <= 1, everything
+ *      happens on the calling thread. If fewer threads
+ *      can be started, we make do with those.
+ *
+ *      For each file, this creates a DOM with
+ *      flParserFlags, pfnGetCPData and pvCallbackUser as
+ *      with xmlCreateDOM, calls xmlSetDTD with pDTD if
+ *      that's not NULL, and parses the file. The DOM and
+ *      the error code go into the file's XMLBATCHFILE.
+ *      The DOM is kept on errors too for its error info,
+ *      so the caller must call xmlFreeDOM for every pDom
+ *      that isn't NULL.
+ *
+ *      pfnGetCPData is called on any of the threads, so
+ *      it must be thread-safe.
+ *
+ *      Since all DOMs share pDTD, the files are only
+ *      validated against their DTD if their DOCTYPE
+ *      refers to pDTD's system ID (there's no external
+ *      entity callback).
+ *
+ *      Returns NO_ERROR if all files were parsed, or the
+ *      error code of the first file in the list that
+ *      failed. ERROR_FILE_NOT_FOUND and ERROR_READ_FAULT
+ *      are returned for files that couldn't be read.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+APIRET xmlParseFiles(PXMLBATCHFILE paFiles,     // in/out: files to parse
+                     ULONG cFiles,              // in: array item count
+                     ULONG flParserFlags,       // in: DF_* parser flags
+                     PXMLDTD pDTD,              // in: DTD from xmlCreateDTD or NULL
+                     PFNGETCPDATA pfnGetCPData, // in: codepage callback or NULL
+                     PVOID pvCallbackUser,      // in: user param for callbacks
+                     ULONG cThreads)            // in: max. no. of threads
+{
+    APIRET      arc = NO_ERROR;
+    XMLBATCH    Batch;
+    TID         atid[XML_MAX_BATCH_THREADS];
+    ULONG       cStarted,
+                ul;
+
+    if (!paFiles)
+        return ERROR_INVALID_PARAMETER;
+
+    for (ul = 0;
+         ul < cFiles;
+         ++ul)
+    {
+        paFiles[ul].pDom = NULL;
+        paFiles[ul].arc = NO_ERROR;
+    }
+
+    Batch.paFiles = paFiles;
+    Batch.cFiles = cFiles;
+    Batch.flParserFlags = flParserFlags;
+    Batch.pDTD = pDTD;
+    Batch.pfnGetCPData = pfnGetCPData;
+    Batch.pvCallbackUser = pvCallbackUser;
+    Batch.lNext = 0;
+
+    if (cThreads > cFiles)
+        cThreads = cFiles;
+    if (cThreads > XML_MAX_BATCH_THREADS)
+        cThreads = XML_MAX_BATCH_THREADS;
+
+    // the calling thread is one of them
+    for (cStarted = 0;
+         cStarted + 1 < cThreads;
+         ++cStarted)
+        if (DosCreateThread(&atid[cStarted],
+                            fntParseBatch,
+                            (ULONG)&Batch,
+                            0,
+                            BATCH_STACKSIZE))
+            break;
+
+    ParseBatch(&Batch);
+
+    for (ul = 0;
+         ul < cStarted;
+         ++ul)
+        DosWaitThread(&atid[ul], DCWW_WAIT);
+
+    for (ul = 0;
+         ul < cFiles;
+         ++ul)
+        if (arc = paFiles[ul].arc)
+            break;
+
+    return arc;
+}
+
+/* ******************************************************************
  *
- *      Pass the XMLDOM returned here to xmlParse afterwards.
+ *   Binary DOM snapshots
  *
- *      Simplest possible usage:
+ ********************************************************************/
+
+#define XMLBIN_MAGIC        0x4D4F4458      // "XDOM" on little-endian machines
+#define XMLBIN_VERSION      1
+#define XMLBIN_NONE         0xFFFFFFFF
+
+/*
+ *@@ XMLBINHEADER:
+ *      header of a binary DOM snapshot, as written by
+ *      xmlSaveBinary. The header is followed by:
  *
- *      1) Create a DOM instance.
+ *      --  cSymbols XMLBINSYMBOL's, the names of the
+ *          document (see DOMSYMBOL);
  *
- +          PXMLDOM pDom = NULL;
- +          APIRET arc = xmlCreateDOM(flags, NULL, NULL, NULL, &pDom);
- +
- *      2) Give chunks of data (or an entire buffer)
- *         to the DOM instance for parsing.
+ *      --  cNodes XMLBINNODE's, the document first and then
+ *          every other node in document order, each element
+ *          followed by its attributes and then its children;
  *
- +          arc = xmlParse(pDom,
- +                         pBuf,
- +                         TRUE); // if last, this will clean up the parser
+ *      --  cbStrings bytes of names and values, each one
+ *          null-terminated.
  *
- *      3) Process the data in the DOM tree.
+ *      There are no pointers in the file, only indices and
+ *      string offsets, so it can be used wherever it was
+ *      read to. Everything is in the machine's byte order;
+ *      a snapshot from a machine with another one fails the
+ *      magic check and is treated as damaged.
  *
- *         Look at the DOMNODE definition to see how you
- *         can traverse the data. Essentially, everything
- *         is based on linked lists and string maps.
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+typedef struct _XMLBINHEADER
+{
+    ULONG       ulMagic;            // XMLBIN_MAGIC
+    ULONG       ulVersion;          // XMLBIN_VERSION
+    ULONG       cbFile;             // size of the whole snapshot
+    ULONG       cbSource;           // size of the source file or 0
+    FDATE       fdateSource;        // last write date of the source file or 0
+    FTIME       ftimeSource;        // last write time of the source file or 0
+    ULONG       cSymbols;
+    ULONG       cNodes;             // including the document
+    ULONG       cbStrings;
+} XMLBINHEADER, *PXMLBINHEADER;
+
+/*
+ *@@ XMLBINSYMBOL:
+ *      a name in a binary DOM snapshot.
  *
- *         A few helper functions have been added for
- *         quick lookup. See xmlGetRootElement,
- *         xmlGetFirstChild, xmlGetLastChild, xmlGetFirstText,
- *         xmlGetElementsByTagName, xmlGetAttribute.
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+typedef struct _XMLBINSYMBOL
+{
+    ULONG       ulName;             // offset of name in strings
+    ULONG       ulLength;           // length of name
+} XMLBINSYMBOL, *PXMLBINSYMBOL;
+
+/*
+ *@@ XMLBINNODE:
+ *      a node in a binary DOM snapshot. Since only the
+ *      document has index 0, 0 means "none" for the links.
  *
- *      4) When done, call xmlFreeDOM, which will free all memory.
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+typedef struct _XMLBINNODE
+{
+    ULONG       ulNodeType;         // DOMNODE_* type
+    ULONG       ulSymbol;           // index of name in symbols or XMLBIN_NONE
+    ULONG       ulValue;            // offset of value in strings or XMLBIN_NONE
+    ULONG       cbValue;            // length of value
+    ULONG       ulFirstAttrib;      // index of first attribute or 0
+    ULONG       ulFirstChild;       // index of first child or 0
+    ULONG       ulNextSibling;      // index of next attribute or child
+                                    // of the same parent or 0
+} XMLBINNODE, *PXMLBINNODE;
+
+/*
+ *@@ XMLBINWRITER:
+ *      state for WriteBinaryNode.
  *
- *      The above code has limitations: only a few character
- *      @encodings are supported, and @external_entities are
- *      silently ignored.
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+typedef struct _XMLBINWRITER
+{
+    PXMLBINNODE paNodes;
+    ULONG       cNodes;             // nodes written so far
+    PSZ         pszStrings;
+    ULONG       cbStrings;          // string bytes written so far
+} XMLBINWRITER, *PXMLBINWRITER;
+
+/*
+ *@@ CountBinaryNodes:
+ *      adds the number of attributes and children below
+ *      pNode to *pcNodes and the space for their values
+ *      to *pcbStrings. DOCTYPE nodes are skipped.
  *
- *      This function supports a number of callbacks and flags
- *      to allow for maximum flexibility. Note however that
- *      not all @expat features are supported yet.
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+STATIC VOID CountBinaryNodes(PDOMNODE pNode,
+                             PULONG pcNodes,
+                             PULONG pcbStrings)
+{
+    PDOMNODE pSub;
+
+    for (pSub = (PDOMNODE)treeFirst(pNode->AttributesMap);
+         pSub;
+         pSub = (PDOMNODE)treeNext((TREE*)pSub))
+    {
+        ++(*pcNodes);
+        if (pSub->pstrNodeValue)
+            *pcbStrings += pSub->pstrNodeValue->ulLength + 1;
+    }
+
+    for (pSub = pNode->pFirstChild;
+         pSub;
+         pSub = pSub->pNextSibling)
+        if (pSub->NodeBase.ulNodeType != DOMNODE_DOCUMENT_TYPE)
+        {
+            ++(*pcNodes);
+            if (pSub->pstrNodeValue)
+                *pcbStrings += pSub->pstrNodeValue->ulLength + 1;
+            CountBinaryNodes(pSub, pcNodes, pcbStrings);
+        }
+}
+
+/*
+ *@@ AddBinaryString:
+ *      copies cb bytes from pcch to the writer's strings,
+ *      with a null terminator, and returns their offset.
  *
- *      flParserFlags is any combination of the following:
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+STATIC ULONG AddBinaryString(PXMLBINWRITER pWriter,
+                             const char *pcch,
+                             ULONG cb)
+{
+    ULONG ulOfs = pWriter->cbStrings;
+
+    if (cb)
+        memcpy(pWriter->pszStrings + ulOfs, pcch, cb);
+    pWriter->pszStrings[ulOfs + cb] = '\0';
+    pWriter->cbStrings += cb + 1;
+
+    return ulOfs;
+}
+
+/*
+ *@@ WriteBinaryNode:
+ *      adds pNode and everything below it to the writer's
+ *      nodes and returns pNode's index.
  *
- *      --  DF_PARSECOMMENTS: XML @comments are to be returned in
- *          the DOM tree. Otherwise they are discarded.
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+STATIC ULONG WriteBinaryNode(PXMLBINWRITER pWriter,
+                             PDOMNODE pNode)
+{
+    ULONG       ulIndex = pWriter->cNodes++,
+                ulPrev = 0;
+    PXMLBINNODE pBin = &pWriter->paNodes[ulIndex];
+    PDOMNODE    pSub;
+
+    pBin->ulNodeType = pNode->NodeBase.ulNodeType;
+
+    if (    (IsInterned(&pNode->NodeBase))
+         && (pNode->NodeBase.strNodeName.psz)
+       )
+        pBin->ulSymbol = SymbolFromName(&pNode->NodeBase.strNodeName)->ulIndex;
+    else
+        pBin->ulSymbol = XMLBIN_NONE;
+
+    if (    (pNode->pstrNodeValue)
+         && (pNode->pstrNodeValue->psz)
+       )
+    {
+        pBin->cbValue = pNode->pstrNodeValue->ulLength;
+        pBin->ulValue = AddBinaryString(pWriter,
+                                        pNode->pstrNodeValue->psz,
+                                        pBin->cbValue);
+    }
+    else
+        pBin->ulValue = XMLBIN_NONE;
+
+    for (pSub = (PDOMNODE)treeFirst(pNode->AttributesMap);
+         pSub;
+         pSub = (PDOMNODE)treeNext((TREE*)pSub))
+    {
+        ULONG ulSub = WriteBinaryNode(pWriter, pSub);
+        if (ulPrev)
+            pWriter->paNodes[ulPrev].ulNextSibling = ulSub;
+        else
+            pBin->ulFirstAttrib = ulSub;
+        ulPrev = ulSub;
+    }
+
+    ulPrev = 0;
+    for (pSub = pNode->pFirstChild;
+         pSub;
+         pSub = pSub->pNextSibling)
+        if (pSub->NodeBase.ulNodeType != DOMNODE_DOCUMENT_TYPE)
+        {
+            ULONG ulSub = WriteBinaryNode(pWriter, pSub);
+            if (ulPrev)
+                pWriter->paNodes[ulPrev].ulNextSibling = ulSub;
+            else
+                pBin->ulFirstChild = ulSub;
+            ulPrev = ulSub;
+        }
+
+    return ulIndex;
+}
+
+/*
+ *@@ xmlSaveBinary:
+ *      writes a binary snapshot of the given document to
+ *      pcszFilename, which xmlLoadBinary can load again
+ *      much faster than the document can be parsed.
+ *
+ *      If pcszSourceFile is given, the size and last write
+ *      time of that file are stored in the snapshot, and
+ *      xmlLoadBinary will only use the snapshot as long as
+ *      they are the same. This should be the file that the
+ *      document was parsed from.
+ *
+ *      The snapshot has all element, attribute, text,
+ *      comment and PI nodes of the document. The DOCTYPE
+ *      and its declarations are not saved; the document
+ *      was validated against them when it was parsed.
+ *
+ *      The whole snapshot is built in memory and written
+ *      with a single fwrite. If that fails, the file is
+ *      deleted again and ERROR_WRITE_FAULT is returned.
+ *      Besides, this returns ERROR_INVALID_PARAMETER,
+ *      ERROR_NOT_ENOUGH_MEMORY, ERROR_FILE_NOT_FOUND if the
+ *      file can't be created, or the error code from
+ *      DosQueryPathInfo for pcszSourceFile.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+APIRET xmlSaveBinary(PDOMDOCUMENTNODE pDocument,    // in: document to save
+                     PCSZ pcszFilename,             // in: snapshot file to write
+                     PCSZ pcszSourceFile)           // in: file the document came from or NULL
+{
+    APIRET          arc = NO_ERROR;
+    XMLBINHEADER    Header;
+    PBYTE           pb;
+    PXMLBINSYMBOL   paSymbols;
+    XMLBINWRITER    Writer;
+    PSTRMAPSLOT     pSlot;
+    ULONG           ul;
+    FILE            *file;
+
+    if (    (!pDocument)
+         || (!pcszFilename)
+       )
+        return ERROR_INVALID_PARAMETER;
+
+    memset(&Header, 0, sizeof(Header));
+    Header.ulMagic = XMLBIN_MAGIC;
+    Header.ulVersion = XMLBIN_VERSION;
+
+    if (pcszSourceFile)
+    {
+        FILESTATUS3 fs3;
+        if (arc = DosQueryPathInfo((PSZ)pcszSourceFile,
+                                   FIL_STANDARD,
+                                   &fs3,
+                                   sizeof(fs3)))
+            return arc;
+
+        Header.cbSource = fs3.cbFile;
+        Header.fdateSource = fs3.fdateLastWrite;
+        Header.ftimeSource = fs3.ftimeLastWrite;
+    }
+
+    // count everything first so it all fits in one buffer
+    ul = 0;
+    while (pSlot = smapEnum(&pDocument->SymbolsMap, &ul))
+    {
+        PDOMSYMBOL pSymbol = (PDOMSYMBOL)pSlot->pvData;
+        pSymbol->ulIndex = Header.cSymbols++;
+        Header.cbStrings += pSymbol->ulLength + 1;
+    }
+
+    Header.cNodes = 1;
+    CountBinaryNodes((PDOMNODE)pDocument,
+                     &Header.cNodes,
+                     &Header.cbStrings);
+
+    Header.cbFile =   sizeof(XMLBINHEADER)
+                    + Header.cSymbols * sizeof(XMLBINSYMBOL)
+                    + Header.cNodes * sizeof(XMLBINNODE)
+                    + Header.cbStrings;
+
+    if (!(pb = (PBYTE)malloc(Header.cbFile)))
+        return ERROR_NOT_ENOUGH_MEMORY;
+
+    memset(pb, 0, Header.cbFile);
+    memcpy(pb, &Header, sizeof(Header));
+
+    paSymbols = (PXMLBINSYMBOL)(pb + sizeof(XMLBINHEADER));
+    Writer.paNodes = (PXMLBINNODE)(paSymbols + Header.cSymbols);
+    Writer.cNodes = 0;
+    Writer.pszStrings = (PSZ)(Writer.paNodes + Header.cNodes);
+    Writer.cbStrings = 0;
+
+    ul = 0;
+    while (pSlot = smapEnum(&pDocument->SymbolsMap, &ul))
+    {
+        PDOMSYMBOL pSymbol = (PDOMSYMBOL)pSlot->pvData;
+        paSymbols[pSymbol->ulIndex].ulName = AddBinaryString(&Writer,
+                                                             pSymbol->szName,
+                                                             pSymbol->ulLength);
+        paSymbols[pSymbol->ulIndex].ulLength = pSymbol->ulLength;
+    }
+
+    WriteBinaryNode(&Writer, (PDOMNODE)pDocument);
+
+    if (!(file = fopen(pcszFilename, "wb")))
+        arc = ERROR_FILE_NOT_FOUND;
+    else
+    {
+        if (fwrite(pb, 1, Header.cbFile, file) != Header.cbFile)
+            arc = ERROR_WRITE_FAULT;
+        if (fclose(file))
+            arc = ERROR_WRITE_FAULT;
+        if (arc)
+            remove(pcszFilename);
+    }
+
+    free(pb);
+
+    return arc;
+}
+
+/*
+ *@@ GetBinaryString:
+ *      returns the string at ulOfs in a snapshot's strings
+ *      if it is in bounds and null-terminated after cb
+ *      bytes, or NULL otherwise.
  *
- *      --  DF_PARSEDTD: add the @DTD of the document into the DOM tree
- *          as well and validate the document, if a DTD was found.
- *          Otherwise just parse and do not validate.
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+STATIC PSZ GetBinaryString(PSZ pszStrings,
+                           ULONG cbStrings,
+                           ULONG ulOfs,
+                           ULONG cb)
+{
+    if (    (ulOfs < cbStrings)
+         && (cb < cbStrings - ulOfs)
+         && (!pszStrings[ulOfs + cb])
+       )
+        return pszStrings + ulOfs;
+
+    return NULL;
+}
+
+/*
+ *@@ LinkBinaryNode:
+ *      links the attributes or the children of pParent,
+ *      which are in a chain starting at index ulFirst.
+ *      Every link must point past the node it comes from,
+ *      and every node must only be linked once, so that
+ *      a damaged snapshot can't produce cycles.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+STATIC APIRET LinkBinaryNode(PDOMNODE pParent,
+                             ULONG ulParent,            // in: index of pParent
+                             ULONG ulFirst,             // in: index of first sub-node or 0
+                             BOOL fAttribs,             // in: TRUE for the attribute chain
+                             PXMLBINNODE paBinNodes,
+                             PDOMNODE paNodes,          // in: nodes 1 and up
+                             ULONG cNodes)
+{
+    ULONG ulPrev = ulParent,
+          ul = ulFirst;
+
+    while (ul)
+    {
+        PDOMNODE pNode;
+
+        if (    (ul <= ulPrev)
+             || (ul >= cNodes)
+           )
+            return ERROR_DOM_INVALID_SNAPSHOT;
+
+        pNode = &paNodes[ul - 1];
+
+        if (    (pNode->pParentNode)
+             || (fAttribs != (pNode->NodeBase.ulNodeType == DOMNODE_ATTRIBUTE))
+           )
+            return ERROR_DOM_INVALID_SNAPSHOT;
+
+        pNode->pParentNode = pParent;
+
+        if (fAttribs)
+        {
+            if (treeInsert(&pParent->AttributesMap,
+                           NULL,
+                           &pNode->NodeBase.Tree,
+                           CompareXStrings))
+                return ERROR_DOM_INVALID_SNAPSHOT;
+        }
+        else
+        {
+            if (pParent->pLastChild)
+                pParent->pLastChild->pNextSibling = pNode;
+            else
+                pParent->pFirstChild = pNode;
+            pParent->pLastChild = pNode;
+        }
+
+        ulPrev = ul;
+        ul = paBinNodes[ul].ulNextSibling;
+    }
+
+    return NO_ERROR;
+}
+
+/*
+ *@@ LoadBinaryNodes:
+ *      sets up the nodes of a snapshot that has been read
+ *      into pb, which is in the document's arena, and adds
+ *      them to the document.
  *
- *          DF_PARSEDTD is required for external entities to work
- *          also.
+ *      The strings are not copied: the names and values of
+ *      the nodes point into pb.
  *
- *      --  DF_FAIL_IF_NO_DTD: fail if no @DTD was found. Useful
- *          if you want to enforce validation. @@todo
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+STATIC APIRET LoadBinaryNodes(PDOMDOCUMENTNODE pDocument,
+                              PBYTE pb,
+                              ULONG cb)
+{
+    APIRET          arc = NO_ERROR;
+    PXMLBINHEADER   pHeader = (PXMLBINHEADER)pb;
+    PXMLBINSYMBOL   paBinSymbols = (PXMLBINSYMBOL)(pHeader + 1);
+    PXMLBINNODE     paBinNodes;
+    PSZ             pszStrings;
+    PDOMSYMBOL      *papSymbols;
+    PDOMNODE        paNodes = NULL;
+    PXSTRING        paValues;
+    ULONG           cbRest = cb - sizeof(XMLBINHEADER),
+                    ul;
+
+    // the tables must fit the file exactly
+    if (    (pHeader->ulMagic != XMLBIN_MAGIC)
+         || (pHeader->ulVersion != XMLBIN_VERSION)
+         || (pHeader->cbFile != cb)
+         || (pHeader->cSymbols > cbRest / sizeof(XMLBINSYMBOL))
+       )
+        return ERROR_DOM_INVALID_SNAPSHOT;
+
+    cbRest -= pHeader->cSymbols * sizeof(XMLBINSYMBOL);
+    if (    (!pHeader->cNodes)
+         || (pHeader->cNodes > cbRest / sizeof(XMLBINNODE))
+         || (pHeader->cbStrings != cbRest - pHeader->cNodes * sizeof(XMLBINNODE))
+       )
+        return ERROR_DOM_INVALID_SNAPSHOT;
+
+    paBinNodes = (PXMLBINNODE)(paBinSymbols + pHeader->cSymbols);
+    pszStrings = (PSZ)(paBinNodes + pHeader->cNodes);
+
+    // intern the names
+    if (!(papSymbols = (PDOMSYMBOL*)malloc((pHeader->cSymbols + 1) * sizeof(PDOMSYMBOL))))
+        return ERROR_NOT_ENOUGH_MEMORY;
+
+    for (ul = 0;
+         (!arc) && (ul < pHeader->cSymbols);
+         ++ul)
+    {
+        PSZ pszName;
+        if (    (!paBinSymbols[ul].ulLength)
+             || (!(pszName = GetBinaryString(pszStrings,
+                                             pHeader->cbStrings,
+                                             paBinSymbols[ul].ulName,
+                                             paBinSymbols[ul].ulLength)))
+           )
+            arc = ERROR_DOM_INVALID_SNAPSHOT;
+        else if (!(papSymbols[ul] = InternName(pDocument,
+                                               pszName,
+                                               paBinSymbols[ul].ulLength)))
+            arc = ERROR_NOT_ENOUGH_MEMORY;
+    }
+
+    // set up all nodes in one go before linking them, since
+    // the attributes need their names for the attribute maps
+    if (    (!arc)
+         && (    (!(paNodes = (PDOMNODE)ArenaAlloc(pDocument->pArena,
+                                                   pHeader->cNodes * sizeof(DOMNODE))))
+              || (!(paValues = (PXSTRING)ArenaAlloc(pDocument->pArena,
+                                                    pHeader->cNodes * sizeof(XSTRING))))
+            )
+       )
+        arc = ERROR_NOT_ENOUGH_MEMORY;
+
+    if (    (!arc)
+         && (    (paBinNodes[0].ulNodeType != DOMNODE_DOCUMENT)
+              || (paBinNodes[0].ulSymbol != XMLBIN_NONE)
+              || (paBinNodes[0].ulValue != XMLBIN_NONE)
+              || (paBinNodes[0].ulFirstAttrib)
+            )
+       )
+        arc = ERROR_DOM_INVALID_SNAPSHOT;
+
+    for (ul = 1;
+         (!arc) && (ul < pHeader->cNodes);
+         ++ul)
+    {
+        PXMLBINNODE pBin = &paBinNodes[ul];
+        PDOMNODE    pNode = &paNodes[ul - 1];
+
+        memset(pNode, 0, sizeof(DOMNODE));
+
+        switch (pBin->ulNodeType)
+        {
+            case DOMNODE_ELEMENT:
+            case DOMNODE_ATTRIBUTE:
+            case DOMNODE_PROCESSING_INSTRUCTION:
+                if (pBin->ulSymbol == XMLBIN_NONE)
+                    arc = ERROR_DOM_INVALID_SNAPSHOT;
+            break;
+
+            case DOMNODE_TEXT:
+            case DOMNODE_COMMENT:
+            break;
+
+            default:
+                arc = ERROR_DOM_INVALID_SNAPSHOT;
+        }
+
+        if (    (pBin->ulNodeType != DOMNODE_ELEMENT)
+             && (    (pBin->ulFirstAttrib)
+                  || (pBin->ulFirstChild)
+                )
+           )
+            arc = ERROR_DOM_INVALID_SNAPSHOT;
+
+        if (arc)
+            break;
+
+        pNode->NodeBase.ulNodeType = (NODEBASETYPE)pBin->ulNodeType;
+        pNode->NodeBase.Tree.ulKey = (ULONG)&pNode->NodeBase.strNodeName;
+        pNode->pDocumentNode = (PDOMNODE)pDocument;
+        treeInit(&pNode->AttributesMap, NULL);
+
+        if (pBin->ulSymbol != XMLBIN_NONE)
+        {
+            PDOMSYMBOL pSymbol;
+            if (pBin->ulSymbol >= pHeader->cSymbols)
+            {
+                arc = ERROR_DOM_INVALID_SNAPSHOT;
+                break;
+            }
+
+            pSymbol = papSymbols[pBin->ulSymbol];
+            pNode->NodeBase.strNodeName.psz = pSymbol->szName;
+            pNode->NodeBase.strNodeName.ulLength = pSymbol->ulLength;
+            pNode->NodeBase.strNodeName.cbAllocated = pSymbol->ulLength + 1;
+        }
+
+        if (pBin->ulValue != XMLBIN_NONE)
+        {
+            PXSTRING pstr = &paValues[ul];
+            if (!(pstr->psz = GetBinaryString(pszStrings,
+                                              pHeader->cbStrings,
+                                              pBin->ulValue,
+                                              pBin->cbValue)))
+            {
+                arc = ERROR_DOM_INVALID_SNAPSHOT;
+                break;
+            }
+
+            pstr->ulLength = pBin->cbValue;
+            pstr->cbAllocated = pBin->cbValue + 1;
+            pstr->ulDelta = 0;
+            pNode->pstrNodeValue = pstr;
+        }
+    }
+
+    // now link them; since the document comes first and
+    // every node comes after its parent, all nodes but the
+    // document must have been linked when we get to them
+    for (ul = 0;
+         (!arc) && (ul < pHeader->cNodes);
+         ++ul)
+    {
+        PDOMNODE pNode = (ul) ? &paNodes[ul - 1] : (PDOMNODE)pDocument;
+
+        if (    (ul)
+             && (!pNode->pParentNode)
+           )
+            arc = ERROR_DOM_INVALID_SNAPSHOT;
+        else if (!(arc = LinkBinaryNode(pNode,
+                                        ul,
+                                        paBinNodes[ul].ulFirstAttrib,
+                                        TRUE,
+                                        paBinNodes,
+                                        paNodes,
+                                        pHeader->cNodes)))
+            arc = LinkBinaryNode(pNode,
+                                 ul,
+                                 paBinNodes[ul].ulFirstChild,
+                                 FALSE,
+                                 paBinNodes,
+                                 paNodes,
+                                 pHeader->cNodes);
+    }
+
+    free(papSymbols);
+
+    return arc;
+}
+
+/*
+ *@@ LoadBinary:
+ *      implementation for xmlLoadBinary. Reads the snapshot
+ *      into the arena of a new document with one fread and
+ *      sets up the nodes from it.
  *
- *      --  DF_DROP_WHITESPACE: discard all @whitespace for those
- *          elements that can only have element content. Whitespace
- *          will be preserved only for elements that can have
- *          mixed content. -- If this flag is not set, all whitespace
- *          is preserved.
+ *      Returns ERROR_DOM_INVALID_SNAPSHOT also if the source
+ *      file has changed since the snapshot was written.
  *
- *      The following callbacks can be specified (any of these
- *      can be NULL):
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+STATIC APIRET LoadBinary(PCSZ pcszFilename,
+                         PCSZ pcszSourceFile,
+                         PDOMDOCUMENTNODE *ppDocument)
+{
+    APIRET              arc = NO_ERROR;
+    FILE                *file;
+    long                cb;
+    PDOMNODE            pDocNode = NULL;
+    PDOMDOCUMENTNODE    pDocument;
+    PBYTE               pb;
+
+    if (!(file = fopen(pcszFilename, "rb")))
+        return ERROR_FILE_NOT_FOUND;
+
+    if (    (fseek(file, 0, SEEK_END))
+         || ((cb = ftell(file)) < (long)sizeof(XMLBINHEADER))
+         || (fseek(file, 0, SEEK_SET))
+       )
+        arc = ERROR_DOM_INVALID_SNAPSHOT;
+    else if (!(arc = xmlCreateDomNode(NULL,
+                                      DOMNODE_DOCUMENT,
+                                      NULL,
+                                      0,
+                                      &pDocNode)))
+    {
+        pDocument = (PDOMDOCUMENTNODE)pDocNode;
+
+        if (    (!(pDocument->pArena = ArenaCreate()))
+             || (!(pb = (PBYTE)ArenaAlloc(pDocument->pArena, cb)))
+           )
+            arc = ERROR_NOT_ENOUGH_MEMORY;
+        else if (fread(pb, 1, cb, file) != (size_t)cb)
+            arc = ERROR_READ_FAULT;
+        else
+        {
+            PXMLBINHEADER pHeader = (PXMLBINHEADER)pb;
+            FILESTATUS3 fs3;
+
+            if (    (pcszSourceFile)
+                 && (    (DosQueryPathInfo((PSZ)pcszSourceFile,
+                                           FIL_STANDARD,
+                                           &fs3,
+                                           sizeof(fs3)))
+                      || (fs3.cbFile != pHeader->cbSource)
+                      || (memcmp(&fs3.fdateLastWrite, &pHeader->fdateSource, sizeof(FDATE)))
+                      || (memcmp(&fs3.ftimeLastWrite, &pHeader->ftimeSource, sizeof(FTIME)))
+                    )
+               )
+                // source has changed or is gone
+                arc = ERROR_DOM_INVALID_SNAPSHOT;
+            else
+                arc = LoadBinaryNodes(pDocument, pb, cb);
+        }
+    }
+
+    fclose(file);
+
+    if (!arc)
+        *ppDocument = pDocument;
+    else if (pDocNode)
+        xmlDeleteNode((PNODEBASE)pDocNode);
+
+    return arc;
+}
+
+/*
+ *@@ xmlLoadBinary:
+ *      loads a document from a binary snapshot that was
+ *      written by xmlSaveBinary, into a DOM that was just
+ *      created with xmlCreateDOM and hasn't parsed anything
+ *      yet. Afterwards, the DOM is like after the last
+ *      xmlParse call.
+ *
+ *      The snapshot is read with a single fread and needs
+ *      no parsing. Its tables are turned into the DOM nodes
+ *      in one pass; the names and values are not copied but
+ *      used from where the snapshot was read to. Like with
+ *      DF_ARENA, the nodes, their strings and the snapshot
+ *      live in an arena, which goes away in one go with the
+ *      document, and the strings must not be modified.
+ *
+ *      pcszSourceFile should be the XML file that the
+ *      snapshot was made from. If it is given, the snapshot
+ *      is only used if the file's size and last write time
+ *      are still the same as when the snapshot was written.
+ *      If they are not, or if the snapshot doesn't exist or
+ *      is damaged, pcszSourceFile is parsed with xmlParse
+ *      instead, and a new snapshot is written if that went
+ *      OK, for the next time. So typically, you would do:
+ *
+ +          PXMLDOM pDom;
+ +          if (!(arc = xmlCreateDOM(0, NULL, 0, NULL, NULL, NULL, &pDom)))
+ +          {
+ +              if (!(arc = xmlLoadBinary(pDom,
+ +                                        "config.xdb",
+ +                                        "config.xml")))
+ +                  ... use pDom->pDocumentNode
+ +              xmlFreeDOM(pDom);
+ +          }
  *
- *      --  pfnGetCPData should be specified if you want to
- *          support character @encodings other than the
- *          four that built into expat itself (see
- *          XML_SetUnknownEncodingHandler). This is probably
- *          a good idea to do under OS/2 since most OS/2
- *          documents are in a PC-specific codepage such as
- *          CP 850.
+ *      The DOCTYPE is not part of the snapshot, so
+ *      XMLDOM.pDocTypeNode is NULL if the snapshot was
+ *      used.
  *
- *          This callback must have the following prototype:
+ *      If pcszSourceFile was parsed, this returns the error
+ *      codes of xmlParse, or ERROR_FILE_NOT_FOUND or
+ *      ERROR_READ_FAULT if it couldn't be read. Without
+ *      pcszSourceFile, this returns ERROR_FILE_NOT_FOUND,
+ *      ERROR_READ_FAULT or ERROR_DOM_INVALID_SNAPSHOT if
+ *      the snapshot can't be used.
  *
- +              int APIENTRY FNGETCPDATA(PXMLDOM pDom, ULONG ulCP, int *piMap)
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+APIRET xmlLoadBinary(PXMLDOM pDom,              // in: DOM from xmlCreateDOM
+                     PCSZ pcszFilename,         // in: snapshot file
+                     PCSZ pcszSourceFile)       // in: XML file to check against and fall back to, or NULL
+{
+    APIRET              arc;
+    PDOMDOCUMENTNODE    pDocument;
+
+    if (    (!pDom)
+         || (!pDom->pParser)
+         || (!pDom->pDocumentNode)
+         || (!pcszFilename)
+       )
+        return ERROR_INVALID_PARAMETER;
+
+    if (!(arc = LoadBinary(pcszFilename,
+                           pcszSourceFile,
+                           &pDocument)))
+    {
+        // replace the empty document from xmlCreateDOM
+        // and clean up like xmlParse after the last chunk
+        xmlDeleteNode((PNODEBASE)pDom->pDocumentNode);
+        pDom->pDocumentNode = pDocument;
+
+        XML_ParserFree(pDom->pParser);
+        pDom->pParser = NULL;
+
+        lstClear(&pDom->llElementStack);
+        xstrClear(&pDom->strText);
+    }
+    else if (    (pcszSourceFile)
+              && (arc != ERROR_NOT_ENOUGH_MEMORY)
+            )
+    {
+        // no snapshot, or an outdated or damaged one:
+        // parse the source instead and make a new snapshot
+        PSZ pszBuf;
+        if (!(pszBuf = (PSZ)malloc(BATCH_BUFSIZE)))
+            arc = ERROR_NOT_ENOUGH_MEMORY;
+        else
+        {
+            if (!(arc = ParseFromFile(pDom,
+                                      pcszSourceFile,
+                                      pszBuf)))
+                // if this fails, we'll parse again next time
+                xmlSaveBinary(pDom->pDocumentNode,
+                              pcszFilename,
+                              pcszSourceFile);
+
+            free(pszBuf);
+        }
+    }
+
+    return arc;
+}
+
+/* ******************************************************************
  *
- *          The callback will only be called once for each
- *          document if the "encoding" attribute of the
- *          XML @text_declaration starts with "cp" (e.g.
- *          "cp850") and will then receive the following
- *          parameters:
+ *   DOM lookup
  *
- *          --  "pDom" will be the XMLDOM created by this function.
+ ********************************************************************/
+
+/*
+ *@@ xmlFindElementDecl:
+ *      returns the CMELEMENTDECLNODE for the element
+ *      with the specified name or NULL if there's none.
  *
- *          --  ulCP has the IBM code page number, such as "850".
+ *@@added V0.9.9 (2001-02-16) [umoeller]
+ *@@changed V1.0.24 (2026-10-18) [agent]: DTD declarations are now in STRMAP hash maps
+ *@@changed V1.0.24 (2026-10-18) [agent]: added shared DTD support
+ */
+
+PCMELEMENTDECLNODE xmlFindElementDecl(PXMLDOM pDom,
+                                      const XSTRING *pcstrElementName)
+{
+    PCMELEMENTDECLNODE pElementDecl = NULL;
+
+    PDOMDOCTYPENODE pDocTypeNode = GetDeclarations(pDom);
+    if (    (pDocTypeNode)
+         && (pcstrElementName)
+         && (pcstrElementName->ulLength)
+       )
+    {
+        pElementDecl = (PCMELEMENTDECLNODE)FindDecl(
+                                      &pDocTypeNode->ElementDeclsMap,
+                                      pcstrElementName);
+    }
+
+    return pElementDecl;
+}
+
+/*
+ *@@ xmlFindAttribDeclBase:
+ *      returns the CMATTRIBUTEDECLBASE for the specified
+ *      element name, or NULL if none exists.
  *
- *          --  piMap is an array of 256 integer values which must
- *              be filled with the callback. Each array item index
- *              is the codepage value, and the value of each field
- *              is the corresponding Unicode value, or -1 if the
- *              character is invalid (shouldn't happen with codepages).
+ *      To find a specific attribute declaration from both
+ *      an element and an attribute name, use xmlFindAttribDecl
+ *      instead.
  *
- *              For example, the German o-umlaut character is
- *              0x94 in CP850 and 0x00f6 in Unicode. So set
- *              the int at index 0x94 to 0x00f6.
+ *@@added V0.9.9 (2001-02-16) [umoeller]
+ *@@changed V1.0.24 (2026-10-18) [agent]: DTD declarations are now in STRMAP hash maps
+ *@@changed V1.0.24 (2026-10-18) [agent]: added shared DTD support
+ */
+
+PCMATTRIBUTEDECLBASE xmlFindAttribDeclBase(PXMLDOM pDom,
+                                           const XSTRING *pstrElementName)
+{
+    PDOMDOCTYPENODE pDocTypeNode = GetDeclarations(pDom);
+    if (    (pDocTypeNode)
+         && (pstrElementName)
+         && (pstrElementName->ulLength)
+       )
+    {
+        return (PCMATTRIBUTEDECLBASE)FindDecl(&pDocTypeNode->AttribDeclBasesMap,
+                                              pstrElementName);
+    }
+
+    return NULL;
+}
+
+/*
+ *@@ xmlFindAttribDecl:
+ *      returns the CMATTRIBUTEDEDECL for the specified
+ *      element and attribute name, or NULL if none exists.
  *
- *      --  pfnExternalHandler should be specified if you want the
- *          parser to be able to handle @external_entities. Since
- *          the parser has no concept of storage whatsoever, it is
- *          the responsibility of this callback to supply the parser
- *          with additional XML data when an external entity reference
- *          is encountered.
+ *@@added V0.9.9 (2001-02-16) [umoeller]
+ *@@changed V1.0.24 (2026-10-18) [agent]: DTD declarations are now in STRMAP hash maps
+ */
+
+PCMATTRIBUTEDECL xmlFindAttribDecl(PXMLDOM pDom,
+                                   const XSTRING *pstrElementName,
+                                   const XSTRING *pstrAttribName,
+                                   PCMATTRIBUTEDECLBASE *ppAttribDeclBase)
+                                            // in/out: attr decl base cache;
+                                            // the pointer pointed to by this
+                                            // must be NULL on the first call
+{
+    if (pstrElementName && pstrAttribName)
+    {
+        if (!*ppAttribDeclBase)
+            // first call for this:
+            *ppAttribDeclBase = xmlFindAttribDeclBase(pDom,
+                                                      pstrElementName);
+        if (*ppAttribDeclBase)
+        {
+            return (PCMATTRIBUTEDECL)FindDecl(&(**ppAttribDeclBase).AttribDeclsMap,
+                                              pstrAttribName);
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ *@@ xmlGetRootElement:
+ *      returns the root element node from the specified
+ *      DOM. Useful helper to start enumerating elements.
  *
- *          This callback must have the following prototype:
+ *@@added V0.9.11 (2001-04-22) [umoeller]
+ *@@changed V0.9.20 (2002-07-03) [umoeller]: this never worked with DTDs, fixed
+ */
+
+PDOMNODE xmlGetRootElement(PXMLDOM pDom)
+{
+    PDOMDOCUMENTNODE    pDocumentNode;
+    PDOMNODE            pDomNode;
+    if (    (pDom)
+         && (pDocumentNode = pDom->pDocumentNode)
+         && (pDomNode = pDocumentNode->DomNode.pFirstChild)
+       )
+    {
+        // V0.9.20 (2002-07-03) [umoeller]:
+        // we can't just return the first node on the
+        // list, because if we have DTD, this might
+        // be the doctype... so loop until we find
+        // an element, which must be the root element
+        while (pDomNode)
+        {
+            if (pDomNode->NodeBase.ulNodeType == DOMNODE_ELEMENT)
+                return pDomNode;
+
+            pDomNode = pDomNode->pNextSibling;
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ *@@ xmlGetFirstChild:
+ *      returns the first child node of pDomNode.
+ *      See DOMNODE for what a "child" can be for the
+ *      various node types.
  *
- +              APIRET APIENTRY ParseExternal(PXMLDOM pDom,
- +                                            XML_Parser pSubParser,
- +                                            const char *pcszSystemID,
- +                                            const char *pcszPublicID)
- +
+ *@@added V0.9.9 (2001-02-14) [umoeller]
+ *@@changed V1.0.24 (2026-10-18) [agent]: replaced llChildren
+ */
+
+PDOMNODE xmlGetFirstChild(PDOMNODE pDomNode)
+{
+    return pDomNode->pFirstChild;
+}
+
+/*
+ *@@ xmlGetLastChild:
+ *      returns the last child node of pDomNode.
+ *      See DOMNODE for what a "child" can be for the
+ *      various node types.
  *
- *          The callback will be called for each reference that refers
- *          to an external entity. pSubParser is a sub-parser created
- *          by the DOM engine, and pcszSystemID and pcszPublicID
- *          reference the external entity by means of a URI. As always
- *          with XML, the system ID is required, while the public ID is
- *          optional.
+ *@@added V0.9.9 (2001-02-14) [umoeller]
+ *@@changed V1.0.24 (2026-10-18) [agent]: replaced llChildren
+ */
+
+PDOMNODE xmlGetLastChild(PDOMNODE pDomNode)
+{
+    return pDomNode->pLastChild;
+}
+
+/*
+ *@@ xmlGetNextSibling:
+ *      returns the child node of pDomNode's parent that
+ *      follows pDomNode, or NULL if pDomNode is the last
+ *      one. Together with xmlGetFirstChild, this walks
+ *      the children of a node.
  *
- *          In the simplest case, this code could look as follows:
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+PDOMNODE xmlGetNextSibling(PDOMNODE pDomNode)
+{
+    return pDomNode->pNextSibling;
+}
+
+/*
+ *@@ xmlGetFirstText:
+ *      returns the first text (character data) node
+ *      of pElement or NULL if there's none.
  *
- +              APIRET arc = ERROR_FILE_NOT_FOUND;
- +
- +              if (pcszSystemID)
- +              {
- +                  PSZ pszContents = NULL;
- +                  if (!(arc = doshLoadTextFile(pcszSystemID,
- +                                               &pszContents,
- +                                               NULL)))
- +                  {
- +                      if (!XML_Parse(pSubParser,
- +                                     pszContents,
- +                                     strlen(pszContents),
- +                                     TRUE))
- +                          arc = -1;
- +
- +                      free(pszContents);
- +                  }
- +              }
- +
- +              return arc;
+ *@@added V0.9.11 (2001-04-22) [umoeller]
+ */
+
+PDOMNODE xmlGetFirstText(PDOMNODE pElement)
+{
+    PDOMNODE    pDomNodeThis;
+
+    for (pDomNodeThis = pElement->pFirstChild;
+         pDomNodeThis;
+         pDomNodeThis = pDomNodeThis->pNextSibling)
+    {
+        if (pDomNodeThis->NodeBase.ulNodeType == DOMNODE_TEXT)
+            return pDomNodeThis;
+    }
+
+    return NULL;
+}
+
+/*
+ *@@ xmlGetElementsByTagName:
+ *      returns a linked list of DOMNODE nodes which
+ *      match the specified element name. The special name
+ *      "*" matches all elements.
  *
- *      --  pvCallbackUser is a user parameter which is simply stored
- *          in the XMLDOM struct which is returned. Since the XMLDOM
- *          is passed to all the callbacks, you can access that pointer
- *          from them.
+ *      pParent must be the parent element DOMNODE...
+ *      the only allowed exception is
+ *
+ *      The caller must free the list by calling lstFree.
+ *      Returns NULL if no such elements could be found.
+ *
+ *      Since element names are interned (see DOMSYMBOL),
+ *      this looks up pcszName once and then compares
+ *      pointers only.
  *
  *@@added V0.9.9 (2001-02-14) [umoeller]
- *@@changed V0.9.14 (2001-08-09) [umoeller]: added DF_DROP_WHITESPACE support
- *@@changed V0.9.20 (2002-07-06) [umoeller]: added static system IDs
+ *@@changed V1.0.24 (2026-10-18) [agent]: now comparing interned names
  */
 
-APIRET xmlCreateDOM(ULONG flParserFlags,            // in: DF_* parser flags
-                    const STATICSYSTEMID *paSystemIds, // in: array of STATICSYSTEMID's or NULL
-                    ULONG cSystemIds,                // in: array item count
-                    PFNGETCPDATA pfnGetCPData,      // in: codepage callback or NULL
-                    PFNEXTERNALHANDLER pfnExternalHandler, // in: external entity callback or NULL
-                    PVOID pvCallbackUser,           // in: user param for callbacks
-                    PXMLDOM *ppDom)                 // out: XMLDOM struct created
+PLINKLIST xmlGetElementsByTagName(PDOMNODE pParent,
+                                  const char *pcszName)
 {
-    APIRET      arc = NO_ERROR;
-    PXMLDOM     pDom;
-    PDOMNODE    pDocument = NULL;
+    PLINKLIST           pll;
+    PDOMDOCUMENTNODE    pDocument;
+    BOOL                fFindAll = !strcmp(pcszName, "*");
+    PCSZ                pcszSymbol = NULL;
 
-    if (!(pDom = (PXMLDOM)malloc(sizeof(*pDom))))
-        return ERROR_NOT_ENOUGH_MEMORY;
+    if (!(pDocument = GetDocument(pParent)))
+        // cannot have children then
+        return 0;
 
-    memset(pDom, 0, sizeof(XMLDOM));
+    if (!fFindAll)
+    {
+        PDOMSYMBOL pSymbol;
+        if (!(pSymbol = FindSymbol(pDocument, pcszName, 0)))
+            // no element in the document has this name
+            return 0;
 
-    pDom->flParserFlags = flParserFlags;
-    pDom->pfnGetCPData = pfnGetCPData;
-    pDom->pfnExternalHandler = pfnExternalHandler;
-    pDom->pvCallbackUser = pvCallbackUser;
+        pcszSymbol = pSymbol->szName;
+    }
 
-    // these added with V0.9.20 (2002-07-06) [umoeller]
-    pDom->paSystemIds = paSystemIds;
-    pDom->cSystemIds = cSystemIds;
+    if (pll = lstCreate(FALSE))       // no free
+    {
+        ULONG   cItems = 0;
 
-    lstInit(&pDom->llElementStack,
-            TRUE);                 // auto-free
+        PDOMNODE    pDomNodeThis;
 
-    // create the document node
-    if (!(arc = xmlCreateDomNode(NULL, // no parent
-                                 DOMNODE_DOCUMENT,
-                                 NULL,
-                                 0,
-                                 &pDocument)))
-    {
-        // store the document in the DOM
-        pDom->pDocumentNode = (PDOMDOCUMENTNODE)pDocument;
+        for (pDomNodeThis = pParent->pFirstChild;
+             pDomNodeThis;
+             pDomNodeThis = pDomNodeThis->pNextSibling)
+        {
+            if (    (pDomNodeThis->NodeBase.ulNodeType == DOMNODE_ELEMENT)
+                 && (    (fFindAll)
+                      || (pDomNodeThis->NodeBase.strNodeName.psz == pcszSymbol)
+                    )
+               )
+            {
+                // element matches:
+                lstAppendItem(pll, pDomNodeThis);
+                cItems++;
+            }
+        }
 
-        // push the document on the stack so the handlers
-        // will append to that
-        PushElementStack(pDom,
-                         pDocument);
+        if (cItems)
+            return pll;
 
-        pDom->pParser = XML_ParserCreate(NULL);
+        lstFree(&pll);
+    }
 
-        if (!pDom->pParser)
-            arc = ERROR_NOT_ENOUGH_MEMORY;
-        else
-        {
-            if (pfnGetCPData)
-                XML_SetUnknownEncodingHandler(pDom->pParser,
-                                              UnknownEncodingHandler,
-                                              pDom);        // user data
+    return 0;
+}
 
-            XML_SetParamEntityParsing(pDom->pParser,
-                                      XML_PARAM_ENTITY_PARSING_ALWAYS);
+/*
+ *@@ xmlGetAttribute:
+ *      returns the value of pElement's attribute
+ *      with the given name or NULL.
+ *
+ *      This is a const pointer into the element's
+ *      attribute list.
+ *
+ *      The name is looked up in the document's symbol
+ *      table first, which fails fast for names that no
+ *      attribute has, and makes CompareXStrings compare
+ *      pointers on a match.
+ *
+ *@@added V0.9.11 (2001-04-22) [umoeller]
+ *@@changed V1.0.24 (2026-10-18) [agent]: now using interned names
+ */
 
-            XML_SetElementHandler(pDom->pParser,
-                                  StartElementHandler,
-                                  EndElementHandler);
+const XSTRING* xmlGetAttribute(PDOMNODE pElement,
+                               const char *pcszAttribName)
+{
+    XSTRING str;
+    PDOMNODE pAttrNode;
+    PDOMDOCUMENTNODE pDocument;
+    PDOMSYMBOL pSymbol;
 
-            XML_SetCharacterDataHandler(pDom->pParser,
-                                        CharacterDataHandler);
+    if (    (!(pDocument = GetDocument(pElement)))
+         || (!(pSymbol = FindSymbol(pDocument, pcszAttribName, 0)))
+       )
+        return NULL;
 
-            // XML_SetProcessingInstructionHandler(XML_Parser parser,
-            //                          XML_ProcessingInstructionHandler handler);
+    xstrInitSet2(&str, pSymbol->szName, pSymbol->ulLength);
+    // note, cheap trick: no malloc here, but we need
+    // an XSTRING for treeFind
+    if (pAttrNode = (PDOMNODE)treeFind(pElement->AttributesMap,
+                                       (ULONG)&str,
+                                       CompareXStrings))
+        return pAttrNode->pstrNodeValue;
 
+    return NULL;
+}
 
-            if (flParserFlags & DF_PARSECOMMENTS)
-                XML_SetCommentHandler(pDom->pParser,
-                                      CommentHandler);
+/* ******************************************************************
+ *
+ *   DOM queries
+ *
+ ********************************************************************/
 
-            if (    (pfnExternalHandler)
-                 || (cSystemIds)     // V0.9.20 (2002-07-06) [umoeller]
-               )
-                XML_SetExternalEntityRefHandler(pDom->pParser,
-                                                ExternalEntityRefHandler);
+#define XPATH_MAX_STEPS         32      // steps are bits in a ULONG
+#define XPATH_MAX_PREDICATES    32
+#define XPATH_MAX_POSITIONS     8       // [n] and [last()] predicates
 
-            if (flParserFlags & DF_PARSEDTD)
-            {
-                XML_SetDoctypeDeclHandler(pDom->pParser,
-                                          StartDoctypeDeclHandler,
-                                          EndDoctypeDeclHandler);
+/*
+ *@@ XPATHPRED:
+ *      one predicate of an XPATHSTEP.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
 
-                XML_SetNotationDeclHandler(pDom->pParser,
-                                           NotationDeclHandler);
+typedef struct _XPATHPRED
+{
+    ULONG       ulType;
+                    // one of:
+                    // -- XPRED_HASATTRIB: [@name]
+                    // -- XPRED_ATTRIBEQUALS: [@name='value']
+                    // -- XPRED_POSITION: [n]
+                    // -- XPRED_LAST: [last()]
+    PCSZ        pcszAttrib;     // attribute name for the first two
+    PCSZ        pcszValue;      // value for XPRED_ATTRIBEQUALS
+    ULONG       ulPosition;     // 1-based position for XPRED_POSITION
+    ULONG       iCounter;       // sibling counter for the last two
+} XPATHPRED, *PXPATHPRED;
+
+#define XPRED_HASATTRIB         1
+#define XPRED_ATTRIBEQUALS      2
+#define XPRED_POSITION          3
+#define XPRED_LAST              4
 
-                XML_SetElementDeclHandler(pDom->pParser,
-                                          ElementDeclHandler);
+/*
+ *@@ XPATHSTEP:
+ *      one step of an XMLPATH, i.e. one name test with
+ *      its predicates.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
 
-                XML_SetAttlistDeclHandler(pDom->pParser,
-                                          AttlistDeclHandler);
+typedef struct _XPATHSTEP
+{
+    BOOL        fDescendant;    // TRUE after "//" (descendant axis), else child axis
+    BOOL        fAttribute;     // TRUE for "@name" (attribute axis, last step only)
+    PCSZ        pcszName;       // name or NULL for "*"
+    ULONG       iFirstPred,     // first predicate in XMLPATH.aPreds
+                cPreds;         // no. of predicates
+    BOOL        fPositional;    // TRUE if a predicate is [n] or [last()]
+} XPATHSTEP, *PXPATHSTEP;
 
-                XML_SetEntityDeclHandler(pDom->pParser,
-                                         EntityDeclHandler);
+/*
+ *@@ XMLPATH:
+ *      compiled path, as returned by xmlCompilePath.
+ *      This is never modified by the queries, so it
+ *      can be used with any number of documents.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
 
-                XML_SetParamEntityParsing(pDom->pParser,
-                                          XML_PARAM_ENTITY_PARSING_ALWAYS);
-            }
+typedef struct _XMLPATH
+{
+    BOOL        fAbsolute;      // TRUE if the path starts with "/"
+    BOOL        fDescendant;    // TRUE if any step has the descendant axis
+    BOOL        fPositional;    // TRUE if any step has [n] or [last()]
+    ULONG       cSteps;
+    XPATHSTEP   aSteps[XPATH_MAX_STEPS];
+    ULONG       cPreds;
+    XPATHPRED   aPreds[XPATH_MAX_PREDICATES];
+    ULONG       cCounters;      // no. of [n] and [last()] predicates
+    CHAR        achStrings[1];  // names and values, null-terminated
+} XMLPATH;
 
-            // XML_SetXmlDeclHandler ... do we care for this? I guess not
+/*
+ *@@ XPATHQUERY:
+ *      state of one xmlSelectNodes or xmlSelectSingleNode
+ *      call.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
 
-            // pass the XMLDOM as user data to the handlers
-            XML_SetUserData(pDom->pParser,
-                            pDom);
-        }
+typedef struct _XPATHQUERY
+{
+    const XMLPATH   *pPath;
+    PDOMNODE        pContext;       // node the path is relative to
+    XSTRING         astrNames[XPATH_MAX_STEPS];
+                        // interned step names (psz is NULL for "*")
+    XSTRING         astrAttribs[XPATH_MAX_PREDICATES];
+                        // interned attribute names of the predicates
+    PLINKLIST       pll;            // results or NULL if we want one only
+    PDOMNODE        pFound;         // first result
+    BOOL            fOutOfMemory;
+} XPATHQUERY, *PXPATHQUERY;
+
+#define IsPathSpace(c) (((c) == ' ') || ((c) == '\t') || ((c) == '\r') || ((c) == '\n'))
+
+/*
+ *@@ IsPathNameChar:
+ *      returns TRUE if c can be part of a name in a path.
+ *      This is lax: anything that isn't path syntax is.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+STATIC BOOL IsPathNameChar(CHAR c)
+{
+    return (    (c)
+             && (!strchr("/[]@=*'\"()!<>| \t\r\n", c))
+           );
+}
+
+/*
+ *@@ CopyPathString:
+ *      copies cb chars from p to *ppszTarget, null-terminates
+ *      them and advances *ppszTarget. Returns the copy.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+STATIC PCSZ CopyPathString(PSZ *ppszTarget,
+                           const char *p,
+                           ULONG cb)
+{
+    PSZ psz = *ppszTarget;
+    memcpy(psz, p, cb);
+    psz[cb] = '\0';
+    *ppszTarget = psz + cb + 1;
+    return psz;
+}
+
+/*
+ *@@ CompilePredicate:
+ *      parses one predicate, starting after the "[",
+ *      into pPred. Returns the position after the "]"
+ *      or NULL on syntax errors.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+STATIC const char* CompilePredicate(const char *p,
+                                    PXPATHPRED pPred,
+                                    PSZ *ppszTarget)
+{
+    while (IsPathSpace(*p))
+        p++;
+
+    if ((*p >= '0') && (*p <= '9'))
+    {
+        pPred->ulType = XPRED_POSITION;
+        if (!(pPred->ulPosition = strtoul(p, (char**)&p, 10)))
+            // positions start with 1
+            return NULL;
+    }
+    else if (!strncmp(p, "last()", 6))
+    {
+        pPred->ulType = XPRED_LAST;
+        p += 6;
     }
+    else if (*p == '@')
+    {
+        const char *pStart = ++p;
 
-    if (arc == NO_ERROR)
-        *ppDom = pDom;
+        while (IsPathNameChar(*p))
+            p++;
+        if (p == pStart)
+            return NULL;
+        pPred->pcszAttrib = CopyPathString(ppszTarget, pStart, p - pStart);
+
+        while (IsPathSpace(*p))
+            p++;
+
+        if (*p != '=')
+            pPred->ulType = XPRED_HASATTRIB;
+        else
+        {
+            CHAR        cQuote;
+            const char  *pEnd;
+
+            p++;
+            while (IsPathSpace(*p))
+                p++;
+
+            if (    ((cQuote = *p) != '\'')
+                 && (cQuote != '"')
+               )
+                return NULL;
+
+            if (!(pEnd = strchr(++p, cQuote)))
+                return NULL;
+
+            pPred->ulType = XPRED_ATTRIBEQUALS;
+            pPred->pcszValue = CopyPathString(ppszTarget, p, pEnd - p);
+            p = pEnd + 1;
+        }
+    }
     else
-        xmlFreeDOM(pDom);
+        return NULL;
 
-    return arc;
+    while (IsPathSpace(*p))
+        p++;
+
+    if (*p != ']')
+        return NULL;
+
+    return p + 1;
 }
 
 /*
- *@@ xmlParse:
- *      parses another chunk of XML data.
+ *@@ xmlCompilePath:
+ *      compiles a path expression for xmlSelectNodes and
+ *      xmlSelectSingleNode. This supports the following
+ *      subset of XPath 1.0 in abbreviated syntax:
  *
- *      If (fIsLast == TRUE), the internal @expat parser
- *      will be freed, but not the DOM itself.
+ *      --  "/" at the start makes the path absolute, i.e.
+ *          relative to the document; otherwise, it is
+ *          relative to the context node given to the query.
+ *          A "." at the start is allowed but does nothing.
  *
- *      You can pass an XML document to this function
- *      in one flush. Set fIsLast = TRUE on the first
- *      and only call then.
+ *      --  "name" selects the child elements of that name,
+ *          "*" all child elements.
  *
- *      This returns NO_ERROR if the chunk was successfully
- *      parsed. Otherwise one of the following errors is
- *      returned:
+ *      --  "//name" selects all descendant elements of that
+ *          name.
  *
- *      -- ERROR_INVALID_PARAMETER
+ *      --  "@name" as the last step selects the attribute
+ *          of that name (the attribute node, not its value).
  *
- *      -- ERROR_DOM_PARSING: an @expat parsing error occurred.
- *         This might also be memory problems.
- *         With this error code, you will find specific
- *         error information in the XMLDOM fields.
+ *      --  Each element step can have any number of predicates:
+ *          "[@a]" selects those that have attribute "a",
+ *          "[@a='x']" (or "[@a="x"]") those whose attribute "a"
+ *          has the value "x", "[1]" the first and "[last()]" the
+ *          last of those. The predicates apply in order, so
+ *          "item[@a='x'][2]" is the second "item" with a="x".
+ *          As in XPath, positions are among the siblings, so
+ *          "//item[1]" is every "item" that is the first one in
+ *          its parent.
  *
- *      -- ERROR_DOM_VALIDITY: the document is not @valid.
- *         This can only happen if @DTD parsing was enabled
- *         with xmlCreateDOM.
- *         With this error code, you will find specific
- *         error information in the XMLDOM fields.
+ *      Examples:
  *
- *@@added V0.9.9 (2001-02-14) [umoeller]
+ +          /config/server[@name='main']/port
+ +          //item[@id='42']
+ +          //table/row[last()]/@height
+ *
+ *      Returns:
+ *
+ *      --  NO_ERROR: *ppPath has the compiled path. Free
+ *          it with xmlFreePath.
+ *
+ *      --  ERROR_DOM_INVALID_PATH: syntax error, or the path
+ *          has more than 32 steps or predicates or more than
+ *          8 positional predicates.
+ *
+ *      --  ERROR_NOT_ENOUGH_MEMORY.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
  */
 
-APIRET xmlParse(PXMLDOM pDom,               // in: DOM created by xmlCreateDOM
-                const char *pcszBuf,        // in: chunk of XML document data (or full document)
-                ULONG cb,                   // in: size of that chunk (required)
-                BOOL fIsLast)               // in: set to TRUE if this is the last chunk
+APIRET xmlCompilePath(const char *pcszPath,     // in: path expression
+                      PXMLPATH *ppPath)         // out: compiled path
 {
-    APIRET arc = NO_ERROR;
+    PXMLPATH    pPath;
+    PSZ         pszTarget;
+    const char  *p = pcszPath;
+    BOOL        fDescendant = FALSE;
+
+    if (!pcszPath || !ppPath)
+        return ERROR_INVALID_PARAMETER;
+
+    // all names and values are copied to achStrings, and
+    // together they can't be more than twice the path
+    if (!(pPath = (PXMLPATH)malloc(sizeof(XMLPATH) + strlen(pcszPath) * 2)))
+        return ERROR_NOT_ENOUGH_MEMORY;
+
+    memset(pPath, 0, sizeof(XMLPATH));
+    pszTarget = pPath->achStrings;
+
+    while (IsPathSpace(*p))
+        p++;
+
+    if (!*p)
+    {
+        // empty path
+        free(pPath);
+        return ERROR_DOM_INVALID_PATH;
+    }
+
+    if (*p == '/')
+    {
+        pPath->fAbsolute = TRUE;
+        if (p[1] == '/')
+            fDescendant = TRUE;
+        else if (!p[1])
+            p++;            // "/": no steps, selects the document
+    }
+    else if (    (*p == '.')
+              && (!IsPathNameChar(p[1]))
+            )
+        p++;                // ".", "./" or ".//"
 
-    if (!pDom)
-        arc = ERROR_INVALID_PARAMETER;
-    else
+    if (*p == '/')
     {
-        // go parse then
-        if (!XML_Parse(pDom->pParser,
-                       pcszBuf,
-                       cb,
-                       fIsLast))
-        {
-            // expat parsing error:
-            xmlSetError(pDom,
-                        XML_GetErrorCode(pDom->pParser),
-                        NULL,
-                        FALSE);
+        fDescendant = (p[1] == '/');
+        p += (fDescendant) ? 2 : 1;
+        if (!*p)
+            p--;            // "//" or "./" without a step
+    }
 
-            if (pDom->pDocumentNode)
-            {
-                xmlDeleteNode((PNODEBASE)pDom->pDocumentNode);
-                pDom->pDocumentNode = NULL;
-            }
+    while (*p)
+    {
+        PXPATHSTEP  pStep;
 
-            arc = ERROR_DOM_PARSING;
+        if (pPath->cSteps >= XPATH_MAX_STEPS)
+        {
+            p = NULL;
+            break;
         }
-        else if (pDom->fInvalid)
+
+        pStep = &pPath->aSteps[pPath->cSteps++];
+        pStep->fDescendant = fDescendant;
+        pStep->iFirstPred = pPath->cPreds;
+        if (fDescendant)
+            pPath->fDescendant = TRUE;
+
+        if (*p == '@')
         {
-            // expat was doing OK, but the handlers' validation failed:
-            arc = ERROR_DOM_VALIDITY;
-                        // error info has already been set
+            pStep->fAttribute = TRUE;
+            p++;
         }
-        else
-            // expat was doing OK, but maybe we have integrity errors
-            // from our DOM callbacks:
-            if (pDom->arcDOM)
-                arc = pDom->arcDOM;
 
-        if (arc != NO_ERROR || fIsLast)
+        if (    (*p == '*')
+             && (!pStep->fAttribute)
+           )
+            p++;            // pcszName stays NULL
+        else
         {
-            // last call or error: clean up
-            XML_ParserFree(pDom->pParser);
-            pDom->pParser = NULL;
+            const char *pStart = p;
 
-            // clean up the stack (but not the DOM itself)
-            lstClear(&pDom->llElementStack);
+            while (IsPathNameChar(*p))
+                p++;
+            if (p == pStart)
+            {
+                p = NULL;
+                break;
+            }
+            pStep->pcszName = CopyPathString(&pszTarget, pStart, p - pStart);
         }
-    }
 
-    return arc;
-}
+        while (*p == '[')
+        {
+            PXPATHPRED pPred;
 
-#ifdef __DEBUG__
+            if (    (pStep->fAttribute)
+                 || (pPath->cPreds >= XPATH_MAX_PREDICATES)
+               )
+            {
+                p = NULL;
+                break;
+            }
 
-/*
- *@@ Dump:
- *
- *@@added V0.9.20 (2002-07-03) [umoeller]
- */
+            pPred = &pPath->aPreds[pPath->cPreds];
+            if (!(p = CompilePredicate(p + 1, pPred, &pszTarget)))
+                break;
 
-STATIC VOID Dump(int iIndent,
-                 PDOMNODE pDomNode)
-{
-    PLISTNODE pChildNode;
-    int i;
-    for (i = 0;
-         i < iIndent;
-         ++i)
-    {
-        printf(" ");
+            if (    (pPred->ulType == XPRED_POSITION)
+                 || (pPred->ulType == XPRED_LAST)
+               )
+            {
+                if (pPath->cCounters >= XPATH_MAX_POSITIONS)
+                {
+                    p = NULL;
+                    break;
+                }
+                pPred->iCounter = pPath->cCounters++;
+                pStep->fPositional = TRUE;
+                pPath->fPositional = TRUE;
+            }
+
+            pPath->cPreds++;
+            pStep->cPreds++;
+        }
+
+        if (    (!p)
+             || (    (*p)
+                  && (*p != '/')
+                )
+                // attributes have no children, and we
+                // don't do "//@name"
+             || (    (pStep->fAttribute)
+                  && (    (*p)
+                       || (fDescendant)
+                     )
+                )
+           )
+        {
+            p = NULL;
+            break;
+        }
+
+        if (*p)
+        {
+            fDescendant = (p[1] == '/');
+            p += (fDescendant) ? 2 : 1;
+            if (!*p)
+            {
+                // trailing "/" or "//"
+                p = NULL;
+                break;
+            }
+        }
     }
 
-    switch (pDomNode->NodeBase.ulNodeType)
+    if (!p)
     {
-        #define DUMPTYPE(t) case t: printf(#t); break;
-        DUMPTYPE(DOMNODE_ELEMENT)
-        DUMPTYPE(DOMNODE_ATTRIBUTE)
-        DUMPTYPE(DOMNODE_TEXT)
-        DUMPTYPE(DOMNODE_PROCESSING_INSTRUCTION)
-        DUMPTYPE(DOMNODE_COMMENT)
-        DUMPTYPE(DOMNODE_DOCUMENT)
-        DUMPTYPE(DOMNODE_DOCUMENT_TYPE)
-        DUMPTYPE(ELEMENTPARTICLE_EMPTY)
-        DUMPTYPE(ELEMENTPARTICLE_ANY)
-        DUMPTYPE(ELEMENTPARTICLE_MIXED)
-        DUMPTYPE(ELEMENTPARTICLE_CHOICE)
-        DUMPTYPE(ELEMENTPARTICLE_SEQ)
-        DUMPTYPE(ELEMENTPARTICLE_NAME)
-        DUMPTYPE(ATTRIBUTE_DECLARATION_BASE)
-        DUMPTYPE(ATTRIBUTE_DECLARATION)
-        DUMPTYPE(ATTRIBUTE_DECLARATION_ENUM)
+        free(pPath);
+        return ERROR_DOM_INVALID_PATH;
     }
 
-    printf(" \"%s\"\n", STRINGORNULL(pDomNode->NodeBase.strNodeName.psz));
+    *ppPath = pPath;
 
-    ++iIndent;
-    for (pChildNode = lstQueryFirstNode(&pDomNode->llChildren);
-         pChildNode;
-         pChildNode = pChildNode->pNext)
-    {
-        Dump(iIndent, (PDOMNODE)pChildNode->pItemData);
-    }
-    --iIndent;
+    return NO_ERROR;
 }
 
-#endif
-
 /*
- *@@ xmlDump:
- *      debug function which dumps the DOM to stdout.
+ *@@ xmlFreePath:
+ *      frees a path from xmlCompilePath.
  *
- *@@added V0.9.20 (2002-07-03) [umoeller]
+ *@@added V1.0.24 (2026-10-18) [agent]
  */
 
-VOID xmlDump(PXMLDOM pDom)
+VOID xmlFreePath(PXMLPATH pPath)
 {
-#ifdef __DEBUG__
-    if (!pDom)
-    {
-        printf(__FUNCTION__ ": pDom is NULL\n");
-        return;
-    }
-
-    printf(__FUNCTION__ ": dumping document node ");
-
-    Dump(0, (PDOMNODE)pDom->pDocumentNode);
-#endif
+    if (pPath)
+        free(pPath);
 }
 
 /*
- *@@ xmlFreeDOM:
- *      cleans up all resources allocated by
- *      xmlCreateDOM and xmlParse, including
- *      the entire DOM tree.
- *
- *      If you wish to keep any data, make
- *      a copy of the respective pointers in pDom
- *      or subitems and set them to NULL before
- *      calling this function.
+ *@@ CountElements:
+ *      counts the elements below pParent by name,
+ *      in their symbols, for BuildNameIndex.
  *
- *@@added V0.9.9 (2001-02-14) [umoeller]
+ *@@added V1.0.24 (2026-10-18) [agent]
  */
 
-APIRET xmlFreeDOM(PXMLDOM pDom)
+STATIC VOID CountElements(PDOMNODE pParent)
 {
-    APIRET arc = NO_ERROR;
-    if (pDom)
-    {
-        // if the parser is still alive for some reason, close it.
-        if (pDom->pParser)
+    PDOMNODE pNode;
+
+    for (pNode = pParent->pFirstChild;
+         pNode;
+         pNode = pNode->pNextSibling)
+        if (pNode->NodeBase.ulNodeType == DOMNODE_ELEMENT)
         {
-            XML_ParserFree(pDom->pParser);
-            pDom->pParser = NULL;
+            SymbolFromName(&pNode->NodeBase.strNodeName)->cElements++;
+            CountElements(pNode);
         }
+}
 
-        xmlDeleteNode((PNODEBASE)pDom->pDocumentNode);
-
-        if (pDom->pxstrSystemID)
-            xstrFree(&pDom->pxstrSystemID);
-        if (pDom->pxstrFailingNode)
-            xstrFree(&pDom->pxstrFailingNode);
-
-        lstClear(&pDom->llElementStack);
+/*
+ *@@ IndexElements:
+ *      adds the elements below pParent to the arrays
+ *      in their symbols, in document order, for
+ *      BuildNameIndex.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
 
-        free(pDom);
-    }
+STATIC VOID IndexElements(PDOMNODE pParent)
+{
+    PDOMNODE pNode;
 
-    return arc;
+    for (pNode = pParent->pFirstChild;
+         pNode;
+         pNode = pNode->pNextSibling)
+        if (pNode->NodeBase.ulNodeType == DOMNODE_ELEMENT)
+        {
+            PDOMSYMBOL pSymbol = SymbolFromName(&pNode->NodeBase.strNodeName);
+            pSymbol->papElements[pSymbol->cElements++] = pNode;
+            IndexElements(pNode);
+        }
 }
 
-/* ******************************************************************
- *
- *   DOM lookup
- *
- ********************************************************************/
-
 /*
- *@@ xmlFindElementDecl:
- *      returns the CMELEMENTDECLNODE for the element
- *      with the specified name or NULL if there's none.
+ *@@ BuildNameIndex:
+ *      builds the document's name index, which has all
+ *      elements of each name in the symbol for the name,
+ *      in document order. This costs a pointer per element
+ *      and is dropped by FreeNameIndex whenever an element
+ *      is added or removed.
  *
- *@@added V0.9.9 (2001-02-16) [umoeller]
+ *      Returns FALSE if we're out of memory.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
  */
 
-PCMELEMENTDECLNODE xmlFindElementDecl(PXMLDOM pDom,
-                                      const XSTRING *pcstrElementName)
+STATIC BOOL BuildNameIndex(PDOMDOCUMENTNODE pDocument)
 {
-    PCMELEMENTDECLNODE pElementDecl = NULL;
+    PSTRMAPSLOT pSlot;
+    ULONG       ul = 0;
 
-    PDOMDOCTYPENODE pDocTypeNode = pDom->pDocTypeNode;
-    if (    (pDocTypeNode)
-         && (pcstrElementName)
-         && (pcstrElementName->ulLength)
-       )
+    // two passes, so that every array has the exact size
+    CountElements((PDOMNODE)pDocument);
+
+    pDocument->fNameIndex = TRUE;
+    while (pSlot = smapEnum(&pDocument->SymbolsMap, &ul))
     {
-        pElementDecl = (PCMELEMENTDECLNODE)treeFind(
-                                      pDocTypeNode->ElementDeclsTree,
-                                      (ULONG)pcstrElementName,
-                                      CompareXStrings);
+        PDOMSYMBOL pSymbol = (PDOMSYMBOL)pSlot->pvData;
+        if (pSymbol->cElements)
+        {
+            if (!(pSymbol->papElements = (PDOMNODE*)malloc(pSymbol->cElements * sizeof(PDOMNODE))))
+            {
+                FreeNameIndex(pDocument);
+                return FALSE;
+            }
+            pSymbol->cElements = 0;
+        }
     }
 
-    return pElementDecl;
+    IndexElements((PDOMNODE)pDocument);
+
+    return TRUE;
 }
 
 /*
- *@@ xmlFindAttribDeclBase:
- *      returns the CMATTRIBUTEDECLBASE for the specified
- *      element name, or NULL if none exists.
+ *@@ ResolvePath:
+ *      looks up the names in the query's path in the
+ *      document's symbol table, so that the query can
+ *      compare pointers.
  *
- *      To find a specific attribute declaration from both
- *      an element and an attribute name, use xmlFindAttribDecl
- *      instead.
+ *      Returns FALSE if one of them isn't there. No node
+ *      can match that step or predicate then, so the query
+ *      has no results.
  *
- *@@added V0.9.9 (2001-02-16) [umoeller]
+ *@@added V1.0.24 (2026-10-18) [agent]
  */
 
-PCMATTRIBUTEDECLBASE xmlFindAttribDeclBase(PXMLDOM pDom,
-                                           const XSTRING *pstrElementName)
+STATIC BOOL ResolvePath(PXPATHQUERY pQuery,
+                        PDOMDOCUMENTNODE pDocument)
 {
-    PDOMDOCTYPENODE pDocTypeNode = pDom->pDocTypeNode;
-    if (    (pDocTypeNode)
-         && (pstrElementName)
-         && (pstrElementName->ulLength)
-       )
-    {
-        return (PCMATTRIBUTEDECLBASE)treeFind(pDocTypeNode->AttribDeclBasesTree,
-                                              (ULONG)pstrElementName,
-                                              CompareXStrings);
-    }
+    const XMLPATH   *pPath = pQuery->pPath;
+    PDOMSYMBOL      pSymbol;
+    ULONG           ul;
+
+    for (ul = 0;
+         ul < pPath->cSteps;
+         ul++)
+        if (pPath->aSteps[ul].pcszName)
+        {
+            if (!(pSymbol = FindSymbol(pDocument, pPath->aSteps[ul].pcszName, 0)))
+                return FALSE;
+            xstrInitSet2(&pQuery->astrNames[ul], pSymbol->szName, pSymbol->ulLength);
+        }
+        else
+            xstrInit(&pQuery->astrNames[ul], 0);
 
-    return NULL;
+    for (ul = 0;
+         ul < pPath->cPreds;
+         ul++)
+        if (pPath->aPreds[ul].pcszAttrib)
+        {
+            if (!(pSymbol = FindSymbol(pDocument, pPath->aPreds[ul].pcszAttrib, 0)))
+                return FALSE;
+            xstrInitSet2(&pQuery->astrAttribs[ul], pSymbol->szName, pSymbol->ulLength);
+        }
+
+    return TRUE;
 }
 
 /*
- *@@ xmlFindAttribDecl:
- *      returns the CMATTRIBUTEDEDECL for the specified
- *      element and attribute name, or NULL if none exists.
+ *@@ FindAttribNode:
+ *      returns pElement's attribute node with the given
+ *      interned name or NULL.
  *
- *@@added V0.9.9 (2001-02-16) [umoeller]
+ *@@added V1.0.24 (2026-10-18) [agent]
  */
 
-PCMATTRIBUTEDECL xmlFindAttribDecl(PXMLDOM pDom,
-                                   const XSTRING *pstrElementName,
-                                   const XSTRING *pstrAttribName,
-                                   PCMATTRIBUTEDECLBASE *ppAttribDeclBase)
-                                            // in/out: attr decl base cache;
-                                            // the pointer pointed to by this
-                                            // must be NULL on the first call
+STATIC PDOMNODE FindAttribNode(PDOMNODE pElement,
+                               const XSTRING *pstrName)
 {
-    if (pstrElementName && pstrAttribName)
-    {
-        if (!*ppAttribDeclBase)
-            // first call for this:
-            *ppAttribDeclBase = xmlFindAttribDeclBase(pDom,
-                                                      pstrElementName);
-        if (*ppAttribDeclBase)
-        {
-            return (PCMATTRIBUTEDECL)treeFind(((**ppAttribDeclBase).AttribDeclsTree),
-                                              (ULONG)pstrAttribName,
-                                              CompareXStrings);
-        }
-    }
-
-    return NULL;
+    return (PDOMNODE)treeFind(pElement->AttributesMap,
+                              (ULONG)pstrName,
+                              CompareXStrings);
 }
 
 /*
- *@@ xmlGetRootElement:
- *      returns the root element node from the specified
- *      DOM. Useful helper to start enumerating elements.
+ *@@ MatchStep:
+ *      returns TRUE if pNode matches the name test of the
+ *      given step and its predicates up to (but not including)
+ *      ulStopPred.
  *
- *@@added V0.9.11 (2001-04-22) [umoeller]
- *@@changed V0.9.20 (2002-07-03) [umoeller]: this never worked with DTDs, fixed
+ *      paulCounts has the no. of siblings before pNode that
+ *      have passed each positional predicate, which we update;
+ *      paulLast has the total for each [last()]. Both are only
+ *      used if the step has positional predicates.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
  */
 
-PDOMNODE xmlGetRootElement(PXMLDOM pDom)
+STATIC BOOL MatchStep(PXPATHQUERY pQuery,
+                      ULONG iStep,
+                      PDOMNODE pNode,
+                      ULONG ulStopPred,
+                      PULONG paulCounts,
+                      const ULONG *paulLast)
 {
-    PDOMDOCUMENTNODE    pDocumentNode;
-    PLISTNODE           pListNode;
-    if (    (pDom)
-         && (pDocumentNode = pDom->pDocumentNode)
-         && (pListNode = lstQueryFirstNode(&pDocumentNode->DomNode.llChildren))
+    const XMLPATH   *pPath = pQuery->pPath;
+    ULONG           ul;
+
+    if (    (pNode->NodeBase.ulNodeType != DOMNODE_ELEMENT)
+         || (    (pQuery->astrNames[iStep].psz)
+              && (pNode->NodeBase.strNodeName.psz != pQuery->astrNames[iStep].psz)
+            )
        )
+        return FALSE;
+
+    for (ul = pPath->aSteps[iStep].iFirstPred;
+         ul < ulStopPred;
+         ul++)
     {
-        // V0.9.20 (2002-07-03) [umoeller]:
-        // we can't just return the first node on the
-        // list, because if we have DTD, this might
-        // be the doctype... so loop until we find
-        // an element, which must be the root element
-        while (pListNode)
+        const XPATHPRED *pPred = &pPath->aPreds[ul];
+        PDOMNODE        pAttrib;
+
+        switch (pPred->ulType)
         {
-            PDOMNODE pDomNode = (PDOMNODE)pListNode->pItemData;
-            if (pDomNode->NodeBase.ulNodeType == DOMNODE_ELEMENT)
-                return pDomNode;
+            case XPRED_HASATTRIB:
+                if (!FindAttribNode(pNode, &pQuery->astrAttribs[ul]))
+                    return FALSE;
+            break;
+
+            case XPRED_ATTRIBEQUALS:
+                if (    (!(pAttrib = FindAttribNode(pNode, &pQuery->astrAttribs[ul])))
+                     || (!pAttrib->pstrNodeValue)
+                     || (strcmp(pAttrib->pstrNodeValue->psz, pPred->pcszValue))
+                   )
+                    return FALSE;
+            break;
+
+            case XPRED_POSITION:
+                if (++paulCounts[pPred->iCounter] != pPred->ulPosition)
+                    return FALSE;
+            break;
 
-            pListNode = pListNode->pNext;
+            case XPRED_LAST:
+                if (++paulCounts[pPred->iCounter] != paulLast[pPred->iCounter])
+                    return FALSE;
+            break;
         }
     }
 
-    return NULL;
+    return TRUE;
 }
 
 /*
- *@@ xmlGetFirstChild:
- *      returns the first child node of pDomNode.
- *      See DOMNODE for what a "child" can be for the
- *      various node types.
+ *@@ AddResult:
+ *      adds a node to the query's results. Returns FALSE
+ *      if the query is done.
  *
- *@@added V0.9.9 (2001-02-14) [umoeller]
+ *@@added V1.0.24 (2026-10-18) [agent]
  */
 
-PDOMNODE xmlGetFirstChild(PDOMNODE pDomNode)
+STATIC BOOL AddResult(PXPATHQUERY pQuery,
+                      PDOMNODE pNode)
 {
-    PLISTNODE pListNode = lstQueryFirstNode(&pDomNode->llChildren);
-    if (pListNode)
-        return (PDOMNODE)pListNode->pItemData;
+    if (!pQuery->pFound)
+        pQuery->pFound = pNode;
 
-    return 0;
+    if (!pQuery->pll)
+        // xmlSelectSingleNode: that's it
+        return FALSE;
+
+    if (!lstAppendItem(pQuery->pll, pNode))
+    {
+        pQuery->fOutOfMemory = TRUE;
+        return FALSE;
+    }
+
+    return TRUE;
 }
 
 /*
- *@@ xmlGetLastChild:
- *      returns the last child node of pDomNode.
- *      See DOMNODE for what a "child" can be for the
- *      various node types.
+ *@@ MatchedStep:
+ *      called when pNode has matched step iStep. If that
+ *      was the last element step, this adds pNode (or its
+ *      attribute) to the results. Otherwise it sets the
+ *      bit for the next step in *pflChildSteps, so that
+ *      pNode's children are tested for that.
  *
- *@@added V0.9.9 (2001-02-14) [umoeller]
+ *      Returns FALSE if the query is done.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
  */
 
-PDOMNODE xmlGetLastChild(PDOMNODE pDomNode)
+STATIC BOOL MatchedStep(PXPATHQUERY pQuery,
+                        ULONG iStep,            // in: step or -1 for the context
+                        PDOMNODE pNode,
+                        PULONG pflChildSteps)
 {
-    PLISTNODE pListNode = lstQueryLastNode(&pDomNode->llChildren);
-    if (pListNode)
-        return (PDOMNODE)pListNode->pItemData;
+    const XMLPATH   *pPath = pQuery->pPath;
+    ULONG           iNext = iStep + 1;
 
-    return 0;
+    if (iNext >= pPath->cSteps)
+        return AddResult(pQuery, pNode);
+
+    if (pPath->aSteps[iNext].fAttribute)
+    {
+        PDOMNODE pAttrib;
+        if (pAttrib = FindAttribNode(pNode, &pQuery->astrNames[iNext]))
+            return AddResult(pQuery, pAttrib);
+        return TRUE;
+    }
+
+    *pflChildSteps |= 1UL << iNext;
+
+    return TRUE;
 }
 
 /*
- *@@ xmlGetFirstText:
- *      returns the first text (character data) node
- *      of pElement or NULL if there's none.
+ *@@ SelectChildren:
+ *      tests the children of pParent against the steps
+ *      in flSteps (bit n set for step n) and recurses.
+ *      A step with the descendant axis stays in the set
+ *      for all descendants. So this visits every node once
+ *      at most, and finds the results in document order.
  *
- *@@added V0.9.11 (2001-04-22) [umoeller]
+ *      Returns FALSE if the query is done.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
  */
 
-PDOMNODE xmlGetFirstText(PDOMNODE pElement)
+STATIC BOOL SelectChildren(PXPATHQUERY pQuery,
+                           PDOMNODE pParent,
+                           ULONG flSteps)
 {
-    PLISTNODE   pNode;
-    PDOMNODE    pDomNodeThis;
+    const XMLPATH   *pPath = pQuery->pPath;
+    ULONG           aulCounts[XPATH_MAX_POSITIONS],
+                    aulLast[XPATH_MAX_POSITIONS],
+                    iStep;
+    PDOMNODE        pChild;
 
-    for (pNode = lstQueryFirstNode(&pElement->llChildren);
-         pNode;
-         pNode = pNode->pNext)
+    if (pPath->fPositional)
+    {
+        // [last()] needs to know the no. of siblings that pass
+        // the predicates before it, so count those first
+        memset(aulLast, 0, sizeof(aulLast));
+
+        for (iStep = 0;
+             iStep < pPath->cSteps;
+             iStep++)
+        {
+            const XPATHSTEP *pStep = &pPath->aSteps[iStep];
+            ULONG           ul;
+
+            if (    (!(flSteps & (1UL << iStep)))
+                 || (!pStep->fPositional)
+               )
+                continue;
+
+            for (ul = pStep->iFirstPred;
+                 ul < pStep->iFirstPred + pStep->cPreds;
+                 ul++)
+                if (pPath->aPreds[ul].ulType == XPRED_LAST)
+                {
+                    memset(aulCounts, 0, sizeof(aulCounts));
+                    for (pChild = pParent->pFirstChild;
+                         pChild;
+                         pChild = pChild->pNextSibling)
+                        if (MatchStep(pQuery, iStep, pChild, ul, aulCounts, aulLast))
+                            aulLast[pPath->aPreds[ul].iCounter]++;
+                }
+        }
+
+        memset(aulCounts, 0, sizeof(aulCounts));
+    }
+
+    for (pChild = pParent->pFirstChild;
+         pChild;
+         pChild = pChild->pNextSibling)
     {
-        if (    (pDomNodeThis = (PDOMNODE)pNode->pItemData)
-             && (pDomNodeThis->NodeBase.ulNodeType == DOMNODE_TEXT)
+        ULONG flChildSteps = 0;
+
+        if (pChild->NodeBase.ulNodeType != DOMNODE_ELEMENT)
+            continue;
+
+        for (iStep = 0;
+             iStep < pPath->cSteps;
+             iStep++)
+        {
+            const XPATHSTEP *pStep = &pPath->aSteps[iStep];
+
+            if (!(flSteps & (1UL << iStep)))
+                continue;
+
+            if (pStep->fDescendant)
+                // keep looking further down
+                flChildSteps |= 1UL << iStep;
+
+            if (    (MatchStep(pQuery,
+                               iStep,
+                               pChild,
+                               pStep->iFirstPred + pStep->cPreds,
+                               aulCounts,
+                               aulLast))
+                 && (!MatchedStep(pQuery, iStep, pChild, &flChildSteps))
+               )
+                return FALSE;
+        }
+
+        if (    (flChildSteps)
+             && (pChild->pFirstChild)
+             && (!SelectChildren(pQuery, pChild, flChildSteps))
            )
-            return pDomNodeThis;
+            return FALSE;
     }
 
-    return NULL;
+    return TRUE;
 }
 
 /*
- *@@ xmlGetElementsByTagName:
- *      returns a linked list of DOMNODE nodes which
- *      match the specified element name. The special name
- *      "*" matches all elements.
- *
- *      pParent must be the parent element DOMNODE...
- *      the only allowed exception is
+ *@@ MatchBackwards:
+ *      returns TRUE if pNode matches step iStep and its
+ *      ancestors match the steps before, up to the context
+ *      node. This is for SelectFromIndex, which gets
+ *      candidates for the last step and must check the
+ *      path from the other end.
  *
- *      The caller must free the list by calling lstFree.
- *      Returns NULL if no such elements could be found.
+ *      This can't do positional predicates.
  *
- *@@added V0.9.9 (2001-02-14) [umoeller]
+ *@@added V1.0.24 (2026-10-18) [agent]
  */
 
-PLINKLIST xmlGetElementsByTagName(PDOMNODE pParent,
-                                  const char *pcszName)
+STATIC BOOL MatchBackwards(PXPATHQUERY pQuery,
+                           ULONG iStep,
+                           PDOMNODE pNode)
 {
-    PLINKLIST pll = lstCreate(FALSE);       // no free
-    if (pll)
+    const XPATHSTEP *pStep = &pQuery->pPath->aSteps[iStep];
+    PDOMNODE        pParent;
+
+    if (!MatchStep(pQuery,
+                   iStep,
+                   pNode,
+                   pStep->iFirstPred + pStep->cPreds,
+                   NULL,
+                   NULL))
+        return FALSE;
+
+    pParent = pNode->pParentNode;
+
+    if (!pStep->fDescendant)
     {
-        ULONG   cItems = 0;
-        BOOL    fFindAll = !strcmp(pcszName, "*");
+        if (!iStep)
+            return (pParent == pQuery->pContext);
 
-        PLISTNODE   pNode;
-        PDOMNODE    pDomNodeThis;
+        return (    (pParent)
+                 && (MatchBackwards(pQuery, iStep - 1, pParent))
+               );
+    }
 
-        for (pNode = lstQueryFirstNode(&pParent->llChildren);
-             pNode;
-             pNode = pNode->pNext)
+    for (;
+         pParent;
+         pParent = pParent->pParentNode)
+        if (!iStep)
         {
-            if (    (pDomNodeThis = (PDOMNODE)pNode->pItemData)
-                 && (pDomNodeThis->NodeBase.ulNodeType == DOMNODE_ELEMENT)
-                 && (    (fFindAll)
-                      || (!strcmp(pcszName, pDomNodeThis->NodeBase.strNodeName.psz))
-                    )
-               )
-            {
-                // element matches:
-                lstAppendItem(pll, pDomNodeThis);
-                cItems++;
-            }
+            if (pParent == pQuery->pContext)
+                return TRUE;
         }
+        else if (MatchBackwards(pQuery, iStep - 1, pParent))
+            return TRUE;
 
-        if (cItems)
-            return pll;
+    return FALSE;
+}
 
-        lstFree(&pll);
+/*
+ *@@ SelectFromIndex:
+ *      answers the query from the document's name index
+ *      if that is possible and probably faster than
+ *      SelectChildren. Returns FALSE if not.
+ *
+ *      That is the case if the last element step has a
+ *      name, there are no positional predicates, and
+ *      there is a descendant step (otherwise SelectChildren
+ *      only visits the nodes on the path anyway). Also,
+ *      the context must be the document or the root element,
+ *      or we'd look at too many elements outside of it.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+STATIC BOOL SelectFromIndex(PXPATHQUERY pQuery,
+                            PDOMDOCUMENTNODE pDocument)
+{
+    const XMLPATH   *pPath = pQuery->pPath;
+    ULONG           cSteps = pPath->cSteps,
+                    iLast,
+                    ul;
+    PDOMSYMBOL      pSymbol;
+
+    if (    (cSteps)
+         && (pPath->aSteps[cSteps - 1].fAttribute)
+       )
+        cSteps--;
+
+    if (    (!cSteps)
+         || (!pQuery->astrNames[iLast = cSteps - 1].psz)
+         || (pPath->fPositional)
+         || (!pPath->fDescendant)
+         || (    (pQuery->pContext != (PDOMNODE)pDocument)
+              && (pQuery->pContext->pParentNode != (PDOMNODE)pDocument)
+            )
+         || (    (!pDocument->fNameIndex)
+              && (!BuildNameIndex(pDocument))
+            )
+       )
+        return FALSE;
+
+    pSymbol = SymbolFromName(&pQuery->astrNames[iLast]);
+    for (ul = 0;
+         ul < pSymbol->cElements;
+         ul++)
+    {
+        PDOMNODE pNode = pSymbol->papElements[ul];
+        ULONG    flChildSteps = 0;
+
+        if (    (MatchBackwards(pQuery, iLast, pNode))
+             && (!MatchedStep(pQuery, iLast, pNode, &flChildSteps))
+           )
+            break;
     }
 
-    return 0;
+    return TRUE;
 }
 
 /*
- *@@ xmlGetAttribute:
- *      returns the value of pElement's attribute
- *      with the given name or NULL.
+ *@@ Select:
+ *      implementation for xmlSelectNodes and
+ *      xmlSelectSingleNode.
  *
- *      This is a const pointer into the element's
- *      attribute list.
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+STATIC VOID Select(PXPATHQUERY pQuery,
+                   PDOMNODE pContext,
+                   const XMLPATH *pPath)
+{
+    PDOMDOCUMENTNODE    pDocument;
+    ULONG               flSteps = 0;
+
+    if (!(pDocument = GetDocument(pContext)))
+        return;
+
+    pQuery->pPath = pPath;
+    pQuery->pContext = (pPath->fAbsolute) ? (PDOMNODE)pDocument : pContext;
+
+    if (    (ResolvePath(pQuery, pDocument))
+         && (!SelectFromIndex(pQuery, pDocument))
+         && (MatchedStep(pQuery, (ULONG)-1, pQuery->pContext, &flSteps))
+         && (flSteps)
+       )
+        SelectChildren(pQuery, pQuery->pContext, flSteps);
+}
+
+/*
+ *@@ xmlSelectNodes:
+ *      returns a linked list of all nodes that the given
+ *      path selects from pContext, in document order, or
+ *      NULL if there are none. See xmlCompilePath for the
+ *      path syntax.
+ *
+ *      These are element nodes unless the path ends with
+ *      an attribute step, and the document node for "/".
+ *
+ *      The caller must free the list with lstFree, but not
+ *      the nodes, which are still in the document.
+ *
+ *      Element and attribute names are looked up in the
+ *      document's symbol table once, so a path with a name
+ *      that doesn't occur in the document returns at once.
+ *      Paths with "//" and no positional predicates, from
+ *      the document or the root element, use the document's
+ *      name index, which is built on first use and dropped
+ *      when elements are added or removed. So "//item[@id='42']"
+ *      only looks at the "item" elements. Other paths walk
+ *      the tree below pContext, but only as far down as the
+ *      path can match.
+ *
+ *      As this may build the index, do not query one document
+ *      from several threads at once. The XMLPATH is never
+ *      modified though.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+PLINKLIST xmlSelectNodes(PDOMNODE pContext,         // in: node the path is relative to
+                         const XMLPATH *pPath)      // in: path from xmlCompilePath
+{
+    XPATHQUERY  Query;
+
+    if (    (!pContext)
+         || (!pPath)
+       )
+        return NULL;
+
+    memset(&Query, 0, sizeof(Query));
+    if (!(Query.pll = lstCreate(FALSE)))       // no free
+        return NULL;
+
+    Select(&Query, pContext, pPath);
+
+    if (    (Query.fOutOfMemory)
+         || (!lstCountItems(Query.pll))
+       )
+        lstFree(&Query.pll);
+
+    return Query.pll;
+}
+
+/*
+ *@@ xmlSelectSingleNode:
+ *      like xmlSelectNodes, but returns the first node
+ *      only, or NULL if there is none. This stops looking
+ *      at the first match.
  *
- *@@added V0.9.11 (2001-04-22) [umoeller]
+ *@@added V1.0.24 (2026-10-18) [agent]
  */
 
-const XSTRING* xmlGetAttribute(PDOMNODE pElement,
-                               const char *pcszAttribName)
+PDOMNODE xmlSelectSingleNode(PDOMNODE pContext,     // in: node the path is relative to
+                             const XMLPATH *pPath)  // in: path from xmlCompilePath
 {
-    XSTRING str;
-    PDOMNODE pAttrNode;
-    xstrInitSet(&str, (PSZ)pcszAttribName);
-    // note, cheap trick: no malloc here, but we need
-    // an XSTRING for treeFind
-    if (pAttrNode = (PDOMNODE)treeFind(pElement->AttributesMap,
-                                       (ULONG)&str,
-                                       CompareXStrings))
-        return pAttrNode->pstrNodeValue;
+    XPATHQUERY  Query;
 
-    return NULL;
+    if (    (!pContext)
+         || (!pPath)
+       )
+        return NULL;
+
+    memset(&Query, 0, sizeof(Query));
+
+    Select(&Query, pContext, pPath);
+
+    return Query.pFound;
 }
 
 /* ******************************************************************
@@ -3143,82 +7462,142 @@ APIRET xmlCreateDocument(const char *pcszRootElementName,   // in: root element
 }
 
 /*
- *@@ ESCAPES:
- *
- *@@added V1.0.0 (2002-08-21) [umoeller]
+ *@@ XMLWRITER:
+ *      buffered output for xmlWriteDocumentToSink.
+ *      Output is collected in achBuf and passed to
+ *      the sink whenever that is full, so the sink
+ *      gets large chunks no matter how small the
+ *      nodes are.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
  */
 
-typedef struct _ESCAPES
+#define XMLWRITER_BUFSIZE   4096
+
+typedef struct _XMLWRITER
 {
-    XSTRING strQuot1,       // "
-            strQuot2,       // &quot;
-            strAmp1,        // &
-            strAmp2,        // &amp;
-            strLT1,         // <
-            strLT2,         // &lt;
-            strGT1,         // >
-            strGT2;         // &gt;
+    PFNXMLWRITE     pfnWrite;
+    PVOID           pvUser;
+    APIRET          arc;                // first error from pfnWrite
+    ULONG           cbBuf;              // bytes used in achBuf
+    BYTE            abEscapeText[256],  // index into G_aEscapes for every char
+                    abEscapeAttrib[256];
+                        // (the same plus quotes for attribute values)
+    CHAR            achBuf[XMLWRITER_BUFSIZE];
+} XMLWRITER, *PXMLWRITER;
 
-    XSTRING strTemp;        // temp buffer
+/*
+ *      Entity references for the characters that have to
+ *      be escaped; XMLWRITER.abEscapeText and abEscapeAttrib
+ *      index into this, with 0 for chars that are written
+ *      as they are.
+ */
 
-} ESCAPES, *PESCAPES;
+static const struct
+{
+    PCSZ    pcsz;
+    ULONG   cb;
+} G_aEscapes[] =
+    {
+        { NULL, 0 },
+        { "&amp;", 5 },
+        { "&lt;", 4 },
+        { "&gt;", 4 },
+        { "&quot;", 6 }
+    };
 
 /*
- *@@ DoEscapes:
+ *@@ FlushWriter:
+ *      passes the buffered output to the sink.
  *
- *@@added V1.0.0 (2002-08-21) [umoeller]
+ *@@added V1.0.24 (2026-10-18) [agent]
  */
 
-VOID DoEscapes(PESCAPES pEscapes,
-               BOOL fQuotesToo)
+STATIC VOID FlushWriter(PXMLWRITER pWriter)
 {
-    ULONG   ulOfs;
-    size_t  ShiftTable[256];
-    BOOL    fRepeat;
+    if (    (pWriter->cbBuf)
+         && (!pWriter->arc)
+       )
+        pWriter->arc = pWriter->pfnWrite(pWriter->pvUser,
+                                         pWriter->achBuf,
+                                         pWriter->cbBuf);
+    pWriter->cbBuf = 0;
+}
+
+/*
+ *@@ WriteChars:
+ *      writes cch chars to the buffer. Runs that don't
+ *      fit into an empty buffer go to the sink directly.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
 
-    if (fQuotesToo)
+STATIC VOID WriteChars(PXMLWRITER pWriter,
+                       const char *pcch,
+                       ULONG cch)
+{
+    if (pWriter->cbBuf + cch > XMLWRITER_BUFSIZE)
     {
-        ulOfs = 0;
-        fRepeat = FALSE;
-        while (xstrFindReplace(&pEscapes->strTemp,
-                               &ulOfs,
-                               &pEscapes->strQuot1,
-                               &pEscapes->strQuot2,
-                               ShiftTable,
-                               &fRepeat))
-            ;
+        FlushWriter(pWriter);
+
+        if (cch >= XMLWRITER_BUFSIZE)
+        {
+            if (!pWriter->arc)
+                pWriter->arc = pWriter->pfnWrite(pWriter->pvUser,
+                                                 pcch,
+                                                 cch);
+            return;
+        }
     }
 
-    ulOfs = 0;
-    fRepeat = FALSE;
-    while (xstrFindReplace(&pEscapes->strTemp,
-                           &ulOfs,
-                           &pEscapes->strLT1,
-                           &pEscapes->strLT2,
-                           ShiftTable,
-                           &fRepeat))
-        ;
+    memcpy(pWriter->achBuf + pWriter->cbBuf, pcch, cch);
+    pWriter->cbBuf += cch;
+}
+
+#define WriteString(pWriter, psz) WriteChars((pWriter), (psz), strlen(psz))
+#define WriteXString(pWriter, pstr) WriteChars((pWriter), (pstr)->psz, (pstr)->ulLength)
 
-    ulOfs = 0;
-    fRepeat = FALSE;
-    while (xstrFindReplace(&pEscapes->strTemp,
-                           &ulOfs,
-                           &pEscapes->strGT1,
-                           &pEscapes->strGT2,
-                           ShiftTable,
-                           &fRepeat))
-        ;
+/*
+ *@@ WriteEscaped:
+ *      writes the string with the characters escaped
+ *      that pabEscape says need escaping. This is a
+ *      single pass over the string, which writes the
+ *      runs of unescaped chars in one go.
+ *
+ *      This replaces DoEscapes, which did one
+ *      find-and-replace pass per character, and
+ *      since it did ampersands last, turned "<" into
+ *      "&amp;lt;".
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+STATIC VOID WriteEscaped(PXMLWRITER pWriter,
+                         const XSTRING *pstr,
+                         const BYTE *pabEscape)     // in: XMLWRITER.abEscapeText or abEscapeAttrib
+{
+    const char  *pStart,
+                *p,
+                *pEnd;
+
+    if (!pstr || !pstr->psz)
+        return;
+
+    pEnd = pstr->psz + pstr->ulLength;
+    for (pStart = p = pstr->psz;
+         p < pEnd;
+         p++)
+    {
+        BYTE b;
+        if (b = pabEscape[(UCHAR)*p])
+        {
+            WriteChars(pWriter, pStart, p - pStart);
+            WriteChars(pWriter, G_aEscapes[b].pcsz, G_aEscapes[b].cb);
+            pStart = p + 1;
+        }
+    }
 
-    // replace ampersands last
-    ulOfs = 0;
-    fRepeat = FALSE;
-    while (xstrFindReplace(&pEscapes->strTemp,
-                           &ulOfs,
-                           &pEscapes->strAmp1,
-                           &pEscapes->strAmp2,
-                           ShiftTable,
-                           &fRepeat))
-        ;
+    WriteChars(pWriter, pStart, p - pStart);
 }
 
 /*
@@ -3228,21 +7607,21 @@ VOID DoEscapes(PESCAPES pEscapes,
  *
  *@@added V0.9.12 (2001-05-21) [umoeller]
  *@@changed V1.0.0 (2002-08-21) [umoeller]: changed prototype, fixed unescaped characters in attributes and content
+ *@@changed V1.0.24 (2026-10-18) [agent]: replaced llChildren
+ *@@changed V1.0.24 (2026-10-18) [agent]: now writing to an XMLWRITER
  */
 
-STATIC VOID WriteNodes(PXSTRING pxstr,
-                       PESCAPES pEscapes,
+STATIC VOID WriteNodes(PXMLWRITER pWriter,
                        PDOMNODE pDomNode)       // in: node whose children are to be written (initially DOCUMENT)
 {
-    PLISTNODE pListNode;
+    PDOMNODE pChildNode;
 
     BOOL fMixedContent = (xmlGetFirstText(pDomNode) != NULL);
 
-    for (pListNode = lstQueryFirstNode(&pDomNode->llChildren);
-         (pListNode);
-         pListNode = pListNode->pNext)
+    for (pChildNode = pDomNode->pFirstChild;
+         (pChildNode) && (!pWriter->arc);
+         pChildNode = pChildNode->pNextSibling)
     {
-        PDOMNODE pChildNode = (PDOMNODE)pListNode->pItemData;
 
         switch (pChildNode->NodeBase.ulNodeType)
         {
@@ -3253,55 +7632,51 @@ STATIC VOID WriteNodes(PXSTRING pxstr,
                 // add a line break if this does NOT have mixed
                 // content
                 if (!fMixedContent)
-                    xstrcatc(pxstr, '\n');
+                    WriteChars(pWriter, "\n", 1);
 
-                xstrcatc(pxstr, '<');
-                xstrcats(pxstr, &pChildNode->NodeBase.strNodeName);
+                WriteChars(pWriter, "<", 1);
+                WriteXString(pWriter, &pChildNode->NodeBase.strNodeName);
 
                 // go through attributes
                 for (pAttribNode = (PDOMNODE)treeFirst(pChildNode->AttributesMap);
                      (pAttribNode);
                      pAttribNode = (PDOMNODE)treeNext((TREE*)pAttribNode))
                 {
-                    xstrcat(pxstr, "\n    ", 0);
-                    xstrcats(pxstr, &pAttribNode->NodeBase.strNodeName);
-                    xstrcat(pxstr, "=\"", 0);
+                    WriteChars(pWriter, "\n    ", 5);
+                    WriteXString(pWriter, &pAttribNode->NodeBase.strNodeName);
+                    WriteChars(pWriter, "=\"", 2);
 
-                    // copy attribute value to temp buffer first
-                    // so we can escape quotes and ampersands
+                    // escape quotes and ampersands too
                     // V1.0.0 (2002-08-21) [umoeller]
-                    xstrcpys(&pEscapes->strTemp, pAttribNode->pstrNodeValue);
-
-                    DoEscapes(pEscapes,
-                              TRUE);        // quotes too
+                    WriteEscaped(pWriter,
+                                 pAttribNode->pstrNodeValue,
+                                 pWriter->abEscapeAttrib);
 
-                    // alright, use that
-                    xstrcats(pxstr, &pEscapes->strTemp);
-                    xstrcatc(pxstr, '\"');
+                    WriteChars(pWriter, "\"", 1);
                 }
 
                 // now check... do we have child nodes?
-                if (lstCountItems(&pChildNode->llChildren))
+                if (pChildNode->pFirstChild)
                 {
                     // yes:
-                    xstrcatc(pxstr, '>');
+                    WriteChars(pWriter, ">", 1);
 
                     // recurse into this child element
-                    WriteNodes(pxstr, pEscapes, pChildNode);
+                    WriteNodes(pWriter, pChildNode);
 
                     if (!fMixedContent)
-                        xstrcatc(pxstr, '\n');
+                        WriteChars(pWriter, "\n", 1);
 
                     // write closing tag
-                    xstrcat(pxstr, "</", 0);
-                    xstrcats(pxstr, &pChildNode->NodeBase.strNodeName);
-                    xstrcatc(pxstr, '>');
+                    WriteChars(pWriter, "</", 2);
+                    WriteXString(pWriter, &pChildNode->NodeBase.strNodeName);
+                    WriteChars(pWriter, ">", 1);
                 }
                 else
                 {
                     // no child nodes:
                     // mark this tag as "empty"
-                    xstrcat(pxstr, "/>", 0);
+                    WriteChars(pWriter, "/>", 2);
                 }
             }
             break;
@@ -3309,13 +7684,9 @@ STATIC VOID WriteNodes(PXSTRING pxstr,
             case DOMNODE_TEXT:
             case DOMNODE_COMMENT:
                 // that's simple
-                xstrcpys(&pEscapes->strTemp,
-                         pChildNode->pstrNodeValue);
-
-                DoEscapes(pEscapes,         // V1.0.0 (2002-08-21) [umoeller]
-                          FALSE);           // quotes not
-
-                xstrcats(pxstr, &pEscapes->strTemp);
+                WriteEscaped(pWriter,           // V1.0.0 (2002-08-21) [umoeller]
+                             pChildNode->pstrNodeValue,
+                             pWriter->abEscapeText);
             break;
 
             case DOMNODE_DOCUMENT_TYPE:
@@ -3326,6 +7697,150 @@ STATIC VOID WriteNodes(PXSTRING pxstr,
     }
 }
 
+/*
+ *@@ xmlWriteDocumentToSink:
+ *      writes a complete XML document from the specified
+ *      DOMDOCUMENTNODE to an output sink.
+ *
+ *      This creates a full XML document, starting with
+ *      the <?xml...?> header, the DTD (if present),
+ *      and the elements and attributes. See xmlWriteDocument
+ *      for the details.
+ *
+ *      The output is buffered here and passed to pfnWrite
+ *      in chunks of up to 4 KB, and pfnWrite gets pvUser
+ *      with each. It should return NO_ERROR or an error
+ *      code, which stops the writing and is returned. So
+ *      this uses the same small amount of memory for any
+ *      size of document; use xmlWriteFileSink with a FILE*
+ *      as pvUser to write the document to a file.
+ *
+ *      Example:
+ *
+ +          FILE *file;
+ +          if (file = fopen("myfile.xml", "wb"))
+ +          {
+ +              arc = xmlWriteDocumentToSink(pDocument,
+ +                                           "ISO-8859-1",
+ +                                           NULL,      // or DOCTYPE
+ +                                           xmlWriteFileSink,
+ +                                           file);
+ +              fclose(file);
+ +          }
+ *
+ *      Characters that need escaping are replaced with
+ *      entity references in the same pass: "&", "<" and
+ *      ">" everywhere, and double quotes in attribute values.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+APIRET xmlWriteDocumentToSink(PDOMDOCUMENTNODE pDocument,   // in: document node
+                              const char *pcszEncoding,     // in: encoding string (e.g. "ISO-8859-1")
+                              const char *pcszDoctype,      // in: entire DOCTYPE statement or NULL
+                              PFNXMLWRITE pfnWrite,         // in: output sink
+                              PVOID pvUser)                 // in: user data for pfnWrite
+{
+    PXMLWRITER  pWriter;
+    APIRET      arc;
+
+    if ( (!pDocument) || (!pcszEncoding) || (!pfnWrite) )
+        return ERROR_INVALID_PARAMETER;
+
+    // not on the stack, this can be called deep down
+    if (!(pWriter = (PXMLWRITER)malloc(sizeof(XMLWRITER))))
+        return ERROR_NOT_ENOUGH_MEMORY;
+
+    pWriter->pfnWrite = pfnWrite;
+    pWriter->pvUser = pvUser;
+    pWriter->arc = NO_ERROR;
+    pWriter->cbBuf = 0;
+
+    memset(pWriter->abEscapeText, 0, sizeof(pWriter->abEscapeText));
+    pWriter->abEscapeText['&'] = 1;
+    pWriter->abEscapeText['<'] = 2;
+    pWriter->abEscapeText['>'] = 3;
+    memcpy(pWriter->abEscapeAttrib, pWriter->abEscapeText, sizeof(pWriter->abEscapeAttrib));
+    pWriter->abEscapeAttrib['"'] = 4;
+
+    // <?xml version="1.0" encoding="ISO-8859-1"?>
+    WriteString(pWriter, "<?xml version=\"1.0\" encoding=\"");
+    WriteString(pWriter, pcszEncoding);
+    WriteString(pWriter, "\"?>\n");
+
+    // write entire DOCTYPE statement
+    if (pcszDoctype)
+    {
+        WriteChars(pWriter, "\n", 1);
+        WriteString(pWriter, pcszDoctype);
+        WriteChars(pWriter, "\n", 1);
+    }
+
+    // write out children
+    WriteNodes(pWriter, (PDOMNODE)pDocument);
+
+    WriteChars(pWriter, "\n", 1);
+    FlushWriter(pWriter);
+
+    arc = pWriter->arc;
+    free(pWriter);
+
+    return arc;
+}
+
+/*
+ *@@ xmlWriteFileSink:
+ *      output sink for xmlWriteDocumentToSink which
+ *      writes to the FILE* given as pvUser.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+APIRET APIENTRY xmlWriteFileSink(PVOID pvUser,
+                                 const char *pcch,
+                                 ULONG cch)
+{
+    if (fwrite(pcch, 1, cch, (FILE*)pvUser) != cch)
+        return ERROR_WRITE_FAULT;
+
+    return NO_ERROR;
+}
+
+/*
+ *@@ XStringSink:
+ *      output sink for xmlWriteDocument which appends
+ *      to the XSTRING given as pvUser. The string grows
+ *      by doubling, so a large document isn't copied
+ *      over and over.
+ *
+ *@@added V1.0.24 (2026-10-18) [agent]
+ */
+
+STATIC APIRET APIENTRY XStringSink(PVOID pvUser,
+                                   const char *pcch,
+                                   ULONG cch)
+{
+    PXSTRING    pxstr = (PXSTRING)pvUser;
+    ULONG       cbNeeded = pxstr->ulLength + cch + 1;
+
+    if (!cch)
+        // xstrcat would take that as null-terminated
+        return NO_ERROR;
+
+    if (cbNeeded > pxstr->cbAllocated)
+    {
+        ULONG cbAllocate = pxstr->cbAllocated * 2;
+        if (cbAllocate < cbNeeded)
+            cbAllocate = cbNeeded;
+        if (!xstrReserve(pxstr, cbAllocate))
+            return ERROR_NOT_ENOUGH_MEMORY;
+    }
+
+    xstrcat(pxstr, pcch, cch);
+
+    return NO_ERROR;
+}
+
 /*
  *@@ xmlWriteDocument:
  *      creates a complete XML document in the specified
@@ -3350,6 +7865,9 @@ STATIC VOID WriteNodes(PXSTRING pxstr,
  *
  *      3)  Call xmlWriteDocument to have the XML
  *          document written into an XSTRING.
+ *          For large documents, better use
+ *          xmlWriteDocumentToSink, which writes to
+ *          a file directly (and skip step 4).
  *
  *      4)  Write the XSTRING to disk, e.g. using
  *          fwrite().
@@ -3414,6 +7932,7 @@ STATIC VOID WriteNodes(PXSTRING pxstr,
  *      white space may then be significant.
  *
  *@@added V0.9.12 (2001-05-21) [umoeller]
+ *@@changed V1.0.24 (2026-10-18) [agent]: now using xmlWriteDocumentToSink; fixed double escaping of "&"
  */
 
 APIRET xmlWriteDocument(PDOMDOCUMENTNODE pDocument,     // in: document node
@@ -3421,56 +7940,16 @@ APIRET xmlWriteDocument(PDOMDOCUMENTNODE pDocument,     // in: document node
                         const char *pcszDoctype,        // in: entire DOCTYPE statement or NULL
                         PXSTRING pxstr)                 // out: document
 {
-    APIRET arc = NO_ERROR;
-
     if ( (!pDocument) || (!pcszEncoding) || (!pxstr) )
-        arc = ERROR_INVALID_PARAMETER;
-    else
-    {
-        ESCAPES esc;
-
-        // <?xml version="1.0" encoding="ISO-8859-1"?>
-        xstrcpy(pxstr, "<?xml version=\"1.0\" encoding=\"", 0);
-        xstrcat(pxstr, pcszEncoding, 0);
-        xstrcat(pxstr, "\"?>\n", 0);
-
-        // write entire DOCTYPE statement
-        if (pcszDoctype)
-        {
-            xstrcatc(pxstr, '\n');
-            xstrcat(pxstr, pcszDoctype, 0);
-            xstrcatc(pxstr, '\n');
-        }
-
-        xstrInitCopy(&esc.strQuot1, "\"", 0);
-        xstrInitCopy(&esc.strQuot2, "&quot;", 0);
-        xstrInitCopy(&esc.strAmp1, "&", 0);
-        xstrInitCopy(&esc.strAmp2, "&amp;", 0);
-        xstrInitCopy(&esc.strLT1, "<", 0);
-        xstrInitCopy(&esc.strLT2, "&lt;", 0);
-        xstrInitCopy(&esc.strGT1, ">", 0);
-        xstrInitCopy(&esc.strGT2, "&gt;", 0);
-
-        xstrInit(&esc.strTemp, 0);       // temp buffer
-
-        // write out children
-        WriteNodes(pxstr, &esc, (PDOMNODE)pDocument);
+        return ERROR_INVALID_PARAMETER;
 
-        xstrClear(&esc.strQuot1);
-        xstrClear(&esc.strQuot2);
-        xstrClear(&esc.strAmp1);
-        xstrClear(&esc.strAmp2);
-        xstrClear(&esc.strLT1);
-        xstrClear(&esc.strLT2);
-        xstrClear(&esc.strGT1);
-        xstrClear(&esc.strGT2);
+    xstrcpy(pxstr, "", 0);
 
-        xstrClear(&esc.strTemp);       // temp buffer
-
-        xstrcatc(pxstr, '\n');
-    }
-
-    return arc;
+    return xmlWriteDocumentToSink(pDocument,
+                                  pcszEncoding,
+                                  pcszDoctype,
+                                  XStringSink,
+                                  pxstr);
 }
 
 
@@ -986,8 +986,8 @@
  *
  *      -- The "documentElement" member is a convenience pointer to the
  *         document's root element. We don't supply this field; instead,
- *         the llChildren list only contains a single ELEMENT node for the
- *         root element.
+ *         the document's children only contain a single ELEMENT node for
+ *         the root element.
  *
  *      -- The "createElement" method is implemented by xmlCreateElementNode.
  *
@@ -110,6 +110,38 @@
   CHECK_NMSTRT_CASE(3, enc, ptr, end, nextTokPtr) \
   CHECK_NMSTRT_CASE(4, enc, ptr, end, nextTokPtr)
 
+/* Fast paths for the common runs of characters that need no checks
+   beyond their byte type: the scanning loops below skip such runs four
+   characters at a time before falling back to the switch for the
+   character that ends the run (and the last few before the end).
+   This relies on the order of the BT_* types in xmltok_impl.h: all
+   types that end character data are at most BT_LF, and the name
+   characters are BT_NMSTRT and BT_HEX..BT_MINUS (BT_COLON is left to
+   the switch for XML_NS). The byte types come from the encoding's
+   own table, so this works for all encodings, including unknown ones
+   whose ASCII range is not all ASCII. */
+
+/* character data in content and for updatePosition */
+#define IS_DATA_RUN(t) ((t) > BT_LF)
+/* attribute value in a start tag, up to either quote */
+#define IS_ATTVAL_RUN(t) ((t) > BT_APOS)
+/* attribute value where spaces matter (attributeValueTok, getAtts) */
+#define IS_ATTVAL_NO_S_RUN(t) ((t) > BT_S)
+/* name characters */
+#define IS_NAME_RUN(t) \
+  ((t) == BT_NMSTRT || ((t) >= BT_HEX && (t) <= BT_MINUS))
+
+/* Advances ptr over a run of characters for which IS_RUN is true,
+   four at a time. Stops with at least one character left before end,
+   so ptr != end afterwards if it was before. */
+#define SKIP_RUN(enc, ptr, end, IS_RUN) \
+  while ((end) - (ptr) > 4*MINBPC(enc) \
+         && IS_RUN(BYTE_TYPE(enc, ptr)) \
+         && IS_RUN(BYTE_TYPE(enc, (ptr) + MINBPC(enc))) \
+         && IS_RUN(BYTE_TYPE(enc, (ptr) + 2*MINBPC(enc))) \
+         && IS_RUN(BYTE_TYPE(enc, (ptr) + 3*MINBPC(enc)))) \
+    (ptr) += 4*MINBPC(enc)
+
 #ifndef PREFIX
 #define PREFIX(ident) ident
 #endif
@@ -382,6 +414,7 @@ static int EXPATENTRY PREFIX(cdataSectionTok)(const ENCODING *enc,
     break;
   }
   while (ptr != end) {
+    SKIP_RUN(enc, ptr, end, IS_DATA_RUN);
     switch (BYTE_TYPE(enc, ptr)) {
 #define LEAD_CASE(n) \
     case BT_LEAD ## n: \
@@ -426,6 +459,7 @@ static int EXPATENTRY PREFIX(scanEndTag)(const ENCODING *enc,
     return XML_TOK_INVALID;
   }
   while (ptr != end) {
+    SKIP_RUN(enc, ptr, end, IS_NAME_RUN);
     switch (BYTE_TYPE(enc, ptr)) {
     CHECK_NAME_CASES(enc, ptr, end, nextTokPtr)
     case BT_S: case BT_CR: case BT_LF:
@@ -567,6 +601,7 @@ static int EXPATENTRY PREFIX(scanAtts)(const ENCODING *enc,
   int hadColon = 0;
 #endif
   while (ptr != end) {
+    SKIP_RUN(enc, ptr, end, IS_NAME_RUN);
     switch (BYTE_TYPE(enc, ptr)) {
     CHECK_NAME_CASES(enc, ptr, end, nextTokPtr)
 #ifdef XML_NS
@@ -638,6 +673,7 @@ static int EXPATENTRY PREFIX(scanAtts)(const ENCODING *enc,
       int t;
       if (ptr == end)
         return XML_TOK_PARTIAL;
+      SKIP_RUN(enc, ptr, end, IS_ATTVAL_RUN);
       t = BYTE_TYPE(enc, ptr);
       if (t == open)
         break;
@@ -755,6 +791,7 @@ static int EXPATENTRY PREFIX(scanLt)(const ENCODING *enc,
 #endif
   /* we have a start-tag */
   while (ptr != end) {
+    SKIP_RUN(enc, ptr, end, IS_NAME_RUN);
     switch (BYTE_TYPE(enc, ptr)) {
     CHECK_NAME_CASES(enc, ptr, end, nextTokPtr)
 #ifdef XML_NS
@@ -872,6 +909,7 @@ static int EXPATENTRY PREFIX(contentTok)(const ENCODING *enc,
     break;
   }
   while (ptr != end) {
+    SKIP_RUN(enc, ptr, end, IS_DATA_RUN);
     switch (BYTE_TYPE(enc, ptr)) {
 #define LEAD_CASE(n) \
     case BT_LEAD ## n: \
@@ -1249,6 +1287,7 @@ static int EXPATENTRY PREFIX(attributeValueTok)(const ENCODING *enc,
     return XML_TOK_NONE;
   start = ptr;
   while (ptr != end) {
+    SKIP_RUN(enc, ptr, end, IS_ATTVAL_NO_S_RUN);
     switch (BYTE_TYPE(enc, ptr)) {
 #define LEAD_CASE(n) \
     case BT_LEAD ## n: ptr += n; break;
@@ -1481,6 +1520,14 @@ static int EXPATENTRY PREFIX(getAtts)(const ENCODING *enc,
            initialization just to shut up compilers */
 
   for (ptr += MINBPC(enc);; ptr += MINBPC(enc)) {
+    /* the tag has been scanned already, so the run must end
+       before the tag does and we needn't check for the end */
+    if (state == inValue)
+      while (IS_ATTVAL_NO_S_RUN(BYTE_TYPE(enc, ptr)))
+        ptr += MINBPC(enc);
+    else if (state == inName)
+      while (IS_NAME_RUN(BYTE_TYPE(enc, ptr)))
+        ptr += MINBPC(enc);
     switch (BYTE_TYPE(enc, ptr)) {
 #define START_NAME \
       if (state == other) { \
@@ -1742,6 +1789,8 @@ static int EXPATENTRY PREFIX(nameLength)(const ENCODING *enc,
 {
   const char *start = ptr;
   for (;;) {
+    while (IS_NAME_RUN(BYTE_TYPE(enc, ptr)))
+      ptr += MINBPC(enc);
     switch (BYTE_TYPE(enc, ptr)) {
 #define LEAD_CASE(n) \
     case BT_LEAD ## n: ptr += n; break;
@@ -1786,6 +1835,9 @@ static void EXPATENTRY PREFIX(updatePosition)(const ENCODING *enc,
                                               POSITION *pos)
 {
   while (ptr != end) {
+    const char *run = ptr;
+    SKIP_RUN(enc, ptr, end, IS_DATA_RUN);
+    pos->columnNumber += (unsigned)((ptr - run) / MINBPC(enc));
     switch (BYTE_TYPE(enc, ptr)) {
 #define LEAD_CASE(n) \
     case BT_LEAD ## n: \
@@ -1816,6 +1868,11 @@ static void EXPATENTRY PREFIX(updatePosition)(const ENCODING *enc,
 #undef DO_LEAD_CASE
 #undef MULTIBYTE_CASES
 #undef INVALID_CASES
+#undef IS_DATA_RUN
+#undef IS_ATTVAL_RUN
+#undef IS_ATTVAL_NO_S_RUN
+#undef IS_NAME_RUN
+#undef SKIP_RUN
 #undef CHECK_NAME_CASE
 #undef CHECK_NAME_CASES
 #undef CHECK_NMSTRT_CASE